@@ -0,0 +1,125 @@
+# Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+# This file is part of Share Your Files (SYF).
+
+# SYF is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# SYF is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+
+QT += core gui network qml testlib
+
+TARGET = Microbenchmarks
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+# Enable C++11 support
+CONFIG += C++11
+
+# Add some more warnings.
+QMAKE_CXXFLAGS += -Wall -Wextra -Wpedantic
+
+# Sources under benchmark
+SYF_DIR = $$PWD/../../ShareYourFiles
+INCLUDEPATH += $$SYF_DIR
+
+SOURCES += main.cpp \
+    benchmarkcounters.cpp \
+    fileinfobenchmark.cpp \
+    peerslistbenchmark.cpp \
+    syfddatagrambenchmark.cpp \
+    syfdratelimiterbenchmark.cpp \
+    transferlistbenchmark.cpp \
+    transfersmodelbenchmark.cpp \
+    $$SYF_DIR/Common/coalescedtimer.cpp \
+    $$SYF_DIR/Common/common.cpp \
+    $$SYF_DIR/Common/logging.cpp \
+    $$SYF_DIR/Common/threadpool.cpp \
+    $$SYF_DIR/UserDiscovery/receptionpolicy.cpp \
+    $$SYF_DIR/UserDiscovery/syfddatagram.cpp \
+    $$SYF_DIR/UserDiscovery/syfddatagramview.cpp \
+    $$SYF_DIR/UserDiscovery/syfdratelimiter.cpp \
+    $$SYF_DIR/UserDiscovery/syfitprotocol.cpp \
+    $$SYF_DIR/UserDiscovery/syfitscheduler.cpp \
+    $$SYF_DIR/UserDiscovery/user.cpp \
+    $$SYF_DIR/UserDiscovery/usericon.cpp \
+    $$SYF_DIR/UserDiscovery/usericoncache.cpp \
+    $$SYF_DIR/UserDiscovery/usericonloader.cpp \
+    $$SYF_DIR/UserDiscovery/usericonpack.cpp \
+    $$SYF_DIR/UserDiscovery/users.cpp \
+    $$SYF_DIR/UserDiscovery/userstore.cpp \
+    $$SYF_DIR/FileTransfer/fileinfo.cpp \
+    $$SYF_DIR/FileTransfer/fileintransfer.cpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolcommon.cpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolreceiver.cpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolsender.cpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolserver.cpp \
+    $$SYF_DIR/FileTransfer/transferhistory.cpp \
+    $$SYF_DIR/FileTransfer/transferinfo.cpp \
+    $$SYF_DIR/FileTransfer/transferlist.cpp \
+    $$SYF_DIR/Gui/Wrappers/duplicatedfilemodel.cpp \
+    $$SYF_DIR/Gui/Wrappers/transferfilesmodel.cpp \
+    $$SYF_DIR/Gui/Wrappers/transferrequestmodel.cpp \
+    $$SYF_DIR/Gui/Wrappers/transferresponsemodel.cpp \
+    $$SYF_DIR/Gui/Wrappers/transfersmodel.cpp
+
+HEADERS += \
+    benchmarkcounters.hpp \
+    fileinfobenchmark.hpp \
+    peerslistbenchmark.hpp \
+    syfddatagrambenchmark.hpp \
+    syfdratelimiterbenchmark.hpp \
+    transferlistbenchmark.hpp \
+    transfersmodelbenchmark.hpp \
+    $$SYF_DIR/Common/coalescedtimer.hpp \
+    $$SYF_DIR/Common/common.hpp \
+    $$SYF_DIR/Common/logging.hpp \
+    $$SYF_DIR/Common/threadpool.hpp \
+    $$SYF_DIR/UserDiscovery/receptionpolicy.hpp \
+    $$SYF_DIR/UserDiscovery/receptionpreferences.hpp \
+    $$SYF_DIR/UserDiscovery/syfddatagram.hpp \
+    $$SYF_DIR/UserDiscovery/syfddatagramview.hpp \
+    $$SYF_DIR/UserDiscovery/syfdratelimiter.hpp \
+    $$SYF_DIR/UserDiscovery/syfitprotocol.hpp \
+    $$SYF_DIR/UserDiscovery/syfitscheduler.hpp \
+    $$SYF_DIR/UserDiscovery/user.hpp \
+    $$SYF_DIR/UserDiscovery/usericon.hpp \
+    $$SYF_DIR/UserDiscovery/usericoncache.hpp \
+    $$SYF_DIR/UserDiscovery/usericonloader.hpp \
+    $$SYF_DIR/UserDiscovery/usericonpack.hpp \
+    $$SYF_DIR/UserDiscovery/userinfo.hpp \
+    $$SYF_DIR/UserDiscovery/users.hpp \
+    $$SYF_DIR/UserDiscovery/userstore.hpp \
+    $$SYF_DIR/FileTransfer/fileinfo.hpp \
+    $$SYF_DIR/FileTransfer/fileintransfer.hpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolcommon.hpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolreceiver.hpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolsender.hpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolserver.hpp \
+    $$SYF_DIR/FileTransfer/transferhistory.hpp \
+    $$SYF_DIR/FileTransfer/transferinfo.hpp \
+    $$SYF_DIR/FileTransfer/transferlist.hpp \
+    $$SYF_DIR/Gui/Wrappers/duplicatedfilemodel.hpp \
+    $$SYF_DIR/Gui/Wrappers/transferfilesmodel.hpp \
+    $$SYF_DIR/Gui/Wrappers/transferrequestmodel.hpp \
+    $$SYF_DIR/Gui/Wrappers/transferresponsemodel.hpp \
+    $$SYF_DIR/Gui/Wrappers/transfersmodel.hpp
+
+# CuteLogger library
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../../CuteLogger/release/ -lCuteLogger
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../../CuteLogger/debug/ -lCuteLogger
+else:unix: LIBS += -L$$OUT_PWD/../../CuteLogger/ -lCuteLogger
+
+INCLUDEPATH += $$PWD/../../CuteLogger/include
+DEPENDPATH += $$PWD/../../CuteLogger/include
@@ -0,0 +1,106 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "benchmarkcounters.hpp"
+
+#include <QtGlobal>
+
+#include <cstdlib>
+
+#if defined(__GLIBC__)
+
+/// \brief The number of allocations performed by the current thread.
+static thread_local quint64 threadAllocations = 0;
+
+// The functions of the GNU C library are replaced by the ones defined here
+// (which take precedence being part of the executable), and the original
+// implementations are reached through their internal aliases; the exception
+// specification must match the one of the declarations in <cstdlib>
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size) __THROW
+{
+    threadAllocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) __THROW
+{
+    threadAllocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) __THROW
+{
+    threadAllocations++;
+    return __libc_realloc(pointer, size);
+}
+}
+
+#endif
+
+///
+/// The timer is started immediately, hence the time reported includes also the
+/// (negligible) overhead introduced by QBENCHMARK between the iterations.
+///
+BenchmarkCounters::BenchmarkCounters() : m_operations(0), m_allocations(0)
+{
+    m_timer.start();
+}
+
+///
+/// The values are printed through qInfo(), hence they are shown by QtTest
+/// next to the name of the current function and data row.
+///
+void BenchmarkCounters::report() const
+{
+    if (m_operations == 0) {
+        return;
+    }
+
+    double nsPerOp = static_cast<double>(m_timer.nsecsElapsed()) / m_operations;
+    if (!allocationsSupported()) {
+        qInfo("%.1f ns/op", nsPerOp);
+        return;
+    }
+
+    double allocsPerOp = static_cast<double>(m_allocations) / m_operations;
+    qInfo("%.1f ns/op, %.2f allocs/op", nsPerOp, allocsPerOp);
+}
+
+quint64 BenchmarkCounters::allocations()
+{
+#if defined(__GLIBC__)
+    return threadAllocations;
+#else
+    return 0;
+#endif
+}
+
+bool BenchmarkCounters::allocationsSupported()
+{
+#if defined(__GLIBC__)
+    return true;
+#else
+    return false;
+#endif
+}
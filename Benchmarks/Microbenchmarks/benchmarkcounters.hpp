@@ -0,0 +1,104 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef BENCHMARKCOUNTERS_HPP
+#define BENCHMARKCOUNTERS_HPP
+
+#include <QElapsedTimer>
+
+///
+/// \brief The BenchmarkCounters class measures the average time and the
+/// average number of memory allocations per operation of a benchmark.
+///
+/// QBENCHMARK reports the time per iteration in the unit of the selected
+/// backend, and does not count the memory allocations. An instance of this
+/// class is therefore created before QBENCHMARK and a Scope is declared in
+/// its body, around the measured code: report() then prints the time in
+/// nanoseconds and the allocations per operation as an additional message.
+///
+/// The allocations are counted by intercepting malloc(), calloc() and
+/// realloc(), which are used both by operator new and by the Qt containers;
+/// this is currently supported only with the GNU C library, while elsewhere
+/// only the time is reported. Only the allocations performed by the current
+/// thread are counted.
+///
+class BenchmarkCounters
+{
+public:
+    ///
+    /// \brief The Scope class delimits the code of a benchmark iteration.
+    ///
+    class Scope
+    {
+    public:
+        ///
+        /// \brief Starts counting the allocations.
+        /// \param counters the instance where the results are accumulated.
+        /// \param operations the number of operations performed by the
+        /// iteration.
+        ///
+        explicit Scope(BenchmarkCounters &counters, quint64 operations = 1)
+                : m_counters(counters),
+                  m_allocations(BenchmarkCounters::allocations())
+        {
+            m_counters.m_operations += operations;
+        }
+
+        ///
+        /// \brief Stops counting the allocations.
+        ///
+        ~Scope()
+        {
+            m_counters.m_allocations +=
+                BenchmarkCounters::allocations() - m_allocations;
+        }
+
+    private:
+        BenchmarkCounters &m_counters; ///< \brief The destination instance.
+        quint64 m_allocations; ///< \brief The allocations at the beginning.
+    };
+
+    ///
+    /// \brief Constructs a new instance and starts measuring the time.
+    ///
+    explicit BenchmarkCounters();
+
+    ///
+    /// \brief Prints the time and the allocations per operation.
+    ///
+    void report() const;
+
+    ///
+    /// \brief Returns the number of allocations performed by the current
+    /// thread since its start.
+    ///
+    static quint64 allocations();
+
+    ///
+    /// \brief Returns whether the allocations can be counted or not.
+    ///
+    static bool allocationsSupported();
+
+private:
+    QElapsedTimer m_timer;   ///< \brief The timer started at construction.
+    quint64 m_operations;    ///< \brief The number of operations performed.
+    quint64 m_allocations;   ///< \brief The number of allocations performed.
+};
+
+#endif // BENCHMARKCOUNTERS_HPP
@@ -0,0 +1,195 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "fileinfobenchmark.hpp"
+#include "FileTransfer/fileinfo.hpp"
+#include "FileTransfer/syfftprotocolreceiver.hpp"
+#include "benchmarkcounters.hpp"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QMutex>
+#include <QVector>
+#include <QtTest>
+
+///
+/// \brief The SyfftCommands class exposes the definitions of the commands
+/// used by the SYFFT protocol and the functions decoding them (never
+/// instantiated).
+///
+class SyfftCommands : public SyfftProtocolReceiver
+{
+public:
+    using SyfftProtocolReceiver::Command;
+    using SyfftProtocolReceiver::CommandType;
+    using SyfftProtocolReceiver::ReadResult;
+    using SyfftProtocolReceiver::readCommand;
+    using SyfftProtocolReceiver::readItem;
+};
+
+///
+/// \brief Configures a QDataStream as done by SyfftProtocolCommon.
+/// \param stream the stream to be configured.
+///
+static void setupStream(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Version::Qt_5_0);
+    stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+}
+
+///
+/// The list is composed by files spread in different directories, each one
+/// preceded by the ITEM command code.
+///
+void FileInfoBenchmark::initTestCase()
+{
+    QBuffer buffer(&m_items);
+    buffer.open(QIODevice::WriteOnly);
+    QDataStream stream(&buffer);
+    setupStream(stream);
+
+    QDateTime lastModified = QDateTime::currentDateTime();
+    for (int i = 0; i < ITEMS; i++) {
+        FileInfo file(QString("Directory %1/Subdirectory/File %2.dat")
+                          .arg(i / 100)
+                          .arg(i),
+                      static_cast<quint64>(i) * 4096, lastModified);
+        QVERIFY(file.valid());
+
+        stream << static_cast<SyfftCommands::CommandType>(
+            SyfftCommands::Command::ITEM);
+        stream << file;
+    }
+}
+
+///
+/// The instance is written to a buffer whose memory is reused, as it happens
+/// with the socket of the SYFFT protocol.
+///
+void FileInfoBenchmark::write()
+{
+    QFETCH(QString, path);
+
+    FileInfo file(path, Q_UINT64_C(123456789), QDateTime::currentDateTime());
+    QVERIFY(file.valid());
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QDataStream stream(&buffer);
+    setupStream(stream);
+
+    // Reserve the memory in advance
+    stream << file;
+
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters);
+        buffer.seek(0);
+        stream << file;
+    }
+    counters.report();
+    QVERIFY(stream.status() == QDataStream::Status::Ok);
+}
+
+///
+/// The instance is written once to a buffer and then repeatedly read.
+///
+void FileInfoBenchmark::read()
+{
+    QFETCH(QString, path);
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    QDataStream writer(&buffer);
+    setupStream(writer);
+    writer << FileInfo(path, Q_UINT64_C(123456789),
+                       QDateTime::currentDateTime());
+    buffer.close();
+
+    buffer.open(QIODevice::ReadOnly);
+    QDataStream stream(&buffer);
+    setupStream(stream);
+
+    FileInfo file;
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters);
+        buffer.seek(0);
+        stream >> file;
+    }
+    counters.report();
+    QVERIFY(file.valid());
+    QCOMPARE(file.filePath(), path);
+}
+
+///
+/// Each iteration builds a new list, as SyfftProtocolReceiver does for each
+/// connection, through the same functions used to decode the commands
+/// received (the mutex protecting the list is locked for every insertion).
+///
+void FileInfoBenchmark::parseItems()
+{
+    QBuffer buffer(&m_items);
+    buffer.open(QIODevice::ReadOnly);
+    QDataStream stream(&buffer);
+    setupStream(stream);
+
+    QMutex mutex;
+    QVector<FileInfo> files;
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters, ITEMS);
+        buffer.seek(0);
+        files = QVector<FileInfo>();
+
+        while (!stream.atEnd()) {
+            SyfftCommands::CommandType command;
+            if (!SyfftCommands::readCommand(stream, command)) {
+                break;
+            }
+            if (command != SyfftCommands::Command::ITEM) {
+                stream.abortTransaction();
+                break;
+            }
+
+            if (SyfftCommands::readItem(stream, files, mutex) !=
+                SyfftCommands::ReadResult::Ok) {
+                break;
+            }
+        }
+    }
+    counters.report();
+    QCOMPARE(files.count(), static_cast<int>(ITEMS));
+}
+
+///
+/// The data table is composed by a single column, containing the relative
+/// path of the file.
+///
+void FileInfoBenchmark::addPaths()
+{
+    QTest::addColumn<QString>("path");
+
+    QTest::newRow("short") << QString("File.txt");
+    QTest::newRow("nested")
+        << QString("Documents/Projects/ShareYourFiles/Sources/main.cpp");
+    QTest::newRow("non-ascii")
+        << QString::fromUtf8("Fotografie/Città/Perché è così.jpg");
+}
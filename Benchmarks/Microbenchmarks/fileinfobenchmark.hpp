@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FILEINFOBENCHMARK_HPP
+#define FILEINFOBENCHMARK_HPP
+
+#include <QByteArray>
+#include <QObject>
+
+///
+/// \brief The FileInfoBenchmark class measures the cost of serializing the
+/// FileInfo instances, both alone and as part of the list of files sent with
+/// a sharing request.
+///
+/// The list of files is parsed through the same sequence of operations
+/// performed by SyfftProtocolReceiver for each ITEM command (stream
+/// transaction, command code, FileInfo and insertion in the list), reading
+/// from a memory buffer instead of from the socket.
+///
+class FileInfoBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    ///
+    /// \brief Generates the list of files used by parseItems().
+    ///
+    void initTestCase();
+
+    /// \brief Provides the paths to write().
+    void write_data() { addPaths(); }
+    /// \brief Writes a FileInfo to a QDataStream (operator<<()).
+    void write();
+
+    /// \brief Provides the paths to read().
+    void read_data() { addPaths(); }
+    /// \brief Reads a FileInfo from a QDataStream (operator>>()).
+    void read();
+
+    ///
+    /// \brief Parses the ITEM commands following a sharing request (the time
+    /// and the allocations are reported per item).
+    ///
+    void parseItems();
+
+private:
+    ///
+    /// \brief Adds the paths to the data table of the current benchmark.
+    ///
+    void addPaths();
+
+    /// \brief The ITEM commands describing the list of files.
+    QByteArray m_items;
+
+    /// \brief The number of files in the list.
+    static const int ITEMS = 1000;
+};
+
+#endif // FILEINFOBENCHMARK_HPP
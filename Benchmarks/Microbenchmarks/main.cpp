@@ -0,0 +1,68 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Common/threadpool.hpp"
+#include "fileinfobenchmark.hpp"
+#include "peerslistbenchmark.hpp"
+#include "syfddatagrambenchmark.hpp"
+#include "syfdratelimiterbenchmark.hpp"
+#include "transferlistbenchmark.hpp"
+#include "transfersmodelbenchmark.hpp"
+
+#include <QCoreApplication>
+#include <QtTest>
+
+///
+/// \brief The entry point of the microbenchmarks.
+///
+/// All the benchmark classes are executed in sequence, forwarding them the
+/// command line arguments (e.g. to select the output format or the subset of
+/// functions to be executed). Each function reports, in addition to the
+/// QBENCHMARK result, the time and the memory allocations per operation.
+///
+/// The worker threads are started since they are needed by PeersList.
+///
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    ThreadPool::createInstance();
+
+    int status = 0;
+
+    SyfdDatagramBenchmark syfdDatagram;
+    status |= QTest::qExec(&syfdDatagram, argc, argv);
+
+    SyfdRateLimiterBenchmark syfdRateLimiter;
+    status |= QTest::qExec(&syfdRateLimiter, argc, argv);
+
+    FileInfoBenchmark fileInfo;
+    status |= QTest::qExec(&fileInfo, argc, argv);
+
+    TransferListBenchmark transferList;
+    status |= QTest::qExec(&transferList, argc, argv);
+
+    PeersListBenchmark peersList;
+    status |= QTest::qExec(&peersList, argc, argv);
+
+    TransfersModelBenchmark transfersModel;
+    status |= QTest::qExec(&transfersModel, argc, argv);
+
+    ThreadPool::destroyInstance();
+    return status;
+}
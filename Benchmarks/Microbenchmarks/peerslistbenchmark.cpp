@@ -0,0 +1,190 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "peerslistbenchmark.hpp"
+#include "UserDiscovery/syfddatagram.hpp"
+#include "UserDiscovery/syfddatagramview.hpp"
+#include "UserDiscovery/user.hpp"
+#include "UserDiscovery/users.hpp"
+#include "benchmarkcounters.hpp"
+#include "syfddatagrambenchmark.hpp"
+
+#include <QDir>
+#include <QtTest>
+
+///
+/// The instance is initialized without performing any operation.
+///
+PeersListBenchmark::PeersListBenchmark() : m_lists(0) {}
+
+///
+/// The local user is destroyed automatically.
+///
+PeersListBenchmark::~PeersListBenchmark() {}
+
+///
+/// The local user is created from scratch, and associated to the loopback
+/// address (no server is started).
+///
+void PeersListBenchmark::initTestCase()
+{
+    m_confDir.reset(new QTemporaryDir());
+    QVERIFY(m_confDir->isValid());
+
+    m_localUser.reset(
+        new LocalUser(m_confDir->path(), m_confDir->path(), 0x7F000001));
+    QVERIFY(m_localUser->valid());
+}
+
+void PeersListBenchmark::cleanupTestCase()
+{
+    m_localUser.reset();
+    m_confDir.reset();
+}
+
+///
+/// The heartbeats of the different peers are used in turn, so that the cost
+/// of the lookups is not hidden by the caches; they are dispatched through
+/// their fields, as done by the SyfdProtocol.
+///
+void PeersListBenchmark::heartbeat()
+{
+    QFETCH(int, peers);
+
+    QVector<SyfdDatagram> profiles;
+    QScopedPointer<PeersList> list(createPeersList(peers, profiles));
+
+    QVector<SyfdDatagram> heartbeats;
+    QVector<quint64> prefixKeys;
+    foreach (const SyfdDatagram &profile, profiles) {
+        heartbeats.append(profile.heartbeat());
+        prefixKeys.append(SyfdDatagramView::prefixKey(
+            reinterpret_cast<const uchar *>(
+                heartbeats.last().uuidPrefix().constData())));
+    }
+
+    int requests = 0;
+    connect(list.data(), &PeersList::profileRequested, this,
+            [&requests]() { requests++; });
+
+    int i = 0;
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters);
+        list->updateHeartbeat(prefixKeys.at(i), heartbeats.at(i).sequence(),
+                              false);
+        i = (i + 1) % heartbeats.size();
+    }
+    counters.report();
+    QCOMPARE(requests, 0);
+}
+
+///
+/// The profiles of the different peers are used in turn, so that the cost
+/// of the lookups is not hidden by the caches.
+///
+void PeersListBenchmark::profile()
+{
+    QFETCH(int, peers);
+
+    QVector<SyfdDatagram> profiles;
+    QScopedPointer<PeersList> list(createPeersList(peers, profiles));
+
+    int updates = 0;
+    connect(list.data(), &PeersList::peerUpdated, this,
+            [&updates]() { updates++; });
+
+    int i = 0;
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters);
+        list->update(profiles.at(i));
+        i = (i + 1) % profiles.size();
+    }
+    counters.report();
+    QCOMPARE(updates, 0);
+}
+
+///
+/// The digest summarizes all the peers, up to the maximum number of entries
+/// allowed in a single datagram.
+///
+void PeersListBenchmark::digest()
+{
+    QFETCH(int, peers);
+
+    QVector<SyfdDatagram> profiles;
+    QScopedPointer<PeersList> list(createPeersList(peers, profiles));
+
+    QVector<SyfdDatagram::DigestEntry> entries;
+    for (int i = 0;
+         i < profiles.size() && i < SyfdDatagram::MAX_DIGEST_ENTRIES; i++) {
+        entries.append(SyfdDatagram::DigestEntry(
+            SyfdDatagram::prefixFromUuid(profiles.at(i).uuid()),
+            profiles.at(i).sequence()));
+    }
+    SyfdDatagram digest = SyfdDatagram::digest(entries);
+    QVERIFY(digest.valid());
+
+    int requests = 0;
+    connect(list.data(), &PeersList::profileRequested, this,
+            [&requests]() { requests++; });
+
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters,
+                                      static_cast<quint64>(entries.size()));
+        list->update(digest);
+    }
+    counters.report();
+    QCOMPARE(requests, 0);
+}
+
+///
+/// The data table is composed by a single column, containing the number of
+/// peers.
+///
+void PeersListBenchmark::addPeers()
+{
+    QTest::addColumn<int>("peers");
+
+    QTest::newRow("10 peers") << 10;
+    QTest::newRow("100 peers") << 100;
+    QTest::newRow("1000 peers") << 1000;
+}
+
+///
+/// Each instance uses a different configuration directory, so that the peers
+/// saved by the previous instances are not loaded.
+///
+PeersList *PeersListBenchmark::createPeersList(int peers,
+                                               QVector<SyfdDatagram> &profiles)
+{
+    QString confPath =
+        QDir(m_confDir->path()).filePath(QString("list%1").arg(m_lists++));
+    QDir().mkpath(confPath);
+
+    PeersList *list = new PeersList(confPath, m_localUser.data());
+    for (int i = 0; i < peers; i++) {
+        SyfdDatagram profile(SyfdDatagramBenchmark::buildProfile(false));
+        list->update(profile);
+        profiles.append(profile);
+    }
+    return list;
+}
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PEERSLISTBENCHMARK_HPP
+#define PEERSLISTBENCHMARK_HPP
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+#include <QVector>
+
+class LocalUser;
+class PeersList;
+class SyfdDatagram;
+
+///
+/// \brief The PeersListBenchmark class measures the cost of updating the
+/// PeersList when a datagram is received, depending on the number of peers.
+///
+/// The datagrams considered are the ones received in steady state, i.e. the
+/// heartbeats, the unchanged profiles and the digests referring to peers
+/// already known; all of them are expected to confirm the peers without
+/// requesting their profiles.
+///
+class PeersListBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief Constructs a new instance.
+    ///
+    explicit PeersListBenchmark();
+
+    ///
+    /// \brief Destroys the instance.
+    ///
+    ~PeersListBenchmark();
+
+private slots:
+    ///
+    /// \brief Creates the local user.
+    ///
+    void initTestCase();
+
+    ///
+    /// \brief Destroys the local user.
+    ///
+    void cleanupTestCase();
+
+    /// \brief Provides the number of peers to heartbeat().
+    void heartbeat_data() { addPeers(); }
+    /// \brief Updates the list with the heartbeat of a peer.
+    void heartbeat();
+
+    /// \brief Provides the number of peers to profile().
+    void profile_data() { addPeers(); }
+    /// \brief Updates the list with the unchanged profile of a peer.
+    void profile();
+
+    /// \brief Provides the number of peers to digest().
+    void digest_data() { addPeers(); }
+    ///
+    /// \brief Updates the list with a digest (the time and the allocations are
+    /// reported per entry).
+    ///
+    void digest();
+
+private:
+    ///
+    /// \brief Adds the number of peers to the data table of the current
+    /// benchmark.
+    ///
+    void addPeers();
+
+    ///
+    /// \brief Creates a new PeersList (with its own configuration directory)
+    /// and adds the requested number of peers.
+    /// \param peers the number of peers to be added.
+    /// \param profiles the vector filled with the profiles of the peers.
+    /// \return the new instance.
+    ///
+    PeersList *createPeersList(int peers, QVector<SyfdDatagram> &profiles);
+
+    /// \brief The directory containing the configuration files.
+    QScopedPointer<QTemporaryDir> m_confDir;
+    /// \brief The instance representing the local user.
+    QScopedPointer<LocalUser> m_localUser;
+    /// \brief The number of PeersList instances created.
+    int m_lists;
+};
+
+#endif // PEERSLISTBENCHMARK_HPP
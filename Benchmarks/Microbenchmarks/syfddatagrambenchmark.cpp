@@ -0,0 +1,190 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "syfddatagrambenchmark.hpp"
+#include "benchmarkcounters.hpp"
+#include "UserDiscovery/syfddatagram.hpp"
+#include "UserDiscovery/syfddatagramview.hpp"
+
+#include <QDataStream>
+#include <QUuid>
+#include <QtTest>
+
+///
+/// The profiles are built by hand, while the heartbeat and the digest are
+/// generated through the SyfdDatagram class. All the datagrams are checked
+/// to be accepted by both the decoders.
+///
+void SyfdDatagramBenchmark::initTestCase()
+{
+    m_profile = buildProfile(false);
+    m_profileIcon = buildProfile(true);
+    m_heartbeat = SyfdDatagram(m_profile).heartbeat(true).toByteArray();
+
+    QVector<SyfdDatagram::DigestEntry> entries;
+    for (int i = 0; i < SyfdDatagram::MAX_DIGEST_ENTRIES; i++) {
+        entries.append(SyfdDatagram::DigestEntry(
+            SyfdDatagram::prefixFromUuid(QUuid::createUuid().toString()),
+            static_cast<quint32>(i)));
+    }
+    m_digest = SyfdDatagram::digest(entries).toByteArray();
+
+    QList<QByteArray> datagrams = {m_profile, m_profileIcon, m_heartbeat,
+                                   m_digest};
+    foreach (const QByteArray &data, datagrams) {
+        SyfdDatagramView view;
+        QVERIFY(view.decode(data.constData(), data.size()));
+        QVERIFY(SyfdDatagram(data).valid());
+        QCOMPARE(SyfdDatagram(view).toByteArray(), data);
+    }
+}
+
+///
+/// The same steps performed by SyfdDatagram before the introduction of the
+/// SyfdDatagramView are repeated: the stream is built and the datagram is
+/// read through operator>>().
+///
+void SyfdDatagramBenchmark::decodeStream()
+{
+    QFETCH(QByteArray, data);
+
+    bool valid = false;
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters);
+        QDataStream stream(data);
+        stream.setVersion(QDataStream::Version::Qt_5_0);
+        stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+
+        SyfdDatagram datagram;
+        stream >> datagram;
+        valid = datagram.valid();
+    }
+    counters.report();
+    QVERIFY(valid);
+}
+
+///
+/// Only the validation and the decoding of the fixed-size fields are measured.
+///
+void SyfdDatagramBenchmark::decodeView()
+{
+    QFETCH(QByteArray, data);
+
+    SyfdDatagramView view;
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters);
+        view.decode(data.constData(), data.size());
+    }
+    counters.report();
+    QVERIFY(view.valid());
+}
+
+///
+/// The decoding is followed by the copy of all the fields to a SyfdDatagram,
+/// i.e. the work performed when a profile actually changed.
+///
+void SyfdDatagramBenchmark::decodeViewConvert()
+{
+    QFETCH(QByteArray, data);
+
+    bool valid = false;
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters);
+        SyfdDatagramView view;
+        view.decode(data.constData(), data.size());
+        valid = SyfdDatagram(view).valid();
+    }
+    counters.report();
+    QVERIFY(valid);
+}
+
+///
+/// The datagram is decoded once and then repeatedly converted to bytes.
+///
+void SyfdDatagramBenchmark::encode()
+{
+    QFETCH(QByteArray, data);
+
+    SyfdDatagram datagram(data);
+    QByteArray result;
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters);
+        result = datagram.toByteArray();
+    }
+    counters.report();
+    QCOMPARE(result, data);
+}
+
+///
+/// The data table is composed by a single column, containing the datagram.
+///
+void SyfdDatagramBenchmark::addDatagrams()
+{
+    QTest::addColumn<QByteArray>("data");
+
+    QTest::newRow("profile") << m_profile;
+    QTest::newRow("profile (icon)") << m_profileIcon;
+    QTest::newRow("heartbeat") << m_heartbeat;
+    QTest::newRow("digest") << m_digest;
+}
+
+///
+/// The fields are written through a QDataStream according to the version 2.0
+/// of the SyfdDatagram format, using names of the maximum length allowed.
+///
+QByteArray SyfdDatagramBenchmark::buildProfile(bool icon)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Version::Qt_5_0);
+    stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+
+    // Header
+    stream << static_cast<quint8>('S') << static_cast<quint8>('Y')
+           << static_cast<quint8>('F') << static_cast<quint8>('D');
+    stream << static_cast<quint8>(2) << static_cast<quint8>(icon ? 0x2 : 0x0)
+           << static_cast<quint8>(SyfdDatagram::Type::Profile)
+           << static_cast<quint8>(0);
+
+    // UUID and profile sequence
+    QByteArray uuid = QUuid::createUuid().toRfc4122();
+    stream.writeRawData(uuid.constData(), uuid.length());
+    stream << static_cast<quint32>(1);
+
+    // Names
+    stream << QString(SyfdDatagram::STRING_LEN, QChar('F'));
+    stream << QString(SyfdDatagram::STRING_LEN, QChar('L'));
+
+    // IP and ports
+    stream << static_cast<quint32>(0xC0A80001);
+    stream << static_cast<quint16>(10102);
+    stream << static_cast<quint16>(icon ? 10103 : 0);
+
+    // Icon hash
+    if (icon) {
+        QByteArray hash(SyfdDatagram::HASH_LEN, '\x5A');
+        stream.writeRawData(hash.constData(), hash.length());
+    }
+
+    return data;
+}
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SYFDDATAGRAMBENCHMARK_HPP
+#define SYFDDATAGRAMBENCHMARK_HPP
+
+#include <QByteArray>
+#include <QObject>
+
+///
+/// \brief The SyfdDatagramBenchmark class measures the cost of encoding and
+/// decoding the different types of SyfdDatagram.
+///
+/// The decoding is measured both through the QDataStream based operator>>()
+/// and through the SyfdDatagramView, with and without the conversion to a
+/// complete SyfdDatagram, in order to compare the two implementations.
+///
+class SyfdDatagramBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief Builds a profile according to the SyfdDatagram format, with a
+    /// new random UUID.
+    /// \param icon specifies whether the icon information is included.
+    /// \return the array of bytes representing the profile.
+    ///
+    static QByteArray buildProfile(bool icon);
+
+private slots:
+    ///
+    /// \brief Generates the datagrams used by the benchmarks.
+    ///
+    void initTestCase();
+
+    /// \brief Provides the datagrams to decodeStream().
+    void decodeStream_data() { addDatagrams(); }
+    /// \brief Decodes a datagram through a QDataStream.
+    void decodeStream();
+
+    /// \brief Provides the datagrams to decodeView().
+    void decodeView_data() { addDatagrams(); }
+    /// \brief Decodes a datagram through a SyfdDatagramView.
+    void decodeView();
+
+    /// \brief Provides the datagrams to decodeViewConvert().
+    void decodeViewConvert_data() { addDatagrams(); }
+    /// \brief Decodes a datagram through a SyfdDatagramView and converts it to
+    /// a complete SyfdDatagram.
+    void decodeViewConvert();
+
+    /// \brief Provides the datagrams to encode().
+    void encode_data() { addDatagrams(); }
+    /// \brief Encodes a datagram to an array of bytes.
+    void encode();
+
+private:
+    ///
+    /// \brief Adds the datagrams to the data table of the current benchmark.
+    ///
+    void addDatagrams();
+
+    QByteArray m_profile;     ///< \brief Profile without icon.
+    QByteArray m_profileIcon; ///< \brief Profile with icon.
+    QByteArray m_heartbeat;   ///< \brief Heartbeat.
+    QByteArray m_digest;      ///< \brief Digest with the maximum entries.
+};
+
+#endif // SYFDDATAGRAMBENCHMARK_HPP
@@ -0,0 +1,128 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "syfdratelimiterbenchmark.hpp"
+#include "UserDiscovery/syfdratelimiter.hpp"
+#include "benchmarkcounters.hpp"
+
+#include <QtTest>
+
+///
+/// The data table is composed by a single column, containing the number of
+/// peers (i.e. of sources).
+///
+void SyfdRateLimiterBenchmark::admit_data()
+{
+    QTest::addColumn<int>("peers");
+
+    QTest::newRow("10 peers") << 10;
+    QTest::newRow("100 peers") << 100;
+    QTest::newRow("1000 peers") << 1000;
+}
+
+///
+/// The result of the admission is not checked, since the sources are used at
+/// a rate much higher than the one allowed.
+///
+void SyfdRateLimiterBenchmark::admit()
+{
+    QFETCH(int, peers);
+
+    SyfdRateLimiter limiter;
+    limiter.setPeers(peers);
+
+    quint32 i = 0;
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters);
+        limiter.admit(SyfdRateLimiterBenchmark::FIRST_ADDRESS + i);
+        i = (i + 1) % static_cast<quint32>(peers);
+    }
+    counters.report();
+}
+
+///
+/// Each scenario is characterized by the number of peers answering, whether
+/// they are already known and whether the solicitation has been sent by the
+/// local host.
+///
+void SyfdRateLimiterBenchmark::solicitationAnswers_data()
+{
+    QTest::addColumn<int>("peers");
+    QTest::addColumn<bool>("known");
+    QTest::addColumn<bool>("local");
+
+    QTest::newRow("100 known peers") << 100 << true << false;
+    QTest::newRow("1000 known peers") << 1000 << true << false;
+    QTest::newRow("10000 known peers") << 10000 << true << false;
+    QTest::newRow("10000 unknown peers (local solicitation)")
+        << 10000 << false << true;
+}
+
+///
+/// Every peer sends its profile at once, which is the worst case of the
+/// answers spread over the random delay.
+///
+void SyfdRateLimiterBenchmark::solicitationAnswers()
+{
+    QFETCH(int, peers);
+    QFETCH(bool, known);
+    QFETCH(bool, local);
+
+    SyfdRateLimiter limiter;
+    limiter.setPeers(known ? peers : 0);
+    if (local) {
+        limiter.solicitationSent(SyfdRateLimiterBenchmark::SOLICIT_WINDOW);
+    }
+
+    int admitted = 0;
+    for (int i = 0; i < peers; i++) {
+        if (limiter.admit(SyfdRateLimiterBenchmark::FIRST_ADDRESS +
+                          static_cast<quint32>(i))) {
+            admitted++;
+        }
+    }
+
+    QCOMPARE(admitted, peers);
+    QVERIFY(limiter.droppedBySource() == 0);
+    QVERIFY(limiter.droppedGlobally() == 0);
+}
+
+///
+/// The same burst of the previous test, received from unknown sources without
+/// a local solicitation, is limited (the sources exceeding the ones tracked
+/// separately share a single bucket).
+///
+void SyfdRateLimiterBenchmark::storm()
+{
+    const int sources = 10000;
+
+    SyfdRateLimiter limiter;
+    int admitted = 0;
+    for (int i = 0; i < sources; i++) {
+        if (limiter.admit(SyfdRateLimiterBenchmark::FIRST_ADDRESS +
+                          static_cast<quint32>(i))) {
+            admitted++;
+        }
+    }
+
+    QVERIFY(admitted < sources);
+    QVERIFY(limiter.droppedBySource() + limiter.droppedGlobally() > 0);
+}
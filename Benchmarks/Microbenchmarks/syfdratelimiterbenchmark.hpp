@@ -0,0 +1,64 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef SYFDRATELIMITERBENCHMARK_HPP
+#define SYFDRATELIMITERBENCHMARK_HPP
+
+#include <QObject>
+
+///
+/// \brief The SyfdRateLimiterBenchmark class measures the cost of admitting a
+/// SYFD datagram, and verifies that the limits do not drop the legitimate
+/// traffic.
+///
+/// The legitimate traffic considered is the burst of profiles sent by all the
+/// peers answering a solicitation, which must be entirely admitted both when
+/// the peers are already known and when they are not (i.e. in case of a
+/// solicitation sent by the local host at startup).
+///
+class SyfdRateLimiterBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /// \brief Provides the number of peers to admit().
+    void admit_data();
+    /// \brief Admits a datagram, with the sources used in turn.
+    void admit();
+
+    /// \brief Provides the scenarios to solicitationAnswers().
+    void solicitationAnswers_data();
+    /// \brief Verifies that all the answers to a solicitation are admitted.
+    void solicitationAnswers();
+
+    ///
+    /// \brief Verifies that the limits are still enforced outside the
+    /// solicitation window.
+    ///
+    void storm();
+
+private:
+    /// \brief The address of the first simulated peer.
+    static const quint32 FIRST_ADDRESS = 0x0A000001;
+    /// \brief The duration of the solicitation window (ms).
+    static const int SOLICIT_WINDOW = 2000;
+};
+
+#endif // SYFDRATELIMITERBENCHMARK_HPP
@@ -0,0 +1,115 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "transferlistbenchmark.hpp"
+#include "FileTransfer/transferlist.hpp"
+#include "benchmarkcounters.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QtTest>
+
+///
+/// Two trees of 1000 files are generated: the first one with all the files in
+/// the same directory, the second one with a file in each leaf of a tree of
+/// depth 3.
+///
+void TransferListBenchmark::initTestCase()
+{
+    QString base;
+#ifdef Q_OS_LINUX
+    if (QFileInfo(QStringLiteral("/dev/shm")).isWritable()) {
+        base = QStringLiteral("/dev/shm/SYFMicrobenchmarks-XXXXXX");
+    }
+#endif
+    m_dir.reset((base.isEmpty()) ? new QTemporaryDir()
+                                 : new QTemporaryDir(base));
+    QVERIFY(m_dir->isValid());
+
+    QVERIFY(generateTree(m_dir->filePath("flat"), 0, 1000));
+    QVERIFY(generateTree(m_dir->filePath("tree"), 3, 1));
+}
+
+void TransferListBenchmark::cleanupTestCase()
+{
+    m_dir.reset();
+}
+
+///
+/// The data table is composed by the path of the root of the tree and by the
+/// number of files it contains.
+///
+void TransferListBenchmark::build_data()
+{
+    QTest::addColumn<QString>("path");
+    QTest::addColumn<int>("files");
+
+    QTest::newRow("flat") << m_dir->filePath("flat") << 1000;
+    QTest::newRow("tree") << m_dir->filePath("tree") << 1000;
+}
+
+///
+/// The list is built from the path of the root of the tree, as done when the
+/// directory is selected by the user.
+///
+void TransferListBenchmark::build()
+{
+    QFETCH(QString, path);
+    QFETCH(int, files);
+
+    quint32 totalFiles = 0;
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters, static_cast<quint64>(files));
+        TransferList list(QStringList{path});
+        totalFiles = list.totalFiles();
+    }
+    counters.report();
+    QCOMPARE(totalFiles, static_cast<quint32>(files));
+}
+
+///
+/// The tree is generated recursively: each directory contains FANOUT
+/// subdirectories, until the requested depth is reached.
+///
+bool TransferListBenchmark::generateTree(const QString &path, int depth,
+                                         int files)
+{
+    if (!QDir().mkpath(path)) {
+        return false;
+    }
+
+    if (depth > 0) {
+        for (int i = 0; i < FANOUT; i++) {
+            if (!generateTree(QString("%1/Directory %2").arg(path).arg(i),
+                              depth - 1, files)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    for (int i = 0; i < files; i++) {
+        QFile file(QString("%1/File %2.dat").arg(path).arg(i));
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,76 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TRANSFERLISTBENCHMARK_HPP
+#define TRANSFERLISTBENCHMARK_HPP
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+
+///
+/// \brief The TransferListBenchmark class measures the cost of building a
+/// TransferList from the paths selected by the user.
+///
+/// TransferList explores the file system through QFileInfo and QDir, hence
+/// the trees are generated in a temporary directory, located in memory when
+/// possible (i.e. /dev/shm on Linux): the time measured then refers to the
+/// enumeration only and not to the accesses to the disk.
+///
+class TransferListBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    ///
+    /// \brief Generates the trees used by the benchmarks.
+    ///
+    void initTestCase();
+
+    ///
+    /// \brief Removes the trees used by the benchmarks.
+    ///
+    void cleanupTestCase();
+
+    /// \brief Provides the trees to build().
+    void build_data();
+    ///
+    /// \brief Builds a TransferList from the root of a tree (the time and the
+    /// allocations are reported per file).
+    ///
+    void build();
+
+private:
+    ///
+    /// \brief Generates a tree of empty files.
+    /// \param path the root of the tree.
+    /// \param depth the number of levels of subdirectories.
+    /// \param files the number of files in each leaf directory.
+    /// \return true in case of success and false otherwise.
+    ///
+    static bool generateTree(const QString &path, int depth, int files);
+
+    /// \brief The directory containing the trees.
+    QScopedPointer<QTemporaryDir> m_dir;
+
+    /// \brief The number of subdirectories per directory.
+    static const int FANOUT = 10;
+};
+
+#endif // TRANSFERLISTBENCHMARK_HPP
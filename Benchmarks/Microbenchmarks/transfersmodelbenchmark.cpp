@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "transfersmodelbenchmark.hpp"
+#include "FileTransfer/transferhistory.hpp"
+#include "Gui/Wrappers/transfersmodel.hpp"
+#include "UserDiscovery/syfddatagram.hpp"
+#include "UserDiscovery/user.hpp"
+#include "UserDiscovery/users.hpp"
+#include "benchmarkcounters.hpp"
+#include "syfddatagrambenchmark.hpp"
+
+#include <QDir>
+#include <QUuid>
+#include <QtTest>
+
+#include <algorithm>
+
+///
+/// The instance is initialized without performing any operation.
+///
+TransfersModelBenchmark::TransfersModelBenchmark() {}
+
+///
+/// The model is destroyed before the objects it depends on.
+///
+TransfersModelBenchmark::~TransfersModelBenchmark() {}
+
+///
+/// The records alternate between sent and received transfers, and between
+/// closed and aborted ones.
+///
+void TransfersModelBenchmark::initTestCase()
+{
+    m_confDir.reset(new QTemporaryDir());
+    QVERIFY(m_confDir->isValid());
+
+    m_localUser.reset(
+        new LocalUser(m_confDir->path(), m_confDir->path(), 0x7F000001));
+    QVERIFY(m_localUser->valid());
+
+    // Add the known peers
+    m_peersList.reset(new PeersList(m_confDir->path(), m_localUser.data()));
+    QStringList peers;
+    for (int i = 0; i < PEERS; i++) {
+        SyfdDatagram profile(SyfdDatagramBenchmark::buildProfile(false));
+        m_peersList->update(profile);
+        peers.append(profile.uuid());
+    }
+
+    // Write the history
+    QList<TransferRecord> records;
+    for (int i = 0; i < TransferHistory::MAX_RECORDS; i++) {
+        TransferRecord record;
+        record.sender = (i % 2 == 0);
+        record.status = (i % 4 < 2) ? SyfftProtocolCommon::Status::Closed
+                                    : SyfftProtocolCommon::Status::Aborted;
+        if (i < PEERS) {
+            record.peerUuid = peers.at(i);
+        } else {
+            record.peerUuid = QUuid::createUuid().toString();
+            record.names = QString("First %1 Last %1").arg(i);
+        }
+        if (record.status == SyfftProtocolCommon::Status::Aborted) {
+            for (int j = 0; j < TRANSFER_FILES; j++) {
+                FileInfo file(QString("dir/file-%1").arg(j), 1024,
+                              QDateTime());
+                file.setStatus(FileInfo::Status::TransferFailed);
+                record.files.append(file);
+            }
+        }
+        records.append(record);
+    }
+
+    QString historyPath = QDir(m_confDir->path()).filePath("history.db");
+    QVERIFY(TransferHistory(historyPath).save(records));
+
+    m_model.reset(new TransfersModel(m_localUser.data(), m_peersList.data(),
+                                     historyPath));
+    QCOMPARE(m_model->rowCount(),
+             static_cast<int>(TransferHistory::MAX_RECORDS));
+}
+
+void TransfersModelBenchmark::cleanupTestCase()
+{
+    m_model.reset();
+    m_peersList.reset();
+    m_localUser.reset();
+    m_confDir.reset();
+}
+
+///
+/// The data table is composed by a row for each of the roles exposed by the
+/// model to the views, named after them.
+///
+void TransfersModelBenchmark::data_data()
+{
+    QTest::addColumn<int>("role");
+
+    // roleNames() is protected in TransfersModel
+    const QAbstractItemModel *model = m_model.data();
+    QHash<int, QByteArray> roles = model->roleNames();
+
+    QList<int> keys = roles.keys();
+    std::sort(keys.begin(), keys.end());
+    foreach (int role, keys) {
+        QTest::newRow(roles.value(role).constData()) << role;
+    }
+}
+
+///
+/// All the rows are read in sequence, as done by a view when it is refreshed.
+///
+void TransfersModelBenchmark::data()
+{
+    QFETCH(int, role);
+
+    int rows = m_model->rowCount();
+    QVariant value;
+    BenchmarkCounters counters;
+    QBENCHMARK {
+        BenchmarkCounters::Scope scope(counters, static_cast<quint64>(rows));
+        for (int row = 0; row < rows; row++) {
+            value = m_model->data(m_model->index(row), role);
+        }
+    }
+    counters.report();
+    QVERIFY(value.isValid());
+}
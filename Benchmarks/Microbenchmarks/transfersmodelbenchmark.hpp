@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TRANSFERSMODELBENCHMARK_HPP
+#define TRANSFERSMODELBENCHMARK_HPP
+
+#include <QObject>
+#include <QScopedPointer>
+#include <QTemporaryDir>
+
+class LocalUser;
+class PeersList;
+class TransfersModel;
+
+///
+/// \brief The TransfersModelBenchmark class measures the cost of the data()
+/// lookups performed by the views of the TransfersModel, for each role.
+///
+/// The model is populated through the history file with the maximum number
+/// of records, half of them referring to peers in the PeersList and half of
+/// them to peers no longer known (whose names are read from the record). The
+/// aborted records also store some failed files, as done at archive time.
+///
+class TransfersModelBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief Constructs a new instance.
+    ///
+    explicit TransfersModelBenchmark();
+
+    ///
+    /// \brief Destroys the instance.
+    ///
+    ~TransfersModelBenchmark();
+
+private slots:
+    ///
+    /// \brief Creates the model and the objects it depends on.
+    ///
+    void initTestCase();
+
+    ///
+    /// \brief Destroys the model and the objects it depends on.
+    ///
+    void cleanupTestCase();
+
+    /// \brief Provides the roles to data().
+    void data_data();
+    ///
+    /// \brief Reads a role from all the rows of the model (the time and the
+    /// allocations are reported per row).
+    ///
+    void data();
+
+private:
+    /// \brief The directory containing the configuration files.
+    QScopedPointer<QTemporaryDir> m_confDir;
+    /// \brief The instance representing the local user.
+    QScopedPointer<LocalUser> m_localUser;
+    /// \brief The instance representing the list of peers.
+    QScopedPointer<PeersList> m_peersList;
+    /// \brief The model under benchmark.
+    QScopedPointer<TransfersModel> m_model;
+
+    /// \brief The number of peers added to the PeersList.
+    static const int PEERS = 50;
+    /// \brief The number of failed files stored in each aborted record.
+    static const int TRANSFER_FILES = 20;
+};
+
+#endif // TRANSFERSMODELBENCHMARK_HPP
@@ -0,0 +1,82 @@
+# Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+# This file is part of Share Your Files (SYF).
+
+# SYF is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# SYF is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+
+QT += core network qml
+QT -= gui
+
+TARGET = Throughput
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+# Enable C++11 support
+CONFIG += C++11
+
+# Add some more warnings.
+QMAKE_CXXFLAGS += -Wall -Wextra -Wpedantic
+
+# Sources under benchmark
+SYF_DIR = $$PWD/../../ShareYourFiles
+INCLUDEPATH += $$SYF_DIR
+
+SOURCES += main.cpp \
+    dataset.cpp \
+    loopbacktransfer.cpp \
+    processusage.cpp \
+    $$SYF_DIR/Common/common.cpp \
+    $$SYF_DIR/Common/logging.cpp \
+    $$SYF_DIR/Common/threadpool.cpp \
+    $$SYF_DIR/FileTransfer/fileinfo.cpp \
+    $$SYF_DIR/FileTransfer/fileintransfer.cpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolcommon.cpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolreceiver.cpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolsender.cpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolserver.cpp \
+    $$SYF_DIR/FileTransfer/transferinfo.cpp \
+    $$SYF_DIR/FileTransfer/transferlist.cpp \
+    $$SYF_DIR/UserDiscovery/receptionpolicy.cpp
+
+HEADERS += \
+    dataset.hpp \
+    loopbacktransfer.hpp \
+    processusage.hpp \
+    $$SYF_DIR/Common/common.hpp \
+    $$SYF_DIR/Common/logging.hpp \
+    $$SYF_DIR/Common/threadpool.hpp \
+    $$SYF_DIR/FileTransfer/fileinfo.hpp \
+    $$SYF_DIR/FileTransfer/fileintransfer.hpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolcommon.hpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolreceiver.hpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolsender.hpp \
+    $$SYF_DIR/FileTransfer/syfftprotocolserver.hpp \
+    $$SYF_DIR/FileTransfer/transferinfo.hpp \
+    $$SYF_DIR/FileTransfer/transferlist.hpp \
+    $$SYF_DIR/UserDiscovery/receptionpolicy.hpp \
+    $$SYF_DIR/UserDiscovery/receptionpreferences.hpp
+
+# Peak memory usage on Windows
+win32: LIBS += -lpsapi
+
+# CuteLogger library
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../../CuteLogger/release/ -lCuteLogger
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../../CuteLogger/debug/ -lCuteLogger
+else:unix: LIBS += -L$$OUT_PWD/../../CuteLogger/ -lCuteLogger
+
+INCLUDEPATH += $$PWD/../../CuteLogger/include
+DEPENDPATH += $$PWD/../../CuteLogger/include
@@ -0,0 +1,220 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "dataset.hpp"
+
+#include <Logger.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <cmath>
+
+///
+/// \brief Computes a pseudo-random number starting from the given one.
+/// \param value the input value.
+/// \return the pseudo-random number (SplitMix64 finalizer).
+///
+static quint64 mix(quint64 value)
+{
+    value += Q_UINT64_C(0x9E3779B97F4A7C15);
+    value = (value ^ (value >> 30)) * Q_UINT64_C(0xBF58476D1CE4E5B9);
+    value = (value ^ (value >> 27)) * Q_UINT64_C(0x94D049BB133111EB);
+    return value ^ (value >> 31);
+}
+
+///
+/// The total size of the dataset is computed in advance, by summing the size
+/// of each file.
+///
+Dataset::Dataset(const QString &name, quint64 files, quint64 minSize,
+                 quint64 maxSize, int depth)
+        : m_name(name),
+          m_files(files),
+          m_minSize(minSize),
+          m_maxSize(qMax(minSize, maxSize)),
+          m_depth(depth),
+          m_bytes(0)
+{
+    for (quint64 i = 0; i < m_files; i++) {
+        m_bytes += fileSize(i);
+    }
+}
+
+///
+/// The standard datasets are:
+/// - single: one file of 10 GiB;
+/// - large: 1000 files of 10 MiB;
+/// - small: 1000000 files of 1 KiB;
+/// - mixed: 10000 files between 1 KiB and 4 MiB, in a tree of depth 3.
+///
+/// The scale factor is applied to the number of files, except for the single
+/// file dataset where it is applied to the size of the file.
+///
+QList<Dataset> Dataset::standardDatasets(double scale)
+{
+    const quint64 KiB = 1024;
+    const quint64 MiB = 1024 * KiB;
+    const quint64 GiB = 1024 * MiB;
+
+    auto scaled = [scale](quint64 value) {
+        return qMax(Q_UINT64_C(1),
+                    static_cast<quint64>(std::llround(value * scale)));
+    };
+
+    return {Dataset("single", 1, scaled(10 * GiB), scaled(10 * GiB)),
+            Dataset("large", scaled(1000), 10 * MiB, 10 * MiB),
+            Dataset("small", scaled(1000000), KiB, KiB),
+            Dataset("mixed", scaled(10000), KiB, 4 * MiB, 3)};
+}
+
+///
+/// The files are generated in a directory named after the parameters of the
+/// dataset, and a marker file is created next to it once completed. In case
+/// the marker is already present, the files are assumed to be valid and the
+/// generation is skipped; otherwise, any partial result of a previous attempt
+/// is removed.
+///
+bool Dataset::prepare(const QString &workDir)
+{
+    QString dirName = QString("%1-%2-%3-%4-%5")
+                          .arg(m_name)
+                          .arg(m_files)
+                          .arg(m_minSize)
+                          .arg(m_maxSize)
+                          .arg(m_depth);
+    m_path = QDir(workDir).absoluteFilePath(dirName);
+
+    QFile marker(m_path + ".complete");
+    if (marker.exists()) {
+        return true;
+    }
+
+    LOG_INFO() << "Dataset: generating" << m_name << "in"
+               << qUtf8Printable(m_path);
+
+    QDir dir(m_path);
+    if (!dir.removeRecursively() || !dir.mkpath(".")) {
+        LOG_ERROR() << "Dataset: impossible to create"
+                    << qUtf8Printable(m_path);
+        return false;
+    }
+
+    QString lastDir;
+    for (quint64 i = 0; i < m_files; i++) {
+        QString path = dir.absoluteFilePath(relativePath(i));
+
+        // Create the parent directory only when it changes
+        QString parentDir = QFileInfo(path).path();
+        if (parentDir != lastDir && !QDir().mkpath(parentDir)) {
+            LOG_ERROR() << "Dataset: impossible to create"
+                        << qUtf8Printable(parentDir);
+            return false;
+        }
+        lastDir = parentDir;
+
+        if (!writeFile(path, fileSize(i))) {
+            LOG_ERROR() << "Dataset: impossible to write"
+                        << qUtf8Printable(path);
+            return false;
+        }
+    }
+
+    if (!marker.open(QIODevice::WriteOnly)) {
+        LOG_ERROR() << "Dataset: impossible to create"
+                    << qUtf8Printable(marker.fileName());
+        return false;
+    }
+    return true;
+}
+
+///
+/// In case the minimum and the maximum size differ, the size is chosen in a
+/// log-uniform way, so that each order of magnitude contains about the same
+/// number of files; the value depends only on the index, hence it is the same
+/// at every execution.
+///
+quint64 Dataset::fileSize(quint64 index) const
+{
+    if (m_minSize == m_maxSize) {
+        return m_minSize;
+    }
+
+    // Uniform value in [0, 1) built from the 53 most significant bits
+    double uniform = (mix(index) >> 11) * (1.0 / (Q_UINT64_C(1) << 53));
+    double ratio = static_cast<double>(m_maxSize) / m_minSize;
+    double size = std::round(m_minSize * std::pow(ratio, uniform));
+    return qBound(m_minSize, static_cast<quint64>(size), m_maxSize);
+}
+
+///
+/// With a flat layout, the files are placed directly in the dataset directory
+/// if they are at most FILES_PER_DIR, and in subdirectories containing
+/// FILES_PER_DIR files each otherwise. With a tree layout, consecutive files
+/// are instead spread among the TREE_FANOUT^depth leaf directories.
+///
+QString Dataset::relativePath(quint64 index) const
+{
+    QString path;
+    if (m_depth == 0) {
+        if (m_files > FILES_PER_DIR) {
+            path = QString("d%1/").arg(index / FILES_PER_DIR);
+        }
+    } else {
+        quint64 divisor = 1;
+        for (int level = 0; level < m_depth; level++) {
+            path += QString("%1%2/")
+                        .arg(QChar('a' + level))
+                        .arg((index / divisor) % TREE_FANOUT);
+            divisor *= TREE_FANOUT;
+        }
+    }
+    return path + QString("f%1.bin").arg(index);
+}
+
+///
+/// The file is written in blocks taken from a buffer of pseudo-random bytes,
+/// generated only once.
+///
+bool Dataset::writeFile(const QString &path, quint64 size)
+{
+    static const QByteArray block = []() {
+        QByteArray data(1024 * 1024, Qt::Uninitialized);
+        for (int i = 0; i < data.size(); i++) {
+            data[i] = static_cast<char>(mix(static_cast<quint64>(i)));
+        }
+        return data;
+    }();
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    while (size > 0) {
+        qint64 length = static_cast<qint64>(
+            qMin(size, static_cast<quint64>(block.size())));
+        if (file.write(block.constData(), length) != length) {
+            return false;
+        }
+        size -= static_cast<quint64>(length);
+    }
+    return true;
+}
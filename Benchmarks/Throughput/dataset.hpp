@@ -0,0 +1,122 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DATASET_HPP
+#define DATASET_HPP
+
+#include <QList>
+#include <QString>
+
+///
+/// \brief The Dataset class represents a synthetic set of files used to
+/// measure the throughput of the SYFFT Protocol.
+///
+/// Each dataset is characterized by the number of files and by their size,
+/// which can be either fixed or distributed between a minimum and a maximum
+/// value (log-uniformly, in a deterministic way). The files are placed either
+/// in directories of at most FILES_PER_DIR elements or in a tree with the
+/// specified depth and a fanout of TREE_FANOUT.
+///
+/// The files are generated on disk by prepare() in a directory whose name
+/// depends on all the parameters: this allows to reuse them among different
+/// executions, since the generation of the largest datasets is expensive.
+///
+class Dataset
+{
+public:
+    ///
+    /// \brief Builds a new dataset.
+    /// \param name the name identifying the dataset.
+    /// \param files the number of files.
+    /// \param minSize the minimum size of each file.
+    /// \param maxSize the maximum size of each file.
+    /// \param depth the depth of the directory tree (0 for a flat layout).
+    ///
+    explicit Dataset(const QString &name, quint64 files, quint64 minSize,
+                     quint64 maxSize, int depth = 0);
+
+    ///
+    /// \brief Returns the standard datasets.
+    /// \param scale the factor applied to the total size of the datasets
+    /// (i.e. to the number of files, or to the size of single file ones).
+    /// \return the list of datasets.
+    ///
+    static QList<Dataset> standardDatasets(double scale);
+
+    /// \brief Returns the name identifying the dataset.
+    QString name() const { return m_name; }
+    /// \brief Returns the number of files of the dataset.
+    quint64 files() const { return m_files; }
+    /// \brief Returns the total size of the files of the dataset.
+    quint64 bytes() const { return m_bytes; }
+
+    ///
+    /// \brief Returns the path of the directory containing the files (valid
+    /// after a successful call to prepare()).
+    ///
+    QString path() const { return m_path; }
+
+    ///
+    /// \brief Generates the files of the dataset, unless already present.
+    /// \param workDir the directory where the datasets are stored.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool prepare(const QString &workDir);
+
+private:
+    ///
+    /// \brief Returns the size of a file of the dataset.
+    /// \param index the index of the file.
+    /// \return the size in bytes.
+    ///
+    quint64 fileSize(quint64 index) const;
+
+    ///
+    /// \brief Returns the path of a file of the dataset.
+    /// \param index the index of the file.
+    /// \return the path relative to the dataset directory.
+    ///
+    QString relativePath(quint64 index) const;
+
+    ///
+    /// \brief Writes a file filled with pseudo-random data.
+    /// \param path the path of the file.
+    /// \param size the size of the file.
+    /// \return true in case of success and false otherwise.
+    ///
+    static bool writeFile(const QString &path, quint64 size);
+
+public:
+    /// \brief The maximum number of files per directory (flat layout).
+    static const quint64 FILES_PER_DIR = 1000;
+    /// \brief The number of subdirectories per directory (tree layout).
+    static const quint64 TREE_FANOUT = 10;
+
+private:
+    QString m_name;    ///< \brief The name identifying the dataset.
+    quint64 m_files;   ///< \brief The number of files.
+    quint64 m_minSize; ///< \brief The minimum size of each file.
+    quint64 m_maxSize; ///< \brief The maximum size of each file.
+    int m_depth;       ///< \brief The depth of the directory tree.
+
+    quint64 m_bytes; ///< \brief The total size of the files.
+    QString m_path;  ///< \brief The path of the generated files.
+};
+
+#endif // DATASET_HPP
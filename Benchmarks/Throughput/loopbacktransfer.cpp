@@ -0,0 +1,229 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "loopbacktransfer.hpp"
+#include "Common/threadpool.hpp"
+#include "FileTransfer/syfftprotocolreceiver.hpp"
+#include "FileTransfer/syfftprotocolsender.hpp"
+#include "FileTransfer/syfftprotocolserver.hpp"
+#include "FileTransfer/transferlist.hpp"
+#include "UserDiscovery/receptionpolicy.hpp"
+#include "dataset.hpp"
+#include "processusage.hpp"
+
+#include <Logger.h>
+
+#include <QDir>
+#include <QEventLoop>
+#include <QMetaEnum>
+#include <QUuid>
+
+///
+/// \brief Converts a status to its name.
+/// \param status the status to be converted.
+/// \return the name of the status.
+///
+static QString statusName(SyfftProtocolCommon::Status status)
+{
+    return QMetaEnum::fromType<SyfftProtocolCommon::Status>().valueToKey(
+        static_cast<int>(status));
+}
+
+///
+/// The instance is initialized without performing any operation.
+///
+LoopbackTransfer::LoopbackTransfer(const QString &outputDir, QObject *parent)
+        : QObject(parent),
+          m_outputDir(outputDir),
+          m_senderStatus(SyfftProtocolCommon::Status::New),
+          m_receiverStatus(SyfftProtocolCommon::Status::New),
+          m_firstByteTime(-1),
+          m_loop(Q_NULLPTR)
+{
+}
+
+///
+/// The list of files is built first, and the time required is reported
+/// separately since it does not depend on the protocol. A new server and a
+/// new sender are then created and moved to the corresponding threads, and
+/// the transfer is started: an event loop is executed until both sides of the
+/// connection are terminated.
+///
+/// The following values are reported:
+/// - the total time, from the request to the termination of the connection;
+/// - the time to first byte, i.e. the time elapsed before the sender enters
+///   the InTransfer status (the sharing request, the list of files and the
+///   acceptance have been exchanged, and the first chunk is being sent);
+/// - the throughput (in MB/s and files/s) computed on the total time;
+/// - the CPU time consumed by the whole process (both sides), also per GB;
+/// - the peak resident set size of the process (during the transfer only if
+///   peakRssReset is true, otherwise since the start of the process).
+///
+QJsonObject LoopbackTransfer::run(const Dataset &dataset)
+{
+    const QString senderUuid = QUuid::createUuid().toString();
+    const QString receiverUuid = QUuid::createUuid().toString();
+
+    QJsonObject result{{"dataset", dataset.name()},
+                       {"files", double(dataset.files())},
+                       {"bytes", double(dataset.bytes())}};
+
+    // Prepare an empty output directory
+    QDir output(m_outputDir);
+    if (!output.removeRecursively() || !output.mkpath(".")) {
+        LOG_ERROR() << "LoopbackTransfer: impossible to create"
+                    << qUtf8Printable(m_outputDir);
+        result.insert("error", "output directory not available");
+        return result;
+    }
+
+    // Build the list of files to be sent
+    QElapsedTimer enumerationTimer;
+    enumerationTimer.start();
+    TransferList files(QStringList{dataset.path()});
+    result.insert("enumerationMs", double(enumerationTimer.elapsed()));
+
+    // Start the server and accept the incoming connection
+    SyfftProtocolServer *server = new SyfftProtocolServer(
+        receiverUuid, QSharedPointer<const ReceptionPolicy>());
+    connect(server, &SyfftProtocolServer::connectionRequested, this,
+            [this](QSharedPointer<SyfftProtocolReceiver> receiver) {
+                m_receiver = receiver;
+                connect(receiver.data(), &SyfftProtocolCommon::statusChanged,
+                        this, [this](SyfftProtocolCommon::Status status) {
+                            statusChanged(false, status);
+                        });
+                receiver->acceptConnection(this, "transferRequested", this,
+                                           "duplicatedFile");
+            });
+
+    quint16 port = server->start(LOOPBACK_ADDRESS);
+    if (port == SyfftProtocolServer::INVALID_PORT) {
+        delete server;
+        result.insert("error", "server not started");
+        return result;
+    }
+    server->moveToThread(ThreadPool::syfftReceiverThread());
+
+    // Prepare the sender
+    QSharedPointer<SyfftProtocolSender> sender(
+        new SyfftProtocolSender(senderUuid, receiverUuid, LOOPBACK_ADDRESS,
+                                port,
+                                SyfftProtocolSender::PeerStatus::Online),
+        &QObject::deleteLater);
+    sender->moveToThread(ThreadPool::syfftSenderThread());
+    connect(sender.data(), &SyfftProtocolCommon::statusChanged, this,
+            [this](SyfftProtocolCommon::Status status) {
+                statusChanged(true, status);
+            });
+
+    // Start the transfer
+    m_senderStatus = SyfftProtocolCommon::Status::New;
+    m_receiverStatus = SyfftProtocolCommon::Status::New;
+    m_firstByteTime = -1;
+
+    bool peakReset = ProcessUsage::resetPeakRss();
+    qint64 cpuStart = ProcessUsage::cpuTime();
+    m_timer.start();
+    sender->sendFiles(files);
+
+    QEventLoop loop;
+    m_loop = &loop;
+    loop.exec();
+    m_loop = Q_NULLPTR;
+
+    qint64 elapsed = m_timer.elapsed();
+    qint64 cpuTime = ProcessUsage::cpuTime() - cpuStart;
+    qint64 peakRss = ProcessUsage::peakRss();
+
+    // Collect the results (the received ones are the ones actually stored)
+    TransferInfo info = (m_receiver) ? m_receiver->transferInfo()
+                                     : sender->transferInfo();
+    double seconds = qMax(elapsed, Q_INT64_C(1)) / 1000.0;
+    double gigabytes = info.transferredBytes() / 1e9;
+
+    result.insert("senderStatus", statusName(m_senderStatus));
+    result.insert("receiverStatus", statusName(m_receiverStatus));
+    result.insert("transferredFiles", double(info.transferredFiles()));
+    result.insert("transferredBytes", double(info.transferredBytes()));
+    result.insert("elapsedMs", double(elapsed));
+    result.insert("timeToFirstByteMs", double(m_firstByteTime));
+    result.insert("megabytesPerSecond",
+                  info.transferredBytes() / 1e6 / seconds);
+    result.insert("filesPerSecond", info.transferredFiles() / seconds);
+    result.insert("cpuMs", double(cpuTime));
+    result.insert("cpuSecondsPerGB",
+                  (gigabytes > 0) ? cpuTime / 1000.0 / gigabytes : 0.0);
+    result.insert("peakRssBytes", double(peakRss));
+    result.insert("peakRssReset", peakReset);
+
+    // Release the resources
+    m_receiver.clear();
+    sender.clear();
+    server->deleteLater();
+    output.removeRecursively();
+
+    return result;
+}
+
+///
+/// The request is accepted without any message.
+///
+void LoopbackTransfer::transferRequested(
+    QSharedPointer<SyfftProtocolSharingRequest> request)
+{
+    request->accept(m_outputDir);
+}
+
+///
+/// The output directory is emptied before each transfer, hence this should
+/// never happen unless the dataset contains duplicated names.
+///
+void LoopbackTransfer::duplicatedFile(
+    QSharedPointer<SyfftProtocolDuplicatedFile> file)
+{
+    file->replace(true);
+}
+
+///
+/// The time to first byte is recorded when the sender enters the InTransfer
+/// status for the first time. The event loop is terminated when both sides
+/// have been terminated, or when the sender has been aborted before the
+/// receiver side has been created (e.g. connection refused).
+///
+void LoopbackTransfer::statusChanged(bool sender,
+                                     SyfftProtocolCommon::Status status)
+{
+    if (sender) {
+        m_senderStatus = status;
+        if (status == SyfftProtocolCommon::Status::InTransfer &&
+            m_firstByteTime < 0) {
+            m_firstByteTime = m_timer.elapsed();
+        }
+    } else {
+        m_receiverStatus = status;
+    }
+
+    bool receiverDone = (m_receiver) ? terminated(m_receiverStatus)
+                                     : m_senderStatus ==
+                                           SyfftProtocolCommon::Status::Aborted;
+    if (m_loop && terminated(m_senderStatus) && receiverDone) {
+        m_loop->quit();
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LOOPBACKTRANSFER_HPP
+#define LOOPBACKTRANSFER_HPP
+
+#include "FileTransfer/syfftprotocolcommon.hpp"
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QObject>
+#include <QSharedPointer>
+
+class Dataset;
+class SyfftProtocolDuplicatedFile;
+class SyfftProtocolReceiver;
+class SyfftProtocolSharingRequest;
+
+class QEventLoop;
+
+///
+/// \brief The LoopbackTransfer class measures the throughput of the SYFFT
+/// Protocol by transferring a dataset over the loopback interface.
+///
+/// Both sides of the protocol run in the same process, in the threads used by
+/// Share Your Files: a SyfftProtocolServer is started in the SYFFT Receiver
+/// thread, and a SyfftProtocolSender is executed in the SYFFT Sender thread.
+/// The sharing requests are automatically accepted and the files are stored
+/// in the output directory, which is emptied after each transfer.
+///
+/// The ThreadPool instance must have been created before using this class.
+///
+class LoopbackTransfer : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief Constructs a new instance.
+    /// \param outputDir the directory where the received files are stored.
+    /// \param parent the parent of the current object.
+    ///
+    explicit LoopbackTransfer(const QString &outputDir,
+                              QObject *parent = Q_NULLPTR);
+
+    ///
+    /// \brief Transfers a dataset and measures the performance.
+    /// \param dataset the dataset to be transferred (already prepared).
+    /// \return the object containing the results.
+    ///
+    QJsonObject run(const Dataset &dataset);
+
+private slots:
+    ///
+    /// \brief Accepts the sharing request received from the sender.
+    /// \param request the object representing the request.
+    ///
+    void transferRequested(QSharedPointer<SyfftProtocolSharingRequest> request);
+
+    ///
+    /// \brief Replaces the files already present in the output directory.
+    /// \param file the object representing the duplicated file.
+    ///
+    void duplicatedFile(QSharedPointer<SyfftProtocolDuplicatedFile> file);
+
+private:
+    ///
+    /// \brief Records a status change of one of the two sides and terminates
+    /// the transfer when both have been closed or aborted.
+    /// \param sender whether the status refers to the sender side.
+    /// \param status the new status.
+    ///
+    void statusChanged(bool sender, SyfftProtocolCommon::Status status);
+
+    /// \brief Returns whether the status represents a terminated connection.
+    static bool terminated(SyfftProtocolCommon::Status status)
+    {
+        return status == SyfftProtocolCommon::Status::Closed ||
+               status == SyfftProtocolCommon::Status::Aborted;
+    }
+
+public:
+    /// \brief The IPv4 address of the loopback interface.
+    static const quint32 LOOPBACK_ADDRESS = 0x7F000001;
+
+private:
+    /// \brief The directory where the received files are stored.
+    const QString m_outputDir;
+
+    /// \brief The receiver side of the current transfer.
+    QSharedPointer<SyfftProtocolReceiver> m_receiver;
+
+    /// \brief The last status of the sender side.
+    SyfftProtocolCommon::Status m_senderStatus;
+    /// \brief The last status of the receiver side.
+    SyfftProtocolCommon::Status m_receiverStatus;
+
+    /// \brief The timer started when the transfer is requested.
+    QElapsedTimer m_timer;
+    /// \brief The time elapsed before the first byte is sent (-1 if never).
+    qint64 m_firstByteTime;
+
+    /// \brief The event loop executed while the transfer is in progress.
+    QEventLoop *m_loop;
+};
+
+#endif // LOOPBACKTRANSFER_HPP
@@ -0,0 +1,162 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Common/threadpool.hpp"
+#include "dataset.hpp"
+#include "loopbacktransfer.hpp"
+
+#include <ConsoleAppender.h>
+#include <Logger.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+
+#include <cstdio>
+
+///
+/// \brief The entry point of the throughput benchmark.
+///
+/// The selected datasets are generated (if not already present in the work
+/// directory) and transferred one at a time over the loopback interface; the
+/// results are then emitted as a single JSON document, together with the
+/// information needed to compare different builds and settings. The log
+/// messages are printed on the standard error.
+///
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Measures the throughput of the SYFFT protocol over loopback.");
+    parser.addHelpOption();
+
+    QStringList names;
+    foreach (const Dataset &dataset, Dataset::standardDatasets(1)) {
+        names.append(dataset.name());
+    }
+
+    QCommandLineOption datasetsOption(
+        QStringList{"d", "datasets"},
+        "The comma separated list of datasets (" + names.join(", ") + ").",
+        "names", names.join(","));
+    QCommandLineOption scaleOption(
+        QStringList{"s", "scale"},
+        "The factor applied to the size of the datasets.", "factor", "1");
+    QCommandLineOption workDirOption(
+        QStringList{"w", "work-dir"},
+        "The directory where the datasets are generated and received.",
+        "directory", QDir::temp().absoluteFilePath("SYFThroughput"));
+    QCommandLineOption outputOption(
+        QStringList{"o", "output"},
+        "The file where the results are written (default: standard output).",
+        "file");
+    QCommandLineOption labelOption(
+        QStringList{"l", "label"},
+        "The label identifying the execution in the results.", "label");
+    parser.addOption(datasetsOption);
+    parser.addOption(scaleOption);
+    parser.addOption(workDirOption);
+    parser.addOption(outputOption);
+    parser.addOption(labelOption);
+    parser.process(app);
+
+    // Print the log messages on the standard error
+    ConsoleAppender *consoleAppender = new ConsoleAppender;
+    consoleAppender->setFormat("[%{TypeOne}] %{time}{HH:mm:ss.zzz} - "
+                               "%{message}\n");
+    consoleAppender->setDetailsLevel(Logger::Info);
+    cuteLogger->registerAppender(consoleAppender);
+
+    bool ok = false;
+    double scale = parser.value(scaleOption).toDouble(&ok);
+    if (!ok || scale <= 0) {
+        LOG_ERROR() << "Throughput: invalid scale factor";
+        return 1;
+    }
+
+    // Select the datasets
+    QStringList selected = parser.value(datasetsOption).split(',');
+    selected.removeAll(QString());
+    QList<Dataset> datasets;
+    foreach (const Dataset &dataset, Dataset::standardDatasets(scale)) {
+        if (selected.removeAll(dataset.name()) > 0) {
+            datasets.append(dataset);
+        }
+    }
+    if (!selected.isEmpty()) {
+        LOG_ERROR() << "Throughput: unknown datasets" << selected;
+        return 1;
+    }
+
+    QString workDir = parser.value(workDirOption);
+    ThreadPool::createInstance();
+
+    QJsonArray results;
+    LoopbackTransfer transfer(QDir(workDir).absoluteFilePath("received"));
+    for (Dataset &dataset : datasets) {
+        LOG_INFO() << "Throughput: preparing" << dataset.name();
+        if (!dataset.prepare(workDir)) {
+            results.append(QJsonObject{{"dataset", dataset.name()},
+                                       {"error", "dataset not generated"}});
+            continue;
+        }
+
+        LOG_INFO() << "Throughput: transferring" << dataset.name();
+        results.append(transfer.run(dataset));
+    }
+
+    // Let the deferred deletions be executed before stopping the threads
+    QTimer::singleShot(0, &app, &QCoreApplication::quit);
+    app.exec();
+    ThreadPool::destroyInstance();
+
+    QJsonObject document{
+        {"label", parser.value(labelOption)},
+        {"qtVersion", qVersion()},
+#ifdef QT_DEBUG
+        {"buildType", "debug"},
+#else
+        {"buildType", "release"},
+#endif
+        {"scale", scale},
+        {"results", results}};
+    QByteArray json = QJsonDocument(document).toJson();
+
+    // Write the results
+    if (!parser.isSet(outputOption)) {
+        std::fwrite(json.constData(), 1, json.size(), stdout);
+        return 0;
+    }
+
+    QFile output(parser.value(outputOption));
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+        output.write(json) != json.size()) {
+        LOG_ERROR() << "Throughput: impossible to write"
+                    << qUtf8Printable(output.fileName());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "processusage.hpp"
+
+#include <QFile>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+///
+/// The time is obtained through getrusage() on unix systems and through
+/// GetProcessTimes() on Windows.
+///
+qint64 ProcessUsage::cpuTime()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel,
+                         &user)) {
+        return -1;
+    }
+
+    // FILETIME values are expressed in units of 100 nanoseconds
+    auto toMs = [](const FILETIME &time) {
+        return ((static_cast<qint64>(time.dwHighDateTime) << 32) |
+                time.dwLowDateTime) /
+               10000;
+    };
+    return toMs(kernel) + toMs(user);
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+
+    return static_cast<qint64>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+               1000 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#else
+    return -1;
+#endif
+}
+
+///
+/// On Linux the value is read from the VmHWM field of /proc/self/status, which
+/// can be reset through resetPeakRss(); on the other unix systems it is
+/// obtained through getrusage() (expressed in kilobytes, except for macOS) and
+/// on Windows through GetProcessMemoryInfo().
+///
+qint64 ProcessUsage::peakRss()
+{
+#if defined(Q_OS_LINUX)
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+
+    // The line has the format "VmHWM:   123456 kB"
+    const QByteArray key("VmHWM:");
+    while (!status.atEnd()) {
+        QByteArray line = status.readLine();
+        if (line.startsWith(key)) {
+            QByteArray value = line.mid(key.size()).simplified();
+            bool ok = false;
+            qint64 kilobytes = value.left(value.indexOf(' ')).toLongLong(&ok);
+            return (ok) ? kilobytes * 1024 : -1;
+        }
+    }
+    return -1;
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                              sizeof(counters))) {
+        return -1;
+    }
+    return static_cast<qint64>(counters.PeakWorkingSetSize);
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#if defined(Q_OS_DARWIN)
+    return static_cast<qint64>(usage.ru_maxrss);
+#else
+    return static_cast<qint64>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return -1;
+#endif
+}
+
+///
+/// The reset is supported only on Linux (since version 4.0), by writing the
+/// value 5 to /proc/self/clear_refs. Elsewhere, the peak refers to the whole
+/// lifetime of the process.
+///
+bool ProcessUsage::resetPeakRss()
+{
+#if defined(Q_OS_LINUX)
+    QFile clearRefs("/proc/self/clear_refs");
+    if (!clearRefs.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    return clearRefs.write("5") == 1;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,61 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef PROCESSUSAGE_HPP
+#define PROCESSUSAGE_HPP
+
+#include <QtGlobal>
+
+///
+/// \brief The ProcessUsage class provides access to the resources consumed
+/// by the current process.
+///
+/// The values are obtained from the operating system and refer to the whole
+/// process (i.e. all its threads): both the sender and the receiver side of a
+/// loopback transfer are therefore accounted together.
+///
+class ProcessUsage
+{
+public:
+    ///
+    /// \brief The constructor is disabled (it is not possible to create
+    /// instances).
+    ///
+    explicit ProcessUsage() = delete;
+
+    ///
+    /// \brief Returns the CPU time (user and system) consumed so far.
+    /// \return the CPU time in milliseconds (-1 if not available).
+    ///
+    static qint64 cpuTime();
+
+    ///
+    /// \brief Returns the peak resident set size of the process.
+    /// \return the peak RSS in bytes (-1 if not available).
+    ///
+    static qint64 peakRss();
+
+    ///
+    /// \brief Resets the peak resident set size to the current one.
+    /// \return true in case of success and false if not supported.
+    ///
+    static bool resetPeakRss();
+};
+
+#endif // PROCESSUSAGE_HPP
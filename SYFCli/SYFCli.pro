@@ -0,0 +1,40 @@
+# Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+# This file is part of Share Your Files (SYF).
+
+# SYF is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+
+# SYF is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+
+QT += core network
+QT -= gui
+
+TARGET = SYFCli
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+# Enable C++11 support
+CONFIG += C++11
+
+# Add some more warnings.
+QMAKE_CXXFLAGS += -Wall -Wextra -Wpedantic
+
+# Properties (Windows)
+RC_ICONS = ../icon.ico
+QMAKE_TARGET_PRODUCT = "Share Your Files Command Line Interface"
+QMAKE_TARGET_DESCRIPTION = "Utility program used to control SYF from the command line"
+QMAKE_TARGET_COPYRIGHT = "Copyright 2017 Marco Iorio - GNU GPL3 license"
+
+SOURCES += main.cpp
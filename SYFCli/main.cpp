@@ -0,0 +1,333 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QLocalSocket>
+#include <QString>
+#include <QStringList>
+
+#include <cstdio>
+
+// The name used by the server to listen for connections
+static const QString SERVER_NAME = QString("SYFControlProtocol");
+// The maximum time allowed for the operations (in milliseconds)
+static const int TIMEOUT = 5000;
+
+// The events received while waiting for the reply to a request
+static QList<QJsonObject> pendingEvents;
+
+///
+/// \brief Prints an object on a single line.
+/// \param file the file where the object is printed.
+/// \param object the object to be printed.
+///
+static void print(FILE *file, const QJsonObject &object)
+{
+    QByteArray line = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    std::fprintf(file, "%s\n", line.constData());
+    std::fflush(file);
+}
+
+///
+/// \brief Prints an error message.
+/// \param message the description of the error.
+/// \return the exit code representing a failure.
+///
+static int fail(const QString &message)
+{
+    print(stderr, QJsonObject{{"ok", false}, {"error", message}});
+    return 1;
+}
+
+///
+/// \brief Reads the next object sent by ShareYourFiles.
+/// \param socket the socket connected to ShareYourFiles.
+/// \param object the object read.
+/// \param timeout the maximum time to wait (-1 to wait forever).
+/// \return true in case of success and false otherwise.
+///
+static bool readObject(QLocalSocket &socket, QJsonObject &object, int timeout)
+{
+    while (!socket.canReadLine()) {
+        if (socket.state() != QLocalSocket::ConnectedState ||
+            !socket.waitForReadyRead(timeout)) {
+            return false;
+        }
+    }
+
+    QJsonDocument document = QJsonDocument::fromJson(socket.readLine());
+    object = document.object();
+    return document.isObject();
+}
+
+///
+/// \brief Returns the next event sent by ShareYourFiles (waiting forever).
+/// \param socket the socket connected to ShareYourFiles.
+/// \param event the event read.
+/// \return true in case of success and false if the connection is closed.
+///
+static bool nextEvent(QLocalSocket &socket, QJsonObject &event)
+{
+    if (!pendingEvents.isEmpty()) {
+        event = pendingEvents.takeFirst();
+        return true;
+    }
+    return readObject(socket, event, -1);
+}
+
+///
+/// \brief Sends a request to ShareYourFiles and waits for the reply.
+/// \param socket the socket connected to ShareYourFiles.
+/// \param request the request to be sent.
+/// \param reply the reply received (or an object describing the error).
+/// \param timeout the maximum time waiting for data (-1 for no limit).
+/// \return true if the request succeeded and false otherwise.
+///
+/// The events received while waiting are stored to be returned by nextEvent().
+///
+static bool request(QLocalSocket &socket, QJsonObject request,
+                    QJsonObject &reply, int timeout = TIMEOUT)
+{
+    static int nextId = 0;
+    int id = nextId++;
+
+    request.insert("id", id);
+    socket.write(QJsonDocument(request).toJson(QJsonDocument::Compact));
+    socket.write("\n");
+    socket.flush();
+
+    while (readObject(socket, reply, timeout)) {
+        if (reply.contains("event")) {
+            pendingEvents.append(reply);
+        } else if (reply.value("id").toInt(-1) == id) {
+            return reply.value("ok").toBool();
+        }
+    }
+
+    reply = QJsonObject{{"ok", false},
+                        {"error", "No reply received from ShareYourFiles"}};
+    return false;
+}
+
+///
+/// \brief Executes a command without parameters and prints the reply.
+/// \param socket the socket connected to ShareYourFiles.
+/// \param command the command to be executed.
+/// \return the exit code.
+///
+static int simpleCommand(QLocalSocket &socket, const QString &command)
+{
+    QJsonObject reply;
+    bool ok = request(socket, QJsonObject{{"command", command}}, reply);
+    print(ok ? stdout : stderr, reply);
+    return ok ? 0 : 1;
+}
+
+///
+/// \brief Prints the events regarding the transfers until the requested
+/// number of them terminates.
+/// \param socket the socket connected to ShareYourFiles.
+/// \param sender whether the transfers of interest are sent or received.
+/// \param id the identifier of the transfer of interest (-1 for all).
+/// \param count the number of transfers to be waited for (0 for no limit).
+/// \return the exit code (failure in case some transfer is aborted).
+///
+static int followTransfers(QLocalSocket &socket, bool sender, int id,
+                           int count)
+{
+    int terminated = 0;
+    bool aborted = false;
+
+    QJsonObject event;
+    while (nextEvent(socket, event)) {
+        QString name = event.value("event").toString();
+        if (!name.startsWith("transfer") ||
+            event.value("sender").toBool() != sender ||
+            (id >= 0 && event.value("transfer").toInt(-1) != id)) {
+            continue;
+        }
+
+        print(stdout, event);
+
+        QString status = event.value("status").toString();
+        if (name == "transferStatus" &&
+            (status == "Closed" || status == "Aborted")) {
+            aborted |= (status == "Aborted");
+            if (++terminated == count) {
+                return aborted ? 1 : 0;
+            }
+        }
+    }
+
+    return fail("Connection to ShareYourFiles closed");
+}
+
+///
+/// \brief Sends the files to a peer and prints the progress of the transfer.
+/// \param socket the socket connected to ShareYourFiles.
+/// \param to the UUID or the IPv4 address of the peer.
+/// \param paths the paths of the files and directories to be sent.
+/// \param message the message attached to the sharing request.
+/// \return the exit code.
+///
+static int send(QLocalSocket &socket, const QString &to,
+                const QStringList &paths, const QString &message)
+{
+    QJsonObject reply;
+
+    // Subscribe first, so that no event regarding the transfer is lost
+    if (!request(socket, QJsonObject{{"command", "subscribe"}}, reply)) {
+        print(stderr, reply);
+        return 1;
+    }
+
+    // The paths are relative to the current directory of this process
+    QJsonArray absolutePaths;
+    foreach (const QString &path, paths) {
+        absolutePaths.append(QDir().absoluteFilePath(path));
+    }
+
+    // The reply is sent once the files have been enumerated, which may take
+    // a long time in case of large directories
+    if (!request(socket,
+                 QJsonObject{{"command", "send"},
+                             {"to", to},
+                             {"paths", absolutePaths},
+                             {"message", message}},
+                 reply, -1)) {
+        print(stderr, reply);
+        return 1;
+    }
+
+    return followTransfers(socket, true, reply.value("transfer").toInt(), 1);
+}
+
+///
+/// \brief Receives the files in a directory and prints the progress of the
+/// transfers.
+/// \param socket the socket connected to ShareYourFiles (in service mode).
+/// \param directory the directory where the files are received.
+/// \param duplicates the action performed for the duplicated files.
+/// \param count the number of transfers to be received (0 for no limit).
+/// \return the exit code.
+///
+static int receive(QLocalSocket &socket, const QString &directory,
+                   const QString &duplicates, int count)
+{
+    QJsonObject reply;
+
+    if (!request(socket, QJsonObject{{"command", "subscribe"}}, reply) ||
+        !request(socket,
+                 QJsonObject{{"command", "receive"},
+                             {"directory", QDir().absoluteFilePath(directory)},
+                             {"duplicates", duplicates}},
+                 reply)) {
+        print(stderr, reply);
+        return 1;
+    }
+    print(stdout, reply);
+
+    int result = followTransfers(socket, false, -1, count);
+
+    // Stop accepting the transfers automatically
+    request(socket, QJsonObject{{"command", "receive"}, {"directory", ""}},
+            reply);
+    return result;
+}
+
+///
+/// The command line interface connects to the running instance of
+/// ShareYourFiles through the control protocol and executes the requested
+/// command, printing the results as JSON objects (one per line) on the
+/// standard output and the errors on the standard error.
+///
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // Parse the command line
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Controls the running instance of Share Your Files.\n\n"
+        "Commands:\n"
+        "  status                  the information about the local user\n"
+        "  peers                   the list of active peers\n"
+        "  transfers               the list of transfers\n"
+        "  send <peer> <paths...>  sends files to a peer (UUID or address)\n"
+        "  receive <directory>     receives the files (service mode only)\n"
+        "  quit                    terminates the service");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "The command to be executed.");
+
+    QCommandLineOption messageOption(
+        QStringList{"m", "message"},
+        "The message attached to the sharing request (send).", "message");
+    QCommandLineOption duplicatesOption(
+        QStringList{"d", "duplicates"},
+        "The action for the duplicated files: replace, keep or keepboth "
+        "(receive).",
+        "action", "keep");
+    QCommandLineOption countOption(
+        QStringList{"c", "count"},
+        "The number of transfers received before exiting, 0 for no limit "
+        "(receive).",
+        "count", "0");
+    parser.addOption(messageOption);
+    parser.addOption(duplicatesOption);
+    parser.addOption(countOption);
+    parser.process(app);
+
+    QStringList arguments = parser.positionalArguments();
+    if (arguments.isEmpty()) {
+        parser.showHelp(1);
+    }
+    QString command = arguments.takeFirst();
+
+    // Try to establish the connection to ShareYourFiles
+    QLocalSocket socket;
+    socket.connectToServer(SERVER_NAME);
+    if (!socket.waitForConnected(TIMEOUT)) {
+        return fail("Impossible to establish the connection to "
+                    "ShareYourFiles: " +
+                    socket.errorString());
+    }
+
+    if ((command == "status" || command == "peers" ||
+         command == "transfers" || command == "quit") &&
+        arguments.isEmpty()) {
+        return simpleCommand(socket, command);
+    }
+    if (command == "send" && arguments.count() >= 2) {
+        QString to = arguments.takeFirst();
+        return send(socket, to, arguments, parser.value(messageOption));
+    }
+    if (command == "receive" && arguments.count() == 1) {
+        return receive(socket, arguments.first(),
+                       parser.value(duplicatesOption),
+                       parser.value(countOption).toInt());
+    }
+
+    return fail("Invalid command: " + command + " (see --help)");
+}
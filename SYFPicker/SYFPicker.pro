@@ -15,6 +15,7 @@
 # You should have received a copy of the GNU General Public License
 # along with SYF.  If not, see <http://www.gnu.org/licenses/>.
 
+# The widgets are used only to show the error messages
 QT += core gui network
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
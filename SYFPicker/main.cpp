@@ -17,6 +17,7 @@
  */
 
 #include <QApplication>
+#include <QCoreApplication>
 
 #include <QDataStream>
 #include <QLocalSocket>
@@ -26,32 +27,36 @@
 
 // The name used by the server to listen for connections
 static const QString SERVER_NAME = QString("SYFPickerProtocol");
-// The maximum time allowed for the operations (in milliseconds)
+// The maximum time allowed for each operation (in milliseconds)
 static const int TIMEOUT = 5000;
+// The maximum number of paths sent in each batch
+static const int BATCH_SIZE = 1000;
+// The amount of pending bytes causing the data to be flushed
+static const qint64 FLUSH_THRESHOLD = 1024 * 1024;
 
-int main(int argc, char *argv[])
+///
+/// \brief Sends the paths to ShareYourFiles according to the SYFP Protocol.
+/// \param paths the list of paths to be sent.
+/// \param error the message set in case of failure.
+/// \return true in case of success and false otherwise.
+///
+/// The paths are sent in batches of at most BATCH_SIZE elements, each one
+/// preceded by the number of paths it contains, and terminated by an empty
+/// batch: this way, the application can start enumerating the files while the
+/// remaining ones are still being sent.
+///
+static bool sendPaths(const QStringList &paths, QString &error)
 {
-    QApplication a(argc, argv);
-
-    // Get the list of arguments (the list of file names)
-    QStringList arguments = QCoreApplication::arguments();
-    if (arguments.count() <= 1) {
-        // No file or directory names specified, just return
-        return 0;
-    }
-
     // Try to establish the connection to ShareYourFiles
     QLocalSocket socket;
     socket.connectToServer(SERVER_NAME, QLocalSocket::WriteOnly);
 
     if (!socket.waitForConnected(TIMEOUT)) {
         // Connection failed
-        QString title(QObject::tr(TARGET));
-        QString message(QObject::tr("Impossible to establish the connection to"
-                                    " ShareYourFiles.\nCheck if the application"
-                                    " is correctly running and retry later."));
-        QMessageBox::critical(Q_NULLPTR, title, message);
-        return -1;
+        error = QObject::tr("Impossible to establish the connection to"
+                            " ShareYourFiles.\nCheck if the application"
+                            " is correctly running and retry later.");
+        return false;
     }
 
     // Build the stream to send the data
@@ -59,28 +64,70 @@ int main(int argc, char *argv[])
     stream.setVersion(QDataStream::Version::Qt_5_0);
     stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
 
-    // Send the number of strings
-    stream << static_cast<quint32>(arguments.count() - 1);
+    error = QObject::tr("Failed sending the data to ShareYourFiles.\n"
+                        "Check if the application is correctly running"
+                        " and retry later.");
 
-    // Send each path, converted in UTF8 format
-    for (int i = 1; i < arguments.count(); i++) {
-        QByteArray path = arguments.at(i).toUtf8();
-        stream << path;
+    for (int first = 0; first < paths.count(); first += BATCH_SIZE) {
+        int count = qMin(paths.count() - first, BATCH_SIZE);
+
+        // Send the number of strings in the batch
+        stream << static_cast<quint32>(count);
+
+        // Send each path, converted in UTF8 format
+        for (int i = first; i < first + count; i++) {
+            stream << paths.at(i).toUtf8();
+        }
+
+        // Flush the data if too much is pending
+        while (socket.bytesToWrite() > FLUSH_THRESHOLD) {
+            if (!socket.waitForBytesWritten(TIMEOUT)) {
+                return false;
+            }
+        }
     }
 
-    if (!socket.waitForBytesWritten(TIMEOUT)) {
-        // Failed flushing the data
-        QString title(QObject::tr(TARGET));
-        QString message(
-            QObject::tr("Failed sending the data to ShareYourFiles.\n"
-                        "Check if the application is correctly running"
-                        " and retry later."));
-        QMessageBox::critical(Q_NULLPTR, title, message);
-        return -1;
+    // Send the empty batch terminating the sequence
+    stream << static_cast<quint32>(0);
+
+    while (socket.bytesToWrite() > 0) {
+        if (!socket.waitForBytesWritten(TIMEOUT)) {
+            return false;
+        }
     }
 
     // Disconnect from the server
     socket.disconnectFromServer();
 
-    return 0;
+    return true;
+}
+
+///
+/// Only a QCoreApplication is needed to forward the paths to ShareYourFiles;
+/// the GUI is initialized exclusively to show the message in case of error.
+///
+int main(int argc, char *argv[])
+{
+    QString error;
+
+    {
+        QCoreApplication a(argc, argv);
+
+        // Get the list of arguments (the list of file names)
+        QStringList paths = QCoreApplication::arguments();
+        paths.removeFirst();
+        if (paths.isEmpty()) {
+            // No file or directory names specified, just return
+            return 0;
+        }
+
+        if (sendPaths(paths, error)) {
+            return 0;
+        }
+    }
+
+    // Show the error message
+    QApplication a(argc, argv);
+    QMessageBox::critical(Q_NULLPTR, QObject::tr(TARGET), error);
+    return -1;
 }
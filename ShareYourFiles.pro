@@ -15,5 +15,6 @@
 # along with SYF.  If not, see <http://www.gnu.org/licenses/>.
 
 TEMPLATE = subdirs
-SUBDIRS += CuteLogger ShareYourFiles SYFPicker
+SUBDIRS += CuteLogger ShareYourFiles SYFPicker SYFCli Benchmarks
 ShareYourFiles.depends += CuteLogger
+Benchmarks.depends += CuteLogger
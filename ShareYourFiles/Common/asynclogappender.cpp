@@ -0,0 +1,211 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "asynclogappender.hpp"
+
+#include <QThread>
+
+///
+/// \brief The AsyncLogAppender::Writer class represents the thread in charge of
+/// writing the messages to the sinks.
+///
+class AsyncLogAppender::Writer : public QThread
+{
+public:
+    ///
+    /// \brief Constructs a new Writer.
+    /// \param appender the appender whose queue is processed.
+    ///
+    explicit Writer(AsyncLogAppender *appender) : m_appender(appender)
+    {
+        setObjectName("Log Writer");
+    }
+
+protected:
+    /// \brief Executes the main loop of the appender.
+    void run() override { m_appender->process(); }
+
+private:
+    /// \brief The appender whose queue is processed.
+    AsyncLogAppender *m_appender;
+};
+
+AsyncLogAppender::AsyncLogAppender()
+        : m_head(Q_NULLPTR),
+          m_pending(0),
+          m_dropped(0),
+          m_stop(false),
+          m_writer(new Writer(this))
+{
+    m_writer->start(QThread::LowPriority);
+}
+
+///
+/// The writer thread is stopped after having written all the messages already
+/// pushed, and then the remaining ones (if any) are written synchronously.
+///
+AsyncLogAppender::~AsyncLogAppender()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stop = true;
+        m_wakeup.wakeOne();
+    }
+    m_writer->wait();
+
+    writePending();
+    qDeleteAll(m_sinks);
+}
+
+void AsyncLogAppender::addSink(AbstractStringAppender *sink)
+{
+    sink->setFormat("%{message}");
+    m_sinks.append(sink);
+}
+
+///
+/// The function waits until the writer thread signals that no message is left
+/// in the queue.
+///
+void AsyncLogAppender::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    m_wakeup.wakeOne();
+    while (m_pending.loadAcquire() > 0) {
+        m_idle.wait(&m_mutex);
+    }
+}
+
+///
+/// The message is formatted in the current thread (with the write mutex of the
+/// appender held by the caller), copied to a newly allocated node and pushed
+/// to the head of the queue through a compare-and-swap loop, which is needed
+/// since the writer thread detaches the queue without acquiring the mutex.
+/// The writer thread is woken up only if the queue was previously empty, since
+/// otherwise a wake up is already pending.
+///
+void AsyncLogAppender::append(const QDateTime &timeStamp,
+                              Logger::LogLevel logLevel, const char *file,
+                              int line, const char *function,
+                              const QString &category, const QString &message)
+{
+    bool fatal = (logLevel == Logger::Fatal);
+
+    // Drop the message in case too many are already pending
+    if (m_pending.fetchAndAddRelaxed(1) >= MAX_PENDING && !fatal) {
+        m_pending.fetchAndSubRelaxed(1);
+        m_dropped.fetchAndAddRelaxed(1);
+        return;
+    }
+
+    Node *node = new Node();
+    node->timeStamp = timeStamp;
+    node->level = logLevel;
+    node->file = file;
+    node->line = line;
+    node->function = function;
+    node->category = category;
+    node->text = formattedString(timeStamp, logLevel, file, line, function,
+                                 category, message);
+
+    Node *head;
+    do {
+        head = m_head.loadAcquire();
+        node->next = head;
+    } while (!m_head.testAndSetRelease(head, node));
+
+    if (head == Q_NULLPTR) {
+        QMutexLocker locker(&m_mutex);
+        m_wakeup.wakeOne();
+    }
+
+    if (fatal) {
+        flush();
+    }
+}
+
+///
+/// The writer thread sleeps while the queue is empty, signaling in the
+/// meanwhile that all the messages have been written; once woken up, all the
+/// pending messages are written at once.
+///
+void AsyncLogAppender::process()
+{
+    forever {
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stop && m_head.loadAcquire() == Q_NULLPTR) {
+                m_idle.wakeAll();
+                m_wakeup.wait(&m_mutex);
+            }
+
+            if (m_stop) {
+                m_idle.wakeAll();
+                return;
+            }
+        }
+
+        writePending();
+    }
+}
+
+///
+/// The queue is detached at once, and its nodes (stored from the most recent)
+/// are reversed in order to write the messages in the order they were logged.
+///
+void AsyncLogAppender::writePending()
+{
+    Node *node = m_head.fetchAndStoreAcquire(Q_NULLPTR);
+
+    Node *ordered = Q_NULLPTR;
+    while (node) {
+        Node *next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+    }
+
+    while (ordered) {
+        foreach (AbstractStringAppender *sink, m_sinks) {
+            sink->write(ordered->timeStamp, ordered->level, ordered->file,
+                        ordered->line, ordered->function, ordered->category,
+                        ordered->text);
+        }
+
+        Node *next = ordered->next;
+        delete ordered;
+        ordered = next;
+        m_pending.fetchAndSubRelease(1);
+    }
+
+    // Report the messages dropped in the meanwhile
+    int dropped = m_dropped.fetchAndStoreRelaxed(0);
+    if (dropped > 0) {
+        QString message = QString("AsyncLogAppender: %1 messages dropped")
+                              .arg(dropped);
+        QDateTime now = QDateTime::currentDateTime();
+        foreach (AbstractStringAppender *sink, m_sinks) {
+            sink->write(now, Logger::Warning, __FILE__, __LINE__, Q_FUNC_INFO,
+                        QString(),
+                        formattedString(now, Logger::Warning, __FILE__,
+                                        __LINE__, Q_FUNC_INFO, QString(),
+                                        message));
+        }
+    }
+}
@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef ASYNCLOGAPPENDER_HPP
+#define ASYNCLOGAPPENDER_HPP
+
+#include <AbstractStringAppender.h>
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QList>
+#include <QMutex>
+#include <QScopedPointer>
+#include <QWaitCondition>
+
+///
+/// \brief The AsyncLogAppender class provides a CuteLogger appender that moves
+/// the actual writes to a background thread.
+///
+/// The CuteLogger appenders write synchronously from the thread that produced
+/// the message, hence the protocol threads would otherwise be blocked on the
+/// console and on the log file. This appender, instead, only formats the
+/// message (so that the thread specific fields are correct) and pushes it to
+/// a queue, while a dedicated thread forwards the formatted lines to the sink
+/// appenders (configured with the plain "%{message}" format).
+///
+/// Note that this is still an ordinary CuteLogger appender: every message goes
+/// through AbstractAppender::write(), which serializes the producers on the
+/// write mutex of the appender, and requires the allocation of a queue node.
+/// The benefit is that the mutex is held only for the formatting and the push,
+/// rather than for the whole I/O: the queue itself is a linked stack updated
+/// through atomic operations, so that the writer thread can detach it without
+/// blocking the producers.
+///
+/// The writer thread is woken up only when the queue becomes non-empty, and it
+/// always extracts all the pending messages at once. In case the writer cannot
+/// keep up, the messages exceeding MAX_PENDING are dropped and their number is
+/// reported in the log. The fatal messages are never dropped, and the queue is
+/// flushed before returning, since the application is going to be aborted.
+///
+class AsyncLogAppender : public AbstractStringAppender
+{
+public:
+    ///
+    /// \brief Constructs a new AsyncLogAppender and starts the writer thread.
+    ///
+    explicit AsyncLogAppender();
+
+    ///
+    /// \brief Writes the pending messages, stops the writer thread and deletes
+    /// the sinks.
+    ///
+    ~AsyncLogAppender();
+
+    ///
+    /// \brief Adds a new appender where the messages are written.
+    /// \param sink the appender (the ownership is transferred).
+    ///
+    /// The format of the sink is set to "%{message}", since the messages are
+    /// already formatted. The sinks must be added before the appender is
+    /// registered to the logger.
+    ///
+    void addSink(AbstractStringAppender *sink);
+
+    ///
+    /// \brief Blocks until all the pending messages have been written.
+    ///
+    void flush();
+
+protected:
+    ///
+    /// \brief Formats the message and pushes it to the queue.
+    ///
+    void append(const QDateTime &timeStamp, Logger::LogLevel logLevel,
+                const char *file, int line, const char *function,
+                const QString &category, const QString &message) override;
+
+private:
+    class Writer;
+
+    ///
+    /// \brief The Node struct represents a message in the queue.
+    ///
+    struct Node {
+        QDateTime timeStamp;      ///< \brief The time stamp of the message.
+        Logger::LogLevel level;   ///< \brief The level of the message.
+        const char *file;         ///< \brief The source file (static).
+        int line;                 ///< \brief The source line.
+        const char *function;     ///< \brief The source function (static).
+        QString category;         ///< \brief The category of the message.
+        QString text;             ///< \brief The formatted message.
+        Node *next;               ///< \brief The next node in the queue.
+    };
+
+    ///
+    /// \brief Main loop of the writer thread.
+    ///
+    void process();
+
+    ///
+    /// \brief Extracts all the pending messages and writes them to the sinks
+    /// (executed by the writer thread only).
+    ///
+    void writePending();
+
+private:
+    /// \brief The most recent message pushed to the queue (atomic stack,
+    /// reversed by the writer).
+    QAtomicPointer<Node> m_head;
+    /// \brief The number of messages pushed and not yet written.
+    QAtomicInt m_pending;
+    /// \brief The number of messages dropped and not yet reported.
+    QAtomicInt m_dropped;
+
+    /// \brief The appenders where the messages are written.
+    QList<AbstractStringAppender *> m_sinks;
+
+    /// \brief The mutex used to sleep and wake up the writer thread.
+    QMutex m_mutex;
+    /// \brief The condition signaled when the queue becomes non-empty.
+    QWaitCondition m_wakeup;
+    /// \brief The condition signaled when all the messages are written.
+    QWaitCondition m_idle;
+    /// \brief Whether the writer thread has to terminate or not.
+    bool m_stop;
+
+    /// \brief The writer thread.
+    QScopedPointer<Writer> m_writer;
+
+    /// \brief The maximum number of messages waiting to be written.
+    static const int MAX_PENDING = 10000;
+};
+
+#endif // ASYNCLOGAPPENDER_HPP
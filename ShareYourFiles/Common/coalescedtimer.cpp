@@ -0,0 +1,94 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "coalescedtimer.hpp"
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+///
+/// The underlying timer is created as single-shot, since it is rescheduled
+/// at each timeout in order not to accumulate the drift introduced by the
+/// coarse timer type.
+///
+CoalescedTimer::CoalescedTimer(QObject *parent)
+        : QObject(parent), m_timer(new QTimer(this)), m_interval(0)
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, [this]() {
+        schedule();
+        emit timeout();
+    });
+}
+
+bool CoalescedTimer::isActive() const
+{
+    return m_timer->isActive();
+}
+
+void CoalescedTimer::start()
+{
+    schedule();
+}
+
+void CoalescedTimer::start(int msec)
+{
+    m_interval = msec;
+    schedule();
+}
+
+void CoalescedTimer::stop()
+{
+    m_timer->stop();
+}
+
+///
+/// The origin is the first call to this function, and the initialization of
+/// the local static variable is guaranteed to be thread-safe.
+///
+qint64 CoalescedTimer::elapsed()
+{
+    static const QElapsedTimer origin = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return origin.elapsed();
+}
+
+///
+/// The deadline is the next multiple of the interval since the common origin;
+/// in case it is closer than half an interval, the following one is selected
+/// instead. This covers both the timer started right before a deadline and the
+/// timeouts anticipated by the coarse timer type, which would otherwise be
+/// emitted twice in a row.
+///
+void CoalescedTimer::schedule()
+{
+    const int interval = qMax(m_interval, 1);
+    qint64 delay = interval - CoalescedTimer::elapsed() % interval;
+    if (delay < interval / 2) {
+        delay += interval;
+    }
+
+    m_timer->setTimerType((interval >= VERY_COARSE_THRESHOLD)
+                              ? Qt::VeryCoarseTimer
+                              : Qt::CoarseTimer);
+    m_timer->start(static_cast<int>(delay));
+}
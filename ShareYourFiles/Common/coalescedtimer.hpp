@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef COALESCEDTIMER_HPP
+#define COALESCEDTIMER_HPP
+
+#include <QObject>
+#include <QPointer>
+
+class QTimer;
+
+///
+/// \brief The CoalescedTimer class provides a periodic timer whose deadlines
+/// are aligned to a grid shared by the whole application.
+///
+/// Independent QTimer instances started at different moments wake up the
+/// process at unrelated times, even when they have the same interval, which
+/// prevents the CPU from staying idle for long periods. A CoalescedTimer,
+/// instead, always expires at a multiple of its interval measured from a
+/// common monotonic origin: timers with the same interval (or multiple ones)
+/// fire together, even if they belong to different threads, and the wakeups
+/// are merged. Moreover, the underlying timer is configured with a coarse
+/// timer type, so that the system is free to further coalesce it.
+///
+/// The interface mimics the subset of QTimer used by the application, so that
+/// it can be used as a drop-in replacement for periodic timers. Single-shot
+/// timers (e.g. timeouts and delays) are not affected by the alignment and
+/// should continue to use QTimer.
+///
+class CoalescedTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief Constructs a new inactive CoalescedTimer.
+    /// \param parent the parent of the current object.
+    ///
+    explicit CoalescedTimer(QObject *parent = Q_NULLPTR);
+
+    ///
+    /// \brief Sets the interval between subsequent timeouts.
+    /// \param msec the interval in milliseconds.
+    ///
+    /// The change takes effect when the timer is (re)started.
+    ///
+    void setInterval(int msec) { m_interval = msec; }
+
+    /// \brief Returns the interval between subsequent timeouts.
+    int interval() const { return m_interval; }
+
+    /// \brief Returns whether the timer is running or not.
+    bool isActive() const;
+
+    ///
+    /// \brief Starts (or restarts) the timer with the current interval.
+    ///
+    /// The first timeout is emitted at the next aligned deadline which is at
+    /// least half an interval away.
+    ///
+    void start();
+
+    ///
+    /// \brief Starts (or restarts) the timer with the given interval.
+    /// \param msec the interval in milliseconds.
+    ///
+    void start(int msec);
+
+    ///
+    /// \brief Stops the timer.
+    ///
+    void stop();
+
+    ///
+    /// \brief Returns the time elapsed since the common origin.
+    /// \return the number of milliseconds elapsed.
+    ///
+    static qint64 elapsed();
+
+signals:
+    ///
+    /// \brief Signal emitted when the timer expires.
+    ///
+    void timeout();
+
+private:
+    ///
+    /// \brief Schedules the underlying timer at the next aligned deadline.
+    ///
+    void schedule();
+
+private:
+    /// \brief The single-shot timer scheduled at each deadline.
+    QPointer<QTimer> m_timer;
+    /// \brief The interval between subsequent timeouts (in milliseconds).
+    int m_interval;
+
+    ///
+    /// \brief The minimum interval for which the very coarse timer type
+    /// (i.e. whole seconds accuracy) is used.
+    ///
+    static const int VERY_COARSE_THRESHOLD = 10000;
+};
+
+#endif // COALESCEDTIMER_HPP
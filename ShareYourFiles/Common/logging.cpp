@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "logging.hpp"
+
+#include <QElapsedTimer>
+
+LogLimiter::LogLimiter(const char *category, int rate, int sampling)
+        : m_category(category),
+          m_rate(rate),
+          m_sampling(qMax(sampling, 1)),
+          m_second(-1),
+          m_count(0),
+          m_suppressed(0)
+{
+}
+
+///
+/// The messages are counted per second: the first rate ones are allowed, while
+/// only one out of sampling is allowed among the following ones. When a new
+/// second begins, the thread that first detects it resets the counter and
+/// reports the messages suppressed in the previous period.
+///
+bool LogLimiter::allow()
+{
+    int now = seconds();
+    int second = m_second.loadAcquire();
+    if (now != second && m_second.testAndSetOrdered(second, now)) {
+        m_count.storeRelease(0);
+
+        int suppressed = m_suppressed.fetchAndStoreRelaxed(0);
+        if (suppressed > 0) {
+            LOG_INFO() << m_category << "-" << suppressed
+                       << "similar messages suppressed";
+        }
+    }
+
+    int count = m_count.fetchAndAddRelaxed(1);
+    if (count < m_rate || (count - m_rate) % m_sampling == 0) {
+        return true;
+    }
+
+    m_suppressed.fetchAndAddRelaxed(1);
+    return false;
+}
+
+///
+/// The origin is the first call to this function, and the initialization of
+/// the local static variable is guaranteed to be thread-safe.
+///
+int LogLimiter::seconds()
+{
+    static const QElapsedTimer origin = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return static_cast<int>(origin.elapsed() / 1000);
+}
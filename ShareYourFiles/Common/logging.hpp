@@ -0,0 +1,98 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LOGGING_HPP
+#define LOGGING_HPP
+
+#include <Logger.h>
+
+#include <QAtomicInt>
+
+// The debug and trace messages are elided at compile time when requested (i.e.
+// in release builds), following the same approach of QT_NO_DEBUG_OUTPUT: the
+// statement is still compiled, but never evaluated. Hence, the sources must
+// include this header in place of Logger.h for the elision to be effective.
+#ifdef SYF_NO_DEBUG_LOG
+#undef LOG_TRACE
+#undef LOG_DEBUG
+#define LOG_TRACE while (false) QMessageLogger().noDebug
+#define LOG_DEBUG while (false) QMessageLogger().noDebug
+#endif
+
+///
+/// \brief Writes an information message only if allowed by a LogLimiter.
+///
+/// The arguments following the macro are not evaluated in case the message is
+/// suppressed, hence no formatting is performed.
+///
+#define LOG_INFO_LIMITED(limiter) if (!(limiter).allow()) {} else LOG_INFO
+
+///
+/// \brief The LogLimiter class provides rate limiting and sampling for a
+/// category of log messages.
+///
+/// Some messages (e.g. the ones printed for every file transferred) may be
+/// generated at a very high rate, flooding the log without adding information.
+/// An instance of this class, usually static and shared by all the messages of
+/// a category, allows up to a given number of messages every second; beyond
+/// that, only one message out of a given number is sampled. The number of
+/// messages suppressed is reported in the log once the following second
+/// begins and a new message of the category is generated.
+///
+/// The class is thread-safe and lock-free: the counters are approximated in
+/// case of concurrent accesses at the boundaries of a second.
+///
+class LogLimiter
+{
+public:
+    ///
+    /// \brief Constructs a new LogLimiter.
+    /// \param category the name of the category (reported in the log).
+    /// \param rate the number of messages allowed every second.
+    /// \param sampling the fraction of the messages exceeding the rate which
+    /// is sampled (one out of sampling).
+    ///
+    explicit LogLimiter(const char *category, int rate = DEFAULT_RATE,
+                        int sampling = DEFAULT_SAMPLING);
+
+    ///
+    /// \brief Returns whether a new message of the category is to be written.
+    ///
+    bool allow();
+
+    /// \brief The default number of messages allowed every second.
+    static const int DEFAULT_RATE = 20;
+    /// \brief The default sampling applied to the exceeding messages.
+    static const int DEFAULT_SAMPLING = 100;
+
+private:
+    /// \brief Returns the number of seconds elapsed since a common origin.
+    static int seconds();
+
+private:
+    const char *m_category; ///< \brief The name of the category.
+    const int m_rate;       ///< \brief The messages allowed every second.
+    const int m_sampling;   ///< \brief The sampling of exceeding messages.
+
+    QAtomicInt m_second;     ///< \brief The second being counted.
+    QAtomicInt m_count;      ///< \brief The messages of the current second.
+    QAtomicInt m_suppressed; ///< \brief The messages not yet reported.
+};
+
+#endif // LOGGING_HPP
@@ -17,13 +17,12 @@
  */
 
 #include "networkentrieslist.hpp"
-
-#include <Logger.h>
+#include "coalescedtimer.hpp"
+#include "logging.hpp"
 
 #include <QAbstractSocket>
 #include <QHostAddress>
 #include <QNetworkInterface>
-#include <QTimer>
 
 // Static variables definition
 const NetworkEntriesList::Entry NetworkEntriesList::InvalidEntry =
@@ -53,10 +52,10 @@ static void logEntries(const QVector<NetworkEntriesList::Entry> &entries)
 NetworkEntriesList::NetworkEntriesList(QObject *parent)
         : QObject(parent),
           m_entries(buildEntriesList()),
-          m_timer(new QTimer(this))
+          m_timer(new CoalescedTimer(this))
 {
     // Connect the slot and start the timer to update the list
-    connect(m_timer, &QTimer::timeout, this,
+    connect(m_timer, &CoalescedTimer::timeout, this,
             &NetworkEntriesList::updateEntries);
     m_timer->start(NetworkEntriesList::UPDATE_INTERVAL);
 
@@ -24,9 +24,9 @@
 #include <QPointer>
 #include <QVector>
 
+class CoalescedTimer;
 class QHostAddress;
 class QNetworkInterface;
-class QTimer;
 
 ///
 /// \brief The NetworkInterfacesList class represents the list of pairs network
@@ -113,7 +113,7 @@ private:
     QVector<Entry> m_entries;
 
     /// \brief The timer used to update the entries every UPDATE_INTERVAL ms.
-    QPointer<QTimer> m_timer;
+    QPointer<CoalescedTimer> m_timer;
 
     /// \brief The interval between subsequent updates (in milliseconds).
     static const int UPDATE_INTERVAL = 30000;
@@ -0,0 +1,182 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "startupsequence.hpp"
+#include "logging.hpp"
+
+#include <QThread>
+#include <QTimer>
+
+///
+/// The clock is started immediately, so that all the timings reported refer to
+/// the creation of the sequence.
+///
+StartupSequence::StartupSequence(QObject *parent)
+        : QObject(parent), m_running(0), m_failed(false)
+{
+    m_clock.start();
+}
+
+///
+/// The phase is executed synchronously and its timing is reported in the log
+/// as for the other tasks.
+///
+bool StartupSequence::run(const QString &name, const Task &task)
+{
+    qint64 started = m_clock.elapsed();
+    bool success = task();
+    qint64 duration = m_clock.elapsed() - started;
+
+    LOG_INFO() << "StartupSequence:" << qUtf8Printable(name)
+               << (success ? "completed" : "failed") << "after" << duration
+               << "ms (started at" << started << "ms)";
+    return success;
+}
+
+void StartupSequence::addTask(const QString &name,
+                              const QStringList &dependencies,
+                              const Task &task, QThread *thread)
+{
+    LOG_ASSERT_X(!m_tasks.contains(name),
+                 "StartupSequence: task already added");
+
+    Entry entry;
+    entry.dependencies = dependencies;
+    entry.task = task;
+    entry.thread = thread;
+    entry.started = false;
+    entry.completed = false;
+    m_tasks.insert(name, entry);
+}
+
+///
+/// The dependencies are verified to refer to tasks belonging to the sequence,
+/// and then the tasks without dependencies are started.
+///
+void StartupSequence::start()
+{
+    for (auto it = m_tasks.cbegin(); it != m_tasks.cend(); ++it) {
+        foreach (const QString &dependency, it.value().dependencies) {
+            LOG_ASSERT_X(m_tasks.contains(dependency),
+                         "StartupSequence: unknown dependency");
+        }
+    }
+
+    dispatch();
+
+    LOG_ASSERT_X(m_tasks.isEmpty() || m_running > 0,
+                 "StartupSequence: circular dependencies detected");
+
+    // An empty sequence terminates immediately
+    if (m_tasks.isEmpty()) {
+        QTimer::singleShot(0, this, [this]() { emit finished(true); });
+    }
+}
+
+///
+/// The outcome is logged, and in case of success the tasks depending on the
+/// completed one are started. When no task is running anymore, the sequence
+/// terminates and the finished() signal is emitted.
+///
+void StartupSequence::taskFinished(const QString &name, bool success,
+                                   qint64 started, qint64 duration)
+{
+    LOG_INFO() << "StartupSequence:" << qUtf8Printable(name)
+               << (success ? "completed" : "failed") << "after" << duration
+               << "ms (started at" << started << "ms)";
+
+    m_running--;
+    m_tasks[name].completed = success;
+    m_failed = m_failed || !success;
+
+    if (!m_failed) {
+        dispatch();
+    }
+
+    if (m_running > 0) {
+        return;
+    }
+
+    // Tasks never started (i.e. circular dependencies) make the sequence fail
+    foreach (const Entry &entry, m_tasks) {
+        if (!entry.started) {
+            LOG_ERROR() << "StartupSequence: unsatisfiable dependencies";
+            m_failed = true;
+            break;
+        }
+    }
+
+    LOG_INFO() << "StartupSequence:" << (m_failed ? "aborted" : "completed")
+               << "after" << m_clock.elapsed() << "ms";
+    emit finished(!m_failed);
+}
+
+void StartupSequence::dispatch()
+{
+    for (auto it = m_tasks.begin(); it != m_tasks.end(); ++it) {
+        Entry &entry = it.value();
+        if (entry.started) {
+            continue;
+        }
+
+        bool ready = true;
+        foreach (const QString &dependency, entry.dependencies) {
+            ready = ready && m_tasks.value(dependency).completed;
+        }
+
+        if (ready) {
+            entry.started = true;
+            m_running++;
+            execute(it.key(), entry);
+        }
+    }
+}
+
+///
+/// The task is posted to the event loop of the target thread through a
+/// temporary context object, so that it is executed there; the outcome is
+/// then posted back to the thread of the sequence. Only the copy of the
+/// function and the (thread-safe) clock are accessed by the other thread.
+///
+void StartupSequence::execute(const QString &name, const Entry &entry)
+{
+    QObject *context = this;
+    if (entry.thread && entry.thread != thread()) {
+        context = new QObject();
+        context->moveToThread(entry.thread);
+    }
+
+    Task task = entry.task;
+    QTimer::singleShot(0, context, [this, context, name, task]() {
+        qint64 started = m_clock.elapsed();
+        bool success = task();
+        qint64 duration = m_clock.elapsed() - started;
+
+        bool result = QMetaObject::invokeMethod(
+            this, "taskFinished", Qt::QueuedConnection, Q_ARG(QString, name),
+            Q_ARG(bool, success), Q_ARG(qint64, started),
+            Q_ARG(qint64, duration));
+        LOG_ASSERT_X(result,
+                     "StartupSequence: failed invoking taskFinished()");
+
+        if (context != this) {
+            context->deleteLater();
+        }
+    });
+}
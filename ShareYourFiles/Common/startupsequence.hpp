@@ -0,0 +1,146 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef STARTUPSEQUENCE_HPP
+#define STARTUPSEQUENCE_HPP
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+
+#include <functional>
+
+class QThread;
+
+///
+/// \brief The StartupSequence class executes the initialization phases of the
+/// application as a graph of dependent tasks.
+///
+/// Each task is identified by a name, depends on a (possibly empty) set of
+/// other tasks and runs in a given thread: a task is started as soon as all its
+/// dependencies are completed, so that independent phases are carried out in
+/// parallel while the event loop of the owner thread keeps running. The tasks
+/// executed in the owner thread are dispatched through the event loop as well.
+///
+/// The time elapsed since the beginning of the sequence and the duration of
+/// every phase are reported in the log, in order to track startup regressions.
+/// As soon as a task fails, no other task is started and the finished() signal
+/// is emitted once the running ones terminate.
+///
+class StartupSequence : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief The function executed by a task, returning whether it succeeded.
+    ///
+    using Task = std::function<bool()>;
+
+    ///
+    /// \brief Constructs a new empty StartupSequence and starts its clock.
+    /// \param parent the parent of the current object.
+    ///
+    explicit StartupSequence(QObject *parent = Q_NULLPTR);
+
+    ///
+    /// \brief Executes immediately a phase in the current thread.
+    /// \param name the name of the phase (reported in the log).
+    /// \param task the function to be executed.
+    /// \return the value returned by the task.
+    ///
+    /// This function is meant for the phases that must be completed before the
+    /// sequence is started (e.g. the ones the others depend on implicitly).
+    ///
+    bool run(const QString &name, const Task &task);
+
+    ///
+    /// \brief Adds a new task to the sequence.
+    /// \param name the name of the task (unique in the sequence).
+    /// \param dependencies the names of the tasks to be completed before.
+    /// \param task the function to be executed.
+    /// \param thread the thread where the task is executed (null to use the
+    /// thread of the sequence).
+    ///
+    void addTask(const QString &name, const QStringList &dependencies,
+                 const Task &task, QThread *thread = Q_NULLPTR);
+
+    ///
+    /// \brief Starts the tasks that do not depend on any other one.
+    ///
+    void start();
+
+signals:
+    ///
+    /// \brief Signal emitted when the sequence terminates.
+    /// \param success whether all the tasks succeeded or not.
+    ///
+    void finished(bool success);
+
+private slots:
+    ///
+    /// \brief Records the outcome of a task and starts the ones depending on
+    /// it (executed in the thread of the sequence).
+    /// \param name the name of the task.
+    /// \param success whether the task succeeded or not.
+    /// \param started the instant when the task started (in milliseconds from
+    /// the beginning of the sequence).
+    /// \param duration the time taken by the task (in milliseconds).
+    ///
+    void taskFinished(const QString &name, bool success, qint64 started,
+                      qint64 duration);
+
+private:
+    ///
+    /// \brief The Entry struct stores the information about a task.
+    ///
+    struct Entry {
+        QStringList dependencies; ///< \brief The tasks to be completed before.
+        Task task;                ///< \brief The function to be executed.
+        QPointer<QThread> thread; ///< \brief The thread of execution.
+        bool started;             ///< \brief Whether the task has started.
+        bool completed;           ///< \brief Whether the task has completed.
+    };
+
+    ///
+    /// \brief Starts all the tasks whose dependencies are completed.
+    ///
+    void dispatch();
+
+    ///
+    /// \brief Executes a task in its thread.
+    /// \param name the name of the task.
+    /// \param entry the information about the task.
+    ///
+    void execute(const QString &name, const Entry &entry);
+
+private:
+    /// \brief The clock measuring the time since the creation of the sequence.
+    QElapsedTimer m_clock;
+    /// \brief The tasks belonging to the sequence.
+    QMap<QString, Entry> m_tasks;
+    /// \brief The number of tasks started and not yet completed.
+    int m_running;
+    /// \brief Whether some task failed or not.
+    bool m_failed;
+};
+
+#endif // STARTUPSEQUENCE_HPP
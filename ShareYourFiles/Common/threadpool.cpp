@@ -17,8 +17,7 @@
  */
 
 #include "threadpool.hpp"
-
-#include <Logger.h>
+#include "logging.hpp"
 
 #include <QThread>
 
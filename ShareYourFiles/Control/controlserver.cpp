@@ -0,0 +1,667 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "controlserver.hpp"
+#include "Common/coalescedtimer.hpp"
+#include "Common/logging.hpp"
+#include "FileTransfer/syfftprotocolsender.hpp"
+#include "FileTransfer/transferinfo.hpp"
+#include "FileTransfer/transferlistbuilder.hpp"
+#include "UserDiscovery/syfdprotocol.hpp"
+#include "UserDiscovery/user.hpp"
+#include "UserDiscovery/users.hpp"
+#include "shareyourfiles.hpp"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMetaEnum>
+#include <QTimer>
+
+// Static variables definition
+const QString ControlServer::SERVER_NAME = QString("SYFControlProtocol");
+
+///
+/// The instance is created by building the local server and the timer used to
+/// send the progress events. In service mode, the handler in charge of
+/// tracking and accepting the incoming connections is also connected.
+///
+ControlServer::ControlServer(bool service, QObject *parent)
+        : QObject(parent),
+          m_service(service),
+          m_server(new QLocalServer(this)),
+          m_nextId(0),
+          m_duplicatedAction(
+              SyfftProtocolReceiver::DuplicatedFileAction::Keep),
+          m_timerProgress(new CoalescedTimer(this))
+{
+    // Allow only the current user to connect
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+
+    // Connect to the handler for a new client
+    connect(m_server, &QLocalServer::newConnection, this,
+            &ControlServer::newConnection);
+
+    // Forward the changes of the peers list to the subscribers
+    PeersList *peersList = ShareYourFiles::instance()->peersList();
+    connect(peersList, &PeersList::peerAdded, this, [this](QString uuid) {
+        broadcast("peerAdded", QJsonObject{{"uuid", uuid}});
+    });
+    connect(peersList, &PeersList::peerExpired, this, [this](QString uuid) {
+        broadcast("peerExpired", QJsonObject{{"uuid", uuid}});
+    });
+
+    // Send the progress of the transfers periodically
+    m_timerProgress->setInterval(ControlServer::PROGRESS_INTERVAL);
+    connect(m_timerProgress, &CoalescedTimer::timeout, this,
+            &ControlServer::sendProgress);
+
+    // Handle the incoming transfers
+    if (m_service) {
+        connect(ShareYourFiles::instance()->localUser(),
+                &LocalUser::connectionRequested, this,
+                [this](QSharedPointer<SyfftProtocolReceiver> receiver) {
+                    addTransfer(receiver, false);
+                    receiver->acceptConnection(this, "transferRequested", this,
+                                               "duplicatedFile");
+                });
+    }
+}
+
+///
+/// The pending sharing requests are rejected by the destructors of the
+/// corresponding objects, while the server and the clients are destroyed
+/// automatically since they are children of the current instance.
+///
+ControlServer::~ControlServer()
+{
+    LOG_INFO() << "ControlServer: stopped";
+}
+
+///
+/// The server is configured in listening state, after having removed the
+/// instance possibly left by a crash.
+///
+bool ControlServer::start(const QString &name)
+{
+    LOG_ASSERT_X(!m_server->isListening(), "ControlServer: already started");
+
+    // Remove the server instance (if present) to avoid problems after a crash
+    QLocalServer::removeServer(name);
+
+    // Start listening for requests
+    if (!m_server->listen(name)) {
+        LOG_ERROR() << "ControlServer: impossible to start the server -"
+                    << m_server->serverError();
+        return false;
+    }
+
+    LOG_INFO() << "ControlServer: started listening on"
+               << qUtf8Printable(m_server->fullServerName())
+               << (m_service ? "(service mode)" : "");
+    return true;
+}
+
+///
+/// In case a receive directory is set, the request is accepted. Otherwise, it
+/// is recorded and advertised to the subscribed clients, which can take the
+/// decision through the accept and reject commands; if no client is subscribed,
+/// the request is rejected (by the destructor of the object representing it).
+///
+void ControlServer::transferRequested(
+    QSharedPointer<SyfftProtocolSharingRequest> request)
+{
+    if (!m_receiveDirectory.isEmpty()) {
+        request->accept(m_receiveDirectory);
+        return;
+    }
+
+    if (m_subscribers.isEmpty()) {
+        LOG_INFO() << "ControlServer: sharing request rejected (no client"
+                      " subscribed)";
+        return;
+    }
+
+    quint32 id = m_nextId++;
+    m_requests.insert(id, request);
+
+    // Forget the request if the connection is aborted
+    connect(request.data(), &SyfftProtocolSharingRequest::connectionAborted,
+            this, [this, id]() {
+                m_requests.remove(id);
+                broadcast("requestAborted", QJsonObject{{"request", int(id)}});
+            });
+
+    broadcast("sharingRequest",
+              QJsonObject{
+                  {"request", int(id)},
+                  {"peer", request->senderUuid()},
+                  {"totalFiles", double(request->totalFiles())},
+                  {"totalBytes", double(request->totalSize())},
+                  {"message", request->message()},
+              });
+}
+
+void ControlServer::duplicatedFile(
+    QSharedPointer<SyfftProtocolDuplicatedFile> file)
+{
+    using Action = SyfftProtocolReceiver::DuplicatedFileAction;
+    switch (m_duplicatedAction) {
+    case Action::Replace:
+        file->replace(true);
+        break;
+    case Action::KeepBoth:
+        file->keepBoth(true);
+        break;
+    case Action::Keep:
+    case Action::Ask:
+        file->keep(true);
+        break;
+    }
+}
+
+///
+/// For each client connected, the handlers to read the requests and to release
+/// the resources after the disconnection are connected.
+///
+void ControlServer::newConnection()
+{
+    while (m_server->hasPendingConnections()) {
+        QLocalSocket *client = m_server->nextPendingConnection();
+
+        connect(client, &QLocalSocket::readyRead, this,
+                [this, client]() { readRequests(client); });
+        connect(client, &QLocalSocket::disconnected, this, [this, client]() {
+            m_subscribers.remove(client);
+            if (m_subscribers.isEmpty()) {
+                m_timerProgress->stop();
+            }
+            client->deleteLater();
+        });
+    }
+}
+
+///
+/// Every complete line is parsed as a JSON object and executed, while the
+/// client is disconnected in case a request longer than MAX_REQUEST_LEN is
+/// received.
+///
+void ControlServer::readRequests(QLocalSocket *client)
+{
+    while (client->canReadLine()) {
+        QByteArray line = client->readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        QJsonParseError error;
+        QJsonDocument document = QJsonDocument::fromJson(line, &error);
+        if (!document.isObject()) {
+            write(client, failure("Invalid request: " + error.errorString()));
+            continue;
+        }
+
+        QJsonObject request = document.object();
+        QJsonObject reply = execute(client, request);
+        if (reply.isEmpty()) {
+            // The reply is sent once the request completes
+            continue;
+        }
+        if (request.contains("id")) {
+            reply.insert("id", request.value("id"));
+        }
+        write(client, reply);
+    }
+
+    if (client->bytesAvailable() > ControlServer::MAX_REQUEST_LEN) {
+        LOG_WARNING() << "ControlServer: request too long, client disconnected";
+        client->abort();
+    }
+}
+
+QJsonObject ControlServer::execute(QLocalSocket *client,
+                                   const QJsonObject &request)
+{
+    QString command = request.value("command").toString();
+
+    if (command == "status") {
+        return status();
+    }
+    if (command == "peers") {
+        return peers();
+    }
+    if (command == "send") {
+        return send(client, request);
+    }
+    if (command == "transfers") {
+        return transfers();
+    }
+    if (command == "pause" || command == "resume" || command == "abort") {
+        return control(command, request);
+    }
+    if (command == "subscribe") {
+        m_subscribers.insert(client);
+        if (!m_timerProgress->isActive()) {
+            m_timerProgress->start();
+        }
+        return QJsonObject{{"ok", true}};
+    }
+
+    if (!m_service && (command == "receive" || command == "accept" ||
+                       command == "reject" || command == "quit")) {
+        return failure("Command available only in service mode: " + command);
+    }
+    if (command == "receive") {
+        return receive(request);
+    }
+    if (command == "accept" || command == "reject") {
+        return decide(command, request);
+    }
+    if (command == "quit") {
+        QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+        return QJsonObject{{"ok", true}};
+    }
+
+    return failure("Unknown command: " + command);
+}
+
+///
+/// Apart from the information about the local user, the reply reports the
+/// number of discovery datagrams dropped by the rate limiter of the SYFD
+/// protocol (the counters are read atomically, being updated by the SYFD
+/// thread, and restart from zero when the network entry changes).
+///
+QJsonObject ControlServer::status() const
+{
+    LocalUser *localUser = ShareYourFiles::instance()->localUser();
+    UserInfo me = localUser->info();
+
+    SyfdProtocol *syfd = ShareYourFiles::instance()->syfdProtocolInstance();
+    qint64 droppedBySource = (syfd) ? syfd->droppedBySource() : 0;
+    qint64 droppedGlobally = (syfd) ? syfd->droppedGlobally() : 0;
+
+    return QJsonObject{
+        {"ok", true},
+        {"uuid", me.uuid()},
+        {"firstName", me.firstName()},
+        {"lastName", me.lastName()},
+        {"address", QHostAddress(me.ipv4Address()).toString()},
+        {"dataPort", me.dataPort()},
+        {"mode", (localUser->mode() == Enums::OperationalMode::Online)
+                     ? "online"
+                     : "offline"},
+        {"service", m_service},
+        {"droppedBySource", droppedBySource},
+        {"droppedGlobally", droppedGlobally},
+    };
+}
+
+QJsonObject ControlServer::peers() const
+{
+    QJsonArray peers;
+    foreach (const UserInfo &info,
+             ShareYourFiles::instance()->peersList()->activePeers()) {
+        peers.append(QJsonObject{
+            {"uuid", info.uuid()},
+            {"firstName", info.firstName()},
+            {"lastName", info.lastName()},
+            {"address", QHostAddress(info.ipv4Address()).toString()},
+            {"dataPort", info.dataPort()},
+        });
+    }
+    return QJsonObject{{"ok", true}, {"peers", peers}};
+}
+
+///
+/// The recipient is looked up by UUID among the active peers and, if not
+/// found, by IPv4 address. The list of files is then built in background by a
+/// TransferListBuilder (the directories may contain a large number of files),
+/// and the transfer is started, and the reply sent, once it completes.
+///
+QJsonObject ControlServer::send(QLocalSocket *client,
+                                const QJsonObject &request)
+{
+    PeersList *peersList = ShareYourFiles::instance()->peersList();
+    QHash<QString, UserInfo> active = peersList->activePeers();
+
+    // Look for the recipient
+    QString to = request.value("to").toString();
+    QString uuid;
+    if (active.contains(to)) {
+        uuid = to;
+    } else {
+        bool isIPv4 = false;
+        quint32 address = QHostAddress(to).toIPv4Address(&isIPv4);
+        for (auto it = active.constBegin(); isIPv4 && it != active.constEnd();
+             ++it) {
+            if (it.value().ipv4Address() == address) {
+                uuid = it.key();
+                break;
+            }
+        }
+    }
+    if (uuid.isEmpty()) {
+        return failure("Unknown or inactive peer: " + to);
+    }
+
+    // Build the list of files
+    QStringList paths;
+    foreach (const QJsonValue &path, request.value("paths").toArray()) {
+        paths.append(QDir().absoluteFilePath(path.toString()));
+    }
+
+    TransferListBuilder *builder = new TransferListBuilder(this);
+    QPointer<QLocalSocket> socket(client);
+    connect(builder, &TransferListBuilder::finished, this,
+            [this, builder, socket, request,
+             uuid](const TransferList &transferList) {
+                builder->deleteLater();
+
+                QJsonObject reply = startTransfer(
+                    uuid, transferList, request.value("message").toString());
+                if (request.contains("id")) {
+                    reply.insert("id", request.value("id"));
+                }
+
+                // The client may have disconnected in the meanwhile
+                if (socket &&
+                    socket->state() == QLocalSocket::ConnectedState) {
+                    write(socket, reply);
+                }
+            });
+
+    builder->append(paths);
+    builder->finish();
+    return QJsonObject();
+}
+
+///
+/// A new sender instance is started, anonymously in case the local user is
+/// offline (as done by the user interface), and advertised through the
+/// transferStarted() signal.
+///
+QJsonObject ControlServer::startTransfer(const QString &uuid,
+                                         const TransferList &transferList,
+                                         const QString &message)
+{
+    if (transferList.totalFiles() == 0) {
+        return failure("No files to be sent");
+    }
+
+    QSharedPointer<SyfftProtocolSender> sender =
+        ShareYourFiles::instance()->peersList()->newSyfftInstance(
+            uuid, ShareYourFiles::instance()->localUser()->mode() ==
+                      Enums::OperationalMode::Offline);
+    if (sender.isNull()) {
+        return failure("Impossible to contact the peer: " + uuid);
+    }
+
+    quint32 id = addTransfer(sender, true);
+    emit transferStarted(sender);
+    sender->sendFiles(transferList, message);
+
+    return QJsonObject{{"ok", true}, {"transfer", int(id)}};
+}
+
+QJsonObject ControlServer::transfers() const
+{
+    QJsonArray transfers;
+    for (auto it = m_transfers.constBegin(); it != m_transfers.constEnd();
+         ++it) {
+        transfers.append(toJson(it.key(), it.value()));
+    }
+    return QJsonObject{{"ok", true}, {"transfers", transfers}};
+}
+
+QJsonObject ControlServer::control(const QString &command,
+                                   const QJsonObject &request)
+{
+    quint32 id = static_cast<quint32>(request.value("transfer").toInt(-1));
+    auto it = m_transfers.constFind(id);
+    if (it == m_transfers.constEnd()) {
+        return failure("Unknown transfer");
+    }
+
+    if (terminated(it.value())) {
+        return failure("Transfer already terminated");
+    }
+
+    const QSharedPointer<SyfftProtocolCommon> &instance = it.value().instance;
+    if (command == "abort") {
+        instance->terminateConnection();
+    } else {
+        instance->changePauseMode(command == "pause");
+    }
+    return QJsonObject{{"ok", true}};
+}
+
+///
+/// The receive directory is changed only if the "directory" field is present
+/// (an empty value disables the automatic acceptance), and the same holds for
+/// the action performed for the duplicated files ("duplicates" field, one of
+/// "replace", "keep" and "keepboth"). The current settings are returned.
+///
+QJsonObject ControlServer::receive(const QJsonObject &request)
+{
+    using Action = SyfftProtocolReceiver::DuplicatedFileAction;
+    static const QMap<QString, Action> ACTIONS{{"replace", Action::Replace},
+                                               {"keep", Action::Keep},
+                                               {"keepboth", Action::KeepBoth}};
+
+    if (request.contains("duplicates")) {
+        QString duplicates = request.value("duplicates").toString();
+        if (!ACTIONS.contains(duplicates)) {
+            return failure("Invalid duplicates action: " + duplicates);
+        }
+        m_duplicatedAction = ACTIONS.value(duplicates);
+    }
+
+    if (request.contains("directory")) {
+        QString directory = request.value("directory").toString();
+        m_receiveDirectory = (directory.isEmpty())
+                                 ? QString()
+                                 : QDir().absoluteFilePath(directory);
+    }
+
+    LOG_INFO() << "ControlServer: receive directory"
+               << (m_receiveDirectory.isEmpty() ? "not set"
+                                                : qUtf8Printable(
+                                                      m_receiveDirectory));
+
+    return QJsonObject{{"ok", true},
+                       {"directory", m_receiveDirectory},
+                       {"duplicates", ACTIONS.key(m_duplicatedAction)}};
+}
+
+///
+/// The files are received in the "directory" field of the request or, if not
+/// specified, in the receive directory; in case neither is available, the
+/// request cannot be accepted.
+///
+QJsonObject ControlServer::decide(const QString &command,
+                                  const QJsonObject &request)
+{
+    quint32 id = static_cast<quint32>(request.value("request").toInt(-1));
+    if (!m_requests.contains(id)) {
+        return failure("Unknown sharing request");
+    }
+
+    QString message = request.value("message").toString();
+    if (command == "reject") {
+        m_requests.take(id)->reject(message);
+        return QJsonObject{{"ok", true}};
+    }
+
+    QString directory = request.value("directory").toString();
+    directory = (directory.isEmpty()) ? m_receiveDirectory
+                                      : QDir().absoluteFilePath(directory);
+    if (directory.isEmpty()) {
+        return failure("No directory specified");
+    }
+
+    m_requests.take(id)->accept(directory, message);
+    return QJsonObject{{"ok", true}};
+}
+
+///
+/// The transfer is assigned a new identifier and the status changes are
+/// forwarded to the subscribed clients.
+///
+quint32 ControlServer::addTransfer(
+    const QSharedPointer<SyfftProtocolCommon> &instance, bool sender)
+{
+    quint32 id = m_nextId++;
+    Transfer transfer;
+    transfer.instance = instance;
+    transfer.summary.sender = sender;
+    m_transfers.insert(id, transfer);
+
+    connect(instance.data(), &SyfftProtocolCommon::statusChanged, this,
+            [this, id]() { transferStatusChanged(id); });
+
+    broadcast("transferAdded", toJson(id, transfer));
+    return id;
+}
+
+///
+/// Once the transfer is terminated, its final status and statistics are
+/// stored in the summary and the instance is released (and hence deleted,
+/// unless still referenced elsewhere, e.g. by the user interface).
+///
+void ControlServer::transferStatusChanged(quint32 id)
+{
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end() || terminated(it.value())) {
+        return;
+    }
+
+    Transfer &transfer = it.value();
+    SyfftProtocolCommon::Status status = transfer.instance->status();
+    if (terminated(status)) {
+        transfer.summary.status = status;
+        transfer.summary.peerUuid = transfer.instance->peerUuid();
+        transfer.summary.info = transfer.instance->transferInfo();
+
+        disconnect(transfer.instance.data(), Q_NULLPTR, this, Q_NULLPTR);
+        transfer.instance.clear();
+    }
+
+    broadcast("transferStatus", toJson(id, transfer));
+    if (terminated(status)) {
+        pruneTransfers();
+    }
+}
+
+void ControlServer::pruneTransfers()
+{
+    QList<quint32> terminatedIds;
+    for (auto it = m_transfers.constBegin(); it != m_transfers.constEnd();
+         ++it) {
+        if (terminated(it.value())) {
+            terminatedIds.append(it.key());
+        }
+    }
+
+    for (int i = 0; i < terminatedIds.count() - ControlServer::MAX_TERMINATED;
+         i++) {
+        m_transfers.remove(terminatedIds.at(i));
+    }
+}
+
+void ControlServer::sendProgress()
+{
+    for (auto it = m_transfers.constBegin(); it != m_transfers.constEnd();
+         ++it) {
+        if (!terminated(it.value())) {
+            broadcast("transferProgress", toJson(it.key(), it.value()));
+        }
+    }
+}
+
+void ControlServer::broadcast(const QString &event, QJsonObject data)
+{
+    if (m_subscribers.isEmpty()) {
+        return;
+    }
+
+    data.insert("event", event);
+    foreach (QLocalSocket *client, m_subscribers) {
+        write(client, data);
+    }
+}
+
+void ControlServer::write(QLocalSocket *client, const QJsonObject &object)
+{
+    client->write(QJsonDocument(object).toJson(QJsonDocument::Compact));
+    client->write("\n");
+}
+
+QJsonObject ControlServer::failure(const QString &message)
+{
+    return QJsonObject{{"ok", false}, {"error", message}};
+}
+
+///
+/// The object contains the identifier of the peer, the status of the transfer
+/// and all the statistics provided by TransferInfo (times in ms, speeds in
+/// bytes per second). For terminated transfers, they are read from the
+/// summary.
+///
+QJsonObject ControlServer::toJson(quint32 id, const Transfer &transfer)
+{
+    const TransferRecord &summary = transfer.summary;
+    bool ended = terminated(transfer);
+
+    TransferInfo info =
+        (ended) ? summary.info : transfer.instance->transferInfo();
+    const char *status =
+        QMetaEnum::fromType<SyfftProtocolCommon::Status>().valueToKey(
+            static_cast<int>((ended) ? summary.status
+                                     : transfer.instance->status()));
+
+    return QJsonObject{
+        {"transfer", int(id)},
+        {"sender", summary.sender},
+        {"peer", (ended) ? summary.peerUuid : transfer.instance->peerUuid()},
+        {"status", status},
+        {"totalFiles", double(info.totalFiles())},
+        {"transferredFiles", double(info.transferredFiles())},
+        {"skippedFiles", double(info.skippedFiles())},
+        {"totalBytes", double(info.totalBytes())},
+        {"transferredBytes", double(info.transferredBytes())},
+        {"skippedBytes", double(info.skippedBytes())},
+        {"elapsedTime", double(info.elapsedTime())},
+        {"transferTime", double(info.transferTime())},
+        {"pausedTime", double(info.pausedTime())},
+        {"remainingTime", double(info.remainingTime())},
+        {"averageSpeed", info.averageTransferSpeed()},
+        {"currentSpeed", info.currentTransferSpeed()},
+        {"fileInTransfer", info.fileInTransfer()},
+    };
+}
+
+bool ControlServer::terminated(SyfftProtocolCommon::Status status)
+{
+    return status == SyfftProtocolCommon::Status::Closed ||
+           status == SyfftProtocolCommon::Status::Aborted;
+}
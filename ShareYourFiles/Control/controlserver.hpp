@@ -0,0 +1,288 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CONTROLSERVER_HPP
+#define CONTROLSERVER_HPP
+
+#include "FileTransfer/syfftprotocolreceiver.hpp"
+#include "FileTransfer/syfftprotocolsender.hpp"
+#include "FileTransfer/transferhistory.hpp"
+
+#include <QJsonObject>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QSharedPointer>
+
+class CoalescedTimer;
+class QLocalServer;
+class QLocalSocket;
+class TransferList;
+
+///
+/// \brief The ControlServer class provides a local IPC interface to control
+/// Share Your Files from other processes.
+///
+/// The clients connect to a local socket (accessible only by the current user)
+/// and exchange JSON objects, each one on a separate line. Every request
+/// contains a "command" field and, optionally, an "id" field copied to the
+/// corresponding reply, which includes the "ok" field and, in case of failure,
+/// an "error" field describing the problem. The following commands are
+/// supported:
+/// - status: returns the information about the local user and the number of
+///   discovery datagrams dropped to protect from storms;
+/// - peers: returns the list of the active peers;
+/// - send: sends the files identified by "paths" to the peer identified by
+///   "to" (either its UUID or its IPv4 address), attaching "message"; since
+///   the files are enumerated in background, the reply may follow the ones of
+///   subsequent requests (the "id" field allows matching them);
+/// - transfers: returns the list of transfers, with their statistics;
+/// - pause, resume, abort: control the transfer identified by "transfer";
+/// - subscribe: enables the events, sent without "id" and with an "event"
+///   field, regarding peers, transfers (including the progress, every
+///   PROGRESS_INTERVAL ms) and sharing requests;
+/// - receive, accept, reject, quit: available only in service mode (see
+///   below), respectively set the directory where the files are automatically
+///   received and the action performed for duplicated files, accept or reject
+///   a pending sharing request and terminate the application.
+///
+/// When executed in service mode (i.e. without the user interface), the
+/// instance also handles the incoming transfers: the sharing requests not
+/// already accepted or rejected according to the reception preferences are
+/// accepted if a receive directory is set, forwarded to the subscribed clients
+/// otherwise (or rejected in case no client is subscribed).
+///
+/// Once terminated, the transfers are kept (up to MAX_TERMINATED) only as a
+/// summary of their final status and statistics, while the protocol instances
+/// are released together with their list of files.
+///
+/// The user interface does not attach to a service instance as a client yet:
+/// it still runs the protocols in its own process, and the service mode is
+/// meant for hosts without a graphical environment.
+///
+class ControlServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// \brief The default name used to listen for connections.
+    static const QString SERVER_NAME;
+
+    ///
+    /// \brief Constructs a new instance of the server.
+    /// \param service specifies whether the application is running in service
+    /// mode (i.e. the instance handles the incoming transfers).
+    /// \param parent the parent of the current object.
+    ///
+    explicit ControlServer(bool service, QObject *parent = Q_NULLPTR);
+
+    ///
+    /// \brief Terminates the server and disconnects the clients.
+    ///
+    ~ControlServer();
+
+    ///
+    /// \brief Starts listening for connections.
+    /// \param name the name used to listen for connections.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool start(const QString &name = SERVER_NAME);
+
+signals:
+    ///
+    /// \brief Signal emitted when a transfer is started by the send command.
+    /// \param sender the instance carrying out the transfer.
+    ///
+    void transferStarted(QSharedPointer<SyfftProtocolSender> sender);
+
+private slots:
+    ///
+    /// \brief Handles a sharing request received in service mode.
+    /// \param request the object representing the request.
+    ///
+    void transferRequested(QSharedPointer<SyfftProtocolSharingRequest> request);
+
+    ///
+    /// \brief Handles a duplicated file detected in service mode.
+    /// \param file the object representing the duplicated file.
+    ///
+    void duplicatedFile(QSharedPointer<SyfftProtocolDuplicatedFile> file);
+
+private:
+    ///
+    /// \brief The Transfer struct represents a transfer tracked by the server.
+    ///
+    struct Transfer {
+        /// \brief The instance carrying out the transfer (null once
+        /// terminated).
+        QSharedPointer<SyfftProtocolCommon> instance;
+        /// \brief The direction of the transfer and, once terminated, its
+        /// final status, peer and statistics.
+        TransferRecord summary;
+    };
+
+    ///
+    /// \brief Function executed when a new client is ready to be accepted.
+    ///
+    void newConnection();
+
+    ///
+    /// \brief Reads and executes the requests received from a client.
+    /// \param client the socket connected to the client.
+    ///
+    void readRequests(QLocalSocket *client);
+
+    ///
+    /// \brief Executes a request.
+    /// \param client the socket connected to the client.
+    /// \param request the request to be executed.
+    /// \return the reply to be sent to the client, or an empty object if the
+    /// reply is sent once the request completes.
+    ///
+    QJsonObject execute(QLocalSocket *client, const QJsonObject &request);
+
+    /// \brief Executes the status command.
+    QJsonObject status() const;
+    /// \brief Executes the peers command.
+    QJsonObject peers() const;
+    /// \brief Executes the send command.
+    QJsonObject send(QLocalSocket *client, const QJsonObject &request);
+
+    ///
+    /// \brief Starts a transfer requested by the send command.
+    /// \param uuid the identifier of the recipient.
+    /// \param transferList the files to be sent.
+    /// \param message the message attached to the request.
+    /// \return the reply to be sent to the client.
+    ///
+    QJsonObject startTransfer(const QString &uuid,
+                              const TransferList &transferList,
+                              const QString &message);
+    /// \brief Executes the transfers command.
+    QJsonObject transfers() const;
+    /// \brief Executes the pause, resume and abort commands.
+    QJsonObject control(const QString &command, const QJsonObject &request);
+    /// \brief Executes the receive command.
+    QJsonObject receive(const QJsonObject &request);
+    /// \brief Executes the accept and reject commands.
+    QJsonObject decide(const QString &command, const QJsonObject &request);
+
+    ///
+    /// \brief Starts tracking a transfer.
+    /// \param instance the instance carrying out the transfer.
+    /// \param sender whether the local user is the sender.
+    /// \return the identifier assigned to the transfer.
+    ///
+    quint32 addTransfer(const QSharedPointer<SyfftProtocolCommon> &instance,
+                        bool sender);
+
+    ///
+    /// \brief Handles a change of status of a transfer, releasing the
+    /// instance once terminated.
+    /// \param id the identifier of the transfer.
+    ///
+    void transferStatusChanged(quint32 id);
+
+    ///
+    /// \brief Stops tracking the oldest terminated transfers, if more than
+    /// MAX_TERMINATED are present.
+    ///
+    void pruneTransfers();
+
+    ///
+    /// \brief Sends the progress of the ongoing transfers to the subscribers.
+    ///
+    void sendProgress();
+
+    ///
+    /// \brief Sends an event to all the subscribed clients.
+    /// \param event the name of the event.
+    /// \param data the content of the event.
+    ///
+    void broadcast(const QString &event, QJsonObject data = QJsonObject());
+
+    ///
+    /// \brief Sends an object to a client.
+    /// \param client the socket connected to the client.
+    /// \param object the object to be sent.
+    ///
+    static void write(QLocalSocket *client, const QJsonObject &object);
+
+    ///
+    /// \brief Builds a reply describing a failure.
+    /// \param message the description of the error.
+    ///
+    static QJsonObject failure(const QString &message);
+
+    ///
+    /// \brief Converts a transfer to a JSON object.
+    /// \param id the identifier of the transfer.
+    /// \param transfer the transfer to be converted.
+    ///
+    static QJsonObject toJson(quint32 id, const Transfer &transfer);
+
+    ///
+    /// \brief Returns whether the given status represents a terminated
+    /// transfer.
+    ///
+    static bool terminated(SyfftProtocolCommon::Status status);
+
+    ///
+    /// \brief Returns whether a transfer is terminated (i.e. its instance has
+    /// been released).
+    ///
+    static bool terminated(const Transfer &transfer)
+    {
+        return transfer.instance.isNull();
+    }
+
+private:
+    /// \brief Specifies whether the application is running in service mode.
+    bool m_service;
+
+    /// \brief The server listening for connections.
+    QPointer<QLocalServer> m_server;
+    /// \brief The clients that subscribed to the events.
+    QSet<QLocalSocket *> m_subscribers;
+
+    /// \brief The identifier assigned to the next transfer or request.
+    quint32 m_nextId;
+    /// \brief The transfers tracked, ordered by identifier.
+    QMap<quint32, Transfer> m_transfers;
+    /// \brief The sharing requests waiting for the decision of a client.
+    QMap<quint32, QSharedPointer<SyfftProtocolSharingRequest>> m_requests;
+
+    /// \brief The directory where the files are automatically received.
+    QString m_receiveDirectory;
+    /// \brief The action performed when a duplicated file is detected.
+    SyfftProtocolReceiver::DuplicatedFileAction m_duplicatedAction;
+
+    /// \brief The timer used to send the progress of the transfers.
+    QPointer<CoalescedTimer> m_timerProgress;
+
+    /// \brief The interval between two progress events (in ms).
+    static const int PROGRESS_INTERVAL = 1000;
+    /// \brief The maximum number of terminated transfers kept.
+    static const int MAX_TERMINATED = 100;
+    /// \brief The maximum length of a request (in bytes).
+    static const qint64 MAX_REQUEST_LEN = 4 * 1024 * 1024;
+};
+
+#endif // CONTROLSERVER_HPP
@@ -17,8 +17,7 @@
  */
 
 #include "fileinfo.hpp"
-
-#include <Logger.h>
+#include "Common/logging.hpp"
 
 #include <QDataStream>
 #include <QDir>
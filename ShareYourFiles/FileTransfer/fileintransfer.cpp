@@ -17,8 +17,7 @@
  */
 
 #include "fileintransfer.hpp"
-
-#include <Logger.h>
+#include "Common/logging.hpp"
 
 ///
 /// The member fields are initialized, partially according to the parameters,
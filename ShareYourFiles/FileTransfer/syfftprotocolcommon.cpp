@@ -18,11 +18,10 @@
 
 #include "syfftprotocolcommon.hpp"
 #include "Common/common.hpp"
+#include "Common/logging.hpp"
 #include "fileintransfer.hpp"
 #include "transferinfo.hpp"
 
-#include <Logger.h>
-
 #include <QDataStream>
 #include <QElapsedTimer>
 #include <QTcpSocket>
@@ -169,6 +168,55 @@ TransferInfo SyfftProtocolCommon::transferInfo()
     return *m_transferInfo;
 }
 
+///
+/// Only the requested entries are copied (the strings they contain are
+/// implicitly shared), so that the list can be browsed without duplicating it
+/// entirely. The lock is acquired since the list may be modified concurrently
+/// by the thread owning the current object.
+///
+QVector<FileInfo> SyfftProtocolCommon::files(int first, int count) const
+{
+    QMutexLocker lk(&m_mutex);
+
+    first = qBound(0, first, m_files.count());
+    count = qBound(0, count, m_files.count() - first);
+    return m_files.mid(first, count);
+}
+
+///
+/// The two lists of indexes are both sorted, hence they are merged without
+/// scanning the list of files: only the returned entries are accessed. An
+/// index present in both lists (i.e. a skipped file then marked as failed
+/// because of an abort) is returned once.
+///
+QVector<FileInfo> SyfftProtocolCommon::unsuccessfulFiles(int max) const
+{
+    QMutexLocker lk(&m_mutex);
+
+    QVector<FileInfo> files;
+    files.reserve(qMin(max, m_failedFiles.count() + m_skippedFiles.count()));
+
+    int failed = 0, skipped = 0;
+    while (files.count() < max && (failed < m_failedFiles.count() ||
+                                   skipped < m_skippedFiles.count())) {
+        quint32 index;
+        if (skipped == m_skippedFiles.count() ||
+            (failed < m_failedFiles.count() &&
+             m_failedFiles.at(failed) < m_skippedFiles.at(skipped))) {
+            index = m_failedFiles.at(failed++);
+        } else if (failed < m_failedFiles.count() &&
+                   m_failedFiles.at(failed) == m_skippedFiles.at(skipped)) {
+            index = m_failedFiles.at(failed++);
+            skipped++;
+        } else {
+            index = m_skippedFiles.at(skipped++);
+        }
+        files << m_files.at(static_cast<int>(index));
+    }
+
+    return files;
+}
+
 ///
 /// The pause mode is modified, according to the specified request, by the
 /// togglePauseMode() method, which is invoked through a timer in order to
@@ -267,15 +315,15 @@ void SyfftProtocolCommon::abortConnection()
     m_transferInfo->m_skippedFiles += m_transferInfo->remainingFiles();
     m_transferInfo->m_skippedBytes += m_transferInfo->remainingBytes();
 
-    // Delete the file in transfer instance and mark the current file as
-    // TransferFailed (if any)
-    if (m_currentFile < m_transferInfo->totalFiles()) {
-        m_files[static_cast<int>(m_currentFile)].setStatus(
-            FileInfo::Status::TransferFailed);
-    }
+    // Delete the file in transfer instance
     m_fileInTransfer.reset();
     lk.unlock();
 
+    // Mark the current file as TransferFailed (if any)
+    if (m_currentFile < m_transferInfo->totalFiles()) {
+        setFileStatus(FileInfo::Status::TransferFailed);
+    }
+
     // Send the abort code (if the socket is valid and connected)
     if (m_socket->isValid() &&
         m_socket->state() == QTcpSocket::ConnectedState) {
@@ -384,6 +432,27 @@ void SyfftProtocolCommon::togglePauseMode(bool userRequested)
     }
 }
 
+///
+/// The transaction started is committed by the function handling the command
+/// once the data following the command code has been read as well.
+///
+bool SyfftProtocolCommon::readCommand(QDataStream &stream,
+                                      CommandType &command)
+{
+    // Start a new transaction
+    stream.startTransaction();
+
+    // Read the received command
+    stream >> command;
+
+    // Check if the command has been received correctly
+    if (stream.status() != QDataStream::Status::Ok) {
+        stream.rollbackTransaction();
+        return false;
+    }
+    return true;
+}
+
 ///
 /// The function advances the current file counter and then it checks if all
 /// the files has already been transferred. In this case, the status is changed
@@ -392,10 +461,10 @@ void SyfftProtocolCommon::togglePauseMode(bool userRequested)
 ///
 bool SyfftProtocolCommon::moveToNextFile()
 {
+    QMutexLocker lk(&m_mutex);
     m_currentFile++;
 
     // Already transferred all files
-    QMutexLocker lk(&m_mutex);
     if (m_currentFile == m_transferInfo->totalFiles()) {
         // Update the transfer information and the status
         m_transferInfo->m_fileInTransfer = QString();
@@ -420,3 +489,22 @@ bool SyfftProtocolCommon::moveToNextFile()
         m_files.at(static_cast<int>(m_currentFile)).filePath();
     return true;
 }
+
+///
+/// In case the transfer of the file failed (or the file was skipped), its index
+/// is also added to the list of failed (or skipped) files.
+///
+void SyfftProtocolCommon::setFileStatus(FileInfo::Status status)
+{
+    QMutexLocker lk(&m_mutex);
+    if (m_currentFile >= static_cast<quint32>(m_files.count())) {
+        return;
+    }
+
+    m_files[static_cast<int>(m_currentFile)].setStatus(status);
+    if (status == FileInfo::Status::TransferFailed) {
+        m_failedFiles << m_currentFile;
+    } else if (status == FileInfo::Status::TransferRejected) {
+        m_skippedFiles << m_currentFile;
+    }
+}
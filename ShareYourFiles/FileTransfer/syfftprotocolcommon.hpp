@@ -176,6 +176,53 @@ public:
     ///
     TransferInfo transferInfo();
 
+    ///
+    /// \brief Returns the number of entries of the list of files (received so
+    /// far, in case of the receiver).
+    ///
+    int filesCount() const
+    {
+        QMutexLocker lk(&m_mutex);
+        return m_files.count();
+    }
+
+    ///
+    /// \brief Returns a range of entries of the list of files, together with
+    /// their current status.
+    /// \param first the index of the first entry requested.
+    /// \param count the maximum number of entries requested.
+    /// \return the entries (fewer than requested if the list is shorter).
+    ///
+    QVector<FileInfo> files(int first, int count) const;
+
+    ///
+    /// \brief Returns the index of the file currently in transfer (or the
+    /// number of files if the transfer is completed).
+    ///
+    quint32 currentFile() const
+    {
+        QMutexLocker lk(&m_mutex);
+        return m_currentFile;
+    }
+
+    ///
+    /// \brief Returns the indexes of the files whose transfer failed (in
+    /// ascending order).
+    ///
+    QVector<quint32> failedFiles() const
+    {
+        QMutexLocker lk(&m_mutex);
+        return m_failedFiles;
+    }
+
+    ///
+    /// \brief Returns the entries of the files whose transfer failed or was
+    /// skipped (in ascending order), to be kept once the instance is freed.
+    /// \param max the maximum number of entries returned.
+    /// \return the entries, together with their status.
+    ///
+    QVector<FileInfo> unsuccessfulFiles(int max) const;
+
     ///
     /// \brief Enters or exits the pause mode, depending on the parameter.
     /// \param enterPauseMode a value specifying whether the user wants to enter
@@ -293,6 +340,16 @@ protected:
     SyfftProtocolCommon(const QString &localUuid, const QString &peerUuid,
                         QTcpSocket *socket, QObject *parent = Q_NULLPTR);
 
+    ///
+    /// \brief Starts a new transaction on the stream and reads the code of the
+    /// following command.
+    /// \param stream the stream associated to the communication channel.
+    /// \param command the variable set to the command code read.
+    /// \return true in case of success and false if the data is not yet
+    /// available (the transaction is rolled back).
+    ///
+    static bool readCommand(QDataStream &stream, CommandType &command);
+
     ///
     /// \brief Increments the file counter and checks if the transfer finished.
     /// \return true if there are still files to be transferred and false
@@ -300,6 +357,13 @@ protected:
     ///
     bool moveToNextFile();
 
+    ///
+    /// \brief Sets the status of the file currently in transfer in a
+    /// thread-safe manner (the mutex must not be held).
+    /// \param status the status to be set.
+    ///
+    void setFileStatus(FileInfo::Status status);
+
     ///
     /// \brief Returns a string which identifies the current instance of the
     /// protocol (to be printed to the log).
@@ -344,10 +408,16 @@ protected:
     QScopedPointer<TransferInfo> m_transferInfo;
 
     QDir m_basePath; ///< \brief The path the files are relative to.
-    /// \brief The list of files to be transferred or received.
+    /// \brief The list of files to be transferred or received (mutex required
+    /// for modifications and for accesses from other threads).
     QVector<FileInfo> m_files;
+    /// \brief The indexes of the files whose transfer failed (mutex required).
+    QVector<quint32> m_failedFiles;
+    /// \brief The indexes of the files that were skipped (mutex required).
+    QVector<quint32> m_skippedFiles;
 
-    /// \brief The index identifying the file currently in transfer.
+    /// \brief The index identifying the file currently in transfer (mutex
+    /// required for modifications and for accesses from other threads).
     quint32 m_currentFile;
     /// \brief An object representing the file currently in transfer.
     QScopedPointer<FileInTransfer> m_fileInTransfer;
@@ -18,11 +18,11 @@
 
 #include "syfftprotocolreceiver.hpp"
 #include "Common/common.hpp"
+#include "Common/logging.hpp"
+#include "UserDiscovery/receptionpolicy.hpp"
 #include "fileintransfer.hpp"
 #include "transferinfo.hpp"
 
-#include <Logger.h>
-
 #include <QDataStream>
 #include <QElapsedTimer>
 #include <QTcpSocket>
@@ -43,6 +43,9 @@ static MetaTypeRegistration<QSharedPointer<SyfftProtocolDuplicatedFile>>
 static MetaTypeRegistration<SyfftProtocolReceiver::DuplicatedFileAction>
     actionRegisterer("DuplicatedFileAction");
 
+/// \brief The limiter shared by the messages printed for every file received.
+static LogLimiter fileLogLimiter("SyfftProtocolReceiver: per-file messages");
+
 ///
 /// The instance is initialized by executing the SyfftProtocolCommon constructor
 /// for what concerns the common parts and the timeout is started. The signals
@@ -52,11 +55,13 @@ static MetaTypeRegistration<SyfftProtocolReceiver::DuplicatedFileAction>
 ///
 /// \see SyfftProtocolReceiver::acceptConnection()
 ///
-SyfftProtocolReceiver::SyfftProtocolReceiver(const QString &localUuid,
-                                             QTcpSocket *socket,
-                                             QObject *parent)
+SyfftProtocolReceiver::SyfftProtocolReceiver(
+    const QString &localUuid, QTcpSocket *socket,
+    const QSharedPointer<const ReceptionPolicy> &receptionPolicy,
+    QObject *parent)
         : SyfftProtocolCommon(localUuid, UNKNOWN_UUID, socket, parent),
-          m_defaultDFAction(DuplicatedFileAction::Ask)
+          m_defaultDFAction(DuplicatedFileAction::Ask),
+          m_receptionPolicy(receptionPolicy)
 {
     // Block the signals until acceptConnection is executed
     m_socket->blockSignals(true);
@@ -134,16 +139,9 @@ void SyfftProtocolReceiver::readData()
     while (m_socket->bytesAvailable() >=
            static_cast<qint64>(sizeof(CommandType))) {
 
-        // Start a new transaction
-        m_stream->startTransaction();
-
-        // Read the received command
+        // Read the received command (in a new transaction)
         CommandType command;
-        *m_stream >> command;
-
-        // Check if the command has been received correctly
-        if (m_stream->status() != QDataStream::Status::Ok) {
-            m_stream->rollbackTransaction();
+        if (!readCommand(*m_stream, command)) {
             return;
         }
 
@@ -307,8 +305,11 @@ bool SyfftProtocolReceiver::ackCommand()
 ///
 /// On the other hand, if it represents the end of the request (i.e. all the
 /// information about the files has already been correctly received) the
-/// connection is paused, a new SyfftProtocolSharingRequest is built and the
-/// slot in charge of accepting or rejecting the connection is executed.
+/// ReceptionPolicy is checked: in case the preferences associated to the peer
+/// specify to automatically accept or reject the request, it is done directly
+/// in the current thread. Otherwise, the connection is paused, a new
+/// SyfftProtocolSharingRequest is built and the slot in charge of accepting or
+/// rejecting the connection is executed.
 ///
 bool SyfftProtocolReceiver::shareCommand()
 {
@@ -371,7 +372,10 @@ bool SyfftProtocolReceiver::shareCommand()
         }
 
         if (totalBytes != m_transferInfo->m_totalBytes) {
+            QMutexLocker lk(&m_mutex);
             m_files.clear();
+            lk.unlock();
+
             manageError(
                 "Invalid FileInfo received following the sharing request");
             return false;
@@ -382,6 +386,20 @@ bool SyfftProtocolReceiver::shareCommand()
                    << "sharing request received for" << totalFiles << "files -"
                    << qUtf8Printable(sizeToHRFormat(totalBytes));
 
+        // Apply the reception preferences, if they do not require to ask
+        QString path;
+        ReceptionPreferences::Action action =
+            (m_receptionPolicy) ? m_receptionPolicy->decide(m_peerUuid, path)
+                                : ReceptionPreferences::Action::Ask;
+        if (action == ReceptionPreferences::Action::Accept) {
+            sendSharingAccept(path, QString());
+            return true;
+        }
+        if (action == ReceptionPreferences::Action::Reject) {
+            sendSharingReject(QString());
+            return true;
+        }
+
         // Build a new SyfftProtocolSharingRequest instance
         SyfftProtocolSharingRequest *request = new SyfftProtocolSharingRequest(
             m_peerUuid, totalFiles, totalBytes, m_files, m_shareMsg);
@@ -442,23 +460,47 @@ bool SyfftProtocolReceiver::itemCommand()
     }
 
     // Try reading the file information
-    FileInfo file;
-    *m_stream >> file;
+    switch (readItem(*m_stream, m_files, m_mutex)) {
+    case ReadResult::Ok:
+        return true;
 
     // Still missing data
-    if (!m_stream->commitTransaction()) {
+    case ReadResult::Incomplete:
         return false;
-    }
 
     // Wrong file info data received
-    if (!file.valid()) {
-        m_stream->rollbackTransaction();
+    case ReadResult::Invalid:
         manageError("Invalid FileInfo received following the sharing request");
         return false;
     }
+    return false;
+}
 
-    m_files.push_back(file);
-    return true;
+///
+/// The information about the file is read in the transaction started by
+/// readCommand(), which is committed only if the data is complete; in case the
+/// information is not valid, the transaction is rolled back instead. The
+/// mutex is held only while the file is appended to the list.
+///
+SyfftProtocolReceiver::ReadResult
+SyfftProtocolReceiver::readItem(QDataStream &stream, QVector<FileInfo> &files,
+                                QMutex &mutex)
+{
+    FileInfo file;
+    stream >> file;
+
+    if (!stream.commitTransaction()) {
+        return ReadResult::Incomplete;
+    }
+
+    if (!file.valid()) {
+        stream.rollbackTransaction();
+        return ReadResult::Invalid;
+    }
+
+    QMutexLocker lk(&mutex);
+    files.push_back(file);
+    return ReadResult::Ok;
 }
 
 ///
@@ -585,8 +627,9 @@ bool SyfftProtocolReceiver::skipCommand()
         return false;
     }
 
-    LOG_INFO() << qUtf8Printable(logSyfftId()) << "file transfer skipped"
-               << m_files.at(static_cast<int>(m_currentFile)).name();
+    LOG_INFO_LIMITED(fileLogLimiter)()
+        << qUtf8Printable(logSyfftId()) << "file transfer skipped"
+        << m_files.at(static_cast<int>(m_currentFile)).name();
 
     // Send the REJECT command to confirm the reception
     *m_stream << static_cast<CommandType>(Command::REJECT);
@@ -598,8 +641,7 @@ bool SyfftProtocolReceiver::skipCommand()
         m_files.at(static_cast<int>(m_currentFile)).size();
     lk.unlock();
 
-    m_files[static_cast<int>(m_currentFile)].setStatus(
-        FileInfo::Status::TransferFailed);
+    setFileStatus(FileInfo::Status::TransferFailed);
 
     moveToNextFile();
     return true;
@@ -692,15 +734,15 @@ bool SyfftProtocolReceiver::commitCommand()
 
     // Check if it is possible to commit the file
     if (m_fileInTransfer->commit()) {
-        LOG_INFO() << qUtf8Printable(logSyfftId()) << "file transfer committed"
-                   << m_fileInTransfer->relativePath();
+        LOG_INFO_LIMITED(fileLogLimiter)()
+            << qUtf8Printable(logSyfftId()) << "file transfer committed"
+            << m_fileInTransfer->relativePath();
 
         // Acknowledge the commit
         *m_stream << static_cast<CommandType>(Command::COMMIT);
 
         // Update the transfer information
-        m_files[static_cast<int>(m_currentFile)].setStatus(
-            FileInfo::Status::Transferred);
+        setFileStatus(FileInfo::Status::Transferred);
 
         QMutexLocker lk(&m_mutex);
         m_transferInfo->m_transferredFiles++;
@@ -717,8 +759,7 @@ bool SyfftProtocolReceiver::commitCommand()
         *m_stream << static_cast<CommandType>(Command::ROLLBK);
 
         // Update the transfer information
-        m_files[static_cast<int>(m_currentFile)].setStatus(
-            FileInfo::Status::TransferFailed);
+        setFileStatus(FileInfo::Status::TransferFailed);
 
         QMutexLocker lk(&m_mutex);
         m_transferInfo->m_skippedFiles++;
@@ -761,8 +802,7 @@ bool SyfftProtocolReceiver::rollbkCommand()
     *m_stream << static_cast<CommandType>(Command::ROLLBK);
 
     // Otherwise update the transfer information and move to the next file
-    m_files[static_cast<int>(m_currentFile)].setStatus(
-        FileInfo::Status::TransferFailed);
+    setFileStatus(FileInfo::Status::TransferFailed);
 
     QMutexLocker lk(&m_mutex);
     m_transferInfo->m_skippedFiles++;
@@ -801,9 +841,10 @@ bool SyfftProtocolReceiver::closeCommand()
 }
 
 ///
-/// The function is in charge of sending the ACCEPT command to the peer,
-/// followed by the attached textual message; the status is then changed to
-/// InTransfer and the statusChanged() signal is emitted.
+/// The function exits the pause mode entered while waiting for the decision
+/// and, if the connection is still active, sends the ACCEPT command.
+///
+/// \see sendSharingAccept()
 ///
 void SyfftProtocolReceiver::acceptSharingRequest(const QString &path,
                                                  const QString &message)
@@ -817,6 +858,37 @@ void SyfftProtocolReceiver::acceptSharingRequest(const QString &path,
         return;
     }
 
+    sendSharingAccept(path, message);
+}
+
+///
+/// The function exits the pause mode entered while waiting for the decision
+/// and, if the connection is still active, sends the REJECT command.
+///
+/// \see sendSharingReject()
+///
+void SyfftProtocolReceiver::rejectSharingRequest(const QString &message)
+{
+    // Exit pause mode
+    m_preventUserTogglePause = false;
+    togglePauseMode(true);
+
+    // The connection has already been aborted
+    if (m_status == Status::Aborted) {
+        return;
+    }
+
+    sendSharingReject(message);
+}
+
+///
+/// The function is in charge of sending the ACCEPT command to the peer,
+/// followed by the attached textual message; the status is then changed to
+/// InTransfer and the statusChanged() signal is emitted.
+///
+void SyfftProtocolReceiver::sendSharingAccept(const QString &path,
+                                              const QString &message)
+{
     // Check if the specified path is feasible
     QDir directory(path);
     LOG_INFO() << qUtf8Printable(logSyfftId()) << "base path:"
@@ -852,17 +924,8 @@ void SyfftProtocolReceiver::acceptSharingRequest(const QString &path,
 /// followed by the attached textual message; the connection is then
 /// politely closed.
 ///
-void SyfftProtocolReceiver::rejectSharingRequest(const QString &message)
+void SyfftProtocolReceiver::sendSharingReject(const QString &message)
 {
-    // Exit pause mode
-    m_preventUserTogglePause = false;
-    togglePauseMode(true);
-
-    // The connection has already been aborted
-    if (m_status == Status::Aborted) {
-        return;
-    }
-
     // Send the REJECT command and the message to the peer (as UTF8 encoded
     // string)
     QString trimmed = message.left(SyfftProtocolReceiver::MAX_MSG_LEN);
@@ -886,13 +949,13 @@ void SyfftProtocolReceiver::rejectSharingRequest(const QString &message)
 ///
 void SyfftProtocolReceiver::acceptFileTransfer()
 {
-    LOG_INFO() << qUtf8Printable(logSyfftId()) << "file transfer accepted"
-               << m_fileInTransfer->relativePath();
+    LOG_INFO_LIMITED(fileLogLimiter)()
+        << qUtf8Printable(logSyfftId()) << "file transfer accepted"
+        << m_fileInTransfer->relativePath();
     *m_stream << static_cast<CommandType>(Command::ACCEPT);
 
     // Update the transfer information
-    m_files[static_cast<int>(m_currentFile)].setStatus(
-        FileInfo::Status::InTransfer);
+    setFileStatus(FileInfo::Status::InTransfer);
 }
 
 ///
@@ -901,14 +964,14 @@ void SyfftProtocolReceiver::acceptFileTransfer()
 ///
 void SyfftProtocolReceiver::rejectFileTransfer()
 {
-    LOG_INFO() << qUtf8Printable(logSyfftId()) << "file transfer rejected"
-               << m_fileInTransfer->relativePath();
+    LOG_INFO_LIMITED(fileLogLimiter)()
+        << qUtf8Printable(logSyfftId()) << "file transfer rejected"
+        << m_fileInTransfer->relativePath();
     *m_stream << static_cast<CommandType>(Command::REJECT);
 
     // Update the transfer information
     m_fileInTransfer.reset();
-    m_files[static_cast<int>(m_currentFile)].setStatus(
-        FileInfo::Status::TransferRejected);
+    setFileStatus(FileInfo::Status::TransferRejected);
 
     QMutexLocker lk(&m_mutex);
     m_transferInfo->m_skippedFiles++;
@@ -992,7 +1055,10 @@ void SyfftProtocolReceiver::performDFAction(DuplicatedFileAction action)
 
         // If the file does not already exist, start the transfer
         if (!newFileWriter->exists()) {
+            QMutexLocker lk(&m_mutex);
             m_files[static_cast<int>(m_currentFile)] = newFile;
+            lk.unlock();
+
             m_fileInTransfer.reset(newFileWriter.take());
             acceptFileTransfer();
             return;
@@ -21,6 +21,10 @@
 
 #include "syfftprotocolcommon.hpp"
 
+#include <QSharedPointer>
+
+class ReceptionPolicy;
+
 ///
 /// \brief The SyfftProtocolReceiver class provides an implementation of the
 /// receiving side of the SYFFT protocol.
@@ -48,10 +52,15 @@ public:
     /// \brief Constructs a new instance of SYFFT Protocol Receiver.
     /// \param localUuid the UUID representing the local user.
     /// \param socket the connected socket to be used for the communication.
+    /// \param receptionPolicy the snapshot of the reception preferences, used
+    /// to accept or reject the sharing requests without asking the handler.
     /// \param parent the parent of the current object.
     ///
-    explicit SyfftProtocolReceiver(const QString &localUuid, QTcpSocket *socket,
-                                   QObject *parent = Q_NULLPTR);
+    explicit SyfftProtocolReceiver(
+        const QString &localUuid, QTcpSocket *socket,
+        const QSharedPointer<const ReceptionPolicy> &receptionPolicy =
+            QSharedPointer<const ReceptionPolicy>(),
+        QObject *parent = Q_NULLPTR);
 
     ///
     /// \brief Starts the handshake to complete the connection.
@@ -68,6 +77,28 @@ public:
                           QObject *duplicateHandler,
                           const char *duplicateHandlerSlot);
 
+protected:
+    ///
+    /// \brief The ReadResult enum describes the outcome of the decoding of
+    /// the data following a command.
+    ///
+    enum class ReadResult {
+        Ok,         ///< \brief The data has been read correctly.
+        Incomplete, ///< \brief Still missing data (to be read again).
+        Invalid     ///< \brief Invalid data received.
+    };
+
+    ///
+    /// \brief Reads the information about a file following an ITEM command
+    /// and appends it to the list of files.
+    /// \param stream the stream associated to the communication channel.
+    /// \param files the list the file is appended to.
+    /// \param mutex the mutex protecting the list.
+    /// \return the outcome of the operation.
+    ///
+    static ReadResult readItem(QDataStream &stream, QVector<FileInfo> &files,
+                               QMutex &mutex);
+
 private slots:
     ///
     /// \brief Function executed when some data is ready to be read from
@@ -137,18 +168,31 @@ private:
     bool closeCommand();
 
     ///
-    /// \brief Accepts the sharing request.
+    /// \brief Accepts the sharing request, exiting the pause mode.
     /// \param path the path where received files will be stored.
     /// \param message an optional message to the peer.
     ///
     void acceptSharingRequest(const QString &path, const QString &message);
 
     ///
-    /// \brief Rejects the sharing request.
+    /// \brief Rejects the sharing request, exiting the pause mode.
     /// \param message an optional message to the peer.
     ///
     void rejectSharingRequest(const QString &message);
 
+    ///
+    /// \brief Sends the ACCEPT command and starts receiving the files.
+    /// \param path the path where received files will be stored.
+    /// \param message an optional message to the peer.
+    ///
+    void sendSharingAccept(const QString &path, const QString &message);
+
+    ///
+    /// \brief Sends the REJECT command and closes the connection.
+    /// \param message an optional message to the peer.
+    ///
+    void sendSharingReject(const QString &message);
+
     ///
     /// \brief Accepts the reception of the current file.
     ///
@@ -181,6 +225,9 @@ private:
 
     /// \brief The message received following the SHARE command.
     QString m_shareMsg;
+
+    /// \brief The snapshot of the reception preferences.
+    QSharedPointer<const ReceptionPolicy> m_receptionPolicy;
 };
 
 
@@ -18,12 +18,11 @@
 
 #include "syfftprotocolsender.hpp"
 #include "Common/common.hpp"
+#include "Common/logging.hpp"
 #include "fileintransfer.hpp"
 #include "transferinfo.hpp"
 #include "transferlist.hpp"
 
-#include <Logger.h>
-
 #include <QDataStream>
 #include <QElapsedTimer>
 #include <QHostAddress>
@@ -35,6 +34,9 @@
 static MetaTypeRegistration<SyfftProtocolSender::PeerStatus>
     peerStatusRegisterer("PeerStatus");
 
+/// \brief The limiter shared by the messages printed for every file sent.
+static LogLimiter fileLogLimiter("SyfftProtocolSender: per-file messages");
+
 
 ///
 /// The instance is initialized by executing the SyfftProtocolCommon
@@ -94,12 +96,12 @@ void SyfftProtocolSender::sendFiles(const TransferList &files,
             m_status == Status::New,
             qUtf8Printable(logSyfftId() + " instance not in New status"));
 
-        // Set the base directory and the files to be shared
+        // Set the base directory and the files to be shared, together with
+        // their total number and size
         m_basePath = QDir(files.basePath());
-        m_files = files.m_files;
 
-        // Set the total number and size of the files
         QMutexLocker lk(&m_mutex);
+        m_files = files.m_files;
         m_transferInfo->m_totalFiles = files.totalFiles();
         m_transferInfo->m_totalBytes = files.totalBytes();
         lk.unlock();
@@ -211,16 +213,9 @@ void SyfftProtocolSender::readData()
     while (m_socket->bytesAvailable() >=
            static_cast<qint64>(sizeof(CommandType))) {
 
-        // Start a new transaction
-        m_stream->startTransaction();
-
-        // Read the received command
+        // Read the received command (in a new transaction)
         CommandType command;
-        *m_stream >> command;
-
-        // Check if the command has been received correctly
-        if (m_stream->status() != QDataStream::Status::Ok) {
-            m_stream->rollbackTransaction();
+        if (!readCommand(*m_stream, command)) {
             return;
         }
 
@@ -309,8 +304,9 @@ void SyfftProtocolSender::transferNextFile()
     // Otherwise send the START command
     else {
         *m_stream << static_cast<CommandType>(Command::START);
-        LOG_INFO() << qUtf8Printable(logSyfftId()) << "file transfer started"
-                   << m_fileInTransfer->relativePath();
+        LOG_INFO_LIMITED(fileLogLimiter)()
+            << qUtf8Printable(logSyfftId()) << "file transfer started"
+            << m_fileInTransfer->relativePath();
     }
 }
 
@@ -486,12 +482,12 @@ bool SyfftProtocolSender::acceptCommand()
     if (m_status == Status::InTransfer && m_fileInTransfer &&
         !m_fileInTransfer->error() && !m_fileInTransfer->transferStarted()) {
 
-        LOG_INFO() << qUtf8Printable(logSyfftId()) << "file transfer accepted"
-                   << m_fileInTransfer->relativePath();
+        LOG_INFO_LIMITED(fileLogLimiter)()
+            << qUtf8Printable(logSyfftId()) << "file transfer accepted"
+            << m_fileInTransfer->relativePath();
 
         // Start sending the actual data
-        m_files[static_cast<int>(m_currentFile)].setStatus(
-            FileInfo::Status::InTransfer);
+        setFileStatus(FileInfo::Status::InTransfer);
 
         sendDataChunks();
         return true;
@@ -550,8 +546,9 @@ bool SyfftProtocolSender::rejectCommand()
     if (m_status == Status::InTransfer && m_fileInTransfer &&
         !m_fileInTransfer->transferStarted()) {
 
-        LOG_INFO() << qUtf8Printable(logSyfftId()) << "file transfer rejected"
-                   << m_fileInTransfer->relativePath();
+        LOG_INFO_LIMITED(fileLogLimiter)()
+            << qUtf8Printable(logSyfftId()) << "file transfer rejected"
+            << m_fileInTransfer->relativePath();
 
         // Update the transfer information and move to the next file
         QMutexLocker lk(&m_mutex);
@@ -559,9 +556,9 @@ bool SyfftProtocolSender::rejectCommand()
         m_transferInfo->m_skippedBytes += m_fileInTransfer->remainingBytes();
         lk.unlock();
 
-        m_files[static_cast<int>(m_currentFile)].setStatus(
-            m_fileInTransfer->error() ? FileInfo::Status::TransferFailed
-                                      : FileInfo::Status::TransferRejected);
+        setFileStatus(m_fileInTransfer->error()
+                          ? FileInfo::Status::TransferFailed
+                          : FileInfo::Status::TransferRejected);
 
         transferNextFile();
         return true;
@@ -593,12 +590,12 @@ bool SyfftProtocolSender::commitCommand()
         return false;
     }
 
-    LOG_INFO() << qUtf8Printable(logSyfftId()) << "file transfer committed"
-               << m_fileInTransfer->relativePath();
+    LOG_INFO_LIMITED(fileLogLimiter)()
+        << qUtf8Printable(logSyfftId()) << "file transfer committed"
+        << m_fileInTransfer->relativePath();
 
     // Otherwise update the transfer information and move to the next file
-    m_files[static_cast<int>(m_currentFile)].setStatus(
-        FileInfo::Status::Transferred);
+    setFileStatus(FileInfo::Status::Transferred);
 
     QMutexLocker lk(&m_mutex);
     m_transferInfo->m_transferredFiles++;
@@ -634,8 +631,7 @@ bool SyfftProtocolSender::rollbkCommand()
                << m_fileInTransfer->relativePath();
 
     // Otherwise update the transfer information and move to the next file
-    m_files[static_cast<int>(m_currentFile)].setStatus(
-        FileInfo::Status::TransferFailed);
+    setFileStatus(FileInfo::Status::TransferFailed);
 
     QMutexLocker lk(&m_mutex);
     m_transferInfo->m_skippedFiles++;
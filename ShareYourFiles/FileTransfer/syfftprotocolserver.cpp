@@ -18,10 +18,9 @@
 
 #include "syfftprotocolserver.hpp"
 #include "Common/common.hpp"
+#include "Common/logging.hpp"
 #include "syfftprotocolreceiver.hpp"
 
-#include <Logger.h>
-
 #include <QTcpServer>
 #include <QTcpSocket>
 
@@ -33,10 +32,13 @@ static MetaTypeRegistration<QSharedPointer<SyfftProtocolReceiver>>
 /// The instance is created by building a new TCP server and connecting
 /// the handlers to manage new connections and possible errors.
 ///
-SyfftProtocolServer::SyfftProtocolServer(const QString &localUuid,
-                                         QObject *parent)
+SyfftProtocolServer::SyfftProtocolServer(
+    const QString &localUuid,
+    const QSharedPointer<const ReceptionPolicy> &receptionPolicy,
+    QObject *parent)
         : QObject(parent),
           m_localUuid(localUuid),
+          m_receptionPolicy(receptionPolicy),
           m_server(new QTcpServer(this))
 {
     // Connect to the handler for a new request
@@ -100,7 +102,7 @@ void SyfftProtocolServer::newConnection()
 
         // Create a new SyfftProtocolReceiver instance
         SyfftProtocolReceiver *instance = new SyfftProtocolReceiver(
-            m_localUuid, m_server->nextPendingConnection());
+            m_localUuid, m_server->nextPendingConnection(), m_receptionPolicy);
 
         // Connect the slot to abort the connection when the server is
         // terminated
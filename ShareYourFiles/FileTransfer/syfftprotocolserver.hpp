@@ -21,7 +21,9 @@
 
 #include <QObject>
 #include <QPointer>
+#include <QSharedPointer>
 
+class ReceptionPolicy;
 class SyfftProtocolReceiver;
 class QTcpServer;
 
@@ -51,9 +53,14 @@ public:
     ///
     /// \brief Builds a new instance of the server.
     /// \param localUuid the UUID associated to the local user.
+    /// \param receptionPolicy the snapshot of the reception preferences, used
+    /// by the receivers to handle the sharing requests.
     /// \param parent the parent of the current object.
     ///
-    explicit SyfftProtocolServer(const QString &localUuid, QObject *parent = 0);
+    explicit SyfftProtocolServer(
+        const QString &localUuid,
+        const QSharedPointer<const ReceptionPolicy> &receptionPolicy,
+        QObject *parent = 0);
 
     ///
     /// \brief Starts listening for requests.
@@ -95,6 +102,8 @@ private:
 
 private:
     QString m_localUuid; ///< \brief The UUID associated to the local user.
+    /// \brief The snapshot of the reception preferences.
+    QSharedPointer<const ReceptionPolicy> m_receptionPolicy;
     QPointer<QTcpServer> m_server; ///< \brief The socket used for listening.
 };
 
@@ -17,14 +17,19 @@
  */
 
 #include "syfpprotocol.hpp"
-
-#include <Logger.h>
+#include "Common/logging.hpp"
+#include "transferlistbuilder.hpp"
+#include "Common/common.hpp"
 
 #include <QDataStream>
 #include <QLocalServer>
 #include <QLocalSocket>
 #include <QTimer>
 
+// Register TransferList to the qt meta type system
+static MetaTypeRegistration<TransferList>
+    transferListRegisterer("TransferList");
+
 ///
 /// The constructor initializes the internal fields of the instance
 /// but does not actually start waiting for incoming requests.
@@ -32,7 +37,7 @@
 /// \see start(quint32)
 ///
 SyfpProtocolServer::SyfpProtocolServer(QObject *parent)
-        : QObject(parent), m_server(new QLocalServer(this))
+        : QObject(parent), m_server(new QLocalServer(this)), m_attached(false)
 {
     // Connect to the handler for a new request
     connect(m_server, &QLocalServer::newConnection, this,
@@ -76,11 +81,26 @@ bool SyfpProtocolServer::start(const QString &name)
     return true;
 }
 
+///
+/// The transfer lists received before the consumer was connected are emitted
+/// in the order of arrival, and the following ones are emitted directly.
+///
+void SyfpProtocolServer::attach()
+{
+    m_attached = true;
+
+    QVector<TransferList> pending;
+    pending.swap(m_pending);
+    foreach (const TransferList &transferList, pending) {
+        emit transferListReceived(transferList);
+    }
+}
+
 ///
 /// This method is executed every time a new connection is ready to be accepted:
 /// a brand new SyfpProtocolReceiver instance is created to manage the reception
-/// and the handlers are connected to emit the pathsReceived() signal if the
-/// data is received correctly and to delete the instance itself.
+/// and the handlers are connected to emit the transferListReceived() signal if
+/// the data is received correctly and to delete the instance itself.
 ///
 void SyfpProtocolServer::newConnection()
 {
@@ -93,7 +113,7 @@ void SyfpProtocolServer::newConnection()
 
         // Connect the signal handlers
         connect(receiver, &SyfpProtocolReceiver::finished, this,
-                &SyfpProtocolServer::pathsReceived);
+                &SyfpProtocolServer::listReceived);
         connect(receiver, &SyfpProtocolReceiver::finished, receiver,
                 &QObject::deleteLater);
         connect(receiver, &SyfpProtocolReceiver::error, receiver,
@@ -104,6 +124,25 @@ void SyfpProtocolServer::newConnection()
     }
 }
 
+///
+/// The transfer list is queued in case the consumer is not yet connected: if
+/// MAX_PENDING lists are already queued, the oldest one is discarded.
+///
+void SyfpProtocolServer::listReceived(const TransferList &transferList)
+{
+    if (m_attached) {
+        emit transferListReceived(transferList);
+        return;
+    }
+
+    if (m_pending.size() == SyfpProtocolServer::MAX_PENDING) {
+        LOG_WARNING() << "SyfpProtocolServer: too many requests during the"
+                         " startup, discarding the oldest one";
+        m_pending.removeFirst();
+    }
+    m_pending.append(transferList);
+}
+
 
 /******************************************************************************/
 
@@ -111,15 +150,16 @@ void SyfpProtocolServer::newConnection()
 ///
 /// The instance is created by initializing the fields and connecting the
 /// slots in charge of handling the various events during the transfer.
-/// The timeout timer is also set up and started to prevent too long
-/// connections.
+/// The timeout timer is also set up and started to prevent idle connections.
 ///
 SyfpProtocolReceiver::SyfpProtocolReceiver(QLocalSocket *socket,
                                            QObject *parent)
         : QObject(parent),
           m_socket(socket),
           m_stream(new QDataStream(socket)),
-          m_pathNumber(0),
+          m_batchRemaining(0),
+          m_pathsReceived(0),
+          m_builder(new TransferListBuilder(this)),
           m_timerTimeout(new QTimer(this))
 {
     // Take ownership of the socket
@@ -133,6 +173,10 @@ SyfpProtocolReceiver::SyfpProtocolReceiver(QLocalSocket *socket,
     connect(m_socket, &QLocalSocket::readyRead, this,
             &SyfpProtocolReceiver::readData);
 
+    // Connect to the handler for the completion of the enumeration
+    connect(m_builder, &TransferListBuilder::finished, this,
+            &SyfpProtocolReceiver::buildingFinished);
+
     // Connect to the handler in case of error
     connect(m_socket,
             static_cast<void (QLocalSocket::*)(QLocalSocket::LocalSocketError)>(
@@ -143,13 +187,16 @@ SyfpProtocolReceiver::SyfpProtocolReceiver(QLocalSocket *socket,
                 emit error();
             });
 
-    // Set up the timer to interrupt too long connections
+    // Set up the timer to interrupt idle connections (a whole second
+    // accuracy is sufficient and allows the system to coalesce the wakeups)
     m_timerTimeout->setSingleShot(true);
+    m_timerTimeout->setTimerType(Qt::VeryCoarseTimer);
+    m_timerTimeout->setInterval(SyfpProtocolReceiver::IDLE_TIMEOUT);
     connect(m_timerTimeout, &QTimer::timeout, this, [this]() {
         LOG_WARNING() << "SyfpProtocolReceiver: timeout expired";
         emit error();
     });
-    m_timerTimeout->start(SyfpProtocolReceiver::TIMEOUT);
+    m_timerTimeout->start();
 }
 
 /// The destruction is automatically performed by the destructors of the
@@ -158,26 +205,40 @@ SyfpProtocolReceiver::~SyfpProtocolReceiver() {}
 
 ///
 /// This method is in charge of actually reading the data received from the
-/// client. Initially, if the expected number of paths to be received has not
-/// yet been set, it is read (32 bits unsigned number); the paths are then
-/// read and converted: when the process completes, the finished() signal is
-/// emitted to advertise the obtained values.
+/// client. Initially, if the number of paths in the current batch has not yet
+/// been read, it is read (32 bits unsigned number); the paths are then read,
+/// converted and passed to the TransferListBuilder all at once when no more
+/// data is available, so that the enumeration proceeds in background while the
+/// client keeps sending. When the empty batch is received, the connection is
+/// closed and the builder is requested to notify the completion.
 ///
 void SyfpProtocolReceiver::readData()
 {
+    // Some data has been received: restart the idle timeout
+    m_timerTimeout->start();
+
+    QStringList paths;
+    bool completed = false;
+
     // Continue until data is still available
     while (m_socket->bytesAvailable()) {
-        // Number of paths to be received not yet read
-        if (m_pathNumber == 0) {
+        // Number of paths in the current batch not yet read
+        if (m_batchRemaining == 0) {
 
             // Start a new transaction
             m_stream->startTransaction();
-            *m_stream >> m_pathNumber;
+            *m_stream >> m_batchRemaining;
 
             // Still missing data
             if (!m_stream->commitTransaction()) {
-                m_pathNumber = 0;
-                return;
+                m_batchRemaining = 0;
+                break;
+            }
+
+            // Empty batch: all paths received
+            if (m_batchRemaining == 0) {
+                completed = true;
+                break;
             }
         }
 
@@ -190,19 +251,34 @@ void SyfpProtocolReceiver::readData()
 
         // Still missing data
         if (!m_stream->commitTransaction()) {
-            return;
+            break;
         }
 
-        // Add the path to the list
-        m_pathList << QString::fromUtf8(path);
+        // Add the path to the current list
+        paths << QString::fromUtf8(path);
+        m_batchRemaining--;
+    }
 
-        // All paths received
-        if (static_cast<quint32>(m_pathList.count()) == m_pathNumber) {
-            m_timerTimeout->stop();
-            m_socket->disconnectFromServer();
+    // Enumerate the files corresponding to the paths received
+    m_pathsReceived += static_cast<quint32>(paths.count());
+    m_builder->append(paths);
 
-            emit finished(m_pathList);
-            return;
-        }
+    if (completed) {
+        // Ignore the events of the socket while waiting for the enumeration
+        m_timerTimeout->stop();
+        disconnect(m_socket, Q_NULLPTR, this, Q_NULLPTR);
+        m_socket->disconnectFromServer();
+
+        m_builder->finish();
     }
 }
+
+///
+/// The finished() signal is emitted to advertise the obtained list.
+///
+void SyfpProtocolReceiver::buildingFinished(const TransferList &transferList)
+{
+    LOG_INFO() << "SyfpProtocolReceiver:" << m_pathsReceived
+               << "paths received -" << transferList.totalFiles() << "files";
+    emit finished(transferList);
+}
@@ -19,14 +19,18 @@
 #ifndef SYFPPROTOCOL_HPP
 #define SYFPPROTOCOL_HPP
 
+#include "transferlist.hpp"
+
 #include <QObject>
 #include <QPointer>
 #include <QStringList>
+#include <QVector>
 
 class QDataStream;
 class QLocalServer;
 class QLocalSocket;
 class QTimer;
+class TransferListBuilder;
 
 ///
 /// \brief The SyfpProtocolServer class provides the server side implementation
@@ -43,9 +47,14 @@ class QTimer;
 /// particular, it allows starting listening for requests on a specified name:
 /// when a new client gets connected, a brand new instance of
 /// SyfpProtocolReceiver is created to receive the data and, if the transfer
-/// completes correctly, the pathsReceived() signal is finally emitted to
-/// advertise the paths of the files and directories to be shared. The server
-/// can be terminated by destroying the instance representing it.
+/// completes correctly, the transferListReceived() signal is finally emitted
+/// to advertise the files to be shared. The server can be terminated by
+/// destroying the instance representing it.
+///
+/// Since the server is started while the application is still initializing,
+/// the transfer lists completed before the consumer of the
+/// transferListReceived() signal is connected are queued (at most MAX_PENDING
+/// of them) and emitted as soon as attach() is executed.
 ///
 class SyfpProtocolServer : public QObject
 {
@@ -71,12 +80,21 @@ public slots:
     ///
     bool start(const QString &name);
 
+    ///
+    /// \brief Starts emitting the transferListReceived() signal, delivering
+    /// first the transfer lists queued in the meanwhile.
+    ///
+    /// The function is meant to be executed once the consumer of the signal
+    /// is connected.
+    ///
+    void attach();
+
 signals:
     ///
     /// \brief Signal emitted when a reception terminates correctly.
-    /// \param paths the list of paths requested to be shared.
+    /// \param transferList the files requested to be shared.
     ///
-    void pathsReceived(const QStringList &paths);
+    void transferListReceived(const TransferList &transferList);
 
 private:
     ///
@@ -84,8 +102,23 @@ private:
     ///
     void newConnection();
 
+    ///
+    /// \brief Function executed when a transfer list is received, which
+    /// emits the transferListReceived() signal or queues the list.
+    /// \param transferList the files requested to be shared.
+    ///
+    void listReceived(const TransferList &transferList);
+
+    /// \brief Maximum number of transfer lists queued before attach().
+    static const int MAX_PENDING = 8;
+
     /// \brief The socket used for listening.
     QPointer<QLocalServer> m_server;
+
+    /// \brief Specifies whether the consumer of the signal is connected.
+    bool m_attached;
+    /// \brief The transfer lists received before attach() is executed.
+    QVector<TransferList> m_pending;
 };
 
 ///
@@ -94,12 +127,20 @@ private:
 ///
 /// When a new connection is established, an instance of this class is created
 /// to perform the actual reception according to the SYFP Protocol, which
-/// mandates a 32 bits unsigned number representing the number of paths to be
-/// received, followed by each of them (a 32 bits unsigned number representing
-/// the number of bytes and the actual characters in UTF8 format). The numbers
-/// are expected to be transferred in little endian order. If the transfer
-/// completes correctly, the finished() signal is emitted, otherwise the error()
-/// one is used to signal that something went wrong during the transfer.
+/// mandates a sequence of batches, each one composed of a 32 bits unsigned
+/// number representing the number of paths in the batch, followed by each of
+/// them (a 32 bits unsigned number representing the number of bytes and the
+/// actual characters in UTF8 format); an empty batch terminates the sequence.
+/// The numbers are expected to be transferred in little endian order.
+///
+/// The paths are passed to a TransferListBuilder as soon as they are received,
+/// so that the files are enumerated by a worker thread while the socket keeps
+/// being read; there is no limit on the overall duration of the reception,
+/// while the connection is interrupted in case no data is received for
+/// IDLE_TIMEOUT ms (the time spent enumerating is not accounted). If the
+/// transfer completes correctly, the finished() signal is emitted as soon as
+/// the enumeration terminates, otherwise the error() one is used to signal
+/// that something went wrong during the transfer.
 ///
 class SyfpProtocolReceiver : public QObject
 {
@@ -122,9 +163,9 @@ public:
 signals:
     ///
     /// \brief Signal emitted when the reception terminates correctly.
-    /// \param paths the list of paths requested to be shared.
+    /// \param transferList the files requested to be shared.
     ///
-    void finished(const QStringList &paths);
+    void finished(const TransferList &transferList);
 
     ///
     /// \brief Signal emitted when an error occurs.
@@ -137,20 +178,30 @@ private:
     ///
     void readData();
 
+    ///
+    /// \brief Function executed when the enumeration of the files completes.
+    /// \param transferList the files requested to be shared.
+    ///
+    void buildingFinished(const TransferList &transferList);
+
 private:
     /// \brief The socket used for the reception.
     QPointer<QLocalSocket> m_socket;
     /// \brief The stream used for the reception.
     QScopedPointer<QDataStream> m_stream;
 
-    quint32 m_pathNumber;   ///< \brief The number of paths to be received.
-    QStringList m_pathList; ///< \brief The list of received paths.
+    /// \brief The number of paths still to be received in the current batch.
+    quint32 m_batchRemaining;
+    /// \brief The total number of paths received.
+    quint32 m_pathsReceived;
+    /// \brief The builder enumerating the files corresponding to the paths.
+    QPointer<TransferListBuilder> m_builder;
 
-    /// \brief The timer used to stop too long connections.
+    /// \brief The timer used to stop the idle connections.
     QPointer<QTimer> m_timerTimeout;
 
-    /// \brief Maximum duration of a connection (in ms).
-    static const int TIMEOUT = 5000;
+    /// \brief Maximum time without receiving data (in ms).
+    static const int IDLE_TIMEOUT = 5000;
 };
 
 #endif // SYFPPROTOCOL_HPP
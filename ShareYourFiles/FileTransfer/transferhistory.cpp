@@ -0,0 +1,185 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "transferhistory.hpp"
+#include "Common/logging.hpp"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+#include <cstring>
+
+// Static variables initialization
+const char TransferHistory::MAGIC[] = "SYFH";
+
+///
+/// The status is written as an 8 bits number, followed by the other fields in
+/// their QDataStream representation. The files are written as their number
+/// followed, for each of them, by the relative path, the size and the status
+/// (an 8 bits number): the FileInfo operators are not used, since they are
+/// limited to the files scheduled for transfer.
+///
+QDataStream &operator<<(QDataStream &stream, const TransferRecord &record)
+{
+    stream << record.sender << static_cast<quint8>(record.status);
+    stream << record.peerUuid << record.names << record.info;
+
+    int count = qMin(record.files.count(),
+                     static_cast<int>(TransferRecord::MAX_FILES));
+    stream << qint32(count);
+    for (int i = 0; i < count; i++) {
+        const FileInfo &file = record.files.at(i);
+        stream << file.filePath() << file.size()
+               << static_cast<quint8>(file.status());
+    }
+    return stream;
+}
+
+///
+/// In case the status read does not correspond to a terminated transfer, or a
+/// file is invalid or neither failed nor skipped, the status of the stream is
+/// set to ReadCorruptData.
+///
+QDataStream &operator>>(QDataStream &stream, TransferRecord &record)
+{
+    using Status = SyfftProtocolCommon::Status;
+    using FileStatus = FileInfo::Status;
+
+    quint8 status;
+    stream >> record.sender >> status;
+    stream >> record.peerUuid >> record.names >> record.info;
+
+    record.status = static_cast<Status>(status);
+    if (stream.status() == QDataStream::Status::Ok &&
+        record.status != Status::Closed && record.status != Status::Aborted) {
+        stream.setStatus(QDataStream::Status::ReadCorruptData);
+    }
+
+    qint32 count = 0;
+    stream >> count;
+    if (stream.status() == QDataStream::Status::Ok &&
+        (count < 0 || count > TransferRecord::MAX_FILES)) {
+        stream.setStatus(QDataStream::Status::ReadCorruptData);
+    }
+
+    record.files.clear();
+    for (int i = 0; i < count && stream.status() == QDataStream::Status::Ok;
+         i++) {
+        QString filePath;
+        quint64 size;
+        quint8 fileStatus;
+        stream >> filePath >> size >> fileStatus;
+
+        FileInfo file(filePath, size, QDateTime());
+        file.setStatus(static_cast<FileStatus>(fileStatus));
+        bool unsuccessful = (file.status() == FileStatus::TransferFailed ||
+                             file.status() == FileStatus::TransferRejected);
+        if (stream.status() == QDataStream::Status::Ok &&
+            (!file.valid() || !unsuccessful)) {
+            stream.setStatus(QDataStream::Status::ReadCorruptData);
+        }
+        record.files << file;
+    }
+    return stream;
+}
+
+///
+/// A missing file corresponds to an empty history, while a file that cannot
+/// be parsed (including one written with a previous version of the format) is
+/// reported in the log and ignored (it is replaced by the next save).
+///
+QList<TransferRecord> TransferHistory::load() const
+{
+    QList<TransferRecord> records;
+    if (!persistent() || !QFile::exists(m_filePath)) {
+        return records;
+    }
+
+    QFile file(m_filePath);
+    if (!file.open(QFile::ReadOnly)) {
+        LOG_WARNING() << "TransferHistory: failed opening" << m_filePath
+                      << "-" << file.errorString();
+        return records;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    char magic[4];
+    quint8 version = 0;
+    qint32 count = 0;
+    if (stream.readRawData(magic, sizeof(magic)) != sizeof(magic) ||
+        std::memcmp(magic, TransferHistory::MAGIC, sizeof(magic)) != 0) {
+        LOG_WARNING() << "TransferHistory: invalid file" << m_filePath;
+        return records;
+    }
+
+    stream >> version >> count;
+    if (stream.status() != QDataStream::Status::Ok ||
+        version != TransferHistory::VERSION || count < 0 ||
+        count > TransferHistory::MAX_RECORDS) {
+        LOG_WARNING() << "TransferHistory: invalid file" << m_filePath;
+        return records;
+    }
+
+    for (int i = 0; i < count; i++) {
+        TransferRecord record;
+        stream >> record;
+        if (stream.status() != QDataStream::Status::Ok) {
+            LOG_WARNING() << "TransferHistory: invalid file" << m_filePath;
+            return QList<TransferRecord>();
+        }
+        records << record;
+    }
+
+    LOG_INFO() << "TransferHistory:" << records.count() << "records loaded";
+    return records;
+}
+
+///
+/// The file is written through QSaveFile, so that the previous version is
+/// preserved in case of error.
+///
+bool TransferHistory::save(const QList<TransferRecord> &records) const
+{
+    if (!persistent()) {
+        return true;
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    int first = qMax(0, records.count() - TransferHistory::MAX_RECORDS);
+    stream.writeRawData(TransferHistory::MAGIC, 4);
+    stream << TransferHistory::VERSION << qint32(records.count() - first);
+    for (int i = first; i < records.count(); i++) {
+        stream << records.at(i);
+    }
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QSaveFile::WriteOnly) ||
+        file.write(data) != data.size() || !file.commit()) {
+        LOG_ERROR() << "TransferHistory: failed writing" << m_filePath << "-"
+                    << file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,134 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TRANSFERHISTORY_HPP
+#define TRANSFERHISTORY_HPP
+
+#include "fileinfo.hpp"
+#include "syfftprotocolcommon.hpp"
+#include "transferinfo.hpp"
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+class QDataStream;
+
+///
+/// \brief The TransferRecord class contains the summary of a terminated
+/// transfer, which is kept once the SYFFT protocol instance has been freed.
+///
+/// Of the list of files, only the entries whose transfer failed or was skipped
+/// are kept (at most MAX_FILES), so that they can still be inspected.
+///
+struct TransferRecord {
+    ///
+    /// \brief Builds an empty record.
+    ///
+    explicit TransferRecord()
+            : sender(false), status(SyfftProtocolCommon::Status::Closed)
+    {
+    }
+
+    /// \brief Whether the files have been sent or received.
+    bool sender;
+    /// \brief The final status of the transfer (closed or aborted).
+    SyfftProtocolCommon::Status status;
+    /// \brief The identifier of the peer.
+    QString peerUuid;
+    /// \brief The names of the peer at the end of the transfer.
+    QString names;
+    /// \brief The final transfer information.
+    TransferInfo info;
+    /// \brief The files whose transfer failed or was skipped (in order).
+    QVector<FileInfo> files;
+
+    /// \brief The maximum number of files kept in a record.
+    static const int MAX_FILES = 200;
+};
+
+///
+/// \brief Writes a TransferRecord to a QDataStream.
+/// \param stream the stream the data is written to.
+/// \param record the record to be written.
+/// \return the stream itself.
+///
+QDataStream &operator<<(QDataStream &stream, const TransferRecord &record);
+
+///
+/// \brief Reads a TransferRecord from a QDataStream.
+/// \param stream the stream the data is read from.
+/// \param record the record where the data is stored.
+/// \return the stream itself.
+///
+QDataStream &operator>>(QDataStream &stream, TransferRecord &record);
+
+///
+/// \brief The TransferHistory class persists the records of the terminated
+/// transfers to a binary file.
+///
+/// The history is capped to MAX_RECORDS elements and hence the file, composed
+/// by a header (magic string and version) followed by the records, is small
+/// enough to be entirely rewritten (atomically) at every save. An instance
+/// built with an empty path represents a history that is not persisted.
+///
+class TransferHistory
+{
+public:
+    ///
+    /// \brief Builds a new instance of this class.
+    /// \param filePath the path of the file where the records are stored
+    /// (empty to disable the persistence).
+    ///
+    explicit TransferHistory(const QString &filePath) : m_filePath(filePath)
+    {
+    }
+
+    /// \brief Returns whether the history is persisted or not.
+    bool persistent() const { return !m_filePath.isEmpty(); }
+
+    ///
+    /// \brief Reads the records stored in the file.
+    /// \return the records read, from the oldest to the newest (an empty list
+    /// in case of error).
+    ///
+    QList<TransferRecord> load() const;
+
+    ///
+    /// \brief Replaces the content of the file with the given records.
+    /// \param records the records to be stored (only the newest MAX_RECORDS
+    /// are kept).
+    /// \return true in case of success and false otherwise.
+    ///
+    bool save(const QList<TransferRecord> &records) const;
+
+    /// \brief The maximum number of records kept in the history.
+    static const int MAX_RECORDS = 100;
+
+private:
+    /// \brief The path of the file where the records are stored.
+    const QString m_filePath;
+
+    /// \brief The magic string identifying the file.
+    static const char MAGIC[];
+    /// \brief The version of the file format.
+    static const quint8 VERSION = 2;
+};
+
+#endif // TRANSFERHISTORY_HPP
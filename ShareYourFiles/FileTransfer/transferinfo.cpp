@@ -19,6 +19,8 @@
 #include "transferinfo.hpp"
 #include "Common/common.hpp"
 
+#include <QDataStream>
+
 ///
 /// The instance is initialized with default values.
 ///
@@ -105,3 +107,50 @@ void TransferInfo::recomputeCurrentSpeed(bool reset)
     previousBytes = m_transferredBytes;
     previousTime = m_transferTime;
 }
+
+///
+/// Only the summary of the transfer is written to the stream, that is the
+/// number of files and of bytes (total, transferred and skipped) and the
+/// elapsed times, while the information related to the current state of the
+/// transfer (the current speed and the file in transfer) is discarded.
+///
+/// \see operator>>()
+///
+QDataStream &operator<<(QDataStream &stream, const TransferInfo &info)
+{
+    stream << info.m_totalFiles << info.m_transferredFiles
+           << info.m_skippedFiles;
+    stream << info.m_totalBytes << info.m_transferredBytes
+           << info.m_skippedBytes;
+    stream << info.m_elapsedTime << info.m_transferTime << info.m_pausedTime;
+    return stream;
+}
+
+///
+/// The fields are read according to the format described in operator<<(),
+/// while the current speed and the file in transfer are reset. In case of
+/// invalid data, the status of the stream is set to ReadCorruptData.
+///
+/// \see operator<<()
+///
+QDataStream &operator>>(QDataStream &stream, TransferInfo &info)
+{
+    info = TransferInfo();
+
+    stream >> info.m_totalFiles >> info.m_transferredFiles >>
+        info.m_skippedFiles;
+    stream >> info.m_totalBytes >> info.m_transferredBytes >>
+        info.m_skippedBytes;
+    stream >> info.m_elapsedTime >> info.m_transferTime >> info.m_pausedTime;
+
+    if (stream.status() == QDataStream::Status::Ok &&
+        (quint64(info.m_transferredFiles) + info.m_skippedFiles >
+             info.m_totalFiles ||
+         info.m_transferredBytes > info.m_totalBytes ||
+         info.m_skippedBytes > info.m_totalBytes - info.m_transferredBytes)) {
+        stream.setStatus(QDataStream::Status::ReadCorruptData);
+    }
+
+    info.recomputeCurrentSpeed(true);
+    return stream;
+}
@@ -21,6 +21,8 @@
 
 #include <QString>
 
+class QDataStream;
+
 ///
 /// \brief The TransferInfo class provides statistics about the transfer
 /// progress
@@ -112,6 +114,22 @@ public:
     /// \brief Returns relative path of the file currently in transfer.
     QString fileInTransfer() const { return m_fileInTransfer; }
 
+    ///
+    /// \brief Writes the summary of a TransferInfo to a QDataStream.
+    /// \param stream the stream where data is written to.
+    /// \param info the TransferInfo instance to be written.
+    /// \return the stream given as parameter to allow concatenations.
+    ///
+    friend QDataStream &operator<<(QDataStream &stream,
+                                   const TransferInfo &info);
+    ///
+    /// \brief Reads the summary of a TransferInfo from a QDataStream.
+    /// \param stream the stream from where data is read.
+    /// \param info the TransferInfo instance to be filled.
+    /// \return the stream given as parameter to allow concatenations.
+    ///
+    friend QDataStream &operator>>(QDataStream &stream, TransferInfo &info);
+
 private:
     ///
     /// \brief Computes a transfer speed.
@@ -17,34 +17,44 @@
  */
 
 #include "transferlist.hpp"
-
-#include <Logger.h>
+#include "Common/logging.hpp"
 
 #include <QDir>
 #include <QFileInfo>
 
+TransferList::TransferList() : m_totalBytes(0), m_error(false) {}
+
 ///
 /// The instance is generated starting from the list of absolute paths referring
-/// to files or directories that are going to be scheduled for transfer: it is
-/// mandatory that the paths given as parameters are absolute and all referring
-/// to elements in the same directory. This strong constraint is due to the
-/// necessity to convert the paths obtained through the SYFP Protocol (that
-/// follows the given format) to relative paths with respect to a base directory
-/// that can be sent through the SYFFT Protocol.
+/// to files or directories that are going to be scheduled for transfer.
+///
+/// \see append()
+///
+TransferList::TransferList(const QStringList &pathsList) : TransferList()
+{
+    append(pathsList);
+}
+
+///
+/// It is mandatory that the paths given as parameters are absolute and all
+/// referring to elements in the same directory (also with respect to the ones
+/// previously added). This strong constraint is due to the necessity to convert
+/// the paths obtained through the SYFP Protocol (that follows the given format)
+/// to relative paths with respect to a base directory that can be sent through
+/// the SYFFT Protocol.
 ///
 /// The list building proceeds by adding creating a FileInfo instance for each
 /// valid file specified; in case of directories, on the other hand, the process
-/// continues recursively until all files have been included.
+/// continues recursively until all files have been included. The files are
+/// added in the same order of the paths, and duplicated paths are ignored.
 ///
-TransferList::TransferList(const QStringList &pathsList) : m_totalBytes(0)
+void TransferList::append(const QStringList &pathsList)
 {
-    // No files specified: just return
-    if (pathsList.isEmpty()) {
+    // The list has already been invalidated: just return
+    if (m_error) {
         return;
     }
 
-    // Build the list of file and directory names
-    QStringList items;
     foreach (const QString &path, pathsList) {
         QFileInfo info(path);
 
@@ -65,51 +75,19 @@ TransferList::TransferList(const QStringList &pathsList) : m_totalBytes(0)
             LOG_ERROR() << "TransferList: detected files or directories "
                            "with different base paths: it is not possible "
                            "to continue generating the list.";
+            m_error = true;
+            m_files.clear();
+            m_totalBytes = 0;
+            m_items.clear();
             return;
         }
 
-        // Add the name to the list
-        items << info.fileName();
-    }
-
-    // Build the actual list
-    buildFileList(items);
-}
-
-///
-/// The function builds the list of the files to be transferred, according
-/// to the items specified as parameter. In particular, it scans the directory
-/// specified as base path and, for each file or directory found, checks if the
-/// items list contains it: in that case the addToFileList() function is
-/// executed to recursively add all files to the list. The items must be names
-/// of files or directories directly children of the base directory, and they
-/// must not contain trailing slashes.
-///
-void TransferList::buildFileList(QStringList items)
-{
-    // Get the list of files and directories contained in the base path and
-    // check which are in the items list.
-    foreach (const QFileInfo &child,
-             QDir(m_basePath)
-                 .entryInfoList(QDir::AllEntries | QDir::Readable |
-                                    QDir::NoDotAndDotDot,
-                                QDir::Name | QDir::DirsLast)) {
-
-        // Get the name of the file or the directory
-        QString itemName = child.fileName();
-        // Check if it is in the list of items, and in that case add it
-        // to the file list
-        if (items.contains(itemName)) {
-            items.removeAll(itemName);
-            addToFileList(child);
+        // Add the item to the list (unless already present)
+        if (!m_items.contains(info.fileName())) {
+            m_items.insert(info.fileName());
+            addToFileList(info);
         }
     }
-
-    // Check the remaining values which are invalid
-    foreach (const QString &item, items) {
-        LOG_WARNING() << "TransferList: skipped invalid file or directory"
-                      << item;
-    }
 }
 
 ///
@@ -21,6 +21,7 @@
 
 #include "fileinfo.hpp"
 
+#include <QSet>
 #include <QString>
 #include <QVector>
 
@@ -39,17 +40,35 @@ class QFileInfo;
 /// that directory is explored recursively to add to the list every file
 /// contained inside it.
 ///
+/// The list can be built incrementally through append(), so that the paths can
+/// be enumerated while they are still being received.
+///
 class TransferList
 {
     friend class SyfftProtocolSender;
 
 public:
+    ///
+    /// \brief Builds a new empty instance.
+    ///
+    explicit TransferList();
+
     ///
     /// \brief Builds a new instance from the list of paths specified.
     /// \param pathsList the list of absolute paths of the files to be shared.
     ///
     explicit TransferList(const QStringList &pathsList);
 
+    ///
+    /// \brief Adds a list of paths to the ones already present.
+    /// \param pathsList the list of absolute paths of the files to be shared
+    /// (in the same directory of the ones already added).
+    ///
+    /// In case a path refers to a different directory, the whole list is
+    /// cleared and the following calls have no effect.
+    ///
+    void append(const QStringList &pathsList);
+
     /// \brief Returns the path the files are relative to.
     QString basePath() const { return m_basePath; }
 
@@ -72,12 +91,6 @@ public:
     quint64 totalBytes() const { return m_totalBytes; }
 
 private:
-    ///
-    /// \brief Builds the transfer files list.
-    /// \param items the list of file or directory names to be added.
-    ///
-    void buildFileList(QStringList items);
-
     ///
     /// \brief Adds the file or directory specified by the parameter to the
     /// transfer files list (in a recursive manner).
@@ -91,6 +104,11 @@ private:
 
     /// \brief The total size of the files to be transferred.
     quint64 m_totalBytes;
+
+    /// \brief The names of the files and directories already added.
+    QSet<QString> m_items;
+    /// \brief Whether paths referring to different directories were detected.
+    bool m_error;
 };
 
 #endif // TRANSFERLIST_HPP
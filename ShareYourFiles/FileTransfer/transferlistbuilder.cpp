@@ -0,0 +1,133 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "transferlistbuilder.hpp"
+#include "Common/logging.hpp"
+
+#include <QRunnable>
+
+///
+/// \brief The TransferListBuilderTask class represents the enumeration of a
+/// batch of paths, executed by the worker thread of a TransferListBuilder.
+///
+class TransferListBuilderTask : public QRunnable
+{
+public:
+    ///
+    /// \brief Builds a new instance of this class.
+    /// \param builder the instance to be notified at the end.
+    /// \param transferList the list the paths are appended to.
+    /// \param pathsList the paths to be enumerated (empty for the last task).
+    /// \param last whether the builder has to be notified of the completion.
+    ///
+    explicit TransferListBuilderTask(TransferListBuilder *builder,
+                                     TransferList *transferList,
+                                     const QStringList &pathsList, bool last)
+            : m_builder(builder),
+              m_transferList(transferList),
+              m_pathsList(pathsList),
+              m_last(last)
+    {
+    }
+
+    ///
+    /// \brief Appends the paths to the list and, in case of the last task,
+    /// posts a copy of the complete list to the builder.
+    ///
+    void run() override
+    {
+        if (!m_pathsList.isEmpty()) {
+            m_transferList->append(m_pathsList);
+        }
+
+        if (m_last) {
+            QMetaObject::invokeMethod(m_builder, "finishBuilding",
+                                      Qt::QueuedConnection,
+                                      Q_ARG(TransferList, *m_transferList));
+        }
+    }
+
+private:
+    TransferListBuilder *m_builder; ///< \brief The instance to be notified.
+    TransferList *m_transferList;   ///< \brief The list being built.
+    QStringList m_pathsList;        ///< \brief The paths to be enumerated.
+    bool m_last;                    ///< \brief Whether it is the last task.
+};
+
+
+///
+/// The pool is limited to a single thread, so that the batches are enumerated
+/// sequentially and in the order they have been appended.
+///
+TransferListBuilder::TransferListBuilder(QObject *parent)
+        : QObject(parent), m_finishing(false)
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+///
+/// The batches not yet started are discarded, while the running one is
+/// awaited, so that the worker does not refer to the instance after its
+/// destruction.
+///
+TransferListBuilder::~TransferListBuilder()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+///
+/// A new task is submitted to the pool, unless finish() has already been
+/// called.
+///
+void TransferListBuilder::append(const QStringList &pathsList)
+{
+    if (m_finishing) {
+        LOG_WARNING() << "TransferListBuilder: list already completed";
+        return;
+    }
+
+    if (!pathsList.isEmpty()) {
+        m_pool.start(new TransferListBuilderTask(this, &m_transferList,
+                                                 pathsList, false));
+    }
+}
+
+///
+/// A last task is submitted to the pool, which is executed after all the
+/// previous ones and notifies the completion.
+///
+void TransferListBuilder::finish()
+{
+    if (m_finishing) {
+        return;
+    }
+
+    m_finishing = true;
+    m_pool.start(new TransferListBuilderTask(this, &m_transferList,
+                                             QStringList(), true));
+}
+
+///
+/// The finished() signal is emitted with the list received from the worker.
+///
+void TransferListBuilder::finishBuilding(const TransferList &transferList)
+{
+    emit finished(transferList);
+}
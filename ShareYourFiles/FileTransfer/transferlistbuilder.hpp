@@ -0,0 +1,97 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TRANSFERLISTBUILDER_HPP
+#define TRANSFERLISTBUILDER_HPP
+
+#include "transferlist.hpp"
+
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+
+///
+/// \brief The TransferListBuilder class enumerates the files to be shared in
+/// background.
+///
+/// Building a TransferList requires to explore recursively the selected
+/// directories, which may take a long time in case of large trees: performing
+/// it in the thread handling the requests would prevent it from serving the
+/// other events (e.g. reading the remaining paths from the socket) until the
+/// enumeration completes.
+///
+/// The paths are instead passed to append() as soon as they are available and
+/// enumerated, in order, by a dedicated worker thread; once finish() has been
+/// called and all the paths enumerated, the finished() signal is emitted in
+/// the thread of the instance with the complete list.
+///
+class TransferListBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief Builds a new instance of this class.
+    /// \param parent the parent of the current object.
+    ///
+    explicit TransferListBuilder(QObject *parent = Q_NULLPTR);
+
+    ///
+    /// \brief Waits for the running enumeration and destroys the instance.
+    ///
+    ~TransferListBuilder();
+
+    ///
+    /// \brief Schedules the enumeration of a list of paths.
+    /// \param pathsList the list of absolute paths of the files to be shared.
+    ///
+    /// \see TransferList::append()
+    ///
+    void append(const QStringList &pathsList);
+
+    ///
+    /// \brief Requests the emission of the finished() signal once all the
+    /// paths already appended have been enumerated.
+    ///
+    void finish();
+
+signals:
+    ///
+    /// \brief Signal emitted when the enumeration completes.
+    /// \param transferList the files requested to be shared.
+    ///
+    void finished(const TransferList &transferList);
+
+private slots:
+    ///
+    /// \brief Completes the enumeration (executed by the worker).
+    /// \param transferList the files requested to be shared.
+    ///
+    void finishBuilding(const TransferList &transferList);
+
+private:
+    /// \brief The pool (with a single thread) performing the enumeration.
+    QThreadPool m_pool;
+    /// \brief The list being built (accessed only by the worker thread).
+    TransferList m_transferList;
+    /// \brief Whether finish() has already been called.
+    bool m_finishing;
+};
+
+#endif // TRANSFERLISTBUILDER_HPP
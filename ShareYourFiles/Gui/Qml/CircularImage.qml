@@ -54,7 +54,9 @@ Rectangle {
         sourceSize.height: root.imageSize
 
         fillMode: Image.PreserveAspectCrop
-        cache: false
+        // Icons served by the provider include the hash in the URL, hence
+        // they can be safely cached (while plain files may change content)
+        cache: root.imageSet && root.imagePath.indexOf("image://") === 0
 
         layer.enabled: true
         layer.effect: OpacityMask {
@@ -133,7 +133,7 @@ ApplicationWindow {
                             Layout.alignment: Qt.AlignCenter
 
                             imageSet: model.iconSet
-                            imagePath: "file:///" + model.iconPath
+                            imagePath: model.iconUrl
 
                             borderSet: model.selected
                             borderColor: Material.accent
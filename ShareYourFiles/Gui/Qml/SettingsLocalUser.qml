@@ -82,7 +82,7 @@ Item {
 
                 imageSize: 128
                 imageSet: model.iconSet
-                imagePath: "file:///" + model.iconPath
+                imagePath: model.iconUrl
                 borderSet: true
                 borderColor: Material.accent
             }
@@ -116,7 +116,7 @@ Item {
             nameFilters: ["Image files (*.jpg *.jpeg *.png *.bmp *.gif)"]
 
             onAccepted: {
-                model.iconPath = iconPicker.fileUrl
+                model.iconUrl = iconPicker.fileUrl
                 model.iconSet = true
             }
         }
@@ -0,0 +1,46 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+import QtQuick 2.6
+
+// Creates the windows requested by the transfers model. This object is always
+// instantiated, differently from the Transfers window which is created only
+// when shown, so that no request is lost.
+Item {
+    id: root
+
+    Connections {
+        target: transfers
+        onTransferRequestedAsk: {
+            var component = Qt.createComponent("TransferRequest.qml");
+            var object = component.createObject(root, {"request": request, "selfDestroy": true});
+        }
+        onTransferResponseReceived: {
+            var component = Qt.createComponent("TransferResponse.qml");
+            var object = component.createObject(root, {"response": response, "selfDestroy": true});
+        }
+        onDuplicatedFileDetected: {
+            var component = Qt.createComponent("DuplicatedFile.qml");
+            var object = component.createObject(root, {"request": request, "selfDestroy": true});
+        }
+        onFilesRequested: {
+            var component = Qt.createComponent("TransferFiles.qml");
+            var object = component.createObject(root, {"files": files, "selfDestroy": true});
+        }
+    }
+}
@@ -0,0 +1,199 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+import QtQuick 2.6
+import QtQuick.Controls 2.1
+import QtQuick.Controls.Material 2.1
+import QtQuick.Layouts 1.1
+import QtQuick.Window 2.0
+
+ApplicationWindow {
+    id: root
+
+    width: 700
+    height: 600
+
+    minimumWidth: 450
+    minimumHeight: 400
+
+    Component.onCompleted: {
+        setX(Screen.width / 2 - width / 2);
+        setY(Screen.height / 2 - height / 2);
+    }
+
+    visible: true
+    title: qsTr("Share Your Files - Files") +
+           (files.sender ? qsTr(" sent to ") : qsTr(" received from ")) +
+           files.names
+
+    FontLoader { id: appFont; source: "qrc:/Resources/SourceSansPro.ttf" }
+    font.family: appFont.name
+
+    Material.theme: Material.Dark
+    Material.accent: Material.Green
+
+    property var files: undefined
+    property bool selfDestroy: false
+
+    property string accentHex: Material.accent
+    function emph(text) {
+        return "<font color=\"" + accentHex + "\">" + text + "</font>";
+    }
+
+    // Poll the status of the files only while the window is shown
+    // (i.e. neither hidden nor minimized)
+    Binding {
+        target: files
+        property: "active"
+        value: root.visible && root.visibility !== Window.Minimized
+    }
+
+    ColumnLayout {
+        anchors.fill: parent
+        anchors.margins: 25
+
+        Label {
+            text: qsTr("The transfer is terminated: only the files not transferred are kept.")
+
+            Layout.fillWidth: true
+            visible: files.archived
+            wrapMode: Text.WordWrap
+            font.pointSize: 11
+            opacity: 0.7
+        }
+
+        RowLayout {
+            Layout.fillWidth: true
+
+            Label {
+                text: emph(files.rowCount) + qsTr(" of ") +
+                      emph(files.totalCount) + qsTr(" files shown")
+
+                Layout.fillWidth: true
+                elide: Text.ElideRight
+                font.pointSize: 13
+            }
+
+            ComboBox {
+                Layout.preferredWidth: 200
+                model: [ qsTr("All files"), qsTr("In progress"),
+                         qsTr("Failed only") ]
+
+                // The order of the entries matches TransferFilesModel::Filter
+                currentIndex: files.filter
+                onActivated: files.filter = index
+            }
+        }
+
+        ListView {
+            id: filesView
+
+            Layout.fillWidth: true
+            Layout.fillHeight: true
+            clip: true
+
+            ScrollBar.vertical: ScrollBar { }
+
+            // Only the visible rows are instantiated (and hence fetched)
+            model: files
+
+            delegate: Item {
+                width: filesView.width
+                height: 50
+
+                RowLayout {
+                    anchors.fill: parent
+                    anchors.leftMargin: 10
+                    anchors.rightMargin: 10
+
+                    ColumnLayout {
+                        Layout.fillWidth: true
+                        spacing: 0
+
+                        Label {
+                            text: model.name
+
+                            Layout.fillWidth: true
+                            elide: Text.ElideMiddle
+                            font.pointSize: 12
+                        }
+                        Label {
+                            text: model.path === "" ? "." : model.path
+
+                            Layout.fillWidth: true
+                            elide: Text.ElideMiddle
+                            font.pointSize: 9
+                            opacity: 0.7
+                        }
+                    }
+
+                    Label {
+                        text: model.size
+                        Layout.preferredWidth: 80
+                        horizontalAlignment: Text.AlignRight
+                        font.pointSize: 11
+                    }
+
+                    Label {
+                        text: model.status
+                        Layout.preferredWidth: 100
+                        horizontalAlignment: Text.AlignRight
+                        font.pointSize: 11
+                        color: model.failed ? Material.color(Material.Red)
+                                            : (model.inTransfer
+                                               ? Material.accent
+                                               : Material.foreground)
+                    }
+                }
+
+                Rectangle {
+                    anchors.left: parent.left
+                    anchors.right: parent.right
+                    anchors.bottom: parent.bottom
+                    height: 1
+                    color: Material.accent
+                    opacity: 0.3
+                }
+            }
+        }
+
+        DialogButtonBox {
+            Layout.fillWidth: true
+            background: Rectangle { color: "transparent" }
+
+            Button {
+                width: 100
+                text: qsTr("Close")
+                DialogButtonBox.buttonRole: DialogButtonBox.AcceptRole
+
+                onClicked: root.close();
+            }
+        }
+    }
+
+    onClosing: {
+        if (root.selfDestroy) {
+            root.destroy()
+        }
+    }
+
+    Component.onDestruction: {
+        if (root.selfDestroy) {
+            files.requestDestruction()
+        }
+    }
+}
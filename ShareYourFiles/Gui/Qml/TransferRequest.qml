@@ -93,7 +93,7 @@ ApplicationWindow {
                 imageSize: 128
 
                 imageSet: request.iconSet
-                imagePath: "file:///" + request.iconPath
+                imagePath: request.iconUrl
                 borderSet: true
                 borderColor: Material.accent
             }
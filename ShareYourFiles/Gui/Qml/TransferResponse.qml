@@ -89,7 +89,7 @@ ApplicationWindow {
                 imageSize: 128
 
                 imageSet: response.iconSet
-                imagePath: "file:///" + response.iconPath
+                imagePath: response.iconUrl
                 borderSet: true
                 borderColor: Material.accent
             }
@@ -48,6 +48,14 @@ ApplicationWindow {
 
     property bool empty: transfers.rowCount === 0
 
+    // Poll the transfer information only while the window is shown
+    // (i.e. neither hidden nor minimized)
+    Binding {
+        target: transfers
+        property: "active"
+        value: root.visible && root.visibility !== Window.Minimized
+    }
+
     property string accentHex: Material.accent
     function emph(text) {
         return "<font color=\"" + accentHex + "\">" + text + "</font>";
@@ -119,7 +127,7 @@ ApplicationWindow {
                         CircularImage {
 
                             imageSet: model.iconSet
-                            imagePath: "file:///" + model.iconPath
+                            imagePath: model.iconUrl
 
                             borderSet: true
                             borderColor: Material.accent
@@ -163,6 +171,13 @@ ApplicationWindow {
                                     font.pointSize: 13
                                 }
 
+                                ToolButton {
+                                    text: qsTr("Files")
+
+                                    Layout.alignment: Qt.AlignRight
+                                    Layout.rightMargin: -20
+                                    onClicked: transfers.showFiles(index);
+                                }
                                 ToolButton {
                                     id: buttonPause
 
@@ -314,21 +329,5 @@ ApplicationWindow {
 
             onYes: transfers.abortConnection(index)
         }
-
-        Connections {
-            target: transfers
-            onTransferRequestedAsk: {
-                var component = Qt.createComponent("TransferRequest.qml");
-                var object = component.createObject(root, {"request": request, "selfDestroy": true});
-            }
-            onTransferResponseReceived: {
-                var component = Qt.createComponent("TransferResponse.qml");
-                var object = component.createObject(root, {"response": response, "selfDestroy": true});
-            }
-            onDuplicatedFileDetected: {
-                var component = Qt.createComponent("DuplicatedFile.qml");
-                var object = component.createObject(root, {"request": request, "selfDestroy": true});
-            }
-        }
     }
 }
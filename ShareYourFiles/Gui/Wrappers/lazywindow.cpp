@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "lazywindow.hpp"
+#include "Common/logging.hpp"
+
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QQuickWindow>
+#include <QTimer>
+
+LazyWindow::LazyWindow(QQmlEngine *engine, const QUrl &url, int releaseDelay,
+                       QObject *parent)
+        : QObject(parent),
+          m_engine(engine),
+          m_url(url),
+          m_releaseDelay(releaseDelay),
+          m_timerRelease(new QTimer(this))
+{
+    m_timerRelease->setSingleShot(true);
+    connect(m_timerRelease, &QTimer::timeout, this, &LazyWindow::release);
+}
+
+LazyWindow::~LazyWindow()
+{
+    delete m_window.data();
+}
+
+bool LazyWindow::show()
+{
+    if (m_window.isNull() && !create()) {
+        return false;
+    }
+
+    m_window->show();
+    m_window->raise();
+    return true;
+}
+
+///
+/// The window is created from a temporary component, which is not needed
+/// anymore once the object has been instantiated. The window is owned by the
+/// current object (and not by the JavaScript engine).
+///
+bool LazyWindow::create()
+{
+    if (m_engine.isNull()) {
+        return false;
+    }
+
+    QQmlComponent component(m_engine, m_url);
+    QObject *object = component.create();
+    m_window = qobject_cast<QQuickWindow *>(object);
+    if (m_window.isNull()) {
+        LOG_ERROR() << "LazyWindow: failed creating" << m_url.toString()
+                    << "-" << component.errorString();
+        delete object;
+        return false;
+    }
+
+    QQmlEngine::setObjectOwnership(m_window, QQmlEngine::CppOwnership);
+    connect(m_window, &QQuickWindow::visibleChanged, this,
+            &LazyWindow::visibilityChanged);
+
+    LOG_DEBUG() << "LazyWindow:" << m_url.toString() << "created";
+    return true;
+}
+
+void LazyWindow::visibilityChanged(bool visible)
+{
+    if (visible) {
+        m_timerRelease->stop();
+    } else if (m_releaseDelay > 0) {
+        m_timerRelease->start(m_releaseDelay);
+    }
+}
+
+void LazyWindow::release()
+{
+    if (m_window.isNull() || m_window->isVisible()) {
+        return;
+    }
+
+    LOG_DEBUG() << "LazyWindow:" << m_url.toString() << "released";
+
+    QQuickWindow *window = m_window;
+    m_window.clear();
+    window->deleteLater();
+}
@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef LAZYWINDOW_HPP
+#define LAZYWINDOW_HPP
+
+#include <QObject>
+#include <QPointer>
+#include <QUrl>
+
+class QQmlEngine;
+class QQuickWindow;
+class QTimer;
+
+///
+/// \brief The LazyWindow class manages a QML window which is instantiated only
+/// when it is shown for the first time.
+///
+/// The application usually runs in background and its windows are opened only
+/// occasionally: creating them at startup would waste time and memory for the
+/// scene graphs never displayed. Hence, the component is loaded and the window
+/// created the first time show() is called. Moreover, in case a release delay
+/// is specified, the window is destroyed once it has been hidden for that
+/// amount of time and it is created again the next time it is shown; all the
+/// state to be preserved must therefore be stored in the C++ models.
+///
+class LazyWindow : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief Builds a new instance of this class (the window is not created).
+    /// \param engine the engine used to create the window.
+    /// \param url the URL of the QML file describing the window.
+    /// \param releaseDelay the time (in ms) after which a hidden window is
+    /// destroyed (zero means never).
+    /// \param parent the parent of the current object.
+    ///
+    explicit LazyWindow(QQmlEngine *engine, const QUrl &url,
+                        int releaseDelay = RELEASE_DELAY,
+                        QObject *parent = Q_NULLPTR);
+
+    ///
+    /// \brief Destroys the window (if any) and the current object.
+    ///
+    ~LazyWindow() override;
+
+    ///
+    /// \brief Shows the window, creating it if necessary.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool show();
+
+    ///
+    /// \brief Returns whether the window is currently created or not.
+    ///
+    bool created() const { return !m_window.isNull(); }
+
+    /// \brief The default release delay (in ms).
+    static const int RELEASE_DELAY = 5 * 60 * 1000;
+
+private:
+    ///
+    /// \brief Creates the window (hidden).
+    /// \return true in case of success and false otherwise.
+    ///
+    bool create();
+
+    ///
+    /// \brief Starts or stops the release timer when the visibility of the
+    /// window changes.
+    /// \param visible whether the window is visible or not.
+    ///
+    void visibilityChanged(bool visible);
+
+    ///
+    /// \brief Destroys the window, if still hidden.
+    ///
+    void release();
+
+private:
+    QPointer<QQmlEngine> m_engine; ///< \brief The engine creating the window.
+    const QUrl m_url;              ///< \brief The URL of the QML file.
+    const int m_releaseDelay;      ///< \brief The release delay (in ms).
+
+    QPointer<QQuickWindow> m_window; ///< \brief The window (if created).
+    /// \brief The timer used to release the hidden window.
+    QPointer<QTimer> m_timerRelease;
+};
+
+#endif // LAZYWINDOW_HPP
@@ -17,6 +17,7 @@
  */
 
 #include "peersselectormodel.hpp"
+#include "UserDiscovery/usericoncache.hpp"
 #include "UserDiscovery/users.hpp"
 
 PeersSelectorModel::PeersSelectorModel(quint32 filesNumber,
@@ -60,9 +61,15 @@ QVariant PeersSelectorModel::data(const QModelIndex &index, int role) const
     case Roles::LastNameRole:
         return info.lastName();
     case Roles::IconSetRole:
-        return info.icon().set();
-    case Roles::IconPathRole:
-        return info.icon().path();
+        // Icons not yet available are loaded (or requested with priority) in
+        // background and shown later
+        if (!info.icon().set() || !info.icon().verified()) {
+            m_source->loadIcon(info.uuid());
+            return false;
+        }
+        return true;
+    case Roles::IconUrlRole:
+        return UserIconCache::url(info.icon());
     case Roles::SelectedRole:
         return m_selected.at(index.row());
     }
@@ -105,7 +112,7 @@ QHash<int, QByteArray> PeersSelectorModel::roleNames() const
     roles[Roles::FirstNameRole] = "firstName";
     roles[Roles::LastNameRole] = "lastName";
     roles[Roles::IconSetRole] = "iconSet";
-    roles[Roles::IconPathRole] = "iconPath";
+    roles[Roles::IconUrlRole] = "iconUrl";
     roles[Roles::SelectedRole] = "selected";
     return roles;
 }
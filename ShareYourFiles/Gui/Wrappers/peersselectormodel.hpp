@@ -61,7 +61,7 @@ public:
         FirstNameRole = Qt::UserRole + 1, ///< \brief First name.
         LastNameRole,                     ///< \brief Last name.
         IconSetRole,  ///< \brief Whether the icon is set or not.
-        IconPathRole, ///< \brief Icon's path.
+        IconUrlRole,  ///< \brief Icon's URL (served by UserIconProvider).
         SelectedRole  ///< \brief User selected or not.
     };
 
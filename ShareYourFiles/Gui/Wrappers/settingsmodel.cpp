@@ -18,6 +18,7 @@
 
 #include "settingsmodel.hpp"
 #include "UserDiscovery/user.hpp"
+#include "UserDiscovery/usericoncache.hpp"
 #include "UserDiscovery/users.hpp"
 
 #include <QDir>
@@ -77,11 +78,10 @@ void SettingsModel::setIconSet(bool iconSet)
     }
 }
 
-void SettingsModel::setIconPath(const QString &iconPath)
+void SettingsModel::setIconUrl(const QString &iconUrl)
 {
-    QString localPath = QUrl(iconPath).toLocalFile();
-    if (m_iconPath != localPath) {
-        m_iconPath = localPath;
+    if (m_iconUrl != iconUrl) {
+        m_iconUrl = iconUrl;
         emit iconChanged();
         emit modifiedChanged();
     }
@@ -153,7 +153,8 @@ bool SettingsModel::modified()
 {
     const UserInfo &info = m_localUser->info();
     return m_firstName != info.firstName() || m_lastName != info.lastName() ||
-           m_iconSet != info.icon().set() || m_iconPath != info.icon().path() ||
+           m_iconSet != info.icon().set() ||
+           m_iconUrl != UserIconCache::url(info.icon()) ||
            m_online !=
                (m_localUser->mode() == Enums::OperationalMode::Online) ||
            m_action != info.preferences().action() ||
@@ -171,9 +172,9 @@ bool SettingsModel::saveChanges()
 
     // Update the image only if changed
     const UserIcon &icon = m_localUser->info().icon();
-    if (m_iconSet != icon.set() || m_iconPath != icon.path()) {
-        success =
-            m_localUser->setIcon((m_iconSet) ? QImage(m_iconPath) : QImage());
+    if (m_iconSet != icon.set() || m_iconUrl != UserIconCache::url(icon)) {
+        success = m_localUser->setIcon(
+            (m_iconSet) ? QImage(QUrl(m_iconUrl).toLocalFile()) : QImage());
     }
 
     // Set the operational mode
@@ -200,7 +201,7 @@ void SettingsModel::resetChanges()
     m_firstName = info.firstName();
     m_lastName = info.lastName();
     m_iconSet = info.icon().set();
-    m_iconPath = info.icon().path();
+    m_iconUrl = UserIconCache::url(info.icon());
 
     m_online = m_localUser->mode() == Enums::OperationalMode::Online;
 
@@ -49,9 +49,8 @@ public:
         QString lastName READ lastName WRITE setLastName NOTIFY lastNameChanged)
     /// \brief Provides access to whether the user's icon is set or not.
     Q_PROPERTY(bool iconSet READ iconSet WRITE setIconSet NOTIFY iconChanged)
-    /// \brief Provides access to the user's icon path.
-    Q_PROPERTY(
-        QString iconPath READ iconPath WRITE setIconPath NOTIFY iconChanged)
+    /// \brief Provides access to the user's icon URL.
+    Q_PROPERTY(QString iconUrl READ iconUrl WRITE setIconUrl NOTIFY iconChanged)
 
     /// \brief Provides access to a value indicating whether the user is
     /// currently online or not.
@@ -114,12 +113,13 @@ public:
     /// \param iconSet a boolean value indicating the user's choice.
     void setIconSet(bool iconSet);
 
-    /// \brief Returns the user's icon path.
-    QString iconPath() const { return m_iconPath; }
+    /// \brief Returns the user's icon URL (either the one of the image provider
+    /// for the current icon or the one of a local file for a new icon).
+    QString iconUrl() const { return m_iconUrl; }
 
-    /// \brief Sets the user's icon path.
-    /// \param iconPath the new icon path to be set
-    void setIconPath(const QString &iconPath);
+    /// \brief Sets the user's icon URL.
+    /// \param iconUrl the new icon URL to be set
+    void setIconUrl(const QString &iconUrl);
 
 
     /// \brief Returns a value indicating whether the user is currently online
@@ -225,7 +225,7 @@ private:
 
     /// \brief A value indicating whether the user's icon is set or not.
     bool m_iconSet;
-    QString m_iconPath; ///< \brief User's icon path.
+    QString m_iconUrl; ///< \brief User's icon URL.
 
     /// \brief A value indicating whether the user is currently online or not.
     bool m_online;
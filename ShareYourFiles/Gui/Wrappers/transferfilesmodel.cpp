@@ -0,0 +1,356 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "transferfilesmodel.hpp"
+#include "Common/coalescedtimer.hpp"
+#include "Common/common.hpp"
+#include "FileTransfer/syfftprotocolcommon.hpp"
+
+// Static variables initialization
+static QMap<FileInfo::Status, QString> statusInitializer()
+{
+    using Status = FileInfo::Status;
+    QMap<Status, QString> status;
+    status.insert(Status::Scheduled, QObject::tr("Waiting"));
+    status.insert(Status::InTransfer, QObject::tr("In transfer"));
+    status.insert(Status::Transferred, QObject::tr("Transferred"));
+    status.insert(Status::TransferRejected, QObject::tr("Skipped"));
+    status.insert(Status::TransferFailed, QObject::tr("Failed"));
+    return status;
+}
+const QMap<FileInfo::Status, QString>
+    TransferFilesModel::STATUS(statusInitializer());
+
+TransferFilesModel::TransferFilesModel(
+    QSharedPointer<SyfftProtocolCommon> instance, const QString &names,
+    QObject *parent)
+        : QAbstractListModel(parent),
+          m_instance(instance),
+          m_sender(instance->inherits("SyfftProtocolSender")),
+          m_names(names),
+          m_filter(Filter::All),
+          m_active(false),
+          m_rows(0),
+          m_filesCount(0),
+          m_totalCount(0),
+          m_currentFile(0xFFFFFFFF),
+          m_cacheFirst(0),
+          m_timerUpdate(new CoalescedTimer(this))
+{
+    // Initialize the timer used to poll the status (started when active)
+    m_timerUpdate->setInterval(UPDATE_INTERVAL);
+    connect(m_timerUpdate, &CoalescedTimer::timeout, this,
+            &TransferFilesModel::update);
+
+    reload();
+}
+
+///
+/// The status of an archived transfer does not change anymore, hence the
+/// timer used to poll it is never started.
+///
+TransferFilesModel::TransferFilesModel(bool sender, const TransferInfo &info,
+                                       const QVector<FileInfo> &files,
+                                       const QString &names, QObject *parent)
+        : QAbstractListModel(parent),
+          m_archived(files),
+          m_sender(sender),
+          m_names(names),
+          m_filter(Filter::All),
+          m_active(false),
+          m_rows(0),
+          m_filesCount(0),
+          m_totalCount(static_cast<int>(
+              qMin<quint32>(info.totalFiles(), INT_MAX))),
+          m_currentFile(0xFFFFFFFF),
+          m_cacheFirst(0),
+          m_timerUpdate(new CoalescedTimer(this))
+{
+    reload();
+}
+
+int TransferFilesModel::rowCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_rows;
+}
+
+QVariant TransferFilesModel::data(const QModelIndex &index, int role) const
+{
+    if (index.row() < 0 || index.row() >= m_rows)
+        return QVariant();
+
+    const FileInfo info = file(fileIndex(index.row()));
+    if (!info.valid())
+        return QVariant();
+
+    switch (role) {
+    case Roles::NameRole:
+        return info.name();
+    case Roles::PathRole:
+        return info.path();
+    case Roles::SizeRole:
+        return sizeToHRFormat(info.size());
+    case Roles::StatusRole:
+        return TransferFilesModel::STATUS[info.status()];
+    case Roles::InTransferRole:
+        return info.status() == FileInfo::Status::InTransfer;
+    case Roles::FailedRole:
+        return info.status() == FileInfo::Status::TransferFailed;
+    }
+
+    return QVariant();
+}
+
+bool TransferFilesModel::canFetchMore(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_filter == Filter::All && m_rows < m_filesCount;
+}
+
+void TransferFilesModel::fetchMore(const QModelIndex &parent)
+{
+    Q_UNUSED(parent);
+
+    int count = qMin(static_cast<int>(FETCH_SIZE), m_filesCount - m_rows);
+    if (m_filter != Filter::All || count <= 0) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), m_rows, m_rows + count - 1);
+    m_rows += count;
+    endInsertRows();
+
+    emit rowCountChanged();
+}
+
+void TransferFilesModel::setFilter(Filter filter)
+{
+    if (m_filter == filter) {
+        return;
+    }
+
+    m_filter = filter;
+    reload();
+    emit filterChanged();
+}
+
+///
+/// When the model becomes active, the rows are immediately updated, since the
+/// status has not been polled while the model was inactive.
+///
+void TransferFilesModel::setActive(bool active)
+{
+    if (m_active == active) {
+        return;
+    }
+
+    m_active = active;
+    if (m_active && !archived()) {
+        update();
+        m_timerUpdate->start();
+    } else {
+        m_timerUpdate->stop();
+    }
+
+    emit activeChanged();
+}
+
+///
+/// The files are transferred in order and only the status of the file in
+/// transfer is modified: hence, the rows whose status may have changed since
+/// the last update are the ones between the previous and the current file in
+/// transfer. The list of failed files can only grow, while the new files
+/// received by the peer (if any) are exposed through fetchMore(). Once the
+/// connection is terminated, the status does not change anymore and the
+/// polling is stopped.
+///
+void TransferFilesModel::update()
+{
+    int filesCount = m_instance->filesCount();
+    quint32 currentFile = m_instance->currentFile();
+    QVector<quint32> failed = m_instance->failedFiles();
+    SyfftProtocolCommon::Status status = m_instance->status();
+
+    // The status of the cached entries may have changed
+    m_cache.clear();
+
+    int previous = position(m_currentFile);
+    int current = position(currentFile);
+    bool countChanged = (m_filesCount != filesCount);
+    m_filesCount = filesCount;
+    m_totalCount = filesCount;
+    m_currentFile = currentFile;
+
+    switch (m_filter) {
+    case Filter::All: {
+        int first = qMax(0, qMin(previous, current));
+        int last = qMin(m_rows - 1, qMax(previous, current));
+        if (first <= last) {
+            emit dataChanged(createIndex(first, 0), createIndex(last, 0));
+        }
+        m_failed = failed;
+        break;
+    }
+
+    case Filter::Failed:
+        if (failed.count() > m_rows) {
+            beginInsertRows(QModelIndex(), m_rows, failed.count() - 1);
+            m_failed = failed;
+            m_rows = m_failed.count();
+            endInsertRows();
+            countChanged = true;
+        }
+        break;
+
+    case Filter::InProgress: {
+        m_failed = failed;
+        int rows = inProgressRows();
+        if (rows > m_rows) {
+            beginInsertRows(QModelIndex(), 0, 0);
+            m_rows = rows;
+            endInsertRows();
+            countChanged = true;
+        } else if (rows < m_rows) {
+            beginRemoveRows(QModelIndex(), 0, 0);
+            m_rows = rows;
+            endRemoveRows();
+            countChanged = true;
+        } else if (rows > 0 && previous != current) {
+            emit dataChanged(createIndex(0, 0), createIndex(0, 0));
+        }
+        break;
+    }
+    }
+
+    if (countChanged) {
+        emit rowCountChanged();
+    }
+
+    if (status == SyfftProtocolCommon::Status::Closed ||
+        status == SyfftProtocolCommon::Status::Aborted) {
+        m_timerUpdate->stop();
+    }
+}
+
+///
+/// In case of an archived transfer, the entries are the ones stored in the
+/// record, and the indexes of the failed ones are computed locally.
+///
+void TransferFilesModel::reload()
+{
+    beginResetModel();
+
+    m_cache.clear();
+    if (archived()) {
+        m_filesCount = m_archived.count();
+        m_failed.clear();
+        for (int i = 0; i < m_archived.count(); i++) {
+            if (m_archived.at(i).status() == FileInfo::Status::TransferFailed) {
+                m_failed << static_cast<quint32>(i);
+            }
+        }
+    } else {
+        m_filesCount = m_instance->filesCount();
+        m_totalCount = m_filesCount;
+        m_currentFile = m_instance->currentFile();
+        m_failed = m_instance->failedFiles();
+    }
+
+    switch (m_filter) {
+    case Filter::All:
+        m_rows = qMin(static_cast<int>(FETCH_SIZE), m_filesCount);
+        break;
+    case Filter::InProgress:
+        m_rows = inProgressRows();
+        break;
+    case Filter::Failed:
+        m_rows = m_failed.count();
+        break;
+    }
+
+    endResetModel();
+    emit rowCountChanged();
+}
+
+int TransferFilesModel::inProgressRows() const
+{
+    int current = position(m_currentFile);
+    if (current < 0 || current >= m_filesCount) {
+        return 0;
+    }
+
+    return (file(current).status() == FileInfo::Status::InTransfer) ? 1 : 0;
+}
+
+int TransferFilesModel::fileIndex(int row) const
+{
+    switch (m_filter) {
+    case Filter::All:
+        return row;
+    case Filter::InProgress:
+        return position(m_currentFile);
+    case Filter::Failed:
+        return static_cast<int>(m_failed.at(row));
+    }
+    return -1;
+}
+
+///
+/// The entries are read in aligned blocks of CACHE_SIZE elements, so that the
+/// rows displayed together by a view require a single access to the instance
+/// (and hence a single lock of its mutex).
+///
+FileInfo TransferFilesModel::file(int index) const
+{
+    if (index < 0) {
+        return FileInfo();
+    }
+
+    if (archived()) {
+        return m_archived.value(index);
+    }
+
+    if (index < m_cacheFirst || index >= m_cacheFirst + m_cache.count()) {
+        m_cacheFirst = index - index % CACHE_SIZE;
+        m_cache = m_instance->files(m_cacheFirst, CACHE_SIZE);
+    }
+
+    int offset = index - m_cacheFirst;
+    return (offset < m_cache.count()) ? m_cache.at(offset) : FileInfo();
+}
+
+int TransferFilesModel::position(quint32 currentFile)
+{
+    return (currentFile == 0xFFFFFFFF)
+               ? -1
+               : static_cast<int>(qMin<quint32>(currentFile, INT_MAX));
+}
+
+QHash<int, QByteArray> TransferFilesModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[Roles::NameRole] = "name";
+    roles[Roles::PathRole] = "path";
+    roles[Roles::SizeRole] = "size";
+    roles[Roles::StatusRole] = "status";
+    roles[Roles::InTransferRole] = "inTransfer";
+    roles[Roles::FailedRole] = "failed";
+    return roles;
+}
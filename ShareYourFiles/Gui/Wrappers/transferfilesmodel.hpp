@@ -0,0 +1,277 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef TRANSFERFILESMODEL_HPP
+#define TRANSFERFILESMODEL_HPP
+
+#include "FileTransfer/fileinfo.hpp"
+#include "FileTransfer/transferinfo.hpp"
+
+#include <QAbstractListModel>
+#include <QMap>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QVector>
+
+class CoalescedTimer;
+class SyfftProtocolCommon;
+
+///
+/// \brief The TransferFilesModel class provides the c++ model used by the
+/// TransferFiles QML window, listing the files of a transfer together with
+/// their status.
+///
+/// The entries are read directly from the list of files stored by the SYFFT
+/// protocol instance, without copying it: only the blocks of CACHE_SIZE entries
+/// containing the rows requested by the views are fetched, and the rows are
+/// exposed incrementally (FETCH_SIZE at a time) through canFetchMore() and
+/// fetchMore(), so that very large transfers do not slow down the interface.
+/// The list can be filtered to show only the file in transfer or the files
+/// whose transfer failed.
+///
+/// While the model is active (i.e. displayed), the status is polled and only
+/// the rows whose status may have changed (i.e. the ones between the previous
+/// and the current file in transfer) are notified to the views.
+///
+/// A model can also be built for a terminated (archived) transfer, whose
+/// instance has been freed: in that case, the rows are served from the failed
+/// and skipped files stored in the history record and no polling occurs.
+///
+class TransferFilesModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief The Filter enum represents the possible subsets of files shown.
+    ///
+    enum Filter {
+        All,        ///< \brief All the files.
+        InProgress, ///< \brief Only the file currently in transfer.
+        Failed,     ///< \brief Only the files whose transfer failed.
+    };
+    Q_ENUM(Filter)
+
+    /// \brief Provides access to the number of elements in the model.
+    Q_PROPERTY(int rowCount READ rowCount NOTIFY rowCountChanged)
+    /// \brief Provides access to the total number of files of the transfer.
+    Q_PROPERTY(int totalCount READ totalCount NOTIFY rowCountChanged)
+    /// \brief Provides access to whether the transfer is archived (and hence
+    /// only the failed and skipped files are available).
+    Q_PROPERTY(bool archived READ archived CONSTANT)
+    /// \brief Provides access to the subset of files shown.
+    Q_PROPERTY(Filter filter READ filter WRITE setFilter NOTIFY filterChanged)
+    /// \brief Specifies whether the model is currently displayed.
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+
+    /// \brief Provides access to whether the files are sent or received.
+    Q_PROPERTY(bool sender READ sender CONSTANT)
+    /// \brief Provides access to the peer's names.
+    Q_PROPERTY(QString names READ names CONSTANT)
+
+    ///
+    /// \brief The Roles enum represents the possible properties that can be
+    /// queried for each element of the model.
+    ///
+    enum Roles {
+        NameRole = Qt::UserRole + 1, ///< \brief The name of the file.
+        PathRole,       ///< \brief The relative path (excluding the name).
+        SizeRole,       ///< \brief The size of the file.
+        StatusRole,     ///< \brief The current status of the file.
+        InTransferRole, ///< \brief Whether the file is in transfer or not.
+        FailedRole,     ///< \brief Whether the transfer failed or not.
+    };
+
+    ///
+    /// \brief Builds a new instance of this model.
+    /// \param instance the SYFFT protocol instance whose files are shown.
+    /// \param names the names of the peer.
+    /// \param parent the parent of the current object.
+    ///
+    explicit TransferFilesModel(QSharedPointer<SyfftProtocolCommon> instance,
+                                const QString &names,
+                                QObject *parent = Q_NULLPTR);
+
+    ///
+    /// \brief Builds a new instance of this model for an archived transfer.
+    /// \param sender whether the files have been sent or received.
+    /// \param info the final transfer information.
+    /// \param files the failed and skipped files stored in the record.
+    /// \param names the names of the peer.
+    /// \param parent the parent of the current object.
+    ///
+    explicit TransferFilesModel(bool sender, const TransferInfo &info,
+                                const QVector<FileInfo> &files,
+                                const QString &names,
+                                QObject *parent = Q_NULLPTR);
+
+    ///
+    /// \brief Returns the number of rows currently exposed by the model.
+    /// \param parent unused.
+    /// \return the number of elements available.
+    ///
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    ///
+    /// \brief Returns the data stored under the given role for the item
+    /// referred to by the index.
+    /// \param index the identifier of the requested item.
+    /// \param role the identifier of the requested role.
+    /// \return the requested value or an invalid QVariant.
+    ///
+    QVariant data(const QModelIndex &index,
+                  int role = Qt::DisplayRole) const override;
+
+    ///
+    /// \brief Returns whether further rows can be exposed.
+    /// \param parent unused.
+    ///
+    bool canFetchMore(const QModelIndex &parent) const override;
+
+    ///
+    /// \brief Exposes the next block of rows.
+    /// \param parent unused.
+    ///
+    void fetchMore(const QModelIndex &parent) override;
+
+    /// \brief Returns the total number of files of the transfer.
+    int totalCount() const { return m_totalCount; }
+    /// \brief Returns whether the transfer is archived or not.
+    bool archived() const { return m_instance.isNull(); }
+
+    /// \brief Returns the subset of files shown.
+    Filter filter() const { return m_filter; }
+    ///
+    /// \brief Changes the subset of files shown.
+    /// \param filter the new value.
+    ///
+    void setFilter(Filter filter);
+
+    /// \brief Returns whether the model is currently displayed or not.
+    bool active() const { return m_active; }
+    ///
+    /// \brief Sets whether the model is currently displayed or not.
+    /// \param active the new value.
+    ///
+    void setActive(bool active);
+
+    /// \brief Returns whether the files are sent or received.
+    bool sender() const { return m_sender; }
+    /// \brief Returns the peer's names.
+    QString names() const { return m_names; }
+
+signals:
+    /// \brief Signal emitted when the number of elements changes.
+    void rowCountChanged();
+    /// \brief Signal emitted when the filter changes.
+    void filterChanged();
+    /// \brief Signal emitted when the active property changes.
+    void activeChanged();
+
+    /// \brief Signal emitted when the instance is requested to be destroyed.
+    void requestedDestruction();
+
+public slots:
+    ///
+    /// \brief Requests the destruction of the current object.
+    ///
+    void requestDestruction() { emit requestedDestruction(); }
+
+protected:
+    ///
+    /// \brief Returns the model's role names.
+    ///
+    QHash<int, QByteArray> roleNames() const override;
+
+private slots:
+    ///
+    /// \brief Polls the status of the transfer and notifies the views about
+    /// the changed rows.
+    ///
+    void update();
+
+private:
+    ///
+    /// \brief Rebuilds the rows of the model according to the filter.
+    ///
+    void reload();
+
+    ///
+    /// \brief Returns the number of rows to be exposed in InProgress mode.
+    ///
+    int inProgressRows() const;
+
+    ///
+    /// \brief Returns the index of the file corresponding to a row.
+    ///
+    int fileIndex(int row) const;
+
+    ///
+    /// \brief Returns an entry of the list of files, reading the block
+    /// containing it if not cached.
+    /// \param index the index of the file.
+    /// \return the requested entry (invalid if not available).
+    ///
+    FileInfo file(int index) const;
+
+    ///
+    /// \brief Converts the index of the file in transfer to a position
+    /// (-1 if the transfer is not yet started).
+    ///
+    static int position(quint32 currentFile);
+
+private:
+    /// \brief The instance storing the list of files (null if archived).
+    QSharedPointer<SyfftProtocolCommon> m_instance;
+    /// \brief The failed and skipped files (if archived).
+    QVector<FileInfo> m_archived;
+
+    bool m_sender;   ///< \brief Whether the files are sent or received.
+    QString m_names; ///< \brief The peer's names.
+
+    Filter m_filter; ///< \brief The subset of files shown.
+    bool m_active;   ///< \brief Whether the model is displayed.
+
+    int m_rows;       ///< \brief The number of rows exposed.
+    int m_filesCount; ///< \brief The number of entries (last update).
+    int m_totalCount; ///< \brief The total number of files (last update).
+    /// \brief The index of the file in transfer (last update).
+    quint32 m_currentFile;
+    /// \brief The indexes of the failed files (last update).
+    QVector<quint32> m_failed;
+
+    mutable int m_cacheFirst;          ///< \brief The first cached entry.
+    mutable QVector<FileInfo> m_cache; ///< \brief The cached entries.
+
+    /// \brief The timer used to poll the status of the transfer.
+    QPointer<CoalescedTimer> m_timerUpdate;
+
+    /// \brief The interval between status updates (in ms).
+    static const int UPDATE_INTERVAL = 500;
+    /// \brief The number of rows exposed by each fetchMore() call.
+    static const int FETCH_SIZE = 500;
+    /// \brief The number of entries read at a time from the instance.
+    static const int CACHE_SIZE = 64;
+
+    /// \brief Provides an association between FileInfo::Status and the
+    /// corresponding textual string.
+    static const QMap<FileInfo::Status, QString> STATUS;
+};
+
+#endif // TRANSFERFILESMODEL_HPP
@@ -19,6 +19,7 @@
 #include "transferrequestmodel.hpp"
 #include "FileTransfer/syfftprotocolreceiver.hpp"
 #include "UserDiscovery/user.hpp"
+#include "UserDiscovery/usericoncache.hpp"
 #include "UserDiscovery/users.hpp"
 
 #include <QUrl>
@@ -138,7 +139,13 @@ void TransferRequestModel::updateSenderInformation()
     }
 
     m_names = info.names();
-    m_iconSet = info.icon().set();
-    m_iconPath = info.icon().path();
+
+    // Icons not yet available are loaded (or requested with priority) in
+    // background and shown later
+    if (!info.icon().set() || !info.icon().verified()) {
+        m_peersList->loadIcon(m_request->senderUuid());
+    }
+    m_iconSet = info.icon().set() && info.icon().verified();
+    m_iconUrl = UserIconCache::url(info.icon());
     emit senderInformationUpdated();
 }
@@ -17,6 +17,7 @@
  */
 
 #include "transferresponsemodel.hpp"
+#include "UserDiscovery/usericoncache.hpp"
 #include "UserDiscovery/users.hpp"
 
 TransferResponseModel::TransferResponseModel(const QString &uuid,
@@ -50,7 +51,13 @@ void TransferResponseModel::updateSenderInformation()
     }
 
     m_names = info.names();
-    m_iconSet = info.icon().set();
-    m_iconPath = info.icon().path();
+
+    // Icons not yet available are loaded (or requested with priority) in
+    // background and shown later
+    if (!info.icon().set() || !info.icon().verified()) {
+        m_peersList->loadIcon(m_uuid);
+    }
+    m_iconSet = info.icon().set() && info.icon().verified();
+    m_iconUrl = UserIconCache::url(info.icon());
     emit senderInformationUpdated();
 }
@@ -40,8 +40,8 @@ public:
     Q_PROPERTY(QString names READ names NOTIFY senderInformationUpdated)
     /// \brief Provides access to whether the senders's icon is set or not.
     Q_PROPERTY(bool iconSet READ iconSet NOTIFY senderInformationUpdated)
-    /// \brief Provides access to the senders's icon path.
-    Q_PROPERTY(QString iconPath READ iconPath NOTIFY senderInformationUpdated)
+    /// \brief Provides access to the senders's icon URL.
+    Q_PROPERTY(QString iconUrl READ iconUrl NOTIFY senderInformationUpdated)
 
     /// \brief Provides access to whether the request has been accepted or not.
     Q_PROPERTY(bool accepted READ accepted CONSTANT)
@@ -64,8 +64,8 @@ public:
     QString names() const { return m_names; }
     /// \brief Returns whether the user's icon is set or not.
     bool iconSet() const { return m_iconSet; }
-    /// \brief Returns the user's icon path.
-    QString iconPath() const { return m_iconPath; }
+    /// \brief Returns the user's icon URL (served by UserIconProvider).
+    QString iconUrl() const { return m_iconUrl; }
 
     /// \brief Returns whether the request has been accepted or not.
     bool accepted() const { return m_accepted; }
@@ -97,7 +97,7 @@ private:
     QString m_names; ///< \brief Sender's names.
     /// \brief A value indicating whether the sender's icon is set or not.
     bool m_iconSet;
-    QString m_iconPath; ///< \brief Sender's icon path.
+    QString m_iconUrl; ///< \brief Sender's icon URL.
 
     /// \brief Whether the request has been accepted or not.
     bool m_accepted;
@@ -17,13 +17,16 @@
  */
 
 #include "transfersmodel.hpp"
+#include "Common/coalescedtimer.hpp"
 #include "FileTransfer/syfftprotocolreceiver.hpp"
 #include "FileTransfer/syfftprotocolsender.hpp"
 #include "FileTransfer/transferinfo.hpp"
 #include "UserDiscovery/user.hpp"
+#include "UserDiscovery/usericoncache.hpp"
 #include "UserDiscovery/users.hpp"
 
 #include "Gui/Wrappers/duplicatedfilemodel.hpp"
+#include "Gui/Wrappers/transferfilesmodel.hpp"
 #include "Gui/Wrappers/transferrequestmodel.hpp"
 #include "Gui/Wrappers/transferresponsemodel.hpp"
 
@@ -35,6 +38,8 @@ static QmlTypeRegistration<TransferRequestModel> requestRegisterer;
 static QmlTypeRegistration<TransferResponseModel> responseRegisterer;
 // Register DuplicatedFileModel to the QML system
 static QmlTypeRegistration<DuplicatedFileModel> duplicatedFileRegisterer;
+// Register TransferFilesModel to the QML system
+static QmlTypeRegistration<TransferFilesModel> filesRegisterer;
 
 // Static variables initialization
 static QMap<SyfftProtocolCommon::Status, QString> statusInitializer()
@@ -59,59 +64,85 @@ static QMap<SyfftProtocolCommon::Status, QString> statusInitializer()
 const QMap<SyfftProtocolCommon::Status, QString>
     TransfersModel::STATUS(statusInitializer());
 
+///
+/// The records of the terminated transfers saved in the history (if enabled)
+/// are loaded and shown before the new ones.
+///
 TransfersModel::TransfersModel(LocalUser *localUser, PeersList *peersList,
-                               QObject *parent)
+                               const QString &historyPath, QObject *parent)
         : QAbstractListModel(parent),
           m_localUser(localUser),
           m_peersList(peersList),
-          m_timerUpdate(new QTimer(this))
+          m_active(false),
+          m_timerUpdate(new CoalescedTimer(this)),
+          m_history(historyPath),
+          m_timerSave(new QTimer(this))
 {
-    // Initialize the timer used to update the transfer information
-    connect(m_timerUpdate, &QTimer::timeout, this, [this]() {
-        // Update all the transfer information
-        for (int i = 0; i < m_instances.count(); i++) {
-            m_transferInformations[i] = m_instances.at(i)->transferInfo();
-        }
+    // Load the history
+    foreach (const TransferRecord &record, m_history.load()) {
+        Transfer transfer;
+        transfer.sender = record.sender;
+        transfer.status = record.status;
+        transfer.peerUuid = record.peerUuid;
+        transfer.names = record.names;
+        transfer.info = record.info;
+        transfer.files = record.files;
+        m_transfers << transfer;
+        loadIcon(transfer.peerUuid);
+    }
 
-        // Emit the data changed signal to force the update of the transfer
-        // information for each element
-        emit dataChanged(createIndex(0, 0),
-                         createIndex(m_instances.count(), 0));
-    });
+    // Initialize the timer used to save the history
+    m_timerSave->setInterval(SAVE_DELAY);
+    m_timerSave->setSingleShot(true);
+    connect(m_timerSave, &QTimer::timeout, this, &TransfersModel::saveHistory);
+
+    // Initialize the timer used to update the transfer information (started
+    // only when needed)
+    m_timerUpdate->setInterval(UPDATE_INTERVAL);
+    connect(m_timerUpdate, &CoalescedTimer::timeout, this,
+            &TransfersModel::updateTransferInfo);
+
+    // Refresh the names and the icons when the peers are updated
+    connect(m_peersList, &PeersList::peerAdded, this,
+            &TransfersModel::peerChanged);
+    connect(m_peersList, &PeersList::peerUpdated, this,
+            &TransfersModel::peerChanged);
+}
 
-    m_timerUpdate->start(UPDATE_INTERVAL);
+TransfersModel::~TransfersModel()
+{
+    if (m_timerSave->isActive()) {
+        m_timerSave->stop();
+        saveHistory();
+    }
 }
 
 int TransfersModel::rowCount(const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    return m_instances.count();
+    return m_transfers.count();
 }
 
 QVariant TransfersModel::data(const QModelIndex &index, int role) const
 {
-    if (index.row() < 0 || index.row() >= m_instances.size())
+    if (index.row() < 0 || index.row() >= m_transfers.size())
         return QVariant();
 
     // Transfer information
-    const TransferInfo tinfo = m_transferInformations.at(index.row());
+    const Transfer &transfer = m_transfers.at(index.row());
+    const TransferInfo &tinfo = transfer.info;
     switch (role) {
     case Roles::SenderRole:
-        return m_instances.at(index.row())->inherits("SyfftProtocolSender");
+        return transfer.sender;
 
     case Roles::StatusRole:
-        return TransfersModel::STATUS[m_instances.at(index.row())->status()];
+        return TransfersModel::STATUS[transfer.status];
     case Roles::InTransferRole:
-        return m_instances.at(index.row())->status() ==
-               SyfftProtocolCommon::Status::InTransfer;
+        return transfer.status == SyfftProtocolCommon::Status::InTransfer;
     case Roles::ClosedRole:
-        return m_instances.at(index.row())->status() ==
-                   SyfftProtocolCommon::Status::Closed ||
-               m_instances.at(index.row())->status() ==
-                   SyfftProtocolCommon::Status::Aborted;
+        return terminated(transfer.status);
     case Roles::PausedRole:
-        return m_instances.at(index.row())->status() ==
-               SyfftProtocolCommon::Status::PausedByUser;
+        return transfer.status == SyfftProtocolCommon::Status::PausedByUser;
 
     case Roles::PercentageRole:
         return tinfo.percentageBytes();
@@ -139,7 +170,7 @@ QVariant TransfersModel::data(const QModelIndex &index, int role) const
     }
 
     // Sender information
-    QString peerUuid = m_instances.at(index.row())->peerUuid();
+    const QString &peerUuid = transfer.peerUuid;
     const UserInfo &info = m_peersList->peer(peerUuid);
 
     // In case the UUID of the peer has not yet been received, return
@@ -147,10 +178,11 @@ QVariant TransfersModel::data(const QModelIndex &index, int role) const
     if (peerUuid == SyfftProtocolCommon::UNKNOWN_UUID || !info.valid()) {
         switch (role) {
         case Roles::NamesRole:
-            return User::NO_NAME;
+            // The names saved in the history are used if the peer expired
+            return (transfer.names.isEmpty()) ? User::NO_NAME : transfer.names;
         case Roles::IconSetRole:
             return false;
-        case Roles::IconPathRole:
+        case Roles::IconUrlRole:
             return QString();
         }
 
@@ -162,14 +194,41 @@ QVariant TransfersModel::data(const QModelIndex &index, int role) const
     case Roles::NamesRole:
         return info.names();
     case Roles::IconSetRole:
-        return info.icon().set();
-    case Roles::IconPathRole:
-        return info.icon().path();
+        // Icons not yet available are shown once loaded (see loadIcon())
+        return info.icon().set() && info.icon().verified();
+    case Roles::IconUrlRole:
+        return UserIconCache::url(info.icon());
     }
 
     return QVariant();
 }
 
+///
+/// When the model becomes active, the transfer information of the instances
+/// not yet terminated is refreshed, since it has not been polled while the
+/// model was inactive.
+///
+void TransfersModel::setActive(bool active)
+{
+    if (m_active == active) {
+        return;
+    }
+
+    m_active = active;
+    if (m_active) {
+        for (int i = 0; i < m_transfers.count(); i++) {
+            if (!terminated(m_transfers.at(i).status)) {
+                QVector<int> roles;
+                refreshTransferInfo(i, roles);
+                notifyChanged(i, roles);
+            }
+        }
+    }
+
+    updateTimer();
+    emit activeChanged();
+}
+
 void TransfersModel::addSyfftInstance(
     QSharedPointer<SyfftProtocolSender> instance)
 {
@@ -201,9 +260,8 @@ void TransfersModel::addSyfftInstance(
 int TransfersModel::ongoingTransfers()
 {
     int count = 0;
-    foreach (const QSharedPointer<SyfftProtocolCommon> instance, m_instances) {
-        if (instance->status() != SyfftProtocolCommon::Status::Closed &&
-            instance->status() != SyfftProtocolCommon::Status::Aborted) {
+    foreach (const Transfer &transfer, m_transfers) {
+        if (!terminated(transfer.status)) {
             count++;
         }
     }
@@ -213,10 +271,8 @@ int TransfersModel::ongoingTransfers()
 int TransfersModel::ongoingReceptions()
 {
     int count = 0;
-    foreach (const QSharedPointer<SyfftProtocolCommon> instance, m_instances) {
-        if (instance->inherits("SyfftProtocolReceiver") &&
-            instance->status() != SyfftProtocolCommon::Status::Closed &&
-            instance->status() != SyfftProtocolCommon::Status::Aborted) {
+    foreach (const Transfer &transfer, m_transfers) {
+        if (!transfer.sender && !terminated(transfer.status)) {
             count++;
         }
     }
@@ -225,33 +281,67 @@ int TransfersModel::ongoingReceptions()
 
 void TransfersModel::pauseConnection(const int index, bool setPause)
 {
-    if (index < 0 || index >= m_instances.size())
+    if (index < 0 || index >= m_transfers.size() ||
+        m_transfers.at(index).instance.isNull())
         return;
 
-    m_instances.at(index)->changePauseMode(setPause);
+    m_transfers.at(index).instance->changePauseMode(setPause);
 }
 
 void TransfersModel::abortConnection(const int index)
 {
-    if (index < 0 || index >= m_instances.size())
+    if (index < 0 || index >= m_transfers.size() ||
+        m_transfers.at(index).instance.isNull())
         return;
 
-    m_instances.at(index)->terminateConnection();
+    m_transfers.at(index).instance->terminateConnection();
 }
 
 void TransfersModel::deleteConnection(const int index)
 {
-    if (index < 0 || index >= m_instances.size())
+    if (index < 0 || index >= m_transfers.size())
         return;
 
+    bool archived = m_transfers.at(index).instance.isNull();
     beginRemoveRows(QModelIndex(), index, index);
-    m_instances.removeAt(index);
-    m_transferInformations.removeAt(index);
+    m_transfers.removeAt(index);
     endRemoveRows();
 
+    // The record has been deleted from the history
+    if (archived) {
+        m_timerSave->start();
+    }
+
+    updateTimer();
     emit rowCountChanged();
 }
 
+///
+/// Once the connection is terminated, the model is built from the files
+/// stored in the history record, since the instance has been freed.
+///
+void TransfersModel::showFiles(const int index)
+{
+    if (index < 0 || index >= m_transfers.size())
+        return;
+
+    // Create the model providing access to the list of files
+    const Transfer &transfer = m_transfers.at(index);
+    QString names = data(createIndex(index, 0), Roles::NamesRole).toString();
+    QPointer<TransferFilesModel> model =
+        (transfer.instance.isNull())
+            ? new TransferFilesModel(transfer.sender, transfer.info,
+                                     transfer.files, names)
+            : new TransferFilesModel(transfer.instance, names);
+
+    // Connect the slot to delete the instance when requested
+    connect(model, &TransferFilesModel::requestedDestruction, model,
+            &QObject::deleteLater);
+
+    // Emit the signal
+    emit filesRequested(model);
+}
+
 void TransfersModel::transferRequested(
     QSharedPointer<SyfftProtocolSharingRequest> request)
 {
@@ -302,21 +392,283 @@ void TransfersModel::duplicatedFile(
 void TransfersModel::addSyfftInstance(
     QSharedPointer<SyfftProtocolCommon> instance)
 {
+    Transfer transfer;
+    transfer.instance = instance;
+    transfer.sender = instance->inherits("SyfftProtocolSender");
+    transfer.status = instance->status();
+    transfer.peerUuid = instance->peerUuid();
+    transfer.info = instance->transferInfo();
+
     int index = rowCount();
     beginInsertRows(QModelIndex(), index, index);
-    m_instances << instance;
-    m_transferInformations << instance->transferInfo();
+    m_transfers << transfer;
     endInsertRows();
+    loadIcon(transfer.peerUuid);
+
+    // Update the cached information when the status changes (the signal is
+    // queued, being emitted by the thread running the instance)
+    SyfftProtocolCommon *pointer = instance.data();
+    connect(pointer, &SyfftProtocolCommon::statusChanged, this,
+            [this, pointer](SyfftProtocolCommon::Status status) {
+                instanceStatusChanged(pointer, status);
+            });
 
+    updateTimer();
     emit rowCountChanged();
 }
 
+///
+/// Apart from the status, the identifier of the peer (received by the
+/// receiver instances when the connection is established) and the transfer
+/// information are refreshed, and the views are notified only about the roles
+/// whose value changed. Notifications referring to instances already removed
+/// from the model are ignored.
+///
+void TransfersModel::instanceStatusChanged(
+    SyfftProtocolCommon *instance, SyfftProtocolCommon::Status status)
+{
+    int index = indexOf(instance);
+    if (index < 0) {
+        return;
+    }
+
+    Transfer &transfer = m_transfers[index];
+    QVector<int> roles;
+    if (transfer.status != status) {
+        transfer.status = status;
+        roles << Roles::StatusRole << Roles::InTransferRole
+              << Roles::ClosedRole << Roles::PausedRole;
+    }
+
+    QString peerUuid = instance->peerUuid();
+    if (transfer.peerUuid != peerUuid) {
+        transfer.peerUuid = peerUuid;
+        roles << Roles::NamesRole << Roles::IconSetRole << Roles::IconUrlRole;
+        loadIcon(peerUuid);
+    }
+
+    refreshTransferInfo(index, roles);
+    notifyChanged(index, roles);
+
+    if (terminated(status)) {
+        archive(index);
+    }
+    updateTimer();
+}
+
+///
+/// The icon of the peer is loaded in case it is referenced by some row and it
+/// changed in the meanwhile (e.g. a new one has been advertised).
+///
+void TransfersModel::peerChanged(const QString &uuid)
+{
+    QVector<int> roles;
+    roles << Roles::NamesRole << Roles::IconSetRole << Roles::IconUrlRole;
+
+    bool found = false;
+    for (int i = 0; i < m_transfers.count(); i++) {
+        if (m_transfers.at(i).peerUuid == uuid) {
+            notifyChanged(i, roles);
+            found = true;
+        }
+    }
+
+    if (found) {
+        loadIcon(uuid);
+    }
+}
+
+///
+/// Icons not yet available are loaded (or requested with priority) in
+/// background, and the views are notified through peerChanged() once they
+/// are ready. Nothing is done for unknown peers or icons already verified.
+///
+void TransfersModel::loadIcon(const QString &uuid)
+{
+    if (uuid == SyfftProtocolCommon::UNKNOWN_UUID) {
+        return;
+    }
+
+    const UserInfo &info = m_peersList->peer(uuid);
+    if (info.valid() && (!info.icon().set() || !info.icon().verified())) {
+        m_peersList->loadIcon(uuid);
+    }
+}
+
+///
+/// Only the instances in transfer are polled, since the information of the
+/// other ones changes only together with their status.
+///
+void TransfersModel::updateTransferInfo()
+{
+    for (int i = 0; i < m_transfers.count(); i++) {
+        if (m_transfers.at(i).status ==
+            SyfftProtocolCommon::Status::InTransfer) {
+            QVector<int> roles;
+            refreshTransferInfo(i, roles);
+            notifyChanged(i, roles);
+        }
+    }
+}
+
+void TransfersModel::saveHistory()
+{
+    QList<TransferRecord> records;
+    foreach (const Transfer &transfer, m_transfers) {
+        if (transfer.instance.isNull()) {
+            TransferRecord record;
+            record.sender = transfer.sender;
+            record.status = transfer.status;
+            record.peerUuid = transfer.peerUuid;
+            record.names = transfer.names;
+            record.info = transfer.info;
+            record.files = transfer.files;
+            records << record;
+        }
+    }
+
+    m_history.save(records);
+}
+
+int TransfersModel::indexOf(const SyfftProtocolCommon *instance) const
+{
+    for (int i = 0; i < m_transfers.count(); i++) {
+        if (m_transfers.at(i).instance.data() == instance) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void TransfersModel::refreshTransferInfo(int index, QVector<int> &roles)
+{
+    TransferInfo &cached = m_transfers[index].info;
+    const TransferInfo info = m_transfers.at(index).instance->transferInfo();
+
+    if (info.percentageBytes() != cached.percentageBytes()) {
+        roles << Roles::PercentageRole;
+    }
+    if (info.fileInTransfer() != cached.fileInTransfer()) {
+        roles << Roles::FilenameRole;
+    }
+    if (info.currentTransferSpeed() != cached.currentTransferSpeed()) {
+        roles << Roles::SpeedRole;
+    }
+    if (info.averageTransferSpeed() != cached.averageTransferSpeed()) {
+        roles << Roles::AvgSpeedRole;
+    }
+    if (info.totalFiles() != cached.totalFiles()) {
+        roles << Roles::TotalNumberRole;
+    }
+    if (info.totalBytes() != cached.totalBytes()) {
+        roles << Roles::TotalSizeRole;
+    }
+    if (info.remainingTime() != cached.remainingTime()) {
+        roles << Roles::RemainingTimeRole;
+    }
+    if (info.remainingFiles() != cached.remainingFiles()) {
+        roles << Roles::RemainingNumberRole;
+    }
+    if (info.remainingBytes() != cached.remainingBytes()) {
+        roles << Roles::RemainingSizeRole;
+    }
+    if (info.skippedFiles() != cached.skippedFiles()) {
+        roles << Roles::SkippedNumberRole;
+    }
+    if (info.skippedBytes() != cached.skippedBytes()) {
+        roles << Roles::SkippedSizeRole;
+    }
+
+    cached = info;
+}
+
+void TransfersModel::notifyChanged(int index, const QVector<int> &roles)
+{
+    if (!roles.isEmpty()) {
+        QModelIndex modelIndex = createIndex(index, 0);
+        emit dataChanged(modelIndex, modelIndex, roles);
+    }
+}
+
+void TransfersModel::updateTimer()
+{
+    bool inTransfer = false;
+    foreach (const Transfer &transfer, m_transfers) {
+        if (transfer.status == SyfftProtocolCommon::Status::InTransfer) {
+            inTransfer = true;
+            break;
+        }
+    }
+
+    if (m_active && inTransfer) {
+        if (!m_timerUpdate->isActive()) {
+            m_timerUpdate->start();
+        }
+    } else {
+        m_timerUpdate->stop();
+    }
+}
+
+///
+/// The names of the peer are stored in the record, so that they can still be
+/// shown if the peer expires, together with (at most
+/// TransferRecord::MAX_FILES) entries of the files whose transfer failed or
+/// was skipped. The instance is released (and hence deleted, unless still
+/// referenced elsewhere), together with the list of files and the connection
+/// resources. The rows do not change position, hence only the
+/// oldest records exceeding the cap are removed.
+///
+void TransfersModel::archive(int index)
+{
+    Transfer &transfer = m_transfers[index];
+    if (transfer.instance.isNull()) {
+        return;
+    }
+
+    const UserInfo &info = m_peersList->peer(transfer.peerUuid);
+    if (transfer.peerUuid != SyfftProtocolCommon::UNKNOWN_UUID &&
+        info.valid()) {
+        transfer.names = info.names();
+    }
+    transfer.files =
+        transfer.instance->unsuccessfulFiles(TransferRecord::MAX_FILES);
+    transfer.instance.clear();
+
+    // Count the records and remove the oldest ones exceeding the cap
+    int records = 0;
+    foreach (const Transfer &current, m_transfers) {
+        records += (current.instance.isNull()) ? 1 : 0;
+    }
+
+    for (int i = 0; i < m_transfers.count() &&
+                    records > TransferHistory::MAX_RECORDS;) {
+        if (!m_transfers.at(i).instance.isNull()) {
+            i++;
+            continue;
+        }
+
+        beginRemoveRows(QModelIndex(), i, i);
+        m_transfers.removeAt(i);
+        endRemoveRows();
+        records--;
+        emit rowCountChanged();
+    }
+
+    m_timerSave->start();
+}
+
+bool TransfersModel::terminated(SyfftProtocolCommon::Status status)
+{
+    return status == SyfftProtocolCommon::Status::Closed ||
+           status == SyfftProtocolCommon::Status::Aborted;
+}
+
 QHash<int, QByteArray> TransfersModel::roleNames() const
 {
     QHash<int, QByteArray> roles;
     roles[Roles::NamesRole] = "names";
     roles[Roles::IconSetRole] = "iconSet";
-    roles[Roles::IconPathRole] = "iconPath";
+    roles[Roles::IconUrlRole] = "iconUrl";
 
     roles[Roles::SenderRole] = "sender";
     roles[Roles::StatusRole] = "status";
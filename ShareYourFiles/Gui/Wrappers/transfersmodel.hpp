@@ -20,6 +20,7 @@
 #define SYFFTINSTANCESMODEL_HPP
 
 #include "FileTransfer/syfftprotocolcommon.hpp"
+#include "FileTransfer/transferhistory.hpp"
 #include "FileTransfer/transferinfo.hpp"
 
 #include <QAbstractListModel>
@@ -33,9 +34,11 @@ class SyfftProtocolSharingRequest;
 class SyfftProtocolDuplicatedFile;
 
 class DuplicatedFileModel;
+class TransferFilesModel;
 class TransferRequestModel;
 class TransferResponseModel;
 
+class CoalescedTimer;
 class QTimer;
 
 ///
@@ -48,6 +51,19 @@ class QTimer;
 /// and re-emitting them after having marshalled the request instance in order
 /// to make it accessible from QML.
 ///
+/// The status and the transfer information of each instance are cached, so
+/// that data() never needs to access the instances (and therefore to lock
+/// their mutexes). The cache is refreshed when an instance notifies a change
+/// of status and, while the Transfers window is visible (see active), through
+/// a periodic polling limited to the instances currently in transfer: only
+/// the rows and the roles actually changed are notified to the views.
+///
+/// Once terminated (closed or aborted), the instances are freed and their rows
+/// become lightweight history records storing only the final information and
+/// the files whose transfer failed or was skipped: the newest
+/// TransferHistory::MAX_RECORDS records are kept and, optionally, saved to
+/// file to be shown again at the next start.
+///
 class TransfersModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -56,6 +72,12 @@ public:
     /// \brief Provides access to the number of elements in the model.
     Q_PROPERTY(int rowCount READ rowCount NOTIFY rowCountChanged)
 
+    ///
+    /// \brief Specifies whether the model is currently displayed (i.e. the
+    /// transfer information of the instances in transfer has to be polled).
+    ///
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+
     ///
     /// \brief The Roles enum represents the possible properties that can be
     /// queried for each element of the model.
@@ -63,7 +85,7 @@ public:
     enum Roles {
         NamesRole = Qt::UserRole + 1, ///< \brief Peer's names.
         IconSetRole,  ///< \brief Whether the peer's icon is set or not.
-        IconPathRole, ///< \brief Peer's icon path.
+        IconUrlRole,  ///< \brief Peer's icon URL (see UserIconProvider).
 
         SenderRole,     ///< \brief Whether the files are sent or received.
         StatusRole,     ///< \brief The current status of the transfer.
@@ -88,11 +110,20 @@ public:
     /// \brief Initializes a new instance of the model.
     /// \param localUser the object representing the local user.
     /// \param peersList the object representing the list of peers.
+    /// \param historyPath the path of the file where the history of the
+    /// terminated transfers is saved (empty to disable the persistence).
     /// \param parent the parent of the current object.
     ///
     TransfersModel(LocalUser *localUser, PeersList *peersList,
+                   const QString &historyPath = QString(),
                    QObject *parent = Q_NULLPTR);
 
+    ///
+    /// \brief Saves the pending changes to the history and destroys the
+    /// instance.
+    ///
+    ~TransfersModel() override;
+
     ///
     /// \brief Returns the number of rows in the model.
     /// \param parent unused.
@@ -110,6 +141,15 @@ public:
     QVariant data(const QModelIndex &index,
                   int role = Qt::DisplayRole) const override;
 
+    /// \brief Returns whether the model is currently displayed or not.
+    bool active() const { return m_active; }
+
+    ///
+    /// \brief Sets whether the model is currently displayed or not.
+    /// \param active the new value.
+    ///
+    void setActive(bool active);
+
     ///
     /// \brief Adds a new SYFFT protocol instance to the model.
     /// \param instance the instance to be added.
@@ -154,6 +194,13 @@ public slots:
     ///
     void deleteConnection(const int index);
 
+    ///
+    /// \brief Requests to show the list of files of the connection (limited
+    /// to the failed and skipped ones once the connection is terminated).
+    /// \param index the index of the element to be shown.
+    ///
+    void showFiles(const int index);
+
 signals:
     ///
     /// \brief Signal emitted when it is necessary to ask the user about the
@@ -174,12 +221,22 @@ signals:
     ///
     void duplicatedFileDetected(DuplicatedFileModel *request);
 
+    ///
+    /// \brief Signal emitted when the list of files of a connection is
+    /// requested to be shown.
+    /// \param files the object providing access to the list of files.
+    ///
+    void filesRequested(TransferFilesModel *files);
+
     ///
     /// \brief Signal emitted when the number of elements in the model
     /// changes.
     ///
     void rowCountChanged();
 
+    /// \brief Signal emitted when the active property changes.
+    void activeChanged();
+
 protected:
     ///
     /// \brief Adds a new SYFFT protocol instance to the model.
@@ -215,20 +272,123 @@ private slots:
     ///
     void duplicatedFile(QSharedPointer<SyfftProtocolDuplicatedFile> request);
 
+    ///
+    /// \brief Updates the cached information of an instance after a change of
+    /// its status and notifies the views.
+    /// \param instance the instance whose status has changed.
+    /// \param status the new status.
+    ///
+    void instanceStatusChanged(SyfftProtocolCommon *instance,
+                               SyfftProtocolCommon::Status status);
+
+    ///
+    /// \brief Notifies the views that the information about a peer changed.
+    /// \param uuid the identifier of the updated peer.
+    ///
+    void peerChanged(const QString &uuid);
+
+    ///
+    /// \brief Polls the transfer information of the instances in transfer
+    /// and notifies the views about the changes.
+    ///
+    void updateTransferInfo();
+
+    ///
+    /// \brief Saves the history of the terminated transfers.
+    ///
+    void saveHistory();
+
 private:
+    ///
+    /// \brief The Transfer struct stores a SYFFT protocol instance together
+    /// with the information cached for the model.
+    ///
+    struct Transfer {
+        /// \brief The SYFFT protocol instance (null once terminated).
+        QSharedPointer<SyfftProtocolCommon> instance;
+        /// \brief Whether the instance sends or receives the files.
+        bool sender;
+        /// \brief The cached status of the instance.
+        SyfftProtocolCommon::Status status;
+        /// \brief The cached identifier of the peer.
+        QString peerUuid;
+        /// \brief The names of the peer (set once terminated).
+        QString names;
+        /// \brief The cached transfer information.
+        TransferInfo info;
+        /// \brief The failed and skipped files (set once terminated).
+        QVector<FileInfo> files;
+    };
+
+    ///
+    /// \brief Returns the index of the row associated to an instance.
+    /// \param instance the instance to be looked for.
+    /// \return the index of the row or -1 if not found.
+    ///
+    int indexOf(const SyfftProtocolCommon *instance) const;
+
+    ///
+    /// \brief Fetches the transfer information of an instance and adds to the
+    /// list of roles the ones whose value changed.
+    /// \param index the index of the row to be refreshed.
+    /// \param roles the list of roles to be extended.
+    ///
+    void refreshTransferInfo(int index, QVector<int> &roles);
+
+    ///
+    /// \brief Emits the dataChanged() signal for a single row.
+    /// \param index the index of the changed row.
+    /// \param roles the list of changed roles (nothing done if empty).
+    ///
+    void notifyChanged(int index, const QVector<int> &roles);
+
+    ///
+    /// \brief Loads in background the icon of a peer referenced by the model,
+    /// in case it is not yet available.
+    /// \param uuid the identifier of the peer.
+    ///
+    void loadIcon(const QString &uuid);
+
+    ///
+    /// \brief Starts or stops the polling timer, depending on whether the
+    /// model is active and some instances are in transfer.
+    ///
+    void updateTimer();
+
+    ///
+    /// \brief Converts the row of a terminated instance to a history record,
+    /// freeing the instance, and removes the oldest records exceeding the cap.
+    /// \param index the index of the terminated row.
+    ///
+    void archive(int index);
+
+    ///
+    /// \brief Returns whether the status corresponds to a terminated
+    /// connection (closed or aborted).
+    ///
+    static bool terminated(SyfftProtocolCommon::Status status);
+
     /// \brief The instance storing data about the local user.
     QPointer<LocalUser> m_localUser;
     /// \brief The instance storing data about the peers.
     QPointer<PeersList> m_peersList;
 
     /// \brief The list of SYFFT protocol instances managed by the model.
-    QList<QSharedPointer<SyfftProtocolCommon>> m_instances;
+    QList<Transfer> m_transfers;
 
-    /// \brief The cached transfer informations.
-    QList<TransferInfo> m_transferInformations;
+    /// \brief Specifies whether the model is currently displayed.
+    bool m_active;
 
     /// \brief The timer used to update the transfer information.
-    QPointer<QTimer> m_timerUpdate;
+    QPointer<CoalescedTimer> m_timerUpdate;
+
+    /// \brief The object persisting the terminated transfers.
+    const TransferHistory m_history;
+    /// \brief The timer used to delay the saving of the history.
+    QPointer<QTimer> m_timerSave;
+
+    /// \brief The delay before the history is saved (in ms).
+    static const int SAVE_DELAY = 1000;
 
     /// \brief The interval between transfer information updates.
     static const int UPDATE_INTERVAL = 500;
@@ -0,0 +1,61 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "usericonprovider.hpp"
+#include "Common/logging.hpp"
+#include "UserDiscovery/usericon.hpp"
+#include "UserDiscovery/usericoncache.hpp"
+
+///
+/// The provider does not force asynchronous loading, since the images are
+/// usually already cached (they are inserted when loaded by UserIconLoader).
+///
+UserIconProvider::UserIconProvider(const QString &confPath)
+        : QQuickImageProvider(QQuickImageProvider::Image), m_confPath(confPath)
+{
+}
+
+///
+/// The identifier is parsed to obtain the hash of the icon, which is then used
+/// to get the image from the cache (reading and verifying it from the icon
+/// pack if not present). The image is scaled only in case
+/// a size different from the original one is requested.
+///
+QImage UserIconProvider::requestImage(const QString &id, QSize *size,
+                                      const QSize &requestedSize)
+{
+    QByteArray hash = UserIconCache::parseId(id);
+    if (hash.isEmpty()) {
+        LOG_WARNING() << "UserIconProvider: invalid identifier" << id;
+        return QImage();
+    }
+
+    QImage image =
+        UserIconCache::image(UserIcon::unverified(m_confPath, hash));
+    if (size) {
+        *size = image.size();
+    }
+
+    if (!image.isNull() && requestedSize.width() > 0 &&
+        requestedSize.height() > 0 && requestedSize != image.size()) {
+        return image.scaled(requestedSize, Qt::KeepAspectRatio,
+                            Qt::SmoothTransformation);
+    }
+    return image;
+}
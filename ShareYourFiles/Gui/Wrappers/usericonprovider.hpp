@@ -0,0 +1,60 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USERICONPROVIDER_HPP
+#define USERICONPROVIDER_HPP
+
+#include <QQuickImageProvider>
+
+///
+/// \brief The UserIconProvider class serves the icons of the peers to the QML
+/// views (through URLs in the form image://syficons/...).
+///
+/// The images are obtained from the UserIconCache, which is shared among all
+/// the engines: hence, each icon is decoded only once regardless of the number
+/// of views displaying it. The URLs are generated by UserIconCache::url() and
+/// contain the identifier of the user and the hash of the icon, which is
+/// checked again in case the image needs to be read from file.
+///
+class UserIconProvider : public QQuickImageProvider
+{
+public:
+    ///
+    /// \brief Builds a new instance of this class.
+    /// \param confPath the base path where configuration files are stored.
+    ///
+    explicit UserIconProvider(const QString &confPath);
+
+    ///
+    /// \brief Returns the image corresponding to the specified identifier.
+    /// \param id the identifier of the image (the URL without the scheme and
+    /// the provider name).
+    /// \param size the variable where the original size of the image is
+    /// stored.
+    /// \param requestedSize the size requested by the view (if valid).
+    /// \return the requested image, or a NULL one in case of error.
+    ///
+    QImage requestImage(const QString &id, QSize *size,
+                        const QSize &requestedSize) override;
+
+private:
+    QString m_confPath; ///< \brief The base path.
+};
+
+#endif // USERICONPROVIDER_HPP
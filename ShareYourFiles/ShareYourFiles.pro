@@ -15,7 +15,7 @@
 # You should have received a copy of the GNU General Public License
 # along with SYF.  If not, see <http://www.gnu.org/licenses/>.
 
-QT       += core gui network qml quickcontrols2
+QT       += core gui network qml quick quickcontrols2
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 TARGET = ShareYourFiles
@@ -56,20 +56,38 @@ DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs depr
 # Enable C++11 support
 CONFIG += C++11
 
+# Elide the debug and trace log messages at compile time in release builds
+# (the sources include Common/logging.hpp in place of Logger.h)
+CONFIG(release, debug|release): DEFINES += SYF_NO_DEBUG_LOG
+
 # Add some more warnings.
 QMAKE_CXXFLAGS += -Wall -Wextra -Wpedantic
 
 SOURCES += main.cpp \
     shareyourfiles.cpp \
+    Common/asynclogappender.cpp \
+    Common/coalescedtimer.cpp \
     Common/common.cpp \
+    Common/logging.cpp \
     Common/networkentrieslist.cpp \
+    Common/startupsequence.cpp \
     Common/threadpool.cpp \
+    Control/controlserver.cpp \
     UserDiscovery/syfddatagram.cpp \
+    UserDiscovery/syfddatagramview.cpp \
+    UserDiscovery/syfdaggregator.cpp \
     UserDiscovery/syfdprotocol.cpp \
+    UserDiscovery/syfdratelimiter.cpp \
+    UserDiscovery/receptionpolicy.cpp \
     UserDiscovery/user.cpp \
     UserDiscovery/users.cpp \
     UserDiscovery/usericon.cpp \
+    UserDiscovery/usericoncache.cpp \
+    UserDiscovery/usericonloader.cpp \
+    UserDiscovery/usericonpack.cpp \
+    UserDiscovery/userstore.cpp \
     UserDiscovery/syfitprotocol.cpp \
+    UserDiscovery/syfitscheduler.cpp \
     FileTransfer/syfpprotocol.cpp \
     FileTransfer/syfftprotocolserver.cpp \
     FileTransfer/syfftprotocolcommon.cpp \
@@ -77,28 +95,47 @@ SOURCES += main.cpp \
     FileTransfer/syfftprotocolsender.cpp \
     FileTransfer/fileinfo.cpp \
     FileTransfer/fileintransfer.cpp \
+    FileTransfer/transferhistory.cpp \
     FileTransfer/transferinfo.cpp \
     FileTransfer/transferlist.cpp \
+    FileTransfer/transferlistbuilder.cpp \
+    Gui/Wrappers/lazywindow.cpp \
     Gui/Wrappers/peersselectormodel.cpp \
     Gui/Wrappers/settingsmodel.cpp \
+    Gui/Wrappers/transferfilesmodel.cpp \
     Gui/Wrappers/transferrequestmodel.cpp \
     Gui/Wrappers/transfersmodel.cpp \
+    Gui/Wrappers/usericonprovider.cpp \
     Gui/Wrappers/transferresponsemodel.cpp \
     Gui/Wrappers/duplicatedfilemodel.cpp
 
 HEADERS  += \
     shareyourfiles.hpp \
+    Common/asynclogappender.hpp \
+    Common/coalescedtimer.hpp \
     Common/common.hpp \
+    Common/logging.hpp \
     Common/networkentrieslist.hpp \
+    Common/startupsequence.hpp \
     Common/threadpool.hpp \
+    Control/controlserver.hpp \
     UserDiscovery/syfddatagram.hpp \
+    UserDiscovery/syfddatagramview.hpp \
+    UserDiscovery/syfdaggregator.hpp \
     UserDiscovery/syfdprotocol.hpp \
+    UserDiscovery/syfdratelimiter.hpp \
     UserDiscovery/user.hpp \
     UserDiscovery/users.hpp \
     UserDiscovery/userinfo.hpp \
     UserDiscovery/usericon.hpp \
+    UserDiscovery/usericoncache.hpp \
+    UserDiscovery/usericonloader.hpp \
+    UserDiscovery/usericonpack.hpp \
+    UserDiscovery/userstore.hpp \
+    UserDiscovery/receptionpolicy.hpp \
     UserDiscovery/receptionpreferences.hpp \
     UserDiscovery/syfitprotocol.hpp \
+    UserDiscovery/syfitscheduler.hpp \
     FileTransfer/syfpprotocol.hpp \
     FileTransfer/syfftprotocolserver.hpp \
     FileTransfer/syfftprotocolcommon.hpp \
@@ -106,18 +143,33 @@ HEADERS  += \
     FileTransfer/syfftprotocolsender.hpp \
     FileTransfer/fileinfo.hpp \
     FileTransfer/fileintransfer.hpp \
+    FileTransfer/transferhistory.hpp \
     FileTransfer/transferinfo.hpp \
     FileTransfer/transferlist.hpp \
+    FileTransfer/transferlistbuilder.hpp \
+    Gui/Wrappers/lazywindow.hpp \
     Gui/Wrappers/peersselectormodel.hpp \
     Gui/Wrappers/settingsmodel.hpp \
+    Gui/Wrappers/transferfilesmodel.hpp \
     Gui/Wrappers/transferrequestmodel.hpp \
     Gui/Wrappers/transfersmodel.hpp \
+    Gui/Wrappers/usericonprovider.hpp \
     Gui/Wrappers/transferresponsemodel.hpp \
     Gui/Wrappers/duplicatedfilemodel.hpp
 
+# Batched reception of SYFD datagrams (Linux only)
+linux {
+    SOURCES += UserDiscovery/syfdbatchreceiver.cpp
+    HEADERS += UserDiscovery/syfdbatchreceiver.hpp
+}
+
 RESOURCES += \
     resources.qrc
 
+# Compile the QML files ahead of time (qmlcachegen, available since Qt 5.11;
+# ignored by older versions, which compile them at runtime)
+CONFIG += qtquickcompiler
+
 # Properties (Windows)
 RC_ICONS = ../icon.ico
 QMAKE_TARGET_PRODUCT = "Share Your Files"
@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "receptionpolicy.hpp"
+
+///
+/// In case the preferences given specify to use the defaults (i.e. they have
+/// not been set), the requests relying on them are asked to the user.
+///
+void ReceptionPolicy::setDefaults(const ReceptionPreferences &preferences)
+{
+    QWriteLocker lk(&m_lock);
+    m_defaults = preferences;
+}
+
+void ReceptionPolicy::setPeer(const QString &uuid, const QString &names,
+                              const ReceptionPreferences &preferences)
+{
+    QWriteLocker lk(&m_lock);
+    m_peers.insert(uuid, Entry{names, preferences});
+}
+
+void ReceptionPolicy::removePeer(const QString &uuid)
+{
+    QWriteLocker lk(&m_lock);
+    m_peers.remove(uuid);
+}
+
+///
+/// The preferences of the peer are looked up and, in case they specify to use
+/// the defaults, replaced by the global ones; the same rules followed by the
+/// request shown to the user are then applied to obtain the full data path.
+///
+ReceptionPreferences::Action ReceptionPolicy::decide(const QString &uuid,
+                                                     QString &path) const
+{
+    QReadLocker lk(&m_lock);
+
+    auto it = m_peers.constFind(uuid);
+    if (it == m_peers.constEnd()) {
+        return ReceptionPreferences::Action::Ask;
+    }
+
+    ReceptionPreferences preferences = it.value().preferences;
+    if (preferences.useDefaults()) {
+        preferences = m_defaults;
+    }
+    QString names = it.value().names;
+    lk.unlock();
+
+    if (preferences.useDefaults()) {
+        return ReceptionPreferences::Action::Ask;
+    }
+
+    if (preferences.action() == ReceptionPreferences::Action::Accept) {
+        path = preferences.fullPath(names);
+    }
+    return preferences.action();
+}
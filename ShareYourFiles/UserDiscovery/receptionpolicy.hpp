@@ -0,0 +1,102 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RECEPTIONPOLICY_HPP
+#define RECEPTIONPOLICY_HPP
+
+#include "receptionpreferences.hpp"
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QString>
+
+///
+/// \brief The ReceptionPolicy class provides a thread-safe snapshot of the
+/// reception preferences, used to decide how to handle the sharing requests.
+///
+/// The preferences are stored in the User instances, which live in the main
+/// thread, while the sharing requests are received by the SyfftProtocolReceiver
+/// instances running in the SYFFT receiver thread. To avoid a round trip to the
+/// main thread when the request can be accepted or rejected without asking the
+/// user, a copy of the global preferences and of the ones of the active peers
+/// is kept in this class: the LocalUser and the PeersList update it every time
+/// the preferences (or the names of a peer) change, while the receivers only
+/// query it through decide().
+///
+/// All the public members are thread-safe.
+///
+class ReceptionPolicy
+{
+public:
+    ///
+    /// \brief Constructs a new instance, where every request is to be asked.
+    ///
+    explicit ReceptionPolicy() {}
+
+    ///
+    /// \brief Sets the global preferences, used by the peers without specific
+    /// ones.
+    /// \param preferences the preferences of the local user.
+    ///
+    void setDefaults(const ReceptionPreferences &preferences);
+
+    ///
+    /// \brief Sets the preferences associated to an active peer.
+    /// \param uuid the identifier of the peer.
+    /// \param names the names of the peer (used to build the data path).
+    /// \param preferences the preferences associated to the peer.
+    ///
+    void setPeer(const QString &uuid, const QString &names,
+                 const ReceptionPreferences &preferences);
+
+    ///
+    /// \brief Removes the preferences associated to a peer (no longer active).
+    /// \param uuid the identifier of the peer.
+    ///
+    void removePeer(const QString &uuid);
+
+    ///
+    /// \brief Returns the action to be performed when a sharing request is
+    /// received.
+    /// \param uuid the identifier of the sender.
+    /// \param path the path where the files are stored, set in case of accept.
+    /// \return the action to be performed (Ask in case the peer is unknown).
+    ///
+    ReceptionPreferences::Action decide(const QString &uuid,
+                                        QString &path) const;
+
+private:
+    ///
+    /// \brief The Entry struct represents the information stored for a peer.
+    ///
+    struct Entry {
+        QString names;                    ///< \brief The names of the peer.
+        ReceptionPreferences preferences; ///< \brief The peer preferences.
+    };
+
+    /// \brief The lock protecting the data members.
+    mutable QReadWriteLock m_lock;
+
+    /// \brief The global preferences.
+    ReceptionPreferences m_defaults;
+    /// \brief The information about the active peers.
+    QHash<QString, Entry> m_peers;
+};
+
+#endif // RECEPTIONPOLICY_HPP
@@ -0,0 +1,166 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "syfdaggregator.hpp"
+#include "syfddatagramview.hpp"
+
+///
+/// The instance is created as not aggregator capable and with no digests
+/// received.
+///
+SyfdAggregator::SyfdAggregator() : m_capable(false) {}
+
+///
+/// The function sets the aggregator capability; in case it is disabled, all
+/// the information collected is discarded since no longer necessary.
+///
+void SyfdAggregator::setCapable(bool capable)
+{
+    m_capable = capable;
+    if (!capable) {
+        clear();
+    }
+}
+
+///
+/// The function discards the candidates, the collected entries and the
+/// information about the last digest received, for example when the local
+/// host goes offline.
+///
+void SyfdAggregator::clear()
+{
+    m_candidates.clear();
+    m_entries.clear();
+    m_digestTimer.invalidate();
+}
+
+///
+/// The local host is elected as aggregator in case it is aggregator capable and
+/// its UUID prefix is lower than the ones of all the other aggregator capable
+/// peers currently active (the capacity of the hosts is not considered, as
+/// explained in the class description).
+///
+bool SyfdAggregator::elected() const
+{
+    if (!m_capable || m_localPrefix.isEmpty()) {
+        return false;
+    }
+
+    for (auto it = m_candidates.constBegin(); it != m_candidates.constEnd();
+         ++it) {
+        if (SyfdDatagramView::prefixFromKey(it.key()) < m_localPrefix) {
+            return false;
+        }
+    }
+    return true;
+}
+
+///
+/// An aggregator is considered to be active in case the local host is not
+/// aggregator capable itself and a digest has been recently received.
+///
+bool SyfdAggregator::aggregated() const
+{
+    return !m_capable && m_digestTimer.isValid() &&
+           !m_digestTimer.hasExpired(SyfdAggregator::DIGEST_TIMEOUT);
+}
+
+///
+/// In case the local host is aggregator capable, the function records the
+/// profile sequence number advertised by the heartbeat and, if the aggregator
+/// flag is set, the sender as a candidate for the election. Heartbeats with
+/// the quit flag set cause the corresponding entries to be removed. The UUID
+/// prefixes are stored as numbers, so that no memory is allocated for the
+/// peers already known.
+///
+void SyfdAggregator::heartbeatReceived(quint64 prefixKey, quint32 sequence,
+                                       bool aggregator, bool quit)
+{
+    if (!m_capable) {
+        return;
+    }
+
+    // The user is quitting
+    if (quit) {
+        m_candidates.remove(prefixKey);
+        m_entries.remove(prefixKey);
+        return;
+    }
+
+    if (aggregator) {
+        m_candidates.insert(prefixKey, 0);
+    }
+
+    Entry entry;
+    entry.sequence = sequence;
+    entry.age = 0;
+    m_entries.insert(prefixKey, entry);
+}
+
+///
+/// Every time this function is executed (once per SYFD interval), the age of
+/// the candidates and of the collected entries is incremented: expired ones
+/// are removed.
+///
+void SyfdAggregator::incrementAge()
+{
+    auto candidate = m_candidates.begin();
+    while (candidate != m_candidates.end()) {
+        if (++candidate.value() > SyfdAggregator::MAX_AGE) {
+            candidate = m_candidates.erase(candidate);
+        } else {
+            ++candidate;
+        }
+    }
+
+    auto entry = m_entries.begin();
+    while (entry != m_entries.end()) {
+        if (++entry.value().age > SyfdAggregator::MAX_AGE) {
+            entry = m_entries.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+}
+
+///
+/// The collected entries are split in as many digests as necessary to fulfill
+/// the maximum number of entries allowed by the SyfdDatagram specifications.
+///
+QList<SyfdDatagram> SyfdAggregator::digests() const
+{
+    QList<SyfdDatagram> digests;
+    QVector<SyfdDatagram::DigestEntry> entries;
+    entries.reserve(SyfdDatagram::MAX_DIGEST_ENTRIES);
+
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        entries.append(qMakePair(SyfdDatagramView::prefixFromKey(it.key()),
+                                 it.value().sequence));
+
+        if (entries.size() == SyfdDatagram::MAX_DIGEST_ENTRIES) {
+            digests.append(SyfdDatagram::digest(entries));
+            entries.clear();
+        }
+    }
+
+    if (!entries.isEmpty()) {
+        digests.append(SyfdDatagram::digest(entries));
+    }
+    return digests;
+}
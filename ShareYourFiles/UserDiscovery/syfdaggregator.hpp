@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SYFDAGGREGATOR_HPP
+#define SYFDAGGREGATOR_HPP
+
+#include "syfddatagram.hpp"
+
+#include <QElapsedTimer>
+#include <QHash>
+
+///
+/// \brief The SyfdAggregator class keeps track of the state needed to support
+/// the hierarchical discovery performed by the SyfdProtocol.
+///
+/// With plain multicast, every host processes the heartbeats of all the other
+/// ones, which is quadratic in the number of users. To improve the scalability
+/// on large LANs, some hosts can be configured as aggregator capable: they
+/// advertise this capability through a flag in the heartbeats and the one with
+/// the lowest UUID is elected as aggregator. The elected aggregator collects
+/// the heartbeats of all the users and periodically publishes digests
+/// summarizing them; ordinary hosts, as long as digests are received, send
+/// their heartbeats only to the aggregator capable hosts and refresh the peers
+/// through the digests, requesting the full profiles only on demand.
+///
+/// The election deliberately ignores the capacity of the hosts: since the
+/// aggregator role is enabled explicitly (through the configuration), the
+/// capacity is taken into account by choosing which hosts are capable, while
+/// the heartbeats carry only the aggregator flag. Electing on the UUID prefix
+/// alone lets every host reach the same result without any negotiation; a
+/// capacity based election would require extending the heartbeat format.
+///
+/// This class is not thread-safe and it is meant to be used only by the
+/// SyfdProtocol instance owning it.
+///
+class SyfdAggregator
+{
+public:
+    ///
+    /// \brief Constructs a new instance of the class.
+    ///
+    explicit SyfdAggregator();
+
+    ///
+    /// \brief Sets whether the local host is aggregator capable or not.
+    /// \param capable the value to be set.
+    ///
+    void setCapable(bool capable);
+
+    ///
+    /// \brief Discards all the information collected.
+    ///
+    void clear();
+
+    ///
+    /// \brief Returns whether the local host is aggregator capable or not.
+    ///
+    bool capable() const { return m_capable; }
+
+    ///
+    /// \brief Sets the UUID prefix identifying the local user.
+    /// \param prefix the prefix to be set.
+    ///
+    void setLocalPrefix(const QByteArray &prefix) { m_localPrefix = prefix; }
+
+    ///
+    /// \brief Returns whether the local host is the elected aggregator.
+    ///
+    bool elected() const;
+
+    ///
+    /// \brief Returns whether an aggregator is currently active in the network.
+    ///
+    /// In this case, the local host (if not aggregator capable) can send its
+    /// heartbeats only to the aggregators.
+    ///
+    bool aggregated() const;
+
+    ///
+    /// \brief Processes a heartbeat received from the network.
+    /// \param prefixKey the UUID prefix of the sender (converted to a number).
+    /// \param sequence the profile sequence number advertised.
+    /// \param aggregator whether the aggregator flag is set.
+    /// \param quit whether the quit flag is set.
+    ///
+    void heartbeatReceived(quint64 prefixKey, quint32 sequence, bool aggregator,
+                           bool quit);
+
+    ///
+    /// \brief Processes a digest received from the network.
+    ///
+    void digestReceived() { m_digestTimer.start(); }
+
+    ///
+    /// \brief Increments the age of the entries collected.
+    ///
+    void incrementAge();
+
+    ///
+    /// \brief Builds the digests summarizing the heartbeats collected.
+    /// \return the list of digests to be published.
+    ///
+    QList<SyfdDatagram> digests() const;
+
+private:
+    ///
+    /// \brief The Entry struct represents a user whose heartbeat has been
+    /// collected.
+    ///
+    struct Entry {
+        quint32 sequence; ///< \brief The profile sequence number.
+        quint8 age;       ///< \brief The age of the entry.
+    };
+
+    /// \brief Maximum age of the collected entries (intervals).
+    static const quint8 MAX_AGE = 4;
+    /// \brief Maximum time elapsed since the last digest received (ms).
+    static const int DIGEST_TIMEOUT = 10000;
+
+    /// \brief Specifies whether the local host is aggregator capable or not.
+    bool m_capable;
+    /// \brief The UUID prefix identifying the local user.
+    QByteArray m_localPrefix;
+
+    /// \brief The aggregator capable peers and the age of their heartbeats.
+    QHash<quint64, quint8> m_candidates;
+    /// \brief The users whose heartbeats have been collected.
+    QHash<quint64, Entry> m_entries;
+
+    /// \brief Timer measuring the time elapsed since the last digest received.
+    QElapsedTimer m_digestTimer;
+};
+
+#endif // SYFDAGGREGATOR_HPP
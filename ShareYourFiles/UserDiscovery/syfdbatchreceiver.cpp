@@ -0,0 +1,201 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "syfdbatchreceiver.hpp"
+
+#include <QHostAddress>
+#include <QNetworkInterface>
+#include <QSocketNotifier>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+///
+/// The instance is created by allocating the ring of buffers and preparing
+/// the headers used by recvmmsg(), which point to the corresponding buffers
+/// and sender addresses and are therefore reused for every batch.
+///
+SyfdBatchReceiver::SyfdBatchReceiver(int slotSize, QObject *parent)
+        : QObject(parent),
+          m_socket(-1),
+          m_localPort(0),
+          m_slotSize(slotSize),
+          m_buffer(BATCH_SIZE * slotSize, Qt::Uninitialized),
+          m_headers(BATCH_SIZE),
+          m_iovecs(BATCH_SIZE),
+          m_addresses(BATCH_SIZE),
+          m_datagrams(BATCH_SIZE)
+{
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        m_iovecs[i].iov_base = m_buffer.data() + i * m_slotSize;
+        m_iovecs[i].iov_len = static_cast<size_t>(m_slotSize);
+
+        std::memset(&m_headers[i], 0, sizeof(mmsghdr));
+        m_headers[i].msg_hdr.msg_iov = &m_iovecs[i];
+        m_headers[i].msg_hdr.msg_iovlen = 1;
+        m_headers[i].msg_hdr.msg_name = &m_addresses[i];
+
+        m_datagrams[i].data = m_buffer.constData() + i * m_slotSize;
+    }
+}
+
+///
+/// The notifier is destroyed before closing the socket it refers to.
+///
+SyfdBatchReceiver::~SyfdBatchReceiver()
+{
+    delete m_notifier.data();
+    if (m_socket >= 0) {
+        ::close(m_socket);
+    }
+}
+
+///
+/// The socket is created in non blocking mode and bound to all the IPv4
+/// addresses and to the given port, allowing other sockets to share the same
+/// port (as done by QUdpSocket::ShareAddress). A notifier is finally created
+/// to emit the readyRead() signal when datagrams are pending.
+///
+bool SyfdBatchReceiver::bind(quint16 port)
+{
+    m_socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_socket < 0) {
+        m_errorString = qt_error_string(errno);
+        return false;
+    }
+
+    int reuse = 1;
+    if (::setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse,
+                     sizeof(reuse)) < 0) {
+        m_errorString = qt_error_string(errno);
+        return false;
+    }
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (::bind(m_socket, reinterpret_cast<sockaddr *>(&address),
+               sizeof(address)) < 0) {
+        m_errorString = qt_error_string(errno);
+        return false;
+    }
+    m_localPort = port;
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this,
+            &SyfdBatchReceiver::readyRead);
+    return true;
+}
+
+///
+/// \see setMembership()
+///
+bool SyfdBatchReceiver::joinMulticastGroup(const QHostAddress &group,
+                                           const QNetworkInterface &iface)
+{
+    return setMembership(IP_ADD_MEMBERSHIP, group, iface);
+}
+
+///
+/// \see setMembership()
+///
+bool SyfdBatchReceiver::leaveMulticastGroup(const QHostAddress &group,
+                                            const QNetworkInterface &iface)
+{
+    return setMembership(IP_DROP_MEMBERSHIP, group, iface);
+}
+
+///
+/// The membership is changed through the corresponding socket option, using
+/// the index of the interface to select it.
+///
+bool SyfdBatchReceiver::setMembership(int option, const QHostAddress &group,
+                                      const QNetworkInterface &iface)
+{
+    if (m_socket < 0) {
+        m_errorString = tr("Socket not bound");
+        return false;
+    }
+
+    ip_mreqn request;
+    std::memset(&request, 0, sizeof(request));
+    request.imr_multiaddr.s_addr = htonl(group.toIPv4Address());
+    request.imr_address.s_addr = htonl(INADDR_ANY);
+    request.imr_ifindex = iface.index();
+
+    if (::setsockopt(m_socket, IPPROTO_IP, option, &request, sizeof(request)) <
+        0) {
+        m_errorString = qt_error_string(errno);
+        return false;
+    }
+    return true;
+}
+
+///
+/// The function receives through a single recvmmsg() system call all the
+/// pending datagrams (at most BATCH_SIZE), storing them into the ring of
+/// buffers, and fills the corresponding descriptors. In case no datagrams are
+/// pending, zero is returned, while in case of errors the error() signal is
+/// also emitted.
+///
+int SyfdBatchReceiver::receive()
+{
+    if (m_socket < 0) {
+        return 0;
+    }
+
+    // Reset the fields modified by the previous execution
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        m_headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        m_headers[i].msg_hdr.msg_flags = 0;
+    }
+
+    int count = ::recvmmsg(m_socket, m_headers.data(), BATCH_SIZE,
+                           MSG_DONTWAIT, Q_NULLPTR);
+    if (count < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            m_errorString = qt_error_string(errno);
+            emit error();
+        }
+        return 0;
+    }
+
+    // Fill the descriptors of the datagrams received
+    for (int i = 0; i < count; i++) {
+        Datagram &datagram = m_datagrams[i];
+        datagram.size = static_cast<int>(m_headers[i].msg_len);
+        datagram.truncated = m_headers[i].msg_hdr.msg_flags & MSG_TRUNC;
+        datagram.senderAddress = ntohl(m_addresses[i].sin_addr.s_addr);
+        datagram.senderPort = ntohs(m_addresses[i].sin_port);
+    }
+    return count;
+}
+
+///
+/// The function receives and drops all the pending datagrams.
+///
+void SyfdBatchReceiver::discardPending()
+{
+    while (receive() == BATCH_SIZE) {
+    }
+}
@@ -0,0 +1,168 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SYFDBATCHRECEIVER_HPP
+#define SYFDBATCHRECEIVER_HPP
+
+#include <QByteArray>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+class QHostAddress;
+class QNetworkInterface;
+class QSocketNotifier;
+
+///
+/// \brief The SyfdBatchReceiver class provides a UDP socket able to receive
+/// multiple datagrams through a single system call (Linux only).
+///
+/// QUdpSocket requires a few system calls and some memory allocations for
+/// each datagram received, which may cause the SYFD thread to fall behind in
+/// case of bursts (e.g. at startup or after solicitations). This class, on
+/// the other hand, exploits the recvmmsg() system call to receive up to
+/// BATCH_SIZE datagrams at a time into a ring of buffers allocated once.
+///
+/// The received datagrams are exposed through lightweight descriptors pointing
+/// to the ring of buffers: they are valid only until the following execution
+/// of receive().
+///
+class SyfdBatchReceiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief The Datagram struct describes a datagram received.
+    ///
+    struct Datagram {
+        const char *data;      ///< \brief Pointer to the datagram payload.
+        int size;              ///< \brief Size of the datagram payload.
+        bool truncated;        ///< \brief The datagram exceeded the slot size.
+        quint32 senderAddress; ///< \brief IPv4 address of the sender.
+        quint16 senderPort;    ///< \brief UDP port of the sender.
+    };
+
+    /// \brief Maximum number of datagrams received at a time.
+    static const int BATCH_SIZE = 32;
+
+    ///
+    /// \brief Constructs a new unbound instance.
+    /// \param slotSize the size of each buffer of the ring (larger datagrams
+    /// are truncated).
+    /// \param parent the parent of the current object.
+    ///
+    explicit SyfdBatchReceiver(int slotSize, QObject *parent = Q_NULLPTR);
+
+    ///
+    /// \brief Closes the socket and releases the resources.
+    ///
+    ~SyfdBatchReceiver();
+
+    ///
+    /// \brief Binds the socket to all the IPv4 addresses and the given port.
+    /// \param port the UDP port to be used.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool bind(quint16 port);
+
+    ///
+    /// \brief Joins a multicast group on the specified interface.
+    /// \param group the multicast address to be joined.
+    /// \param iface the interface to be used.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool joinMulticastGroup(const QHostAddress &group,
+                            const QNetworkInterface &iface);
+
+    ///
+    /// \brief Leaves a multicast group on the specified interface.
+    /// \param group the multicast address to be left.
+    /// \param iface the interface to be used.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool leaveMulticastGroup(const QHostAddress &group,
+                             const QNetworkInterface &iface);
+
+    ///
+    /// \brief Receives the pending datagrams (at most BATCH_SIZE).
+    /// \return the number of datagrams received.
+    ///
+    int receive();
+
+    ///
+    /// \brief Discards all the pending datagrams.
+    ///
+    void discardPending();
+
+    ///
+    /// \brief Returns the descriptor of a datagram received.
+    /// \param index the index of the datagram (less than the value returned by
+    /// the last execution of receive()).
+    ///
+    const Datagram &datagram(int index) const { return m_datagrams[index]; }
+
+    /// \brief Returns the UDP port the socket is bound to.
+    quint16 localPort() const { return m_localPort; }
+
+    /// \brief Returns a description of the last error occurred.
+    QString errorString() const { return m_errorString; }
+
+signals:
+    ///
+    /// \brief Signal emitted when some datagrams are ready to be received.
+    ///
+    void readyRead();
+
+    ///
+    /// \brief Signal emitted when an error occurs while receiving datagrams.
+    ///
+    void error();
+
+private:
+    ///
+    /// \brief Adds or drops the membership to a multicast group.
+    /// \param option either IP_ADD_MEMBERSHIP or IP_DROP_MEMBERSHIP.
+    /// \param group the multicast address.
+    /// \param iface the interface to be used.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool setMembership(int option, const QHostAddress &group,
+                       const QNetworkInterface &iface);
+
+    int m_socket;          ///< \brief The native socket descriptor.
+    quint16 m_localPort;   ///< \brief The UDP port the socket is bound to.
+    QString m_errorString; ///< \brief The description of the last error.
+
+    /// \brief The notifier used to detect pending datagrams.
+    QPointer<QSocketNotifier> m_notifier;
+
+    int m_slotSize;      ///< \brief The size of each buffer of the ring.
+    QByteArray m_buffer; ///< \brief The memory area containing the ring.
+
+    QVector<mmsghdr> m_headers;        ///< \brief The recvmmsg() headers.
+    QVector<iovec> m_iovecs;           ///< \brief The buffers descriptors.
+    QVector<sockaddr_in> m_addresses;  ///< \brief The senders addresses.
+    QVector<Datagram> m_datagrams;     ///< \brief The datagrams received.
+};
+
+#endif // SYFDBATCHRECEIVER_HPP
@@ -18,19 +18,19 @@
 
 #include "syfddatagram.hpp"
 #include "Common/common.hpp"
+#include "Common/logging.hpp"
+#include "syfddatagramview.hpp"
 #include "user.hpp"
 
-#include <Logger.h>
-
 #include <QDataStream>
 
 // Static variables definition
 const int SyfdDatagram::UUID_LEN = Constants::UUID_LEN;
 const int SyfdDatagram::MIN_DATAGRAM_SIZE =
-    MAGIC_LEN * sizeof(quint8) + sizeof(quint8) + sizeof(quint8) + UUID_LEN +
-    2 * sizeof(quint32) + sizeof(quint32) + sizeof(quint16) + sizeof(quint16);
+    MAGIC_LEN * sizeof(quint8) + 4 * sizeof(quint8);
 const int SyfdDatagram::MAX_DATAGRAM_SIZE =
-    MIN_DATAGRAM_SIZE + 2 * STRING_LEN * sizeof(quint16) + HASH_LEN;
+    MAGIC_LEN * sizeof(quint8) + 4 * sizeof(quint8) + sizeof(quint16) +
+    MAX_DIGEST_ENTRIES * (PREFIX_LEN + sizeof(quint32));
 
 ///
 /// The datagram is constructed by making a deep copy of the requested fields
@@ -45,7 +45,7 @@ const int SyfdDatagram::MAX_DATAGRAM_SIZE =
 /// \see SyfdDatagram::valid()
 ///
 SyfdDatagram::SyfdDatagram(const UserInfo &userInfo)
-        : m_valid(false), m_flags(0)
+        : m_valid(false), m_flags(0), m_type(Type::Profile), m_sequence(0)
 {
     // UUID
     QUuid tmpUuid(userInfo.uuid());
@@ -106,32 +106,74 @@ SyfdDatagram::SyfdDatagram(const UserInfo &userInfo)
 /// to fill the different fields. The byte array must fulfill the
 /// SyfdDatagram format.
 ///
-/// Since the byte array is received from the network, it is necessary to
-/// manage problems related to different architectures and operating
-/// systems that possibly are used by different people (e.g. byte ordering):
-/// for this reason, a data stream is created to automatically provide
-/// conversions (obviously the same is applied when byte arrays are generated
-/// for output) and then data is read through the operator>>(). In case the
-/// byte array cannot be converted correctly, an invalid datagram is
-/// generated and the error is appended to the log.
+/// The byte array is validated and decoded through a SyfdDatagramView,
+/// which takes care of the conversions needed to manage the different
+/// architectures possibly used by the peers (e.g. byte ordering), and then
+/// all the fields are copied to the current instance. In case the byte array
+/// cannot be converted correctly, an invalid datagram is generated and the
+/// error is appended to the log.
 ///
 /// \see SyfdDatagram::valid()
 /// \see SyfdDatagram::toByteArray()
 ///
 SyfdDatagram::SyfdDatagram(const QByteArray &data)
+        : m_valid(false), m_flags(0), m_type(Type::Profile), m_sequence(0)
 {
-    // Build the stream to provide uniformity
-    QDataStream stream(data);
-    stream.setVersion(QDataStream::Version::Qt_5_0);
-    stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
-
-    // Build the datagram
-    stream >> *this;
-
-    if (!m_valid) {
+    SyfdDatagramView view;
+    if (!view.decode(data.constData(), data.size())) {
         LOG_WARNING() << "SyfdDatagram: invalid datagram created from the"
                          " byte array";
+        return;
     }
+
+    *this = SyfdDatagram(view);
+}
+
+///
+/// The datagram is constructed by copying all the fields meaningful for the
+/// type of the view given as parameter (in particular, the names are converted
+/// to strings only in case of profile). An invalid datagram is generated if
+/// the view is not valid.
+///
+SyfdDatagram::SyfdDatagram(const SyfdDatagramView &view)
+        : m_valid(false), m_flags(0), m_type(Type::Profile), m_sequence(0)
+{
+    if (!view.valid()) {
+        return;
+    }
+
+    m_flags = view.flags();
+    m_type = view.type();
+    m_sequence = view.sequence();
+
+    switch (m_type) {
+    case Type::Profile:
+        m_uuid = view.uuid();
+        m_firstName = view.firstName();
+        m_lastName = view.lastName();
+        m_ipv4Addr = view.ipv4Addr();
+        m_dataPort = view.dataPort();
+        m_iconPort = view.iconPort();
+        m_iconHash = view.iconHash();
+        break;
+
+    case Type::Heartbeat:
+    case Type::ProfileRequest:
+        m_uuid = view.uuidPrefix();
+        break;
+
+    case Type::Solicit:
+        break;
+
+    case Type::Digest:
+        m_entries.reserve(view.digestEntriesCount());
+        for (int i = 0; i < view.digestEntriesCount(); i++) {
+            m_entries.append(view.digestEntry(i));
+        }
+        break;
+    }
+
+    m_valid = true;
 }
 
 ///
@@ -160,10 +202,152 @@ QByteArray SyfdDatagram::toByteArray() const
     return byteArray;
 }
 
+///
+/// The profile is written according to the version 1.0 of the SyfdDatagram
+/// format specifications, i.e. the header is not followed by the type and
+/// reserved fields and the profile lacks the sequence number. This allows the
+/// hosts not yet upgraded to keep detecting the local user.
+///
+/// \see SyfdDatagram::toByteArray()
+///
+QByteArray SyfdDatagram::toLegacyByteArray() const
+{
+    if (!m_valid || m_type != Type::Profile || flagInvalid() ||
+        flagAggregator()) {
+        LOG_ERROR() << "SyfdDatagram: trying to output an invalid datagram";
+        return QByteArray();
+    }
+
+    QByteArray byteArray;
+    QDataStream stream(&byteArray, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Version::Qt_5_0);
+    stream.setByteOrder(QDataStream::ByteOrder::LittleEndian);
+
+    // Magic numbers
+    stream << SyfdDatagram::MAGIC_0;
+    stream << SyfdDatagram::MAGIC_1;
+    stream << SyfdDatagram::MAGIC_2;
+    stream << SyfdDatagram::MAGIC_3;
+
+    // Version and flags (no type and reserved fields)
+    stream << static_cast<quint8>(SyfdDatagram::Version::V1_0);
+    stream << m_flags;
+
+    // Profile without the sequence number
+    if (!writeProfile(stream, false) ||
+        stream.status() != QDataStream::Status::Ok) {
+        LOG_WARNING() << "SyfdDatagram: error occurred while writing the"
+                         " datagram";
+        return QByteArray();
+    }
+
+    return byteArray;
+}
+
+///
+/// The heartbeat is generated by copying the UUID prefix and the profile
+/// sequence number from the current profile datagram; the quit flag is
+/// preserved while the other ones, meaningful only for profiles, are cleared.
+/// The aggregator flag is finally set if requested.
+///
+SyfdDatagram SyfdDatagram::heartbeat(bool aggregator) const
+{
+    SyfdDatagram datagram;
+    if (!m_valid || m_type != Type::Profile) {
+        LOG_WARNING() << "SyfdDatagram: trying to create a heartbeat from an "
+                         "invalid profile";
+        return datagram;
+    }
+
+    datagram.m_type = Type::Heartbeat;
+    datagram.m_flags = m_flags & SyfdDatagram::Flags::FlagQuit;
+    if (aggregator) {
+        datagram.m_flags |= SyfdDatagram::Flags::FlagAggregator;
+    }
+    datagram.m_uuid = uuidPrefix();
+    datagram.m_sequence = m_sequence;
+    datagram.m_valid = true;
+    return datagram;
+}
+
+///
+/// The request is generated by storing the UUID prefix given as parameter,
+/// which identifies the user whose profile is requested. In case the prefix
+/// has not the expected length, an invalid datagram is returned.
+///
+SyfdDatagram SyfdDatagram::profileRequest(const QByteArray &uuidPrefix)
+{
+    SyfdDatagram datagram;
+    if (uuidPrefix.length() != SyfdDatagram::PREFIX_LEN) {
+        LOG_WARNING() << "SyfdDatagram: trying to create a profile request "
+                         "with an invalid UUID prefix";
+        return datagram;
+    }
+
+    datagram.m_type = Type::ProfileRequest;
+    datagram.m_uuid = uuidPrefix;
+    datagram.m_valid = true;
+    return datagram;
+}
+
+///
+/// The solicitation is composed only by the header, since it is addressed to
+/// all the peers and the identity of the sender is not relevant.
+///
+SyfdDatagram SyfdDatagram::solicitation()
+{
+    SyfdDatagram datagram;
+    datagram.m_type = Type::Solicit;
+    datagram.m_valid = true;
+    return datagram;
+}
+
+///
+/// The digest is generated by copying the entries given as parameter, after
+/// having checked that they do not exceed the maximum number allowed and that
+/// the UUID prefixes have the expected length.
+///
+SyfdDatagram SyfdDatagram::digest(const QVector<DigestEntry> &entries)
+{
+    SyfdDatagram datagram;
+    if (entries.size() > SyfdDatagram::MAX_DIGEST_ENTRIES) {
+        LOG_WARNING() << "SyfdDatagram: trying to create a digest with too "
+                         "many entries";
+        return datagram;
+    }
+
+    foreach (const DigestEntry &entry, entries) {
+        if (entry.first.length() != SyfdDatagram::PREFIX_LEN) {
+            LOG_WARNING() << "SyfdDatagram: trying to create a digest with an "
+                             "invalid UUID prefix";
+            return datagram;
+        }
+    }
+
+    datagram.m_type = Type::Digest;
+    datagram.m_entries = entries;
+    datagram.m_valid = true;
+    return datagram;
+}
+
+///
+/// The UUID is converted to its standard binary representation (the same
+/// transmitted in profiles) and its first PREFIX_LEN bytes are returned.
+///
+QByteArray SyfdDatagram::prefixFromUuid(const QString &uuid)
+{
+    QUuid tmpUuid(uuid);
+    if (tmpUuid.isNull()) {
+        return QByteArray();
+    }
+    return tmpUuid.toRfc4122().left(SyfdDatagram::PREFIX_LEN);
+}
+
 ///
 /// The datagram is written to the stream according to the SyfdDatagram
-/// format specifications, by concatenating the initial header (magic string,
-/// version and flags) and all the other fields.
+/// format specifications (version 2.0), by concatenating the initial header
+/// (magic string, version, flags and type) and all the other fields, which
+/// depend on the type of the datagram.
 ///
 /// In case of invalid datagram given as parameter, nothing is done and an
 /// error is reported in the log. The same is done if the stream is initially
@@ -179,20 +363,12 @@ QDataStream &operator<<(QDataStream &stream, const SyfdDatagram &datagram)
         return stream;
     }
 
-    // Check if the fields related to the icon are consistent
-    bool iconOk =
-        (datagram.flagIcon())
-            ? (datagram.m_iconHash.length() == SyfdDatagram::HASH_LEN &&
-               datagram.iconPort() != 0)
-            : (datagram.iconPort() == 0);
-
-    // Check if the datagram is valid, otherwise abort
-    if (!datagram.valid() || datagram.flagInvalid() ||
-        datagram.m_uuid.length() != SyfdDatagram::UUID_LEN ||
-        datagram.m_firstName.length() > SyfdDatagram::STRING_LEN ||
-        datagram.m_lastName.length() > SyfdDatagram::STRING_LEN ||
-        datagram.m_ipv4Addr == 0 || datagram.m_dataPort == 0 || !iconOk) {
-
+    // Check if the common fields are valid, otherwise abort
+    bool prefixOk = (datagram.m_type == SyfdDatagram::Type::Profile) ||
+                    (datagram.m_type == SyfdDatagram::Type::Solicit) ||
+                    (datagram.m_type == SyfdDatagram::Type::Digest) ||
+                    datagram.m_uuid.length() == SyfdDatagram::PREFIX_LEN;
+    if (!datagram.valid() || datagram.flagInvalid() || !prefixOk) {
         LOG_ERROR() << "SyfdDatagram: trying to output an invalid datagram";
         return stream;
     }
@@ -203,37 +379,56 @@ QDataStream &operator<<(QDataStream &stream, const SyfdDatagram &datagram)
     stream << SyfdDatagram::MAGIC_2;
     stream << SyfdDatagram::MAGIC_3;
 
-    // Version and flags
-    stream << static_cast<quint8>(SyfdDatagram::Version::V1_0);
+    // Version, flags and type
+    stream << static_cast<quint8>(SyfdDatagram::Version::V2_0);
     stream << datagram.m_flags;
+    stream << static_cast<quint8>(datagram.m_type);
+    stream << static_cast<quint8>(0);
 
-    // UUID
-    int result = stream.writeRawData(datagram.m_uuid.constData(),
-                                     datagram.m_uuid.length());
-    if (result != datagram.m_uuid.length()) {
-        LOG_WARNING() << "SyfdDatagram: error occurred while writing the"
-                         " datagram (UUID)";
-        return stream;
-    }
-
-    // Names
-    stream << datagram.m_firstName;
-    stream << datagram.m_lastName;
-
-    // IP and ports
-    stream << datagram.m_ipv4Addr;
-    stream << datagram.m_dataPort;
-    stream << datagram.m_iconPort;
-
-    // Icon hash
-    if (datagram.flagIcon()) {
-        int result = stream.writeRawData(datagram.m_iconHash.constData(),
-                                         datagram.m_iconHash.length());
-        if (result != datagram.m_iconHash.length()) {
-            LOG_WARNING() << "SyfdDatagram: error occurred while writing the "
-                             "datagram (icon hash)";
+    switch (datagram.m_type) {
+    case SyfdDatagram::Type::Profile:
+        if (!datagram.writeProfile(stream, true)) {
+            return stream;
+        }
+        break;
+
+    case SyfdDatagram::Type::Heartbeat:
+    case SyfdDatagram::Type::ProfileRequest:
+        // UUID prefix
+        if (stream.writeRawData(datagram.m_uuid.constData(),
+                                SyfdDatagram::PREFIX_LEN) !=
+            SyfdDatagram::PREFIX_LEN) {
+            LOG_WARNING() << "SyfdDatagram: error occurred while writing the"
+                             " datagram (UUID prefix)";
             return stream;
         }
+
+        // Profile sequence
+        if (datagram.m_type == SyfdDatagram::Type::Heartbeat) {
+            stream << datagram.m_sequence;
+        }
+        break;
+
+    case SyfdDatagram::Type::Solicit:
+        // No further fields
+        break;
+
+    case SyfdDatagram::Type::Digest:
+        // Number of entries
+        stream << static_cast<quint16>(datagram.m_entries.size());
+
+        // UUID prefixes and profile sequences
+        foreach (const SyfdDatagram::DigestEntry &entry, datagram.m_entries) {
+            if (stream.writeRawData(entry.first.constData(),
+                                    SyfdDatagram::PREFIX_LEN) !=
+                SyfdDatagram::PREFIX_LEN) {
+                LOG_WARNING() << "SyfdDatagram: error occurred while writing "
+                                 "the datagram (digest)";
+                return stream;
+            }
+            stream << entry.second;
+        }
+        break;
     }
 
     // Check if the stream is still valid
@@ -249,8 +444,9 @@ QDataStream &operator<<(QDataStream &stream, const SyfdDatagram &datagram)
 ///
 /// The datagram is read from the stream according to the SyfdDatagram
 /// format specifications, by getting the initial header (magic string,
-/// version and flags) that is checked and then continuing with the other
-/// fields.
+/// version, flags and type) that is checked and then continuing with the
+/// other fields. Datagrams in the version 1.0 format are interpreted as
+/// profiles without the sequence number.
 ///
 /// In case of invalid data contained in the stream, an invalid datagram is
 /// generated and an error is reported in the log. The same is done if the
@@ -261,6 +457,8 @@ QDataStream &operator<<(QDataStream &stream, const SyfdDatagram &datagram)
 QDataStream &operator>>(QDataStream &stream, SyfdDatagram &datagram)
 {
     datagram.m_valid = false;
+    datagram.m_type = SyfdDatagram::Type::Profile;
+    datagram.m_sequence = 0;
 
     // Magic numbers
     stream >> datagram.m_magic[0];
@@ -272,76 +470,239 @@ QDataStream &operator>>(QDataStream &stream, SyfdDatagram &datagram)
     stream >> datagram.m_version;
     stream >> datagram.m_flags;
 
+    // Type and reserved field (not present in version 1.0)
+    quint8 type = static_cast<quint8>(SyfdDatagram::Type::Profile);
+    quint8 reserved = 0;
+    if (datagram.m_version == SyfdDatagram::Version::V2_0) {
+        stream >> type;
+        stream >> reserved;
+    }
+
     // Check if some error occurred in this first part
     if (stream.status() != QDataStream::Status::Ok ||
         datagram.m_magic[0] != SyfdDatagram::MAGIC_0 ||
         datagram.m_magic[1] != SyfdDatagram::MAGIC_1 ||
         datagram.m_magic[2] != SyfdDatagram::MAGIC_2 ||
         datagram.m_magic[3] != SyfdDatagram::MAGIC_3 ||
-        datagram.m_version != SyfdDatagram::Version::V1_0 ||
-        datagram.flagInvalid()) {
+        (datagram.m_version != SyfdDatagram::Version::V1_0 &&
+         datagram.m_version != SyfdDatagram::Version::V2_0) ||
+        type < static_cast<quint8>(SyfdDatagram::Type::Profile) ||
+        type > static_cast<quint8>(SyfdDatagram::Type::Digest) ||
+        reserved != 0 || datagram.flagInvalid()) {
 
         LOG_WARNING() << "SyfdDatagram: invalid format detected (header)";
         return stream;
     }
+    datagram.m_type = static_cast<SyfdDatagram::Type>(type);
+
+    switch (datagram.m_type) {
+    case SyfdDatagram::Type::Profile:
+        // The aggregator flag is meaningful only for heartbeats
+        if (datagram.flagAggregator()) {
+            LOG_WARNING() << "SyfdDatagram: invalid format detected (flags)";
+            return stream;
+        }
+
+        if (!datagram.readProfile(
+                stream, datagram.m_version == SyfdDatagram::Version::V2_0)) {
+            return stream;
+        }
+        break;
+
+    case SyfdDatagram::Type::Heartbeat:
+    case SyfdDatagram::Type::ProfileRequest:
+        // Only the quit and aggregator flags are meaningful for heartbeats
+        if (datagram.flagIcon() ||
+            (datagram.m_type == SyfdDatagram::Type::ProfileRequest &&
+             datagram.m_flags != 0)) {
+            LOG_WARNING() << "SyfdDatagram: invalid format detected (flags)";
+            return stream;
+        }
+
+        // UUID prefix
+        datagram.m_uuid.resize(SyfdDatagram::PREFIX_LEN);
+        if (stream.readRawData(datagram.m_uuid.data(),
+                               SyfdDatagram::PREFIX_LEN) !=
+            SyfdDatagram::PREFIX_LEN) {
+            LOG_WARNING()
+                << "SyfdDatagram: invalid format detected (UUID prefix)";
+            return stream;
+        }
+
+        // Profile sequence
+        if (datagram.m_type == SyfdDatagram::Type::Heartbeat) {
+            stream >> datagram.m_sequence;
+        }
+        break;
+
+    case SyfdDatagram::Type::Solicit:
+    case SyfdDatagram::Type::Digest:
+        // No flags are meaningful for solicitations and digests
+        if (datagram.m_flags != 0) {
+            LOG_WARNING() << "SyfdDatagram: invalid format detected (flags)";
+            return stream;
+        }
+
+        if (datagram.m_type == SyfdDatagram::Type::Digest) {
+            // Number of entries
+            quint16 count = 0;
+            stream >> count;
+            if (stream.status() != QDataStream::Status::Ok ||
+                count > SyfdDatagram::MAX_DIGEST_ENTRIES) {
+                LOG_WARNING()
+                    << "SyfdDatagram: invalid format detected (digest)";
+                return stream;
+            }
+
+            // UUID prefixes and profile sequences
+            datagram.m_entries.clear();
+            datagram.m_entries.reserve(count);
+            for (quint16 i = 0; i < count; i++) {
+                SyfdDatagram::DigestEntry entry;
+                entry.first.resize(SyfdDatagram::PREFIX_LEN);
+                if (stream.readRawData(entry.first.data(),
+                                       SyfdDatagram::PREFIX_LEN) !=
+                    SyfdDatagram::PREFIX_LEN) {
+                    LOG_WARNING()
+                        << "SyfdDatagram: invalid format detected (digest)";
+                    return stream;
+                }
+                stream >> entry.second;
+                datagram.m_entries.append(entry);
+            }
+        }
+        break;
+    }
+
+    // Check that all data read was correct
+    if (stream.status() != QDataStream::Status::Ok) {
+        LOG_WARNING() << "SyfdDatagram: invalid format detected";
+        return stream;
+    }
+
+    // Set the datagram as valid
+    datagram.m_valid = true;
+
+    // Return the stream to allow concatenations
+    return stream;
+}
+
+///
+/// The fields characterizing a profile (UUID, sequence number, names,
+/// addresses and icon hash) are written to the stream after having checked
+/// that they are consistent. The sequence number is omitted when generating
+/// the version 1.0 format.
+///
+bool SyfdDatagram::writeProfile(QDataStream &stream, bool sequence) const
+{
+    // Check if the fields related to the icon are consistent
+    bool iconOk = (flagIcon())
+                      ? (m_iconHash.length() == SyfdDatagram::HASH_LEN &&
+                         iconPort() != 0)
+                      : (iconPort() == 0);
+
+    // Check if the profile is valid, otherwise abort
+    if (m_uuid.length() != SyfdDatagram::UUID_LEN ||
+        m_firstName.length() > SyfdDatagram::STRING_LEN ||
+        m_lastName.length() > SyfdDatagram::STRING_LEN || m_ipv4Addr == 0 ||
+        m_dataPort == 0 || !iconOk) {
+
+        LOG_ERROR() << "SyfdDatagram: trying to output an invalid datagram";
+        return false;
+    }
 
     // UUID
-    datagram.m_uuid.resize(SyfdDatagram::UUID_LEN);
-    if (stream.readRawData(datagram.m_uuid.data(), SyfdDatagram::UUID_LEN) !=
+    int result = stream.writeRawData(m_uuid.constData(), m_uuid.length());
+    if (result != m_uuid.length()) {
+        LOG_WARNING() << "SyfdDatagram: error occurred while writing the"
+                         " datagram (UUID)";
+        return false;
+    }
+
+    // Profile sequence
+    if (sequence) {
+        stream << m_sequence;
+    }
+
+    // Names
+    stream << m_firstName;
+    stream << m_lastName;
+
+    // IP and ports
+    stream << m_ipv4Addr;
+    stream << m_dataPort;
+    stream << m_iconPort;
+
+    // Icon hash
+    if (flagIcon()) {
+        int result =
+            stream.writeRawData(m_iconHash.constData(), m_iconHash.length());
+        if (result != m_iconHash.length()) {
+            LOG_WARNING() << "SyfdDatagram: error occurred while writing the "
+                             "datagram (icon hash)";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+///
+/// The fields characterizing a profile (UUID, sequence number if present,
+/// names, addresses and icon hash) are read from the stream and checked.
+///
+bool SyfdDatagram::readProfile(QDataStream &stream, bool sequence)
+{
+    // UUID
+    m_uuid.resize(SyfdDatagram::UUID_LEN);
+    if (stream.readRawData(m_uuid.data(), SyfdDatagram::UUID_LEN) !=
             SyfdDatagram::UUID_LEN ||
-        QUuid::fromRfc4122(datagram.m_uuid).isNull()) {
+        QUuid::fromRfc4122(m_uuid).isNull()) {
 
         LOG_WARNING() << "SyfdDatagram: invalid format detected (UUID)";
-        return stream;
+        return false;
+    }
+
+    // Profile sequence
+    if (sequence) {
+        stream >> m_sequence;
     }
 
     // Names
-    stream >> datagram.m_firstName;
-    stream >> datagram.m_lastName;
+    stream >> m_firstName;
+    stream >> m_lastName;
     if (stream.status() != QDataStream::Status::Ok ||
-        datagram.m_firstName.length() > SyfdDatagram::STRING_LEN ||
-        datagram.m_lastName.length() > SyfdDatagram::STRING_LEN) {
+        m_firstName.length() > SyfdDatagram::STRING_LEN ||
+        m_lastName.length() > SyfdDatagram::STRING_LEN) {
 
         LOG_WARNING() << "SyfdDatagram: invalid format detected (names)";
-        return stream;
+        return false;
     }
 
     // IP and ports
-    stream >> datagram.m_ipv4Addr;
-    stream >> datagram.m_dataPort;
-    stream >> datagram.m_iconPort;
-    bool iconOk = (datagram.flagIcon()) ? (datagram.iconPort() != 0)
-                                        : (datagram.iconPort() == 0);
+    stream >> m_ipv4Addr;
+    stream >> m_dataPort;
+    stream >> m_iconPort;
+    bool iconOk = (flagIcon()) ? (iconPort() != 0) : (iconPort() == 0);
 
-    if (stream.status() != QDataStream::Status::Ok ||
-        datagram.m_ipv4Addr == 0 || datagram.m_dataPort == 0 || !iconOk) {
+    if (stream.status() != QDataStream::Status::Ok || m_ipv4Addr == 0 ||
+        m_dataPort == 0 || !iconOk) {
 
         LOG_WARNING() << "SyfdDatagram: invalid format detected (addresses)";
-        return stream;
+        return false;
     }
 
     // Icon hash
-    if (datagram.flagIcon()) {
-        datagram.m_iconHash.resize(SyfdDatagram::HASH_LEN);
-        if (stream.readRawData(datagram.m_iconHash.data(),
-                               SyfdDatagram::HASH_LEN) !=
+    if (flagIcon()) {
+        m_iconHash.resize(SyfdDatagram::HASH_LEN);
+        if (stream.readRawData(m_iconHash.data(), SyfdDatagram::HASH_LEN) !=
             SyfdDatagram::HASH_LEN) {
 
             LOG_WARNING()
                 << "SyfdDatagram: invalid format detected (icon hash)";
-            return stream;
+            return false;
         }
     }
 
-    // Check that all data read was correct
-    if (stream.status() != QDataStream::Status::Ok) {
-        LOG_WARNING() << "SyfdDatagram: invalid format detected";
-        return stream;
-    }
-
-    // Set the datagram as valid
-    datagram.m_valid = true;
-
-    // Return the stream to allow concatenations
-    return stream;
+    return true;
 }
@@ -19,9 +19,12 @@
 #ifndef SYFDDATAGRAM_HPP
 #define SYFDDATAGRAM_HPP
 
+#include <QPair>
 #include <QString>
 #include <QUuid>
+#include <QVector>
 
+class SyfdDatagramView;
 class UserInfo;
 
 ///
@@ -37,14 +40,32 @@ class UserInfo;
 /// LocalUser instance, it is possible to create a SyfdDatagram that will
 /// eventually be converted to an array of bytes and sent through the network.
 ///
+/// Three different types of datagram are defined: the profile, carrying all
+/// the information about a user and sent only when some of it changes (or when
+/// explicitly requested), the heartbeat, a tiny datagram periodically sent to
+/// advertise the presence of a user, and the profile request, used to ask a
+/// peer to send again its profile (e.g. when the one cached is outdated).
+/// The solicitation is used by a user who just joined the network to ask all
+/// the peers to advertise their profiles. Finally, the digest is periodically
+/// published by the elected aggregator (if any) and summarizes the heartbeats
+/// it received, so that ordinary peers do not need to process each of them.
+/// Heartbeats and profiles are linked by the profile sequence number, which is
+/// incremented by the sender every time its profile is modified.
+///
 /// The data transmitted over the network must fulfill the following format,
 /// where the numbers are in little endian order (4 bytes per row):
 /**
     \verbatim
+    Common header:
     |----------------|----------------|----------------|----------------|
     |       'S'      |       'Y'      |       'F'      |       'D'      |
     |----------------|----------------|----------------|----------------|
-    |     Version    |      Flags     |              UUID               |
+    |     Version    |      Flags     |      Type      |    Reserved    |
+    |----------------|----------------|----------------|----------------|
+
+    Profile (follows the header):
+    |----------------|----------------|----------------|----------------|
+    |                                UUID                               |
     |----------------|----------------|----------------|----------------|
     |                           UUID (continues)                        |
     |----------------|----------------|----------------|----------------|
@@ -52,13 +73,15 @@ class UserInfo;
     |----------------|----------------|----------------|----------------|
     |                           UUID (continues)                        |
     |----------------|----------------|----------------|----------------|
-    |         UUID (continues)        |           First name (1)        |
+    |                          Profile sequence                         |
+    |----------------|----------------|----------------|----------------|
+    |           First name (1)        |          Last name (2)          |
     |----------------|----------------|----------------|----------------|
-    |           Last name (2)         |              IPv4               |
+    |                                IPv4                               |
     |----------------|----------------|----------------|----------------|
-    |        IPv4 (continues)         |            Data port            |
+    |            Data port            |            Icon port            |
     |----------------|----------------|----------------|----------------|
-    |            Icon Port            |            Icon hash            |
+    |                             Icon hash                             |
     |----------------|----------------|----------------|----------------|
     |                        Icon hash (continues)                      |
     |----------------|----------------|----------------|----------------|
@@ -68,7 +91,34 @@ class UserInfo;
     |----------------|----------------|----------------|----------------|
     |                        Icon hash (continues)                      |
     |----------------|----------------|----------------|----------------|
-    |       Icon hash (continues)     | ------------------------------- |
+
+    Heartbeat (follows the header):
+    |----------------|----------------|----------------|----------------|
+    |                            UUID prefix                            |
+    |----------------|----------------|----------------|----------------|
+    |                       UUID prefix (continues)                     |
+    |----------------|----------------|----------------|----------------|
+    |                          Profile sequence                         |
+    |----------------|----------------|----------------|----------------|
+
+    Profile request (follows the header):
+    |----------------|----------------|----------------|----------------|
+    |                            UUID prefix                            |
+    |----------------|----------------|----------------|----------------|
+    |                       UUID prefix (continues)                     |
+    |----------------|----------------|----------------|----------------|
+
+    Solicitation: no further fields.
+
+    Digest (follows the header):
+    |----------------|----------------|----------------|----------------|
+    |        Number of entries        |         UUID prefix (1)         |
+    |----------------|----------------|----------------|----------------|
+    |                     UUID prefix (1) (continues)                   |
+    |----------------|----------------|----------------|----------------|
+    |   UUID prefix (1) (continues)   |      Profile sequence (1)       |
+    |----------------|----------------|----------------|----------------|
+    |  Profile sequence (1) (cont.)   |               ...               |
     |----------------|----------------|----------------|----------------|
 
     \endverbatim
@@ -76,7 +126,13 @@ class UserInfo;
 ///
 ///  * Version: represents the SyfdDatagram version;
 ///  * Flags: provides some information about the datagram;
+///  * Type: specifies the type of the datagram (profile, heartbeat, profile
+///          request, solicitation or digest);
+///  * Reserved: must be set to zero;
 ///  * UUID: a 128 bits number that uniquely identifies a user on the LAN;
+///  * UUID prefix: the first 64 bits of the UUID;
+///  * Profile sequence: 32 bits number incremented every time the profile of
+///                      the user changes;
 ///  * First name: a string of at most 16 characters represented as 4 bytes for
 ///                the length followed by the data in UTF-16;
 ///  * Last name: a string of at most 16 characters represented as 4 bytes for
@@ -88,18 +144,46 @@ class UserInfo;
 ///               listening for icon requests (0 in case no icon set);
 ///  * Icon hash: 160 bits SHA-1 hash of the file representing the user icon
 ///               (omitted if no icon set);
+///  * Number of entries: 16 bits number representing the number of pairs
+///                       (UUID prefix, profile sequence) following;
 ///
 /// N.B. (1) and (2) not in scale.
 ///
+/// Datagrams of version 1.0 (header without the type and reserved fields,
+/// followed by a profile without the sequence number) are still accepted in
+/// input and interpreted as profiles. Version 2.0 is generated by default,
+/// while toLegacyByteArray() provides the profile in the version 1.0 format,
+/// advertised as long as hosts not yet upgraded are detected on the network.
+///
 /// \see SyfdProtocol
 ///
 class SyfdDatagram
 {
 public:
+    ///
+    /// \brief The Type enum provides the valid values for the SyfdDatagram
+    /// type field.
+    ///
+    enum class Type : quint8 {
+        Profile = 0x1,        ///< \brief Full information about the user.
+        Heartbeat = 0x2,      ///< \brief Presence advertisement.
+        ProfileRequest = 0x3, ///< \brief Request for the profile of a user.
+        Solicit = 0x4, ///< \brief Request for the profiles of all the users.
+        Digest = 0x5   ///< \brief Summary of the heartbeats received.
+    };
+
+    ///
+    /// \brief An entry of a digest (UUID prefix and profile sequence number).
+    ///
+    typedef QPair<QByteArray, quint32> DigestEntry;
+
     ///
     /// \brief Constructs an invalid SyfdDatagram.
     ///
-    explicit SyfdDatagram() { m_valid = false; }
+    explicit SyfdDatagram()
+            : m_valid(false), m_flags(0), m_type(Type::Profile), m_sequence(0)
+    {
+    }
 
     ///
     /// \brief Constructs a SyfdDatagram given a UserInfo object.
@@ -114,6 +198,12 @@ public:
     ///
     explicit SyfdDatagram(const QByteArray &data);
 
+    ///
+    /// \brief Constructs a SyfdDatagram given a view of a decoded datagram.
+    /// \param view the view containing the data (all the fields are copied).
+    ///
+    explicit SyfdDatagram(const SyfdDatagramView &view);
+
     ///
     /// \brief Generates an instance which is an exact copy of the parameter.
     /// \param other the instance to be copied.
@@ -137,6 +227,50 @@ public:
     ///
     QByteArray toByteArray() const;
 
+    ///
+    /// \brief Converts the SyfdDatagram to a byte array in the version 1.0
+    /// format, understood by the hosts not yet upgraded.
+    /// \return the created byte array (empty in case the current datagram is
+    /// not a valid profile).
+    ///
+    QByteArray toLegacyByteArray() const;
+
+    ///
+    /// \brief Returns the heartbeat corresponding to the current profile.
+    /// \param aggregator specifies whether the aggregator flag is set.
+    /// \return the heartbeat datagram (invalid if the current datagram is not
+    /// a valid profile).
+    ///
+    SyfdDatagram heartbeat(bool aggregator = false) const;
+
+    ///
+    /// \brief Constructs a datagram requesting the profile of a user.
+    /// \param uuidPrefix the prefix of the UUID identifying the user.
+    /// \return the profile request datagram.
+    ///
+    static SyfdDatagram profileRequest(const QByteArray &uuidPrefix);
+
+    ///
+    /// \brief Constructs a datagram soliciting all peers to advertise their
+    /// profiles.
+    /// \return the solicitation datagram.
+    ///
+    static SyfdDatagram solicitation();
+
+    ///
+    /// \brief Constructs a digest datagram.
+    /// \param entries the entries to be advertised (at most MAX_DIGEST_ENTRIES).
+    /// \return the digest datagram.
+    ///
+    static SyfdDatagram digest(const QVector<DigestEntry> &entries);
+
+    ///
+    /// \brief Computes the UUID prefix used by heartbeats and requests.
+    /// \param uuid the string representation of the UUID.
+    /// \return the computed prefix (empty if the UUID is not valid).
+    ///
+    static QByteArray prefixFromUuid(const QString &uuid);
+
     ///
     /// \brief Returns whether the SyfdDatagram is valid or not.
     ///
@@ -153,14 +287,36 @@ public:
     bool flagQuit() const { return m_flags & Flags::FlagQuit; }
     /// \brief Returns whether the icon flag is set or not.
     bool flagIcon() const { return m_flags & Flags::FlagIcon; }
+    /// \brief Returns whether the aggregator flag is set or not.
+    bool flagAggregator() const { return m_flags & Flags::FlagAggregator; }
 
     /// \brief Sets the quit flag to true.
     void setFlagQuit() { m_flags |= SyfdDatagram::Flags::FlagQuit; }
     /// \brief Sets the quit flag to false.
     void clearFlagQuit() { m_flags &= ~SyfdDatagram::Flags::FlagQuit; }
 
+    /// \brief Returns the type of the SyfdDatagram.
+    Type type() const { return m_type; }
+
+    ///
+    /// \brief Returns the profile sequence number stored in the SyfdDatagram.
+    ///
+    /// This field is meaningful only for profiles and heartbeats; it is always
+    /// zero for profiles received in the version 1.0 format.
+    ///
+    quint32 sequence() const { return m_sequence; }
+    /// \brief Sets the profile sequence number.
+    void setSequence(quint32 sequence) { m_sequence = sequence; }
+
+    ///
     /// \brief Returns the UUID stored in the SyfdDatagram.
+    ///
+    /// Since heartbeats and profile requests only carry the UUID prefix, this
+    /// field is undefined in case the datagram is not a profile.
+    ///
     QString uuid() const { return QUuid::fromRfc4122(m_uuid).toString(); }
+    /// \brief Returns the UUID prefix stored in the SyfdDatagram.
+    QByteArray uuidPrefix() const { return m_uuid.left(PREFIX_LEN); }
     /// \brief Returns the first name stored in the SyfdDatagram.
     QString firstName() const { return m_firstName; }
     /// \brief Returns the last name stored in the SyfdDatagram.
@@ -183,14 +339,25 @@ public:
     ///
     const QByteArray &iconHash() const { return m_iconHash; }
 
+    ///
+    /// \brief Returns the entries stored in the datagram.
+    ///
+    /// This field is meaningful only for digests.
+    ///
+    const QVector<DigestEntry> &digestEntries() const { return m_entries; }
+
     /// \brief Number of bytes required by the magic string.
     static const int MAGIC_LEN = 4;
     /// \brief Number of bytes required to store a UUID.
     static const int UUID_LEN;
+    /// \brief Number of bytes of the UUID carried by heartbeats and requests.
+    static const int PREFIX_LEN = 8;
     /// \brief Maximum length of the strings (first and last name).
     static const int STRING_LEN = 16;
     /// \brief Number of bytes required to store a SHA-1 hash.
     static const int HASH_LEN = 20;
+    /// \brief Maximum number of entries contained in a digest.
+    static const int MAX_DIGEST_ENTRIES = 100;
 
     /// \brief Minimum number of bytes needed by a correct datagram.
     static const int MIN_DATAGRAM_SIZE;
@@ -198,6 +365,9 @@ public:
     static const int MAX_DATAGRAM_SIZE;
 
 private:
+    /// \brief The view shares the definition of the format.
+    friend class SyfdDatagramView;
+
     ///
     /// \brief Writes a SyfdDatagram to a QDataStream.
     /// \param stream the stream where data is written to.
@@ -214,6 +384,22 @@ private:
     ///
     friend QDataStream &operator>>(QDataStream &stream, SyfdDatagram &datagram);
 
+    ///
+    /// \brief Writes the fields specific to a profile to a QDataStream.
+    /// \param stream the stream where data is written to.
+    /// \param sequence specifies whether the sequence number is written.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool writeProfile(QDataStream &stream, bool sequence) const;
+
+    ///
+    /// \brief Reads the fields specific to a profile from a QDataStream.
+    /// \param stream the stream from where data is read.
+    /// \param sequence specifies whether the sequence number is present.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool readProfile(QDataStream &stream, bool sequence);
+
     static const quint8 MAGIC_0 =
         'S'; ///< \brief First character of the magic string
     static const quint8 MAGIC_1 =
@@ -226,7 +412,8 @@ private:
     /// \brief The Version enum provides the valid values for the SyfdDatagram
     /// version field.
     enum Version {
-        V1_0 = 1 ///< \brief Version 1.0.
+        V1_0 = 1, ///< \brief Version 1.0 (profiles only).
+        V2_0 = 2  ///< \brief Version 2.0.
     };
 
     ///
@@ -240,9 +427,11 @@ private:
     enum Flags {
         FlagQuit = 0x1, ///< \brief The user is about to quit (if set).
         FlagIcon = 0x2, ///< \brief The user has an associated icon (if set).
+        /// \brief The user can act as aggregator (if set).
+        FlagAggregator = 0x4,
 
         /// \brief The flags field contains invalid values.
-        FlagInvalid = ~(FlagQuit | FlagIcon)
+        FlagInvalid = ~(FlagQuit | FlagIcon | FlagAggregator)
     };
 
     /// \brief Specifies whether the SyfdDatagram is valid or not.
@@ -252,8 +441,10 @@ private:
     quint8 m_magic[MAGIC_LEN];
     quint8 m_version; ///< \brief Version of the SyfdDatagram.
     quint8 m_flags;   ///< \brief Flags field.
+    Type m_type;      ///< \brief Type field.
 
-    QByteArray m_uuid;   ///< \brief UUID field.
+    QByteArray m_uuid;   ///< \brief UUID (or UUID prefix) field.
+    quint32 m_sequence;  ///< \brief Profile sequence field.
     QString m_firstName; ///< \brief First name field.
     QString m_lastName;  ///< \brief Last name field.
 
@@ -262,6 +453,8 @@ private:
     quint16 m_iconPort; ///< \brief TCP port for icon requests field.
 
     QByteArray m_iconHash; ///< \brief Icon's SHA-1 hash field.
+
+    QVector<DigestEntry> m_entries; ///< \brief Digest entries field.
 };
 
 #endif // SYFDDATAGRAM_HPP
@@ -0,0 +1,388 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "syfddatagramview.hpp"
+#include "Common/logging.hpp"
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+///
+/// The datagram is validated according to the SyfdDatagram format, by checking
+/// the initial header (magic string, version, flags and type) and then the
+/// other fields, which depend on the type of the datagram; datagrams in the
+/// version 1.0 format are interpreted as profiles without the sequence number.
+/// The checks performed are the same of the ones executed by operator>>(), so
+/// that the two decoders accept exactly the same datagrams.
+///
+/// Differently from operator>>(), the numbers are directly converted from
+/// little endian and neither QDataStream nor temporary arrays are involved,
+/// hence no memory allocation is performed. In case of invalid data, the view
+/// is set as invalid and an error is reported in the log.
+///
+bool SyfdDatagramView::decode(const char *data, int size)
+{
+    *this = SyfdDatagramView();
+
+    const uchar *current = reinterpret_cast<const uchar *>(data);
+    const uchar *end = current + size;
+
+    // Magic string, version and flags
+    if (size < SyfdDatagram::MAGIC_LEN + 2 ||
+        current[0] != SyfdDatagram::MAGIC_0 ||
+        current[1] != SyfdDatagram::MAGIC_1 ||
+        current[2] != SyfdDatagram::MAGIC_2 ||
+        current[3] != SyfdDatagram::MAGIC_3) {
+        LOG_WARNING() << "SyfdDatagramView: invalid format detected (header)";
+        return false;
+    }
+    m_version = current[SyfdDatagram::MAGIC_LEN];
+    m_flags = current[SyfdDatagram::MAGIC_LEN + 1];
+    current += SyfdDatagram::MAGIC_LEN + 2;
+
+    // Type and reserved field (not present in version 1.0)
+    quint8 type = static_cast<quint8>(SyfdDatagram::Type::Profile);
+    quint8 reserved = 0;
+    if (m_version == SyfdDatagram::Version::V2_0) {
+        if (end - current < 2) {
+            LOG_WARNING()
+                << "SyfdDatagramView: invalid format detected (header)";
+            return false;
+        }
+        type = current[0];
+        reserved = current[1];
+        current += 2;
+    }
+
+    // Check the header
+    if ((m_version != SyfdDatagram::Version::V1_0 &&
+         m_version != SyfdDatagram::Version::V2_0) ||
+        type < static_cast<quint8>(SyfdDatagram::Type::Profile) ||
+        type > static_cast<quint8>(SyfdDatagram::Type::Digest) ||
+        reserved != 0 || (m_flags & SyfdDatagram::Flags::FlagInvalid)) {
+        LOG_WARNING() << "SyfdDatagramView: invalid format detected (header)";
+        return false;
+    }
+    m_type = static_cast<SyfdDatagram::Type>(type);
+
+    switch (m_type) {
+    case SyfdDatagram::Type::Profile:
+        // The aggregator flag is meaningful only for heartbeats
+        if (m_flags & SyfdDatagram::Flags::FlagAggregator) {
+            LOG_WARNING()
+                << "SyfdDatagramView: invalid format detected (flags)";
+            return false;
+        }
+
+        if (!decodeProfile(current, end,
+                           m_version == SyfdDatagram::Version::V2_0)) {
+            return false;
+        }
+        break;
+
+    case SyfdDatagram::Type::Heartbeat:
+    case SyfdDatagram::Type::ProfileRequest: {
+        // Only the quit and aggregator flags are meaningful for heartbeats
+        bool heartbeat = (m_type == SyfdDatagram::Type::Heartbeat);
+        if (flagIcon() || (!heartbeat && m_flags != 0)) {
+            LOG_WARNING()
+                << "SyfdDatagramView: invalid format detected (flags)";
+            return false;
+        }
+
+        // UUID prefix and profile sequence
+        int length = SyfdDatagram::PREFIX_LEN +
+                     ((heartbeat) ? static_cast<int>(sizeof(quint32)) : 0);
+        if (end - current < length) {
+            LOG_WARNING()
+                << "SyfdDatagramView: invalid format detected (UUID prefix)";
+            return false;
+        }
+
+        std::memcpy(m_uuid, current, SyfdDatagram::PREFIX_LEN);
+        if (heartbeat) {
+            m_sequence = qFromLittleEndian<quint32>(current +
+                                                    SyfdDatagram::PREFIX_LEN);
+        }
+        break;
+    }
+
+    case SyfdDatagram::Type::Solicit:
+    case SyfdDatagram::Type::Digest:
+        // No flags are meaningful for solicitations and digests
+        if (m_flags != 0) {
+            LOG_WARNING()
+                << "SyfdDatagramView: invalid format detected (flags)";
+            return false;
+        }
+
+        if (m_type == SyfdDatagram::Type::Digest) {
+            // Number of entries
+            if (end - current < static_cast<int>(sizeof(quint16))) {
+                LOG_WARNING()
+                    << "SyfdDatagramView: invalid format detected (digest)";
+                return false;
+            }
+            int count = qFromLittleEndian<quint16>(current);
+            current += sizeof(quint16);
+
+            // UUID prefixes and profile sequences
+            if (count > SyfdDatagram::MAX_DIGEST_ENTRIES ||
+                end - current < count * (SyfdDatagram::PREFIX_LEN +
+                                         static_cast<int>(sizeof(quint32)))) {
+                LOG_WARNING()
+                    << "SyfdDatagramView: invalid format detected (digest)";
+                return false;
+            }
+
+            m_entries = current;
+            m_entriesCount = count;
+        }
+        break;
+    }
+
+    // Set the view as valid
+    m_valid = true;
+    return m_valid;
+}
+
+///
+/// The heartbeat is generated by copying the UUID prefix and the profile
+/// sequence number from the current profile, while the only flag preserved is
+/// the quit one. An invalid view is returned if the current one is not a valid
+/// profile.
+///
+SyfdDatagramView SyfdDatagramView::heartbeat() const
+{
+    SyfdDatagramView view;
+    if (!m_valid || m_type != SyfdDatagram::Type::Profile) {
+        return view;
+    }
+
+    view.m_version = SyfdDatagram::Version::V2_0;
+    view.m_flags = m_flags & SyfdDatagram::Flags::FlagQuit;
+    view.m_type = SyfdDatagram::Type::Heartbeat;
+    std::memcpy(view.m_uuid, m_uuid, SyfdDatagram::PREFIX_LEN);
+    view.m_sequence = m_sequence;
+    view.m_valid = true;
+    return view;
+}
+
+///
+/// The prefix is interpreted as a little endian number, which allows to use
+/// it as a key without allocating a QByteArray.
+///
+quint64 SyfdDatagramView::prefixKey(const uchar *prefix)
+{
+    return qFromLittleEndian<quint64>(prefix);
+}
+
+///
+/// The number is written in little endian order, as read by prefixKey().
+///
+QByteArray SyfdDatagramView::prefixFromKey(quint64 key)
+{
+    QByteArray prefix(SyfdDatagram::PREFIX_LEN, '\0');
+    qToLittleEndian<quint64>(key, reinterpret_cast<uchar *>(prefix.data()));
+    return prefix;
+}
+
+///
+/// The UUID is copied to a newly allocated array of bytes.
+///
+QByteArray SyfdDatagramView::uuid() const
+{
+    return QByteArray(reinterpret_cast<const char *>(m_uuid),
+                      Constants::UUID_LEN);
+}
+
+///
+/// The UUID prefix is copied to a newly allocated array of bytes.
+///
+QByteArray SyfdDatagramView::uuidPrefix() const
+{
+    return QByteArray(reinterpret_cast<const char *>(m_uuid),
+                      SyfdDatagram::PREFIX_LEN);
+}
+
+///
+/// The icon hash is copied to a newly allocated array of bytes, while an empty
+/// array is returned in case the icon flag is not set.
+///
+QByteArray SyfdDatagramView::iconHash() const
+{
+    return (flagIcon()) ? QByteArray(reinterpret_cast<const char *>(m_iconHash),
+                                     SyfdDatagram::HASH_LEN)
+                        : QByteArray();
+}
+
+///
+/// The entry is read from the original buffer, and the UUID prefix is copied
+/// to a newly allocated array of bytes.
+///
+SyfdDatagram::DigestEntry SyfdDatagramView::digestEntry(int i) const
+{
+    LOG_ASSERT_X(i >= 0 && i < m_entriesCount,
+                 "SyfdDatagramView: digest entry out of range");
+
+    const uchar *entry =
+        m_entries + i * (SyfdDatagram::PREFIX_LEN + sizeof(quint32));
+    return SyfdDatagram::DigestEntry(
+        QByteArray(reinterpret_cast<const char *>(entry),
+                   SyfdDatagram::PREFIX_LEN),
+        qFromLittleEndian<quint32>(entry + SyfdDatagram::PREFIX_LEN));
+}
+
+quint64 SyfdDatagramView::digestEntryKey(int i) const
+{
+    LOG_ASSERT_X(i >= 0 && i < m_entriesCount,
+                 "SyfdDatagramView: digest entry out of range");
+
+    return prefixKey(m_entries +
+                     i * (SyfdDatagram::PREFIX_LEN + sizeof(quint32)));
+}
+
+quint32 SyfdDatagramView::digestEntrySequence(int i) const
+{
+    LOG_ASSERT_X(i >= 0 && i < m_entriesCount,
+                 "SyfdDatagramView: digest entry out of range");
+
+    return qFromLittleEndian<quint32>(
+        m_entries + i * (SyfdDatagram::PREFIX_LEN + sizeof(quint32)) +
+        SyfdDatagram::PREFIX_LEN);
+}
+
+///
+/// The fields characterizing a profile are validated and stored in the
+/// instance, except for the names that are only located in the buffer.
+///
+bool SyfdDatagramView::decodeProfile(const uchar *data, const uchar *end,
+                                     bool sequence)
+{
+    // UUID (the null one is not valid)
+    if (end - data < Constants::UUID_LEN ||
+        std::all_of(data, data + Constants::UUID_LEN,
+                    [](uchar byte) { return byte == 0; })) {
+        LOG_WARNING() << "SyfdDatagramView: invalid format detected (UUID)";
+        return false;
+    }
+    std::memcpy(m_uuid, data, Constants::UUID_LEN);
+    data += Constants::UUID_LEN;
+
+    // Profile sequence
+    if (sequence) {
+        if (end - data < static_cast<int>(sizeof(quint32))) {
+            LOG_WARNING()
+                << "SyfdDatagramView: invalid format detected (sequence)";
+            return false;
+        }
+        m_sequence = qFromLittleEndian<quint32>(data);
+        data += sizeof(quint32);
+    }
+
+    // Names
+    if (!decodeString(data, end, m_firstName, m_firstNameLen) ||
+        !decodeString(data, end, m_lastName, m_lastNameLen) ||
+        m_firstNameLen > SyfdDatagram::STRING_LEN ||
+        m_lastNameLen > SyfdDatagram::STRING_LEN) {
+        LOG_WARNING() << "SyfdDatagramView: invalid format detected (names)";
+        return false;
+    }
+
+    // IP and ports
+    const int addressesLen = sizeof(quint32) + 2 * sizeof(quint16);
+    if (end - data < addressesLen) {
+        LOG_WARNING()
+            << "SyfdDatagramView: invalid format detected (addresses)";
+        return false;
+    }
+    m_ipv4Addr = qFromLittleEndian<quint32>(data);
+    m_dataPort = qFromLittleEndian<quint16>(data + sizeof(quint32));
+    m_iconPort =
+        qFromLittleEndian<quint16>(data + sizeof(quint32) + sizeof(quint16));
+    data += addressesLen;
+
+    bool iconOk = (flagIcon()) ? (m_iconPort != 0) : (m_iconPort == 0);
+    if (m_ipv4Addr == 0 || m_dataPort == 0 || !iconOk) {
+        LOG_WARNING()
+            << "SyfdDatagramView: invalid format detected (addresses)";
+        return false;
+    }
+
+    // Icon hash
+    if (flagIcon()) {
+        if (end - data < SyfdDatagram::HASH_LEN) {
+            LOG_WARNING()
+                << "SyfdDatagramView: invalid format detected (icon hash)";
+            return false;
+        }
+        std::memcpy(m_iconHash, data, SyfdDatagram::HASH_LEN);
+    }
+
+    return true;
+}
+
+///
+/// QDataStream serializes a QString as its length in bytes (0xFFFFFFFF in case
+/// of null string) followed by the characters in UTF-16: the length is checked
+/// to be even and not to exceed the data available, while the characters are
+/// left in the buffer to be converted only if needed.
+///
+bool SyfdDatagramView::decodeString(const uchar *&data, const uchar *end,
+                                    const uchar *&string, int &length)
+{
+    if (end - data < static_cast<int>(sizeof(quint32))) {
+        return false;
+    }
+
+    quint32 bytes = qFromLittleEndian<quint32>(data);
+    data += sizeof(quint32);
+
+    // Null string
+    if (bytes == 0xFFFFFFFF) {
+        string = data;
+        length = 0;
+        return true;
+    }
+
+    if ((bytes & 0x1) || bytes > static_cast<quint32>(end - data)) {
+        return false;
+    }
+
+    string = data;
+    length = static_cast<int>(bytes / 2);
+    data += bytes;
+    return true;
+}
+
+///
+/// The characters are converted one at a time from little endian, so that the
+/// result does not depend on the architecture of the host.
+///
+QString SyfdDatagramView::toString(const uchar *data, int length)
+{
+    QString string(length, Qt::Uninitialized);
+    QChar *characters = string.data();
+    for (int i = 0; i < length; i++) {
+        characters[i] = QChar(qFromLittleEndian<quint16>(data + 2 * i));
+    }
+    return string;
+}
@@ -0,0 +1,231 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SYFDDATAGRAMVIEW_HPP
+#define SYFDDATAGRAMVIEW_HPP
+
+#include "Common/common.hpp"
+#include "syfddatagram.hpp"
+
+#include <QByteArray>
+#include <QString>
+
+///
+/// \brief The SyfdDatagramView class provides a read-only view of a
+/// SyfdDatagram stored in a raw array of bytes.
+///
+/// Building a SyfdDatagram from a byte array requires a QDataStream, the
+/// conversion of the names to QString and the copy of the UUID and of the
+/// icon hash to QByteArray instances, which is wasteful given that most of
+/// the datagrams received (heartbeats, requests, solicitations and profiles
+/// already known) do not need all these fields. This class, instead, validates
+/// the datagram in place according to the same rules and stores the fixed-size
+/// fields in the instance itself without any memory allocation, while the
+/// names and the digest entries are only referenced in the original buffer and
+/// converted on demand.
+///
+/// The instance does not own the data: the buffer given to decode() must
+/// therefore outlive all the accessors referring to it (i.e. names and digest
+/// entries). A complete SyfdDatagram can be obtained through
+/// SyfdDatagram::SyfdDatagram(const SyfdDatagramView&).
+///
+/// \see SyfdDatagram
+///
+class SyfdDatagramView
+{
+public:
+    ///
+    /// \brief Constructs an invalid SyfdDatagramView.
+    ///
+    explicit SyfdDatagramView()
+            : m_valid(false),
+              m_version(0),
+              m_flags(0),
+              m_type(SyfdDatagram::Type::Profile),
+              m_sequence(0),
+              m_firstName(Q_NULLPTR),
+              m_firstNameLen(0),
+              m_lastName(Q_NULLPTR),
+              m_lastNameLen(0),
+              m_ipv4Addr(0),
+              m_dataPort(0),
+              m_iconPort(0),
+              m_entries(Q_NULLPTR),
+              m_entriesCount(0)
+    {
+    }
+
+    ///
+    /// \brief Validates and decodes a datagram from an array of bytes.
+    /// \param data the array of bytes received from the network.
+    /// \param size the number of bytes available.
+    /// \return true in case of success and false otherwise (the same value
+    /// returned by valid()).
+    ///
+    bool decode(const char *data, int size);
+
+    ///
+    /// \brief Returns a view of the heartbeat corresponding to the current
+    /// profile (only the UUID prefix, the sequence and the quit flag are kept).
+    ///
+    SyfdDatagramView heartbeat() const;
+
+    /// \brief Returns whether the SyfdDatagramView is valid or not.
+    bool valid() const { return m_valid; }
+
+    ///
+    /// \brief Returns whether the datagram has been received in the
+    /// version 1.0 format (i.e. profile without the sequence number).
+    ///
+    bool legacy() const { return m_version == SyfdDatagram::Version::V1_0; }
+
+    /// \brief Returns the flags field of the datagram.
+    quint8 flags() const { return m_flags; }
+    /// \brief Returns whether the quit flag is set or not.
+    bool flagQuit() const { return m_flags & SyfdDatagram::Flags::FlagQuit; }
+    /// \brief Returns whether the icon flag is set or not.
+    bool flagIcon() const { return m_flags & SyfdDatagram::Flags::FlagIcon; }
+    /// \brief Returns whether the aggregator flag is set or not.
+    bool flagAggregator() const
+    {
+        return m_flags & SyfdDatagram::Flags::FlagAggregator;
+    }
+
+    /// \brief Returns the type of the datagram.
+    SyfdDatagram::Type type() const { return m_type; }
+    /// \brief Returns the profile sequence number stored in the datagram.
+    quint32 sequence() const { return m_sequence; }
+
+    ///
+    /// \brief Returns the UUID prefix as a number, suitable to be used as key.
+    ///
+    /// This field is meaningful only for profiles, heartbeats and requests.
+    ///
+    quint64 prefixKey() const { return prefixKey(m_uuid); }
+
+    ///
+    /// \brief Converts a UUID prefix to a number, suitable to be used as key.
+    /// \param prefix the pointer to the PREFIX_LEN bytes of the prefix.
+    /// \return the converted prefix.
+    ///
+    static quint64 prefixKey(const uchar *prefix);
+
+    ///
+    /// \brief Converts a number obtained through prefixKey() back to the
+    /// UUID prefix.
+    /// \param key the converted prefix.
+    /// \return the array of PREFIX_LEN bytes representing the prefix.
+    ///
+    static QByteArray prefixFromKey(quint64 key);
+
+    /// \brief Returns the UUID stored in the datagram (profiles only).
+    QByteArray uuid() const;
+    /// \brief Returns the UUID prefix stored in the datagram.
+    QByteArray uuidPrefix() const;
+    /// \brief Converts the first name stored in the datagram to a string.
+    QString firstName() const { return toString(m_firstName, m_firstNameLen); }
+    /// \brief Converts the last name stored in the datagram to a string.
+    QString lastName() const { return toString(m_lastName, m_lastNameLen); }
+
+    /// \brief Returns the IPv4 address stored in the datagram.
+    quint32 ipv4Addr() const { return m_ipv4Addr; }
+    /// \brief Returns the TCP port associated to data requests.
+    quint16 dataPort() const { return m_dataPort; }
+    /// \brief Returns the TCP port associated to icon requests.
+    quint16 iconPort() const { return m_iconPort; }
+    /// \brief Returns the icon's SHA-1 hash (if the icon flag is set).
+    QByteArray iconHash() const;
+
+    /// \brief Returns the number of entries stored in the digest.
+    int digestEntriesCount() const { return m_entriesCount; }
+    ///
+    /// \brief Returns one of the entries stored in the digest.
+    /// \param i the index of the entry (between 0 and digestEntriesCount()).
+    /// \return the requested entry.
+    ///
+    SyfdDatagram::DigestEntry digestEntry(int i) const;
+    ///
+    /// \brief Returns the UUID prefix (converted to a number) of one of the
+    /// entries stored in the digest, without copying it.
+    /// \param i the index of the entry (between 0 and digestEntriesCount()).
+    ///
+    quint64 digestEntryKey(int i) const;
+    ///
+    /// \brief Returns the profile sequence number of one of the entries stored
+    /// in the digest.
+    /// \param i the index of the entry (between 0 and digestEntriesCount()).
+    ///
+    quint32 digestEntrySequence(int i) const;
+
+private:
+    ///
+    /// \brief Decodes the fields specific to a profile.
+    /// \param data the pointer to the first byte following the header.
+    /// \param end the pointer following the last byte available.
+    /// \param sequence specifies whether the sequence number is present.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool decodeProfile(const uchar *data, const uchar *end, bool sequence);
+
+    ///
+    /// \brief Decodes a string serialized by QDataStream (length in bytes
+    /// followed by the UTF-16 data) without converting it.
+    /// \param data the pointer to the string (advanced past it on success).
+    /// \param end the pointer following the last byte available.
+    /// \param string the pointer set to the first character.
+    /// \param length the number of characters of the string.
+    /// \return true in case of success and false otherwise.
+    ///
+    static bool decodeString(const uchar *&data, const uchar *end,
+                             const uchar *&string, int &length);
+
+    ///
+    /// \brief Converts a string in UTF-16 (little endian) to a QString.
+    /// \param data the pointer to the first character.
+    /// \param length the number of characters.
+    /// \return the converted string.
+    ///
+    static QString toString(const uchar *data, int length);
+
+    /// \brief Specifies whether the SyfdDatagramView is valid or not.
+    bool m_valid;
+
+    quint8 m_version;         ///< \brief Version of the datagram.
+    quint8 m_flags;           ///< \brief Flags field.
+    SyfdDatagram::Type m_type; ///< \brief Type field.
+
+    uchar m_uuid[Constants::UUID_LEN]; ///< \brief UUID (or UUID prefix) field.
+    quint32 m_sequence;                ///< \brief Profile sequence field.
+
+    const uchar *m_firstName; ///< \brief First name (in the original buffer).
+    int m_firstNameLen;       ///< \brief First name length (characters).
+    const uchar *m_lastName;  ///< \brief Last name (in the original buffer).
+    int m_lastNameLen;        ///< \brief Last name length (characters).
+
+    quint32 m_ipv4Addr; ///< \brief IPv4 address field.
+    quint16 m_dataPort; ///< \brief TCP port for data requests field.
+    quint16 m_iconPort; ///< \brief TCP port for icon requests field.
+
+    uchar m_iconHash[SyfdDatagram::HASH_LEN]; ///< \brief Icon's SHA-1 hash.
+
+    const uchar *m_entries; ///< \brief Digest entries (in the original buffer).
+    int m_entriesCount;     ///< \brief Number of digest entries.
+};
+
+#endif // SYFDDATAGRAMVIEW_HPP
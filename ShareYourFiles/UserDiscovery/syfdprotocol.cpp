@@ -17,10 +17,18 @@
  */
 
 #include "syfdprotocol.hpp"
+#include "Common/coalescedtimer.hpp"
+#include "Common/logging.hpp"
+#include "syfdaggregator.hpp"
 #include "syfddatagram.hpp"
+#include "syfddatagramview.hpp"
+#include "syfdratelimiter.hpp"
 
-#include <Logger.h>
+#ifdef Q_OS_LINUX
+#include "syfdbatchreceiver.hpp"
+#endif
 
+#include <QDateTime>
 #include <QHostAddress>
 #include <QNetworkDatagram>
 #include <QNetworkInterface>
@@ -29,6 +37,8 @@
 
 // Static variables definition
 const QHostAddress SyfdProtocol::SYFD_ADDRESS = QHostAddress("239.255.101.10");
+const QHostAddress SyfdProtocol::SYFD_PRESENCE_ADDRESS =
+    QHostAddress("239.255.101.11");
 
 // Register SyfdDatagram to the qt meta type system
 static MetaTypeRegistration<SyfdDatagram> datagramRegisterer("SyfdDatagram");
@@ -52,16 +62,33 @@ SyfdProtocol::SyfdProtocol(const NetworkEntriesList::Entry &entry,
           m_status(Status::Stopped),
           m_mode(Enums::OperationalMode::Offline),
           m_sender(new QUdpSocket(this)),
+#ifdef Q_OS_LINUX
+          m_receiver(
+              new SyfdBatchReceiver(SyfdDatagram::MAX_DATAGRAM_SIZE, this)),
+#else
           m_receiver(new QUdpSocket(this)),
-          m_timer(new QTimer(this)),
+#endif
+          m_timer(new CoalescedTimer(this)),
+          m_solicitTimer(new QTimer(this)),
           m_datagram(new SyfdDatagram()),
           m_datagramBuffer(new QByteArray()),
+          m_heartbeatBuffer(new QByteArray()),
+          m_legacyBuffer(new QByteArray()),
+          m_prefixKey(0),
+          m_sequence(
+              static_cast<quint32>(QDateTime::currentMSecsSinceEpoch() / 1000)),
+          m_random(std::random_device()()),
+          m_aggregator(new SyfdAggregator()),
+          m_rateLimiter(new SyfdRateLimiter()),
           m_errorCount(0)
 {
     LOG_INFO() << "SyfdProtocol: initialization...";
 
+    m_solicitTimer->setSingleShot(true);
+
     // Get the network interface to be used and check if it is valid
     QNetworkInterface iface = QNetworkInterface::interfaceFromName(entry.first);
+    m_interface = iface;
     if (!NetworkEntriesList::validNetworkInterface(iface)) {
         LOG_ERROR() << "SyfdProtocol: invalid interface"
                     << iface.humanReadableName();
@@ -100,9 +127,13 @@ SyfdProtocol::SyfdProtocol(const NetworkEntriesList::Entry &entry,
 
     // Receiver socket initialization
     // Bind to the SYFDProtocol port;
+#ifdef Q_OS_LINUX
+    if (!m_receiver->bind(SyfdProtocol::SYFD_PORT)) {
+#else
     if (!m_receiver->bind(QHostAddress::AnyIPv4, SyfdProtocol::SYFD_PORT,
                           QUdpSocket::ShareAddress |
                               QUdpSocket::ReuseAddressHint)) {
+#endif
         LOG_ERROR() << "SyfdProtocol: failed to bind the receiver socket";
         return;
     }
@@ -135,6 +166,24 @@ SyfdProtocol::~SyfdProtocol()
     }
 }
 
+///
+/// The counter is read atomically from the rate limiter, hence this function
+/// can be safely called from threads other than the one of the protocol.
+///
+quint32 SyfdProtocol::droppedBySource() const
+{
+    return m_rateLimiter->droppedBySource();
+}
+
+///
+/// The counter is read atomically from the rate limiter, hence this function
+/// can be safely called from threads other than the one of the protocol.
+///
+quint32 SyfdProtocol::droppedGlobally() const
+{
+    return m_rateLimiter->droppedGlobally();
+}
+
 ///
 /// The protocol is started by connecting the handler executed
 /// when a datagram is received and starting the timer in charge to
@@ -157,6 +206,20 @@ void SyfdProtocol::start(Enums::OperationalMode mode,
         return;
     }
 
+#ifdef Q_OS_LINUX
+    // Discard all pending datagrams (if any)
+    m_receiver->discardPending();
+
+    // S&S connection: receiver socket error handling
+    connect(m_receiver, &SyfdBatchReceiver::error, this, [this]() {
+        LOG_WARNING() << "SyfdProtocol: receiver socket error:"
+                      << m_receiver->errorString();
+    });
+
+    // S&S connection: datagram received
+    connect(m_receiver, &SyfdBatchReceiver::readyRead, this,
+            &SyfdProtocol::receiveDatagram);
+#else
     // Discard all pending datagrams (if any) to allow
     // readyRead signal to be emitted again
     while (m_receiver->hasPendingDatagrams())
@@ -174,11 +237,16 @@ void SyfdProtocol::start(Enums::OperationalMode mode,
     // S&S connection: datagram received
     connect(m_receiver, &QUdpSocket::readyRead, this,
             &SyfdProtocol::receiveDatagram);
+#endif
 
     // S&S connection: datagram sender timer
-    connect(m_timer, &QTimer::timeout, this,
+    connect(m_timer, &CoalescedTimer::timeout, this,
             &SyfdProtocol::sendBufferedDatagram);
 
+    // S&S connection: answer to solicitations
+    connect(m_solicitTimer, &QTimer::timeout, this,
+            &SyfdProtocol::sendProfile);
+
     // Update the buffered datagram
     updateDatagram(datagram);
 
@@ -189,6 +257,11 @@ void SyfdProtocol::start(Enums::OperationalMode mode,
     // Move to online mode if necessary
     m_mode = Enums::OperationalMode::Offline;
     setMode(mode);
+
+    // Solicit the peers (already done by setMode() when going online)
+    if (m_mode == Enums::OperationalMode::Offline) {
+        sendSolicitation();
+    }
 }
 
 ///
@@ -218,6 +291,7 @@ void SyfdProtocol::stop()
 
     // Signal slot disconnections
     disconnect(m_timer, nullptr, nullptr, nullptr);
+    disconnect(m_solicitTimer, nullptr, nullptr, nullptr);
     disconnect(m_receiver, nullptr, nullptr, nullptr);
     disconnect(m_sender, nullptr, nullptr, nullptr);
 
@@ -255,7 +329,9 @@ void SyfdProtocol::setMode(Enums::OperationalMode mode, bool emitSignal)
             return;
         }
 
-        // Start the timer
+        // Advertise the profile, solicit the peers and start the timer
+        sendProfile();
+        sendSolicitation();
         m_timer->start(SyfdProtocol::SYDF_INTERVAL);
     }
 
@@ -265,6 +341,11 @@ void SyfdProtocol::setMode(Enums::OperationalMode mode, bool emitSignal)
         LOG_INFO() << "SyfdProtocol: going offline...";
         sendQuitDatagram();
         m_timer->stop();
+        m_solicitTimer->stop();
+        m_aggregator->clear();
+        m_profiles.clear();
+        m_rateLimiter->setPeers(0);
+        m_legacyTimer.invalidate();
     }
 
     m_errorCount = 0;
@@ -279,20 +360,146 @@ void SyfdProtocol::setMode(Enums::OperationalMode mode, bool emitSignal)
 
 ///
 /// This function updates the buffered datagram advertised through the network.
-/// In case the parameter is not valid, the buffered datagram is cleared
+/// In case the parameter is not valid, the buffered datagram is cleared.
+/// The profile sequence number is incremented only if the information actually
+/// changed and, in that case, the new profile is immediately advertised (if
+/// the mode is online), so that peers do not need to wait for the heartbeat.
 ///
 void SyfdProtocol::updateDatagram(const SyfdDatagram &datagram)
 {
-    // Store the obtained datagram instance and clean the buffered array
+    // Store the obtained datagram instance with the current sequence number
     *m_datagram = datagram;
+    m_datagram->setSequence(m_sequence);
+
+    // Check whether the profile changed with respect to the buffered one
+    QByteArray buffer =
+        (m_datagram->valid()) ? m_datagram->toByteArray() : QByteArray();
+    if (buffer == *m_datagramBuffer) {
+        return;
+    }
+
+    // Clean the buffered arrays
     m_datagramBuffer->clear();
+    m_heartbeatBuffer->clear();
+    m_legacyBuffer->clear();
 
-    // If the datagram is valid, buffer it for dispatch
+    // If the datagram is valid, buffer it for dispatch with a new sequence
     if (m_datagram->valid()) {
+        m_datagram->setSequence(++m_sequence);
         m_datagramBuffer->append(m_datagram->toByteArray());
+        m_heartbeatBuffer->append(
+            m_datagram->heartbeat(m_aggregator->capable()).toByteArray());
+        m_legacyBuffer->append(m_datagram->toLegacyByteArray());
+    }
+    m_aggregator->setLocalPrefix(m_datagram->valid() ? m_datagram->uuidPrefix()
+                                                     : QByteArray());
+    m_prefixKey = (m_datagram->valid())
+                      ? SyfdDatagramView::prefixKey(
+                            reinterpret_cast<const uchar *>(
+                                m_datagram->uuidPrefix().constData()))
+                      : 0;
+
+    LOG_INFO() << "SyfdProtocol: local datagram updated, sequence"
+               << m_sequence;
+
+    // Advertise the new profile
+    if (m_mode == Enums::OperationalMode::Online &&
+        !m_datagramBuffer->isEmpty()) {
+        sendProfile();
+    }
+}
+
+///
+/// This function sends a datagram asking the peer identified by the UUID prefix
+/// to advertise its full profile, which will be forwarded even though its
+/// sequence number did not change. Nothing is done if the protocol is stopped.
+///
+void SyfdProtocol::requestProfile(const QByteArray &uuidPrefix)
+{
+    if (m_status == Status::Stopped) {
+        return;
+    }
+
+    SyfdDatagram request = SyfdDatagram::profileRequest(uuidPrefix);
+    if (request.valid()) {
+        // The answer must be forwarded even if the profile did not change
+        m_profiles.remove(SyfdDatagramView::prefixKey(
+            reinterpret_cast<const uchar *>(uuidPrefix.constData())));
+        sendDatagram(request.toByteArray());
+    }
+}
+
+///
+/// This function enables or disables the aggregator capability of the local
+/// host: in the former case, the receiver socket joins also the multicast group
+/// used to collect the heartbeats, and the aggregator flag is advertised in the
+/// heartbeats of the local user. The function is meant to be executed before
+/// starting the protocol, even though it can be safely executed later.
+///
+void SyfdProtocol::setAggregatorCapable(bool capable)
+{
+    if (!m_valid || m_aggregator->capable() == capable) {
+        return;
+    }
+
+    // Join or leave the multicast group used to collect the heartbeats
+    bool result =
+        (capable) ? m_receiver->joinMulticastGroup(
+                        SyfdProtocol::SYFD_PRESENCE_ADDRESS, m_interface)
+                  : m_receiver->leaveMulticastGroup(
+                        SyfdProtocol::SYFD_PRESENCE_ADDRESS, m_interface);
+    if (!result) {
+        LOG_ERROR() << "SyfdProtocol: failed changing the aggregator capability"
+                    << m_receiver->errorString();
+        return;
     }
+    m_aggregator->setCapable(capable);
 
-    LOG_INFO() << "SyfdProtocol: local datagram updated";
+    // Update the buffered heartbeat
+    m_heartbeatBuffer->clear();
+    if (m_datagram->valid()) {
+        m_heartbeatBuffer->append(
+            m_datagram->heartbeat(m_aggregator->capable()).toByteArray());
+    }
+
+    LOG_INFO() << "SyfdProtocol: aggregator capability"
+               << (capable ? "enabled" : "disabled");
+}
+
+///
+/// The age of the entry associated to the peer, if any, is reset, so that the
+/// profiles forwarded are kept only for the peers which are still present.
+///
+void SyfdProtocol::refreshProfile(quint64 prefixKey)
+{
+    auto it = m_profiles.find(prefixKey);
+    if (it != m_profiles.end()) {
+        it.value().age = 0;
+    }
+}
+
+///
+/// Every time this function is executed (once per SYFD interval), the age of
+/// the profiles forwarded is incremented: the entries related to the peers not
+/// confirmed for longer than PROFILE_MAX_AGE intervals (hence expired also by
+/// the PeersList) are removed and the rate limiter is updated accordingly.
+///
+void SyfdProtocol::incrementProfileAge()
+{
+    int size = m_profiles.size();
+
+    auto it = m_profiles.begin();
+    while (it != m_profiles.end()) {
+        if (++it.value().age > SyfdProtocol::PROFILE_MAX_AGE) {
+            it = m_profiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (m_profiles.size() != size) {
+        m_rateLimiter->setPeers(m_profiles.size());
+    }
 }
 
 ///
@@ -305,10 +512,11 @@ void SyfdProtocol::updateDatagram(const SyfdDatagram &datagram)
 /// \see sendBufferedDatagram()
 /// \see sendQuitDatagram()
 ///
-void SyfdProtocol::sendDatagram(const QByteArray &datagram)
+void SyfdProtocol::sendDatagram(const QByteArray &datagram,
+                                const QHostAddress &address)
 {
-    if (m_sender->writeDatagram(datagram, SyfdProtocol::SYFD_ADDRESS,
-                                SyfdProtocol::SYFD_PORT) != datagram.length()) {
+    if (m_sender->writeDatagram(datagram, address, SyfdProtocol::SYFD_PORT) !=
+        datagram.length()) {
         LOG_WARNING() << "SyfdProtocol: error while sending datagram"
                       << m_sender->errorString();
 
@@ -328,15 +536,39 @@ void SyfdProtocol::sendDatagram(const QByteArray &datagram)
 
 ///
 /// Every time this function is executed (when the timer timeouts),
-/// the buffered SyfdDatagram representing the local user is sent
+/// the buffered heartbeat representing the local user is sent
 /// through the Local Area Network. In case the buffered datagram is
 /// not valid (i.e. the buffer is empty), the mode is switched to Offline.
 ///
+/// If an aggregator is active, the heartbeat is sent only to the aggregator
+/// capable hosts, while in case the local host is the elected aggregator, the
+/// digests summarizing the heartbeats collected are also published. Moreover,
+/// the profile in the version 1.0 format is sent as well if hosts not yet
+/// upgraded have been recently detected.
+///
 void SyfdProtocol::sendBufferedDatagram()
 {
+    m_aggregator->incrementAge();
+    incrementProfileAge();
+
     // If the buffered datagram is valid, sent it
-    if (!m_datagramBuffer->isEmpty()) {
-        sendDatagram(*m_datagramBuffer);
+    if (!m_heartbeatBuffer->isEmpty()) {
+        sendDatagram(*m_heartbeatBuffer,
+                     m_aggregator->aggregated()
+                         ? SyfdProtocol::SYFD_PRESENCE_ADDRESS
+                         : SyfdProtocol::SYFD_ADDRESS);
+
+        // Publish the digests if elected as aggregator
+        if (m_aggregator->elected()) {
+            foreach (const SyfdDatagram &digest, m_aggregator->digests()) {
+                sendDatagram(digest.toByteArray());
+            }
+        }
+
+        // Keep the hosts not yet upgraded aware of the local user
+        if (legacyPeers() && !m_legacyBuffer->isEmpty()) {
+            sendDatagram(*m_legacyBuffer);
+        }
     }
 
     // Otherwise go offline
@@ -346,11 +578,24 @@ void SyfdProtocol::sendBufferedDatagram()
     }
 }
 
+///
+/// This function advertises the buffered profile of the local user, which is
+/// sent only when it changes or when it is requested by some peer.
+///
+void SyfdProtocol::sendProfile()
+{
+    if (!m_datagramBuffer->isEmpty()) {
+        sendDatagram(*m_datagramBuffer);
+        m_profileTimer.start();
+    }
+}
+
 ///
 /// This function advertises a special SyfdDatagram characterized
 /// by the quit flag set, which tells the other peers that this
 /// user is going to disconnect (to make detection faster than
-/// through the aging time).
+/// through the aging time). The quit flag is advertised also through
+/// the legacy profile if hosts not yet upgraded have been recently detected.
 ///
 void SyfdProtocol::sendQuitDatagram()
 {
@@ -360,26 +605,101 @@ void SyfdProtocol::sendQuitDatagram()
         LOG_INFO() << "SyfdProtocol: sending quit SYFD datagram...";
 
         m_datagram->setFlagQuit();
-        QByteArray buffer(m_datagram->toByteArray());
+        QByteArray buffer(m_datagram->heartbeat().toByteArray());
+        QByteArray legacyBuffer(
+            legacyPeers() ? m_datagram->toLegacyByteArray() : QByteArray());
         m_datagram->clearFlagQuit();
 
         // Send it
         sendDatagram(buffer);
+        if (!legacyBuffer.isEmpty()) {
+            sendDatagram(legacyBuffer);
+        }
         m_sender->flush();
     }
 }
 
+///
+/// This function sends a solicitation, asking all the peers to advertise their
+/// profiles, in order to fill the list of peers as soon as possible. The rate
+/// limiter is notified, so that none of the answers is dropped by the global
+/// limits even if the peers are not yet known.
+///
+void SyfdProtocol::sendSolicitation()
+{
+    LOG_INFO() << "SyfdProtocol: sending solicitation SYFD datagram...";
+    m_rateLimiter->solicitationSent(SyfdProtocol::SOLICIT_WINDOW);
+    sendDatagram(SyfdDatagram::solicitation().toByteArray());
+}
+
+///
+/// This function, executed when a solicitation is received, schedules the
+/// advertisement of the local profile after a random delay (to avoid all the
+/// peers answering at the same time). In case an answer is already scheduled,
+/// nothing is done, since it will serve all the solicitations received in the
+/// meanwhile; moreover, the delay is extended if needed to guarantee that
+/// consecutive profiles are spaced of at least PROFILE_MIN_INTERVAL.
+///
+void SyfdProtocol::answerSolicitation()
+{
+    if (m_mode != Enums::OperationalMode::Online || m_solicitTimer->isActive()) {
+        return;
+    }
+
+    // Select a random delay
+    std::uniform_int_distribution<int> distribution(
+        0, SyfdProtocol::SOLICIT_MAX_DELAY);
+    int delay = distribution(m_random);
+
+    // Space the answer from the previous profile
+    if (m_profileTimer.isValid()) {
+        qint64 remaining =
+            SyfdProtocol::PROFILE_MIN_INTERVAL - m_profileTimer.elapsed();
+        delay = qMax(delay, static_cast<int>(remaining));
+    }
+
+    m_solicitTimer->start(delay);
+}
+
 ///
 /// This function is executed every time a datagram is ready to be read.
 /// Some checks are initially performed to guarantee that it has the
 /// expected size (according to the SyfdDatagram specifications), then
-/// the datagram is received and discarded in case it is the one sent
-/// by the local socket (multicast datagrams are looped back).
-/// The raw array of bytes is then converted to a SyfdDatagram and, if
-/// valid, it is used to update the list of known peers.
+/// the datagram is received and processed through processDatagram().
+///
+/// On Linux, the datagrams are received in batches through the
+/// SyfdBatchReceiver, in order to reduce the number of system calls and
+/// memory allocations required in case of bursts.
 ///
 void SyfdProtocol::receiveDatagram()
 {
+#ifdef Q_OS_LINUX
+    // Repeat until there are pending datagrams
+    int count = SyfdBatchReceiver::BATCH_SIZE;
+    while (count == SyfdBatchReceiver::BATCH_SIZE) {
+        count = m_receiver->receive();
+
+        for (int i = 0; i < count; i++) {
+            const SyfdBatchReceiver::Datagram &datagram =
+                m_receiver->datagram(i);
+
+            // Check if the size is compatible with expected values
+            if (datagram.truncated ||
+                datagram.size < SyfdDatagram::MIN_DATAGRAM_SIZE) {
+                LOG_WARNING()
+                    << "SyfdProtocol: wrong sized datagram received from"
+                    << qUtf8Printable(
+                           QHostAddress(datagram.senderAddress).toString())
+                    << "@" << datagram.senderPort;
+                continue;
+            }
+
+            // The data is not copied, since it is parsed immediately
+            processDatagram(datagram.data, datagram.size,
+                            datagram.senderAddress, datagram.senderPort);
+        }
+    }
+#else
     // Repeat until there are pending datagrams
     while (m_receiver->hasPendingDatagrams()) {
 
@@ -410,19 +730,131 @@ void SyfdProtocol::receiveDatagram()
             continue;
         }
 
-        // Discard my own datagrams looped back
-        if (datagram.senderAddress().toIPv4Address() == m_localAddress &&
-            datagram.senderPort() == m_localPort) {
-            continue;
+        const QByteArray data = datagram.data();
+        processDatagram(data.constData(), data.size(),
+                        datagram.senderAddress().toIPv4Address(),
+                        static_cast<quint16>(datagram.senderPort()));
+    }
+#endif
+}
+
+///
+/// The datagram is discarded in case it is the one sent by the local socket
+/// (multicast datagrams are looped back) or it is not admitted by the rate
+/// limiter (a warning is logged at most every DROP_LOG_INTERVAL in that
+/// case, to avoid flooding the log as well). The raw array of bytes is then
+/// decoded in place through a SyfdDatagramView and, if valid, it is used to
+/// update the list of known peers. Requests for the profile of the local user
+/// are directly answered, unless the profile has just been sent (the multicast
+/// answer reaches all the requesting peers), while solicitations are answered
+/// after a random delay: in both cases no memory allocation is required.
+///
+/// Since profiles are advertised again every time they are requested, most of
+/// them carry the same information already forwarded: in that case (i.e. when
+/// the sequence number did not change) they are forwarded as heartbeats, so
+/// that the names are converted only when the profile actually changed.
+/// Heartbeats are dispatched through heartbeatReceived() as plain fields, and
+/// the digest entries are read in place: a SyfdDatagram (and the copy made by
+/// the queued signal) is built only for profiles and digests.
+///
+void SyfdProtocol::processDatagram(const char *data, int size,
+                                   quint32 senderAddress, quint16 senderPort)
+{
+    // Discard my own datagrams looped back
+    if (senderAddress == m_localAddress && senderPort == m_localPort) {
+        return;
+    }
+
+    // Drop the datagram in case of storm
+    if (!m_rateLimiter->admit(senderAddress)) {
+        if (!m_dropLogTimer.isValid() ||
+            m_dropLogTimer.hasExpired(SyfdProtocol::DROP_LOG_INTERVAL)) {
+            LOG_WARNING() << "SyfdProtocol: datagram storm detected - dropped"
+                          << m_rateLimiter->droppedBySource()
+                          << "(per source) and"
+                          << m_rateLimiter->droppedGlobally() << "(global)";
+            m_dropLogTimer.start();
         }
+        return;
+    }
 
-        // Datagram processing
-        SyfdDatagram syfdDatagram(datagram.data());
-        if (!syfdDatagram.valid()) {
-            LOG_WARNING() << "SyfdProtocol: invalid datagram received";
-            continue;
+    // Datagram processing
+    SyfdDatagramView view;
+    if (!view.decode(data, size)) {
+        LOG_WARNING() << "SyfdProtocol: invalid datagram received";
+        return;
+    }
+
+    bool heartbeat = false;
+    switch (view.type()) {
+    // Answer the requests for the local profile
+    case SyfdDatagram::Type::ProfileRequest:
+        if (m_mode == Enums::OperationalMode::Online &&
+            m_datagram->valid() && view.prefixKey() == m_prefixKey &&
+            (!m_profileTimer.isValid() ||
+             m_profileTimer.hasExpired(SyfdProtocol::PROFILE_MIN_INTERVAL))) {
+            sendProfile();
         }
+        return;
+
+    // Answer the solicitations
+    case SyfdDatagram::Type::Solicit:
+        answerSolicitation();
+        return;
 
-        emit datagramReceived(syfdDatagram);
+    // Forward only the profiles that changed
+    case SyfdDatagram::Type::Profile:
+        if (view.legacy()) {
+            m_legacyTimer.start();
+        } else {
+            auto it = m_profiles.find(view.prefixKey());
+            if (it != m_profiles.end() &&
+                it.value().sequence == view.sequence()) {
+                it.value().age = 0;
+                view = view.heartbeat();
+            } else {
+                ProfileEntry entry;
+                entry.sequence = view.sequence();
+                entry.age = 0;
+                m_profiles.insert(view.prefixKey(), entry);
+                m_rateLimiter->setPeers(m_profiles.size());
+            }
+        }
+        break;
+
+    // Keep track of the information needed by the hierarchical discovery
+    case SyfdDatagram::Type::Heartbeat:
+        heartbeat = true;
+        refreshProfile(view.prefixKey());
+        break;
+
+    case SyfdDatagram::Type::Digest:
+        m_aggregator->digestReceived();
+        for (int i = 0; i < view.digestEntriesCount(); i++) {
+            refreshProfile(view.digestEntryKey(i));
+        }
+        break;
     }
+
+    // Heartbeats (including the unchanged profiles) are dispatched through
+    // their fields, without building a SyfdDatagram
+    if (view.type() == SyfdDatagram::Type::Heartbeat) {
+        // A peer quitting will advertise again its profile when coming back
+        if (view.flagQuit()) {
+            m_profiles.remove(view.prefixKey());
+            m_rateLimiter->setPeers(m_profiles.size());
+        }
+
+        if (heartbeat) {
+            m_aggregator->heartbeatReceived(view.prefixKey(), view.sequence(),
+                                            view.flagAggregator(),
+                                            view.flagQuit());
+        }
+
+        emit heartbeatReceived(view.prefixKey(), view.sequence(),
+                               view.flagQuit());
+        return;
+    }
+
+    emit datagramReceived(SyfdDatagram(view));
 }
@@ -22,15 +22,24 @@
 #include "Common/common.hpp"
 #include "Common/networkentrieslist.hpp"
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QHostAddress>
+#include <QNetworkInterface>
 #include <QObject>
 #include <QPointer>
 
+#include <random>
+
 class QByteArray;
+class CoalescedTimer;
 class QUdpSocket;
 class QTimer;
 
+class SyfdAggregator;
+class SyfdBatchReceiver;
 class SyfdDatagram;
+class SyfdRateLimiter;
 
 ///
 /// \brief The SyfdProtocol class provides an implementation of the SYFD
@@ -49,7 +58,31 @@ class SyfdDatagram;
 /// the datagrams representing the other peers. Therefore this class implements
 /// both the sending and the receiving side of the protocol.
 ///
+/// In order to limit the amount of data exchanged, the full profile of the
+/// local user is advertised only when it changes or when explicitly requested
+/// by some peer, while a tiny heartbeat is periodically sent to confirm the
+/// presence of the user. Additionally, when the protocol is started or the
+/// mode switched to online, a solicitation is sent to let the peers advertise
+/// their profiles after a short random delay, so that the list of peers is
+/// filled without waiting for the periodic heartbeats.
+///
+/// Hosts not yet upgraded only understand the profiles in the version 1.0
+/// format and expect them to be sent periodically: as long as any of them has
+/// been detected within the last LEGACY_TIMEOUT milliseconds, the legacy
+/// profile is advertised together with each heartbeat, so that they keep
+/// detecting the local user.
+///
+/// Finally, the protocol optionally supports a hierarchical discovery mode to
+/// scale on large LANs, where an elected aggregator summarizes the heartbeats
+/// of all the users through periodic digests.
+///
+/// To protect the SYFD thread from datagram storms (e.g. a misbehaving client
+/// or a looped bridge), the datagrams received are processed only if admitted
+/// by a SyfdRateLimiter, which enforces both per-source and global limits.
+///
+/// \see SyfdAggregator
 /// \see SyfdDatagram
+/// \see SyfdRateLimiter
 ///
 class SyfdProtocol : public QObject
 {
@@ -94,6 +127,18 @@ public:
     ///
     bool valid() const { return m_valid; }
 
+    ///
+    /// \brief Returns the number of datagrams dropped since a single source
+    /// exceeded its rate (it can be called from any thread).
+    ///
+    quint32 droppedBySource() const;
+
+    ///
+    /// \brief Returns the number of datagrams dropped since the overall rate
+    /// has been exceeded (it can be called from any thread).
+    ///
+    quint32 droppedGlobally() const;
+
 public slots:
     ///
     /// \brief Starts the SyfdProtocol.
@@ -121,6 +166,18 @@ public slots:
     ///
     void updateDatagram(const SyfdDatagram &datagram);
 
+    ///
+    /// \brief Requests a peer to advertise its full profile.
+    /// \param uuidPrefix the prefix of the UUID identifying the peer.
+    ///
+    void requestProfile(const QByteArray &uuidPrefix);
+
+    ///
+    /// \brief Sets whether the local host is aggregator capable or not.
+    /// \param capable the value to be set.
+    ///
+    void setAggregatorCapable(bool capable);
+
 signals:
     ///
     /// \brief Signal emitted when the protocol is started.
@@ -139,11 +196,21 @@ signals:
     void modeChanged(Enums::OperationalMode mode);
 
     ///
-    /// \brief Signal emitted when a datagram is received.
+    /// \brief Signal emitted when a datagram other than a heartbeat is
+    /// received.
     /// \param datagram the received SYFD datagram.
     ///
     void datagramReceived(const SyfdDatagram &datagram);
 
+    ///
+    /// \brief Signal emitted when a heartbeat is received (or a profile that
+    /// did not change since it was last forwarded).
+    /// \param prefixKey the UUID prefix of the peer (converted to a number).
+    /// \param sequence the profile sequence number advertised.
+    /// \param quit whether the quit flag is set.
+    ///
+    void heartbeatReceived(quint64 prefixKey, quint32 sequence, bool quit);
+
     ///
     /// \brief Signal emitted when the protocol fails sending datagrams.
     ///
@@ -153,24 +220,75 @@ private:
     ///
     /// \brief Sends a datagram containing the data specified.
     /// \param datagram data to be sent.
+    /// \param address the multicast address the datagram is sent to.
     ///
-    void sendDatagram(const QByteArray &datagram);
+    void sendDatagram(const QByteArray &datagram,
+                      const QHostAddress &address = SYFD_ADDRESS);
 
     ///
-    /// \brief Sends the buffered datagram advertising the local user.
+    /// \brief Sends the buffered heartbeat advertising the local user.
     ///
     void sendBufferedDatagram();
 
+    ///
+    /// \brief Sends the buffered profile of the local user.
+    ///
+    void sendProfile();
+
     ///
     /// \brief Sends a datagram with the quit flag set.
     ///
     void sendQuitDatagram();
 
+    ///
+    /// \brief Sends a datagram soliciting the peers to advertise their
+    /// profiles.
+    ///
+    void sendSolicitation();
+
+    ///
+    /// \brief Schedules the answer to a solicitation received.
+    ///
+    void answerSolicitation();
+
+    ///
+    /// \brief Confirms the presence of a peer whose profile has been
+    /// forwarded, resetting the age of the corresponding entry.
+    /// \param prefixKey the UUID prefix of the peer (converted to a number).
+    ///
+    void refreshProfile(quint64 prefixKey);
+
+    ///
+    /// \brief Increments the age of the profiles forwarded, removing the
+    /// expired ones.
+    ///
+    void incrementProfileAge();
+
+    ///
+    /// \brief Returns whether hosts not yet upgraded (i.e. advertising
+    /// profiles in the version 1.0 format) have been recently detected.
+    ///
+    bool legacyPeers() const
+    {
+        return m_legacyTimer.isValid() &&
+               !m_legacyTimer.hasExpired(SyfdProtocol::LEGACY_TIMEOUT);
+    }
+
     ///
     /// \brief Performs datagram reception and dispatching.
     ///
     void receiveDatagram();
 
+    ///
+    /// \brief Processes a datagram received from the network.
+    /// \param data the raw content of the datagram.
+    /// \param size the size of the datagram.
+    /// \param senderAddress the IPv4 address of the sender.
+    /// \param senderPort the UDP port of the sender.
+    ///
+    void processDatagram(const char *data, int size, quint32 senderAddress,
+                         quint16 senderPort);
+
     ///
     /// \brief Updates the buffered datagram.
     /// \return true in case of success and false in case of failure.
@@ -180,12 +298,39 @@ private:
 private:
     /// \brief The IPv4 multicast address used by this protocol.
     static const QHostAddress SYFD_ADDRESS;
+    /// \brief The IPv4 multicast address used to send heartbeats to the
+    /// aggregators.
+    static const QHostAddress SYFD_PRESENCE_ADDRESS;
     /// \brief The UDP port used by this protocol.
     static const quint16 SYFD_PORT = 10101;
     /// \brief Interval between execution of datagram shipping and aging.
     static const int SYDF_INTERVAL = 5000;
     /// \brief The number of errors before the error() signal is emitted.
     static const int ERROR_THRESHOLD = 3;
+    /// \brief Minimum interval between two profiles sent upon request.
+    static const int PROFILE_MIN_INTERVAL = 1000;
+    /// \brief Maximum delay before answering to a solicitation.
+    static const int SOLICIT_MAX_DELAY = 500;
+    /// \brief Time after a solicitation within which the answers are expected
+    /// (the maximum delay plus the minimum interval between two profiles).
+    static const int SOLICIT_WINDOW = 2000;
+    /// \brief Minimum interval between two warnings about dropped datagrams.
+    static const int DROP_LOG_INTERVAL = 5000;
+    /// \brief Time after the last legacy profile received before stopping
+    /// advertising the local profile in the version 1.0 format.
+    static const int LEGACY_TIMEOUT = 4 * SYDF_INTERVAL;
+    /// \brief Maximum age of the profiles forwarded (intervals), after which
+    /// the peer is expired also by the PeersList.
+    static const quint8 PROFILE_MAX_AGE = 4;
+
+    ///
+    /// \brief The ProfileEntry struct represents a peer whose profile has been
+    /// forwarded.
+    ///
+    struct ProfileEntry {
+        quint32 sequence; ///< \brief The profile sequence number.
+        quint8 age;       ///< \brief The age of the entry.
+    };
 
 
     /// \brief Specifies whether the SyfdProtocol instance is valid or not.
@@ -197,10 +342,19 @@ private:
     Enums::OperationalMode m_mode;
 
     QPointer<QUdpSocket> m_sender;   ///< \brief Sender socket.
+#ifdef Q_OS_LINUX
+    /// \brief Receiver socket (batched reception through recvmmsg()).
+    QPointer<SyfdBatchReceiver> m_receiver;
+#else
     QPointer<QUdpSocket> m_receiver; ///< \brief Receiver socket.
+#endif
+    /// \brief The network interface used by the sockets.
+    QNetworkInterface m_interface;
 
     /// \brief Timer used for datagram shipping and aging.
-    QPointer<QTimer> m_timer;
+    QPointer<CoalescedTimer> m_timer;
+    /// \brief Timer used to delay the answer to solicitations.
+    QPointer<QTimer> m_solicitTimer;
 
     /// \brief Local IPv4 address used to send the datagrams.
     quint32 m_localAddress;
@@ -212,6 +366,34 @@ private:
     /// \brief Buffer containing a copy of the datagram representing the local
     /// user.
     QScopedPointer<QByteArray> m_datagramBuffer;
+    /// \brief Buffer containing a copy of the heartbeat advertising the local
+    /// user.
+    QScopedPointer<QByteArray> m_heartbeatBuffer;
+    /// \brief Buffer containing a copy of the profile of the local user in the
+    /// version 1.0 format.
+    QScopedPointer<QByteArray> m_legacyBuffer;
+    /// \brief Timer measuring the time elapsed since the last legacy profile
+    /// received.
+    QElapsedTimer m_legacyTimer;
+
+    /// \brief The UUID prefix of the local user (converted to a number).
+    quint64 m_prefixKey;
+    /// \brief The sequence number of the profile currently advertised.
+    quint32 m_sequence;
+    /// \brief Timer measuring the time elapsed since the last profile sent.
+    QElapsedTimer m_profileTimer;
+    /// \brief Generator used to randomize the answers to solicitations.
+    std::minstd_rand m_random;
+
+    /// \brief The state of the hierarchical discovery.
+    QScopedPointer<SyfdAggregator> m_aggregator;
+    /// \brief The last profiles forwarded (indexed by UUID prefix).
+    QHash<quint64, ProfileEntry> m_profiles;
+
+    /// \brief The limiter protecting against datagram storms.
+    QScopedPointer<SyfdRateLimiter> m_rateLimiter;
+    /// \brief Timer measuring the time elapsed since the last drop warning.
+    QElapsedTimer m_dropLogTimer;
 
     /// \brief The number of errors occurred while sending datagrams.
     int m_errorCount;
@@ -0,0 +1,187 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "syfdratelimiter.hpp"
+
+///
+/// The instance is created with full buckets and all the counters set to zero.
+///
+SyfdRateLimiter::SyfdRateLimiter()
+        : m_lastPurge(0),
+          m_solicitationEnd(-1),
+          m_peers(0),
+          m_droppedBySource(0),
+          m_droppedGlobally(0)
+{
+    m_clock.start();
+    clear();
+}
+
+///
+/// A token is consumed from the bucket of the source (created full when the
+/// source is seen for the first time) and, only in case of success, from the
+/// global one. In case the number of sources tracked reaches maxSources(), the
+/// idle ones are discarded (at most once per PURGE_INTERVAL) and, if no room is
+/// made, the new source is bound to a shared bucket (which penalizes only the
+/// sources not already tracked). Within the window following a solicitation
+/// sent by the local host, neither the shared bucket nor the global one is
+/// enforced (the tokens available, if any, are still consumed).
+///
+bool SyfdRateLimiter::admit(quint32 source)
+{
+    qint64 now = m_clock.elapsed();
+    bool solicited = (now < m_solicitationEnd);
+
+    auto it = m_sources.find(source);
+    if (it == m_sources.end()) {
+        int max = maxSources();
+        if (m_sources.size() >= max &&
+            now - m_lastPurge >= SyfdRateLimiter::PURGE_INTERVAL) {
+            purge(now);
+        }
+        if (m_sources.size() < max) {
+            it = m_sources.insert(
+                source, fullBucket(SyfdRateLimiter::SOURCE_BURST, now));
+        }
+    }
+
+    Bucket &bucket = (it != m_sources.end()) ? it.value() : m_overflow;
+    if (!consume(bucket, SyfdRateLimiter::SOURCE_RATE,
+                 SyfdRateLimiter::SOURCE_BURST, now) &&
+        (it != m_sources.end() || !solicited)) {
+        m_droppedBySource.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    if (!consume(m_global, globalRate(), globalBurst(), now) && !solicited) {
+        m_droppedGlobally.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    return true;
+}
+
+///
+/// The state of the sources is discarded and all the buckets are refilled,
+/// while the drop counters are preserved.
+///
+void SyfdRateLimiter::clear()
+{
+    qint64 now = m_clock.elapsed();
+
+    m_sources.clear();
+    m_overflow = fullBucket(SyfdRateLimiter::SOURCE_BURST, now);
+    m_global = fullBucket(globalBurst(), now);
+    m_solicitationEnd = -1;
+}
+
+///
+/// In case the global burst grows, the additional tokens are made available
+/// immediately, as if the bucket had always been sized accordingly.
+///
+void SyfdRateLimiter::setPeers(int peers)
+{
+    int previous = globalBurst();
+    m_peers = qMax(0, peers);
+
+    int burst = globalBurst();
+    if (burst > previous) {
+        m_global.tokens += static_cast<qint64>(burst - previous) * 1000;
+    }
+}
+
+///
+/// The window is extended in case another one is already open.
+///
+void SyfdRateLimiter::solicitationSent(int window)
+{
+    m_solicitationEnd = qMax(m_solicitationEnd, m_clock.elapsed() + window);
+}
+
+///
+/// The bucket is refilled proportionally to the time elapsed since the last
+/// refill (up to its capacity) and then a token is consumed, if available.
+///
+bool SyfdRateLimiter::consume(Bucket &bucket, int rate, int burst, qint64 now)
+{
+    bucket.tokens = qMin(bucket.tokens + (now - bucket.lastRefill) * rate,
+                         static_cast<qint64>(burst) * 1000);
+    bucket.lastRefill = now;
+
+    if (bucket.tokens < 1000) {
+        return false;
+    }
+
+    bucket.tokens -= 1000;
+    return true;
+}
+
+///
+/// The bucket is created with all the tokens available.
+///
+SyfdRateLimiter::Bucket SyfdRateLimiter::fullBucket(int burst, qint64 now)
+{
+    Bucket bucket;
+    bucket.lastRefill = now;
+    bucket.tokens = static_cast<qint64>(burst) * 1000;
+    return bucket;
+}
+
+///
+/// A source is idle if its bucket would be full once refilled: in that case
+/// discarding it does not change the behavior, since it would be recreated
+/// full when the next datagram is received.
+///
+void SyfdRateLimiter::purge(qint64 now)
+{
+    const qint64 capacity =
+        static_cast<qint64>(SyfdRateLimiter::SOURCE_BURST) * 1000;
+
+    m_lastPurge = now;
+
+    auto it = m_sources.begin();
+    while (it != m_sources.end()) {
+        const Bucket &bucket = it.value();
+        if (bucket.tokens + (now - bucket.lastRefill) *
+                                SyfdRateLimiter::SOURCE_RATE >=
+            capacity) {
+            it = m_sources.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+int SyfdRateLimiter::globalRate() const
+{
+    return qMax(static_cast<int>(SyfdRateLimiter::GLOBAL_RATE),
+                m_peers * SyfdRateLimiter::PEER_RATE);
+}
+
+int SyfdRateLimiter::globalBurst() const
+{
+    return qMax(static_cast<int>(SyfdRateLimiter::GLOBAL_BURST),
+                m_peers * SyfdRateLimiter::PEER_BURST);
+}
+
+int SyfdRateLimiter::maxSources() const
+{
+    return qMax(static_cast<int>(SyfdRateLimiter::MAX_SOURCES),
+                m_peers * SyfdRateLimiter::PEER_SOURCES);
+}
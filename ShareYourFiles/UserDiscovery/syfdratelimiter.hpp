@@ -0,0 +1,186 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SYFDRATELIMITER_HPP
+#define SYFDRATELIMITER_HPP
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QHash>
+
+///
+/// \brief The SyfdRateLimiter class protects the SyfdProtocol from datagram
+/// storms by limiting the number of datagrams processed.
+///
+/// A misbehaving client, or a looped bridge that replays the announcements,
+/// may send datagrams at a rate that saturates the SYFD thread and floods the
+/// list of peers with updates. To prevent this, every datagram received must
+/// be admitted by two token buckets before being processed: the first one is
+/// specific to the source address, so that a single source exceeding its share
+/// does not affect the other ones, while the second one is global and caps the
+/// overall number of datagrams processed per second. Datagrams dropped by the
+/// per-source buckets do not consume global tokens, hence legitimate peers keep
+/// working while a storm is originated by a limited number of sources.
+///
+/// The rates are sized on the legitimate traffic: each peer sends a heartbeat
+/// every few seconds and a profile at most once per second, while the elected
+/// aggregator publishes a burst of digests every interval. Since that traffic
+/// grows with the number of peers, the global limits and the number of sources
+/// tracked separately are scaled with the number of peers known (see
+/// setPeers()), so that all the peers answering a solicitation (i.e. sending
+/// their profile within a short interval) are admitted. Moreover, while the
+/// roster is still being discovered (e.g. at startup), the answers to the
+/// solicitations sent by the local host are admitted regardless of the global
+/// limits for a short window (see solicitationSent()): only the per-source
+/// limits are enforced in the meanwhile.
+///
+/// This class is not thread-safe and it is meant to be used only by the
+/// SyfdProtocol instance owning it, with the exception of the drop counters
+/// that can be read from any thread.
+///
+class SyfdRateLimiter
+{
+public:
+    ///
+    /// \brief Constructs a new instance of the class.
+    ///
+    explicit SyfdRateLimiter();
+
+    ///
+    /// \brief Checks whether a datagram can be processed, consuming a token.
+    /// \param source the IPv4 address of the sender.
+    /// \return true if the datagram can be processed and false if it must be
+    /// dropped.
+    ///
+    bool admit(quint32 source);
+
+    ///
+    /// \brief Discards the state of all the sources.
+    ///
+    void clear();
+
+    ///
+    /// \brief Sets the number of peers known, used to scale the limits.
+    /// \param peers the number of peers known.
+    ///
+    void setPeers(int peers);
+
+    ///
+    /// \brief Notifies that a solicitation has been sent by the local host,
+    /// opening a window in which the global limits are not enforced.
+    /// \param window the duration of the window (ms).
+    ///
+    void solicitationSent(int window);
+
+    ///
+    /// \brief Returns the number of datagrams dropped by the per-source limit.
+    ///
+    quint32 droppedBySource() const { return m_droppedBySource.loadAcquire(); }
+
+    ///
+    /// \brief Returns the number of datagrams dropped by the global limit.
+    ///
+    quint32 droppedGlobally() const { return m_droppedGlobally.loadAcquire(); }
+
+    /// \brief Datagrams per second admitted for each source.
+    static const int SOURCE_RATE = 20;
+    /// \brief Maximum burst of datagrams admitted for each source.
+    static const int SOURCE_BURST = 100;
+    /// \brief Datagrams per second admitted overall (minimum value).
+    static const int GLOBAL_RATE = 2000;
+    /// \brief Maximum burst of datagrams admitted overall (minimum value).
+    static const int GLOBAL_BURST = 4000;
+    /// \brief Datagrams per second admitted overall for each known peer.
+    static const int PEER_RATE = 1;
+    /// \brief Maximum burst of datagrams admitted overall for each known peer.
+    static const int PEER_BURST = 2;
+    /// \brief Maximum number of sources tracked separately (minimum value).
+    static const int MAX_SOURCES = 1024;
+    /// \brief Sources tracked separately for each known peer.
+    static const int PEER_SOURCES = 2;
+
+private:
+    /// \brief Minimum interval between two purges of the idle sources (ms).
+    static const int PURGE_INTERVAL = 1000;
+
+    ///
+    /// \brief The Bucket struct represents a token bucket.
+    ///
+    /// Tokens are stored in thousandths, so that the refill can be computed
+    /// with integer arithmetic from the milliseconds elapsed.
+    ///
+    struct Bucket {
+        qint64 lastRefill; ///< \brief Time of the last refill (ms).
+        qint64 tokens;     ///< \brief Tokens available (thousandths).
+    };
+
+    ///
+    /// \brief Refills a bucket and tries to consume a token.
+    /// \param bucket the bucket to be used.
+    /// \param rate the refill rate (tokens per second).
+    /// \param burst the capacity of the bucket (tokens).
+    /// \param now the current time (ms).
+    /// \return true if a token has been consumed and false otherwise.
+    ///
+    static bool consume(Bucket &bucket, int rate, int burst, qint64 now);
+
+    ///
+    /// \brief Returns a full bucket.
+    /// \param burst the capacity of the bucket (tokens).
+    /// \param now the current time (ms).
+    ///
+    static Bucket fullBucket(int burst, qint64 now);
+
+    ///
+    /// \brief Removes the sources whose bucket would be full (i.e. idle).
+    /// \param now the current time (ms).
+    ///
+    void purge(qint64 now);
+
+    /// \brief Returns the global rate, scaled with the number of peers.
+    int globalRate() const;
+    /// \brief Returns the global burst, scaled with the number of peers.
+    int globalBurst() const;
+    /// \brief Returns the number of sources tracked separately, scaled with
+    /// the number of peers.
+    int maxSources() const;
+
+    /// \brief Clock used to refill the buckets.
+    QElapsedTimer m_clock;
+    /// \brief Time of the last purge of the idle sources (ms).
+    qint64 m_lastPurge;
+    /// \brief End of the window opened by the last solicitation sent (ms).
+    qint64 m_solicitationEnd;
+    /// \brief The number of peers known.
+    int m_peers;
+
+    /// \brief The buckets of the sources tracked separately.
+    QHash<quint32, Bucket> m_sources;
+    /// \brief The bucket shared by the sources exceeding MAX_SOURCES.
+    Bucket m_overflow;
+    /// \brief The bucket enforcing the global limit.
+    Bucket m_global;
+
+    /// \brief Number of datagrams dropped by the per-source limit.
+    QAtomicInteger<quint32> m_droppedBySource;
+    /// \brief Number of datagrams dropped by the global limit.
+    QAtomicInteger<quint32> m_droppedGlobally;
+};
+
+#endif // SYFDRATELIMITER_HPP
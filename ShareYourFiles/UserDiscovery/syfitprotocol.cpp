@@ -17,9 +17,7 @@
  */
 
 #include "syfitprotocol.hpp"
-#include "Common/common.hpp"
-
-#include <Logger.h>
+#include "Common/logging.hpp"
 
 #include <QHostAddress>
 #include <QTcpServer>
@@ -27,10 +25,6 @@
 #include <QTimer>
 #include <QtEndian>
 
-// Register UserIcon to the qt meta type system
-static MetaTypeRegistration<UserIcon> iconRegisterer("UserIcon");
-
-
 ///
 /// The constructor initializes the internal fields of the instance
 /// but does not actually start waiting for incoming requests.
@@ -142,16 +136,14 @@ void SyfitProtocolServer::serveClient()
 /// The instance is created by initializing the fields and connecting the
 /// slots in charge of handling the various events during the transfer.
 ///
-SyfitProtocolClient::SyfitProtocolClient(const QString &confPath,
-                                         const QString &uuid, QObject *parent)
+SyfitProtocolClient::SyfitProtocolClient(QObject *parent)
         : QObject(parent),
-          m_confPath(confPath),
-          m_uuid(uuid),
           m_socket(new QTcpSocket(this)),
-          m_expectedHash(new QByteArray()),
           m_serverAddress(0),
           m_serverPort(0),
+          m_expectedLength(0),
           m_buffer(new QByteArray()),
+          m_completed(false),
           m_timerTimeout(new QTimer(this))
 {
     // Connect to the handler for bytes ready to be read
@@ -164,52 +156,36 @@ SyfitProtocolClient::SyfitProtocolClient(const QString &confPath,
                 &QTcpSocket::error),
             this, [this]() { manageError(m_socket->errorString()); });
 
-    // Set up the timer to interrupt too long connections
+    // Set up the timer to interrupt too long connections (a whole second
+    // accuracy is sufficient and allows the system to coalesce the wakeups)
     m_timerTimeout->setSingleShot(true);
+    m_timerTimeout->setTimerType(Qt::VeryCoarseTimer);
     connect(m_timerTimeout, &QTimer::timeout, this,
             [this]() { manageError("timeout"); });
 }
 
 ///
-/// The method is in charge of receiving as parameters the data advertised
-/// through the SyfdDatagram regarding the icon and to request that icon
-/// to the SyfitProtocolServer. More in detail, the new parameters are
-/// compared to the cached ones: in case of equality the method just returns,
-/// while in case of difference they are updated and the connection is
-/// (re)started.
+/// The function attempts to start a new connection and then starts
+/// the timeout timer in order to prevent too long (e.g. due to server
+/// errors) connections.
 ///
-void SyfitProtocolClient::updateAndStart(quint32 serverAddress,
-                                         quint16 serverPort,
-                                         const QByteArray &iconHash)
+void SyfitProtocolClient::start(quint32 serverAddress, quint16 serverPort)
 {
-    // If some parameter changed
-    if (m_serverAddress != serverAddress || m_serverPort != serverPort ||
-        *m_expectedHash != iconHash) {
-
-        // Save the parameters
-        m_serverAddress = serverAddress;
-        m_serverPort = serverPort;
-        m_expectedHash->clear();
-        m_expectedHash->append(iconHash);
-
-        // Reset the retry time
-        m_retryTime = SyfitProtocolClient::INITIAL_RETRY_TIME;
-
-        // Stop the previous connection if running
-        abortConnection();
-
-        if (m_serverPort != SyfitProtocolServer::INVALID_PORT) {
-            // Start the connection
-            startConnection();
-        } else {
-            // The server has some problems
-            LOG_WARNING()
-                << "SyfitProtocolClient: impossible to start icon request "
-                   "(the server has some problems)"
-                << qUtf8Printable(m_uuid);
-            return;
-        }
-    }
+    LOG_ASSERT_X(m_serverPort == 0, "SyfitProtocolClient: already started");
+
+    m_serverAddress = serverAddress;
+    m_serverPort = serverPort;
+
+    LOG_INFO() << "SyfitProtocolClient: starting icon request to"
+               << qUtf8Printable(QHostAddress(m_serverAddress).toString())
+               << "@" << m_serverPort;
+
+    // Start the timeout timer
+    m_timerTimeout->start(SyfitProtocolClient::TIMEOUT);
+
+    // Connect to the server
+    m_socket->connectToHost(QHostAddress(m_serverAddress), m_serverPort,
+                            QTcpSocket::ReadOnly);
 }
 
 ///
@@ -217,13 +193,16 @@ void SyfitProtocolClient::updateAndStart(quint32 serverAddress,
 /// the server. Initially, if the expected icon length has not yet been set,
 /// the value is read and converted to host byte order; all the remaining
 /// bytes are then appended to the buffer until the expected length is
-/// reached. When the buffer is full, the data is used to try to build
-/// an UserIcon instance and, in case of success, the finished() signal is
-/// emitted. If an error occurs, on the other hand, the manageError() function
-/// is invoked.
+/// reached. When the buffer is full, the finished() signal is emitted with
+/// the data received. If an error occurs, on the other hand, the manageError()
+/// function is invoked.
 ///
 void SyfitProtocolClient::readData()
 {
+    if (m_completed) {
+        return;
+    }
+
     // Expected length still not read
     if (m_expectedLength == 0) {
 
@@ -241,8 +220,9 @@ void SyfitProtocolClient::readData()
         m_expectedLength = qFromLittleEndian(m_expectedLength);
 
         // Check if the obtained value is feasible
-        if (m_expectedLength > UserIcon::ICON_MAX_SIZE_BYTES) {
-            manageError("too big icon detected");
+        if (m_expectedLength == 0 ||
+            m_expectedLength > UserIcon::ICON_MAX_SIZE_BYTES) {
+            manageError("invalid icon length detected");
             return;
         }
 
@@ -258,74 +238,33 @@ void SyfitProtocolClient::readData()
     if (static_cast<quint32>(m_buffer->size()) == m_expectedLength) {
 
         // Close the connection and stop the timeout timer
+        m_completed = true;
         m_timerTimeout->stop();
         m_socket->disconnectFromHost();
 
-        // Try to build an user icon instance
-        UserIcon icon(m_confPath, m_uuid, *m_buffer, *m_expectedHash);
-
-        // In case of success, emit the finished signal
-        if (icon.set()) {
-            LOG_INFO() << "SyfitProtocolClient: icon request completed"
-                       << qUtf8Printable(m_uuid);
-            emit finished(icon);
-        }
-
-        // Otherwise, manage the error
-        else {
-            manageError("failed creating the UserIcon instance");
-        }
+        emit finished(*m_buffer);
     }
 }
 
 ///
 /// The function appends the error message to the log, aborts the
-/// connection and then starts a timer in charge of retrying the transfer
-/// after retry time milliseconds (doubled after any error).
+/// connection and emits the failed() signal.
 ///
 void SyfitProtocolClient::manageError(const QString &message)
 {
+    if (m_completed) {
+        return;
+    }
+
     LOG_WARNING() << "SyfitProtocolClient:" << message
-                  << "while requesting icon of" << qUtf8Printable(m_uuid);
+                  << "while requesting icon to"
+                  << qUtf8Printable(QHostAddress(m_serverAddress).toString())
+                  << "@" << m_serverPort;
 
     // Abort the faulty connection
-    abortConnection();
-
-    // Retry to request the icon after retryTime milliseconds
-    QTimer::singleShot(m_retryTime, this, [this]() { startConnection(); });
-    m_retryTime *= 2;
-}
-
-///
-/// The function attempts to start a new connection and then starts
-/// the timeout timer in order to prevent too long (e.g. due to server
-/// errors) connections.
-///
-void SyfitProtocolClient::startConnection()
-{
-    // Clear the buffer
-    m_expectedLength = 0;
-    m_buffer->clear();
-
-    LOG_INFO() << "SyfitProtocolClient: starting icon request"
-               << qUtf8Printable(m_uuid);
-
-    // Start the timeout timer
-    m_timerTimeout->start(SyfitProtocolClient::TIMEOUT);
-
-    // Connect to the server
-    m_socket->connectToHost(QHostAddress(m_serverAddress), m_serverPort,
-                            QTcpSocket::ReadOnly);
-}
-
-///
-/// The function aborts the current connection and stops the timeout timer.
-///
-void SyfitProtocolClient::abortConnection()
-{
-    // Stop the timeout timer
+    m_completed = true;
     m_timerTimeout->stop();
-
-    // Abort the connection
     m_socket->abort();
+
+    emit failed();
 }
@@ -101,10 +101,11 @@ private:
 /// The client side of the protocol works by attempting a connection to the
 /// SYFIT server specified; then, the expected length of the icon is initially
 /// read through the socket, followed by the stream of bytes representing the
-/// image. The received data is finally used to try to build a new UserIcon
-/// instance and, in case of success, the finished() signal is emitted. If an
-/// error occurs at any step, on the other hand, a timer is set to retry the
-/// request after the specified time, which doubles at every failure.
+/// image. When all the data has been received, the finished() signal is
+/// emitted, while the failed() one is emitted if an error occurs at any step.
+///
+/// Each instance performs a single request: the verification of the received
+/// data and the retries in case of error are managed by the SyfitScheduler.
 ///
 class SyfitProtocolClient : public QObject
 {
@@ -113,30 +114,28 @@ class SyfitProtocolClient : public QObject
 public:
     ///
     /// \brief Constructs a new instance of the client side SYFIT protocol.
-    /// \param confPath the base path where configuration files are stored.
-    /// \param uuid the UUID identifying the user.
     /// \param parent the parent of the current object.
     ///
-    explicit SyfitProtocolClient(const QString &confPath, const QString &uuid,
-                                 QObject *parent = Q_NULLPTR);
+    explicit SyfitProtocolClient(QObject *parent = Q_NULLPTR);
 
-public slots:
     ///
-    /// \brief Updates the cached fields and starts the connection if not yet
-    /// running.
+    /// \brief Starts the connection to the SYFIT server.
     /// \param serverAddress the IPv4 address of the SyfitProtocolServer.
     /// \param serverPort the TCP port of the SyfitProtocolServer.
-    /// \param iconHash the expected SHA-1 hash of the icon.
     ///
-    void updateAndStart(quint32 serverAddress, quint16 serverPort,
-                        const QByteArray &iconHash);
+    void start(quint32 serverAddress, quint16 serverPort);
 
 signals:
     ///
     /// \brief Signal emitted when the transfer terminates correctly.
-    /// \param icon The instance representing the transferred icon.
+    /// \param data the received data (not yet verified).
+    ///
+    void finished(QByteArray data);
+
+    ///
+    /// \brief Signal emitted when the transfer fails.
     ///
-    void finished(UserIcon icon);
+    void failed();
 
 private:
     ///
@@ -149,24 +148,9 @@ private:
     ///
     void manageError(const QString &message);
 
-    ///
-    /// \brief Starts a new connection to the SYFIT server.
-    ///
-    void startConnection();
-    ///
-    /// \brief Aborts the current connection.
-    ///
-    void abortConnection();
-
 private:
-    /// \brief The base path where configuration files are stored.
-    QString m_confPath;
-    QString m_uuid; ///< \brief The UUID identifying the user.
-
     /// \brief The socket used for the connection.
     QPointer<QTcpSocket> m_socket;
-    /// \brief The expected SHA-1 hash representing the icon.
-    QScopedPointer<QByteArray> m_expectedHash;
 
     /// \brief The IPv4 address of the SyfitProtocolServer.
     quint32 m_serverAddress;
@@ -175,17 +159,14 @@ private:
     quint32 m_expectedLength; ///< \brief The expected length of the icon.
     /// \brief The buffer storing the image data already read.
     QScopedPointer<QByteArray> m_buffer;
+    /// \brief Specifies whether the transfer already terminated or not.
+    bool m_completed;
 
     /// \brief The timer used to stop too long connections.
     QPointer<QTimer> m_timerTimeout;
-    /// \brief Time to be waited in case of error before retrying the
-    /// connection.
-    int m_retryTime;
 
     /// \brief Maximum duration of a connection (in ms).
     static const int TIMEOUT = 5000;
-    /// \brief Time to be waited in the case of the first error (in ms).
-    static const int INITIAL_RETRY_TIME = 15000;
 };
 
 #endif // SYFITPROTOCOL_HPP
@@ -0,0 +1,307 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "syfitscheduler.hpp"
+#include "Common/common.hpp"
+#include "Common/logging.hpp"
+#include "syfitprotocol.hpp"
+
+#include <QTimer>
+
+#include <iterator>
+
+// Register UserIcon to the qt meta type system
+static MetaTypeRegistration<UserIcon> iconRegisterer("UserIcon");
+
+
+///
+/// The instance is created by initializing the fields and setting up the timer
+/// used to start the requests whose retry time has elapsed.
+///
+SyfitScheduler::SyfitScheduler(const QString &confPath, QObject *parent)
+        : QObject(parent),
+          m_confPath(confPath),
+          m_running(0),
+          m_order(0),
+          m_timerSchedule(new QTimer(this)),
+          m_random(std::random_device()())
+{
+    m_clock.start();
+
+    m_timerSchedule->setSingleShot(true);
+    connect(m_timerSchedule, &QTimer::timeout, this, [this]() { schedule(); });
+}
+
+///
+/// The running clients are aborted, without notifying any result.
+///
+SyfitScheduler::~SyfitScheduler()
+{
+    for (auto it = m_jobs.begin(); it != m_jobs.end(); ++it) {
+        stopJob(it.value());
+    }
+}
+
+///
+/// The request is added to the one of the same icon if already present (e.g.
+/// requested by another peer), or a new one is created otherwise. In case the
+/// peer was waiting for a different icon, the previous request is cancelled.
+/// A change of the server resets the retry time, as done for new requests.
+///
+void SyfitScheduler::request(const QString &uuid, quint32 serverAddress,
+                             quint16 serverPort, const QByteArray &iconHash)
+{
+    if (serverPort == SyfitProtocolServer::INVALID_PORT) {
+        // The server has some problems
+        LOG_WARNING() << "SyfitScheduler: impossible to request the icon "
+                         "(the server has some problems)"
+                      << qUtf8Printable(uuid);
+        cancel(uuid);
+        return;
+    }
+
+    // The peer changed icon
+    auto request = m_requests.constFind(uuid);
+    if (request != m_requests.constEnd() && request.value() != iconHash) {
+        cancel(uuid);
+    }
+
+    // Get the request of the icon or create a new one
+    auto it = m_jobs.find(iconHash);
+    if (it == m_jobs.end()) {
+        Job job;
+        job.priority = false;
+        job.attempts = 0;
+        job.readyTime = m_clock.elapsed();
+        job.order = m_order++;
+        it = m_jobs.insert(iconHash, job);
+
+        LOG_INFO() << "SyfitScheduler: icon request queued"
+                   << qUtf8Printable(uuid);
+    }
+
+    Job &job = it.value();
+    auto waiter = job.waiters.constFind(uuid);
+    if (waiter == job.waiters.constEnd() ||
+        waiter.value().address != serverAddress ||
+        waiter.value().port != serverPort) {
+
+        job.waiters.insert(uuid, Server{serverAddress, serverPort});
+        if (job.client.isNull()) {
+            job.attempts = 0;
+            job.readyTime = m_clock.elapsed();
+        }
+    }
+
+    m_requests.insert(uuid, iconHash);
+    schedule();
+}
+
+///
+/// The peer is removed from the ones waiting for the icon: in case no other
+/// peer is waiting for it, the request is deleted (and the transfer aborted).
+///
+void SyfitScheduler::cancel(const QString &uuid)
+{
+    auto request = m_requests.find(uuid);
+    if (request == m_requests.end()) {
+        return;
+    }
+
+    auto it = m_jobs.find(request.value());
+    m_requests.erase(request);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    Job &job = it.value();
+    job.waiters.remove(uuid);
+    if (job.waiters.isEmpty()) {
+        stopJob(job);
+        m_jobs.erase(it);
+        schedule();
+    }
+}
+
+///
+/// The request remains prioritized until completed.
+///
+void SyfitScheduler::prioritize(const QString &uuid)
+{
+    auto request = m_requests.constFind(uuid);
+    if (request == m_requests.constEnd()) {
+        return;
+    }
+
+    auto it = m_jobs.find(request.value());
+    if (it != m_jobs.end() && !it.value().priority) {
+        it.value().priority = true;
+        schedule();
+    }
+}
+
+///
+/// The requests not running whose retry time has elapsed are started, giving
+/// precedence to the prioritized ones and then to the oldest ones, until the
+/// concurrency limit is reached. The scan is linear in the number of requests,
+/// which is negligible with respect to the cost of the transfers. In case
+/// some request is still waiting, the timer is set to its retry time.
+///
+void SyfitScheduler::schedule()
+{
+    qint64 now = m_clock.elapsed();
+
+    while (m_running < SyfitScheduler::MAX_CONCURRENT) {
+        auto best = m_jobs.end();
+        for (auto it = m_jobs.begin(); it != m_jobs.end(); ++it) {
+            const Job &job = it.value();
+            if (!job.client.isNull() || job.readyTime > now) {
+                continue;
+            }
+
+            if (best == m_jobs.end() || (job.priority && !best->priority) ||
+                (job.priority == best->priority && job.order < best->order)) {
+                best = it;
+            }
+        }
+
+        if (best == m_jobs.end()) {
+            break;
+        }
+        startJob(best.key(), best.value());
+    }
+
+    // Set the timer to the next retry time (if any)
+    qint64 next = -1;
+    if (m_running < SyfitScheduler::MAX_CONCURRENT) {
+        foreach (const Job &job, m_jobs) {
+            if (job.client.isNull() && (next < 0 || job.readyTime < next)) {
+                next = job.readyTime;
+            }
+        }
+    }
+
+    if (next >= 0) {
+        m_timerSchedule->start(static_cast<int>(qMax<qint64>(0, next - now)));
+    } else {
+        m_timerSchedule->stop();
+    }
+}
+
+///
+/// The server contacted is chosen in rotation among the ones of the peers
+/// waiting for the icon, so that a faulty peer does not prevent the others
+/// from being served.
+///
+void SyfitScheduler::startJob(const QByteArray &hash, Job &job)
+{
+    auto waiter = std::next(job.waiters.constBegin(),
+                            job.attempts % job.waiters.size());
+    LOG_INFO() << "SyfitScheduler: starting icon request"
+               << qUtf8Printable(waiter.key());
+
+    job.client = new SyfitProtocolClient(this);
+    connect(job.client, &SyfitProtocolClient::finished, this,
+            [this, hash](const QByteArray &data) { finishJob(hash, data); });
+    connect(job.client, &SyfitProtocolClient::failed, this,
+            [this, hash]() { finishJob(hash, QByteArray()); });
+
+    m_running++;
+    job.client->start(waiter.value().address, waiter.value().port);
+}
+
+///
+/// In case of success, the data received is used to build a single UserIcon
+/// instance (which verifies the hash, decodes the image and stores it), shared
+/// by all the peers waiting for it, and the fetched() signal is emitted for
+/// each of them. In case of error, or if the instance cannot be built, the
+/// request is rescheduled after the retry time.
+///
+void SyfitScheduler::finishJob(const QByteArray &hash, const QByteArray &data)
+{
+    auto it = m_jobs.find(hash);
+    if (it == m_jobs.end()) {
+        return;
+    }
+
+    Job &job = it.value();
+    stopJob(job);
+
+    // Build the icon once and assign it to all the peers waiting for it
+    if (!data.isEmpty()) {
+        UserIcon icon(m_confPath, job.waiters.firstKey(), data, hash);
+        if (icon.set()) {
+            foreach (const QString &uuid, job.waiters.keys()) {
+                LOG_INFO() << "SyfitScheduler: icon request completed"
+                           << qUtf8Printable(uuid);
+                emit fetched(uuid, icon);
+                m_requests.remove(uuid);
+            }
+            job.waiters.clear();
+        }
+    }
+
+    // Reschedule the request in case of error
+    if (job.waiters.isEmpty()) {
+        m_jobs.erase(it);
+    } else {
+        job.attempts++;
+        qint64 delay = retryDelay(job.attempts);
+        job.readyTime = m_clock.elapsed() + delay;
+
+        LOG_WARNING() << "SyfitScheduler: icon request failed, retrying in"
+                      << delay << "ms" << qUtf8Printable(job.waiters.firstKey());
+    }
+
+    schedule();
+}
+
+///
+/// The client is disconnected before being deleted, so that no further
+/// notifications are received.
+///
+void SyfitScheduler::stopJob(Job &job)
+{
+    if (job.client.isNull()) {
+        return;
+    }
+
+    job.client->disconnect(this);
+    job.client->deleteLater();
+    job.client.clear();
+    m_running--;
+}
+
+///
+/// The delay doubles at every failure up to MAX_RETRY_TIME, and a random value
+/// between its half and its full value is chosen, so that peers failing at the
+/// same time are not retried together.
+///
+qint64 SyfitScheduler::retryDelay(int attempts)
+{
+    qint64 delay = SyfitScheduler::INITIAL_RETRY_TIME;
+    for (int i = 1; i < attempts && delay < SyfitScheduler::MAX_RETRY_TIME;
+         i++) {
+        delay *= 2;
+    }
+    delay = qMin<qint64>(delay, SyfitScheduler::MAX_RETRY_TIME);
+
+    std::uniform_int_distribution<qint64> distribution(delay / 2, delay);
+    return distribution(m_random);
+}
@@ -0,0 +1,189 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SYFITSCHEDULER_HPP
+#define SYFITSCHEDULER_HPP
+
+#include "usericon.hpp"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+
+#include <random>
+
+class QTimer;
+class SyfitProtocolClient;
+
+///
+/// \brief The SyfitScheduler class coordinates the requests of the peers'
+/// icons through the SYFIT protocol.
+///
+/// Starting a SYFIT client for each peer advertising an unknown icon causes a
+/// burst of connections when many peers appear at the same time (e.g. at
+/// startup or after a network outage). The scheduler, instead, queues the
+/// requests and runs at most MAX_CONCURRENT transfers at the same time,
+/// serving first the peers currently displayed by the views (prioritize())
+/// and then the others in order of arrival.
+///
+/// The requests are grouped by icon hash: peers advertising the same icon are
+/// served by a single transfer, possibly retrieved from any of them. In case
+/// of error, the transfer is retried after a delay that doubles at every
+/// failure up to MAX_RETRY_TIME, randomized to avoid synchronized retries.
+///
+/// The instance is meant to be moved to the SYFD thread: the slots are to be
+/// invoked through queued connections, while the results are notified through
+/// the fetched() signal.
+///
+class SyfitScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief Constructs a new instance of the scheduler.
+    /// \param confPath the base path where configuration files are stored.
+    /// \param parent the parent of the current object.
+    ///
+    explicit SyfitScheduler(const QString &confPath,
+                            QObject *parent = Q_NULLPTR);
+
+    ///
+    /// \brief Aborts the running transfers and destroys the instance.
+    ///
+    ~SyfitScheduler();
+
+public slots:
+    ///
+    /// \brief Requests (or updates the request of) the icon of a peer.
+    /// \param uuid the UUID identifying the peer.
+    /// \param serverAddress the IPv4 address of the SyfitProtocolServer.
+    /// \param serverPort the TCP port of the SyfitProtocolServer.
+    /// \param iconHash the expected SHA-1 hash of the icon.
+    ///
+    void request(const QString &uuid, quint32 serverAddress,
+                 quint16 serverPort, const QByteArray &iconHash);
+
+    ///
+    /// \brief Cancels the request of the icon of a peer (if any).
+    /// \param uuid the UUID identifying the peer.
+    ///
+    void cancel(const QString &uuid);
+
+    ///
+    /// \brief Gives priority to the request of the icon of a peer (e.g.
+    /// because it is currently displayed).
+    /// \param uuid the UUID identifying the peer.
+    ///
+    void prioritize(const QString &uuid);
+
+signals:
+    ///
+    /// \brief Signal emitted when the icon of a peer has been retrieved.
+    /// \param uuid the UUID identifying the peer.
+    /// \param icon the instance representing the transferred icon.
+    ///
+    void fetched(QString uuid, UserIcon icon);
+
+private:
+    ///
+    /// \brief The Server struct represents the SYFIT server of a peer.
+    ///
+    struct Server {
+        quint32 address; ///< \brief The IPv4 address of the server.
+        quint16 port;    ///< \brief The TCP port of the server.
+    };
+
+    ///
+    /// \brief The Job struct represents the request of an icon.
+    ///
+    struct Job {
+        /// \brief The peers waiting for the icon, with their servers.
+        QMap<QString, Server> waiters;
+        /// \brief The client performing the transfer (if running).
+        QPointer<SyfitProtocolClient> client;
+        bool priority;    ///< \brief Whether the request has priority.
+        int attempts;     ///< \brief The number of failed attempts.
+        qint64 readyTime; ///< \brief When the request can be (re)started.
+        quint64 order;    ///< \brief The order of arrival of the request.
+    };
+
+    ///
+    /// \brief Starts the requests that are ready, within the concurrency
+    /// limit, and arms the timer for the next one.
+    ///
+    void schedule();
+
+    ///
+    /// \brief Starts the transfer associated to a request.
+    /// \param hash the SHA-1 hash of the requested icon.
+    /// \param job the request to be started.
+    ///
+    void startJob(const QByteArray &hash, Job &job);
+
+    ///
+    /// \brief Completes a transfer, either successfully or not.
+    /// \param hash the SHA-1 hash of the requested icon.
+    /// \param data the data received (empty in case of error).
+    ///
+    void finishJob(const QByteArray &hash, const QByteArray &data);
+
+    ///
+    /// \brief Stops the transfer associated to a request (if running).
+    /// \param job the request to be stopped.
+    ///
+    void stopJob(Job &job);
+
+    ///
+    /// \brief Computes the delay before retrying a failed request.
+    /// \param attempts the number of failed attempts.
+    /// \return the delay (in ms).
+    ///
+    qint64 retryDelay(int attempts);
+
+private:
+    /// \brief The base path where configuration files are stored.
+    QString m_confPath;
+
+    /// \brief The pending requests, grouped by icon hash.
+    QHash<QByteArray, Job> m_jobs;
+    /// \brief The hash of the icon requested by each peer.
+    QHash<QString, QByteArray> m_requests;
+
+    int m_running;   ///< \brief The number of transfers currently running.
+    quint64 m_order; ///< \brief The order assigned to the next request.
+
+    /// \brief The clock used to compute the retry times.
+    QElapsedTimer m_clock;
+    /// \brief The timer used to start the requests waiting for a retry.
+    QPointer<QTimer> m_timerSchedule;
+    /// \brief Generator used to randomize the retry times.
+    std::minstd_rand m_random;
+
+    /// \brief Maximum number of transfers running at the same time.
+    static const int MAX_CONCURRENT = 4;
+    /// \brief Time to be waited in the case of the first error (in ms).
+    static const int INITIAL_RETRY_TIME = 15000;
+    /// \brief Maximum time to be waited before retrying (in ms).
+    static const int MAX_RETRY_TIME = 600000;
+};
+
+#endif // SYFITSCHEDULER_HPP
@@ -18,18 +18,18 @@
 
 #include "user.hpp"
 #include "Common/common.hpp"
+#include "Common/logging.hpp"
 #include "Common/threadpool.hpp"
 #include "FileTransfer/syfftprotocolreceiver.hpp"
 #include "FileTransfer/syfftprotocolsender.hpp"
 #include "FileTransfer/syfftprotocolserver.hpp"
+#include "receptionpolicy.hpp"
 #include "syfddatagram.hpp"
 #include "syfitprotocol.hpp"
+#include "userstore.hpp"
 
-#include <Logger.h>
-
+#include <QDateTime>
 #include <QImage>
-#include <QJsonObject>
-#include <QRegularExpression>
 #include <QTimer>
 #include <QUuid>
 
@@ -59,43 +59,28 @@ static QString getUserName()
 }
 
 ///
-/// \brief Read the icon information from JSON and then try reading the icon
-/// itself.
+/// \brief Checks the icon hash read from a saved record and then tries reading
+/// the icon itself.
 /// \param confPath the base path where configuration files are stored.
 /// \param uuid the identifier of the user.
-/// \param json the JSON object containing information about the user.
+/// \param hash the SHA-1 hash of the icon.
+/// \param verify specifies whether the icon is immediately read or its
+/// verification is deferred.
 /// \return the instance representing the icon or an invalid instance.
 ///
-static UserIcon iconFromJson(const QString &confPath, const QString &uuid,
-                             const QJsonObject &json)
+static UserIcon iconFromRecord(const QString &confPath, const QString &uuid,
+                               const QByteArray &hash, bool verify)
 {
-    // Check if the icon hash is present
-    if (!json.contains("IconHash")) {
+    // Verify if the hash is valid
+    if (hash.length() != SyfdDatagram::HASH_LEN) {
         LOG_WARNING() << "User: icon set but missing or wrong hash - UUID:"
                       << qUtf8Printable(uuid);
         return UserIcon();
-    } else {
-
-        // Read the hash from the JSON object
-        QString strHash = json["IconHash"].toString("");
-        QRegularExpression hexMatcher(
-            "^[0-9A-F]*$", QRegularExpression::CaseInsensitiveOption);
-
-        // Verify if the string read is a valid hash
-        if (strHash.length() != SyfdDatagram::HASH_LEN * 2 ||
-            !hexMatcher.match(strHash).hasMatch()) {
-            LOG_WARNING() << "User: icon set but missing or wrong hash - UUID:"
-                          << qUtf8Printable(uuid);
-            return UserIcon();
-        }
-
-        // Extract the hash from the string
-        QByteArray iconHash =
-            QByteArray::fromHex(QByteArray(strHash.toLocal8Bit()));
-
-        // Try reading the icon and then return the obtained structure
-        return UserIcon(confPath, uuid, iconHash);
     }
+
+    // Try reading the icon and then return the obtained structure
+    return (verify) ? UserIcon(confPath, uuid, hash)
+                    : UserIcon::unverified(confPath, hash);
 }
 
 
@@ -105,43 +90,30 @@ static UserIcon iconFromJson(const QString &confPath, const QString &uuid,
 ///
 /// The function stores the persistent information (UUID, names,
 /// icon info, ...) contained in the current instance to the
-/// JSON object, in order to allow them to be saved for later retrieval.
+/// record, in order to allow them to be saved for later retrieval.
 ///
-/// \see LocalUser(const QString&, const QJsonObject&, quint32, QObject*)
-/// \see PeerUser(const QString&, const QJsonObject&, QObject*)
+/// \see LocalUser(const QString&, const QString&, const UserRecord&, quint32,
+/// QObject*)
+/// \see PeerUser(const QString&, const UserRecord&, const QString&, QObject*)
 ///
-void User::save(QJsonObject &json) const
+void User::save(UserRecord &record) const
 {
     if (!m_valid) {
         LOG_ERROR() << "User: trying to save an invalid instance";
         return;
     }
 
-    // Are you representing me?
-    json["Me"] = localUser();
-
     // UUID and names
-    json["UUID"] = m_info->m_uuid;
-    json["First"] = m_info->m_firstName;
-    json["Last"] = m_info->m_lastName;
+    record.uuid = m_info->m_uuid;
+    record.firstName = m_info->m_firstName;
+    record.lastName = m_info->m_lastName;
 
     // Image
-    json["Icon"] = m_info->m_icon.set();
-    if (m_info->m_icon.set()) {
-        json["IconHash"] = m_info->m_icon.hash().toHex().data();
-    }
+    record.iconHash =
+        (m_info->m_icon.set()) ? m_info->m_icon.hash() : QByteArray();
 
     // Reception preferences
-    bool useDefaults = m_info->m_preferences.useDefaults();
-    json["RP_UseDefaults"] = useDefaults;
-
-    if (!useDefaults) {
-        json["RP_Action"] =
-            qVariantFromValue(m_info->m_preferences.action()).toString();
-        json["RP_Path"] = m_info->m_preferences.path();
-        json["RP_FolderUser"] = m_info->m_preferences.folderUser();
-        json["RP_FolderDate"] = m_info->m_preferences.folderDate();
-    }
+    record.preferences = m_info->m_preferences;
 
     m_toBeSaved = false;
 }
@@ -157,34 +129,28 @@ User::User(const QString &confPath, QObject *parent)
 
 
 ///
-/// The instance is created by reading the data stored in the JSON object. In
-/// case the icon flag is set, it is checked if the cached version is present
-/// and in that case it is loaded.
+/// The instance is created by reading the data stored in the record. In case
+/// the icon hash is set, it is checked if the cached version is present and in
+/// that case it is loaded; for the peers, this check is deferred to the first
+/// time the icon is displayed, to avoid reading all of them at startup.
 ///
-/// \see save(QJsonObject&) const
+/// \see save(UserRecord&) const
 ///
-User::User(const QString &confPath, const QJsonObject &json, QObject *parent)
+User::User(const QString &confPath, const UserRecord &record, bool local,
+           QObject *parent)
         : User(confPath, parent)
 {
     m_toBeSaved = false;
 
-    // Check if the object contains the mandatory fields
-    if (!json.contains("UUID") || !json.contains("First") ||
-        !json.contains("Last")) {
-        LOG_WARNING() << "User: the json object does not contain the mandatory"
-                         " fields or they are wrong";
-        return;
-    }
-
     // Load UUID and names
-    QString uuid = json["UUID"].toString();
-    QString firstName = json["First"].toString();
-    QString lastName = json["Last"].toString();
+    QString uuid = record.uuid;
+    QString firstName = record.firstName;
+    QString lastName = record.lastName;
 
     // Check if they are valid according to the SyfdDatagram specifications
     if (QUuid(uuid).isNull() || firstName.length() > SyfdDatagram::STRING_LEN ||
         lastName.length() > SyfdDatagram::STRING_LEN) {
-        LOG_WARNING() << "User: the json object does not contain the mandatory"
+        LOG_WARNING() << "User: the record does not contain the mandatory"
                          " fields or they are wrong";
         return;
     }
@@ -193,18 +159,17 @@ User::User(const QString &confPath, const QJsonObject &json, QObject *parent)
         firstName = User::NO_NAME;
     }
 
-    // Check if it represents the local user and set the age accordingly
-    bool me = json["Me"].toBool(false);
-    m_age = (me) ? User::Age::AgeInfinity : User::Age::AgeUnconfirmed;
+    // Set the age according to the type of user
+    m_age = (local) ? User::Age::AgeInfinity : User::Age::AgeUnconfirmed;
 
     // User icon
     UserIcon icon;
 
     // Check if the icon is set
-    if (json["Icon"].toBool(false)) {
+    if (!record.iconHash.isEmpty()) {
 
-        // Get the icon
-        icon = iconFromJson(confPath, uuid, json);
+        // Get the icon (the ones of the peers are verified only when needed)
+        icon = iconFromRecord(confPath, uuid, record.iconHash, local);
 
         // If the icon was not read correctly, remove the information
         if (!icon.set()) {
@@ -212,30 +177,10 @@ User::User(const QString &confPath, const QJsonObject &json, QObject *parent)
         }
     }
 
-    // Check if the reception preferences should use the default values
-    ReceptionPreferences preferences;
-    bool useDefaults = json["RP_UseDefaults"].toBool(true) ||
-                       !json.contains("RP_Action") || !json.contains("RP_Path");
-
-    // Otherwise read the values from the JSON document
-    if (!useDefaults) {
-        // Try to read the action to be taken
-        ReceptionPreferences::Action action = ReceptionPreferences::Action::Ask;
-        QVariant vaction = json["RP_Action"].toVariant();
-        if (vaction.canConvert<ReceptionPreferences::Action>()) {
-            action = vaction.value<ReceptionPreferences::Action>();
-        }
-
-        // Build the object
-        preferences = ReceptionPreferences(action, json["RP_Path"].toString(),
-                                           json["RP_FolderUser"].toBool(false),
-                                           json["RP_FolderDate"].toBool(false));
-    }
-
     // Create a new instance of UserInfo filled with the data
-    // obtained from the JSON object
-    m_info.reset(
-        new UserInfo(uuid, firstName, lastName, 0, 0, 0, icon, preferences));
+    // obtained from the record
+    m_info.reset(new UserInfo(uuid, firstName, lastName, 0, 0, 0, icon,
+                              record.preferences));
 
     m_valid = true;
 }
@@ -249,16 +194,18 @@ User::User(const QString &confPath, const QJsonObject &json, QObject *parent)
 /// identifying the user is randomly generated, the first name is obtained by
 /// the username and the icon is set to be empty.
 ///
+/// The address may be null (e.g. while the network entries are still being
+/// enumerated at startup): the instance stays offline and no server is started
+/// until a valid address is set through updateLocalAddress().
+///
 LocalUser::LocalUser(const QString &confPath, const QString &dataPath,
                      quint32 ipv4Address, QObject *parent)
         : User(confPath, parent),
           m_dataPath(dataPath),
-          m_mode(Enums::OperationalMode::Offline)
+          m_mode(Enums::OperationalMode::Offline),
+          m_aggregator(false),
+          m_receptionPolicy(new ReceptionPolicy())
 {
-    LOG_ASSERT_X(
-        ipv4Address != 0,
-        "LocalUser: it is necessary to specify a not null IPv4 address");
-
     m_valid = true;
     m_toBeSaved = true;
 
@@ -272,6 +219,7 @@ LocalUser::LocalUser(const QString &confPath, const QString &dataPath,
                      ipv4Address, 0, 0,        // Address and unknown ports
                      UserIcon(),               // Not set icon
                      ReceptionPreferences(dataPath))); // Reception preferences
+    m_receptionPolicy->setDefaults(m_info->m_preferences);
 
     // Set the invalid data port
     m_info->m_dataPort = SyfftProtocolServer::INVALID_PORT;
@@ -282,30 +230,25 @@ LocalUser::LocalUser(const QString &confPath, const QString &dataPath,
 }
 
 ///
-/// The instance is created by reading the data stored in the JSON object as
-/// done by the User constructor.
+/// The instance is created by reading the data stored in the record as done by
+/// the User constructor. As for the other constructor, the address may be null
+/// until updateLocalAddress() is executed.
 ///
-/// \see User(const QString&, const QJsonObject&, QObject*)
+/// \see User(const QString&, const UserRecord&, bool, QObject*)
 ///
 LocalUser::LocalUser(const QString &confPath, const QString &dataPath,
-                     const QJsonObject &json, quint32 ipv4Address,
+                     const UserRecord &record, quint32 ipv4Address,
                      QObject *parent)
-        : User(confPath, json, parent),
+        : User(confPath, record, true, parent),
           m_dataPath(dataPath),
-          m_mode(Enums::OperationalMode::Offline)
+          m_mode(Enums::OperationalMode::Offline),
+          m_aggregator(record.aggregator),
+          m_receptionPolicy(new ReceptionPolicy())
 {
     // In case of invalid instance return
     if (!m_valid) {
         return;
     }
-    m_valid = false;
-
-    // Check if the generated instance represents a local user
-    if (!localUser()) {
-        LOG_ERROR("LocalUser: expected instance representing a local user "
-                  "but got a peer");
-        return;
-    }
 
     // Set the addresses
     m_info->m_ipv4Address = ipv4Address;
@@ -318,8 +261,7 @@ LocalUser::LocalUser(const QString &confPath, const QString &dataPath,
         m_info->m_preferences = ReceptionPreferences(dataPath);
         m_toBeSaved = true;
     }
-
-    m_valid = true;
+    m_receptionPolicy->setDefaults(m_info->m_preferences);
 }
 
 ///
@@ -332,6 +274,18 @@ LocalUser::~LocalUser()
     stopSyfitProtocolServer();
 }
 
+///
+/// The function saves the information common to all the users and then adds
+/// the settings specific to the local one.
+///
+/// \see User::save(UserRecord&) const
+///
+void LocalUser::save(UserRecord &record) const
+{
+    User::save(record);
+    record.aggregator = m_aggregator;
+}
+
 ///
 /// Every user of Share Your Files is identified univocally by a UUID, which
 /// is generated randomly. This method allows to avoid the necessity of
@@ -461,7 +415,8 @@ bool LocalUser::setIcon(const QImage &icon)
 ///
 /// The function copies the specified preferences to the UserInfo instance
 /// for later retrieval. In case useDefaults is set, a new ReceptionPreferences
-/// is created from default values. Finally the updated signal is emitted.
+/// is created from default values. The snapshot shared with the receivers is
+/// then updated and, finally, the updated signal is emitted.
 ///
 void LocalUser::setReceptionPreferences(const ReceptionPreferences &preferences)
 {
@@ -474,6 +429,7 @@ void LocalUser::setReceptionPreferences(const ReceptionPreferences &preferences)
     else {
         m_info->m_preferences = preferences;
     }
+    m_receptionPolicy->setDefaults(m_info->m_preferences);
 
     m_toBeSaved = true;
     emit updated();
@@ -562,6 +518,26 @@ void LocalUser::updateLocalAddress(quint32 ipv4Address)
 }
 
 
+///
+/// The function enables or disables the aggregator capability of the local
+/// host, used by the hierarchical discovery on large LANs. In case the value
+/// changes, the aggregatorChanged() and updated() signals are emitted.
+///
+void LocalUser::setAggregator(bool aggregator)
+{
+    if (m_aggregator == aggregator) {
+        return;
+    }
+
+    m_aggregator = aggregator;
+    LOG_INFO() << "LocalUser: aggregator capability"
+               << (aggregator ? "enabled" : "disabled");
+
+    m_toBeSaved = true;
+    emit aggregatorChanged(aggregator);
+    emit updated();
+}
+
 ///
 /// The server is started by creating a new instance of the
 /// SyfftProtocolServer and starting it: the selected local
@@ -579,7 +555,8 @@ void LocalUser::startSyfftProtocolServer()
     }
 
     // Create a new instance of the server
-    m_syfftServer = new SyfftProtocolServer(m_info->m_uuid);
+    m_syfftServer =
+        new SyfftProtocolServer(m_info->m_uuid, m_receptionPolicy);
     // Retrigger the connectionRequested signal
     connect(m_syfftServer, &SyfftProtocolServer::connectionRequested, this,
             &LocalUser::connectionRequested);
@@ -657,7 +634,10 @@ void LocalUser::stopSyfitProtocolServer()
 ///
 PeerUser::PeerUser(const QString &confPath, const SyfdDatagram &datagram,
                    const QString &localUuid, QObject *parent)
-        : User(confPath, parent), m_localUuid(localUuid)
+        : User(confPath, parent),
+          m_localUuid(localUuid),
+          m_sequence(datagram.sequence()),
+          m_lastSeen(QDateTime::currentMSecsSinceEpoch())
 {
     m_valid = datagram.valid();
     LOG_ASSERT_X(datagram.valid(), "PeerUser: trying to create a user instance"
@@ -684,30 +664,38 @@ PeerUser::PeerUser(const QString &confPath, const SyfdDatagram &datagram,
 }
 
 ///
-/// The instance is created by reading the data stored in the JSON object as
-/// done by the User constructor. The instance set as expired and it will need
-/// to be refreshed by a datagram before being considered confirmed.
+/// The instance is created by reading the data stored in the record as done by
+/// the User constructor. The instance set as expired and it will need to be
+/// refreshed by a datagram before being considered confirmed.
 ///
-/// \see User(const QString&, const QJsonObject&, QObject*)
+/// \see User(const QString&, const UserRecord&, bool, QObject*)
 ///
-PeerUser::PeerUser(const QString &confPath, const QJsonObject &json,
+PeerUser::PeerUser(const QString &confPath, const UserRecord &record,
                    const QString &localUuid, QObject *parent)
-        : User(confPath, json, parent), m_localUuid(localUuid)
+        : User(confPath, record, false, parent),
+          m_localUuid(localUuid),
+          m_sequence(0),
+          m_lastSeen(record.lastSeen)
 {
-    // Check if the generated instance represents a peer
-    if (m_valid && localUser()) {
-        LOG_ERROR("PeerUser: expected instance representing a peer "
-                  "but got a local user");
-        m_valid = false;
-        return;
-    }
 }
 
 ///
-/// The instance is destroyed by terminating the SYFIT protocol instance
-/// (if running), and letting the destructors to complete the job.
+/// The instance is destroyed by cancelling the request of the icon (if
+/// pending), and letting the destructors to complete the job.
+///
+PeerUser::~PeerUser() { cancelIconRequest(); }
+
+///
+/// The function saves the information common to all the users and then adds
+/// the last time the peer has been seen.
+///
+/// \see User::save(UserRecord&) const
 ///
-PeerUser::~PeerUser() { stopSyfitProtocolClient(); }
+void PeerUser::save(UserRecord &record) const
+{
+    User::save(record);
+    record.lastSeen = m_lastSeen;
+}
 
 ///
 /// Every time this function is executed, the age associated to the user
@@ -723,6 +711,7 @@ bool PeerUser::incrementAge()
 
     if (++m_age > User::Age::AgeMax) {
         m_age = User::Age::AgeUnconfirmed;
+        cancelIconRequest();
         emit updated();
         return true;
     }
@@ -739,6 +728,7 @@ bool PeerUser::setUnconfirmed()
 {
     if (m_age != User::Age::AgeUnconfirmed) {
         m_age = User::Age::AgeUnconfirmed;
+        cancelIconRequest();
         emit updated();
         return true;
     } else {
@@ -769,6 +759,8 @@ bool PeerUser::update(const SyfdDatagram &datagram)
 
     bool updatedFlag = (m_age == User::Age::AgeUnconfirmed);
     m_age = 0;
+    m_sequence = datagram.sequence();
+    touch();
 
     // Names
     if (m_info->m_firstName != datagram.firstName() ||
@@ -807,6 +799,80 @@ bool PeerUser::update(const SyfdDatagram &datagram)
     return updatedFlag;
 }
 
+///
+/// The function is executed when a heartbeat advertising the current user is
+/// received: in case the instance is confirmed and the sequence number matches
+/// the one of the last profile received, the cached information is still
+/// valid and the age is reset to zero. Otherwise (e.g. the profile changed and
+/// the datagram carrying it was lost) false is returned, to let the caller
+/// request the updated profile.
+///
+bool PeerUser::refresh(quint32 sequence)
+{
+    LOG_ASSERT_X(m_valid, "PeerUser: trying to refresh an invalid instance");
+
+    if (m_age == User::Age::AgeUnconfirmed || m_sequence != sequence) {
+        return false;
+    }
+
+    m_age = 0;
+    touch();
+    return true;
+}
+
+///
+/// The function is executed when the background loading of an unverified icon
+/// completes: in case the icon has not been changed in the meanwhile, it is
+/// marked as verified or, in case of error, it is discarded and requested again
+/// to the peer (if currently advertised). The updatedIcon() signal is emitted
+/// in both cases, to let the views refresh.
+///
+void PeerUser::iconLoaded(const QByteArray &hash, bool success)
+{
+    const UserIcon &icon = m_info->m_icon;
+    if (!icon.set() || icon.verified() || icon.hash() != hash) {
+        return;
+    }
+
+    if (success) {
+        m_info->m_icon.setVerified();
+    } else {
+        m_info->m_icon = UserIcon();
+        m_toBeSaved = true;
+
+        // Request the icon again if the peer is active and advertises it
+        if (m_age != User::Age::AgeUnconfirmed && m_info->m_iconPort != 0) {
+            requestIcon(hash);
+        }
+    }
+
+    LOG_INFO() << "PeerUser:" << qUtf8Printable(m_info->m_uuid)
+               << "updated (icon loaded)";
+    emit updatedIcon();
+}
+
+///
+/// The icon is set only in case it corresponds to the one currently requested
+/// (otherwise the peer changed it in the meanwhile and a new request is
+/// already pending).
+///
+void PeerUser::iconFetched(const UserIcon &icon)
+{
+    if (m_iconRequest.isEmpty() || icon.hash() != m_iconRequest) {
+        return;
+    }
+
+    // Set the new icon and complete the request
+    m_info->m_icon = icon;
+    m_iconRequest.clear();
+
+    // Emit the updated signal
+    LOG_INFO() << "PeerUser:" << qUtf8Printable(m_info->m_uuid)
+               << "updated (icon)";
+    m_toBeSaved = true;
+    emit updatedIcon();
+}
+
 ///
 /// The function copies the specified preferences to the UserInfo instance
 /// for later retrieval and then emits the updated signal.
@@ -861,23 +927,23 @@ PeerUser::newSyfftInstance(bool anonymous) const
 ///
 /// The method is in charge, given the data stored in the SyfdDatagram received,
 /// to update accordingly the icon information: mainly, in case of a new icon
-/// detected, the SyfitProtocolClient is started to perform the actual request.
+/// detected, the request is forwarded to the SyfitScheduler.
 ///
 void PeerUser::updatePeerIcon(bool iconSet, const QByteArray &hash)
 {
     // Datagram advertising icon set
     if (iconSet) {
 
-        // If the icon chached locally is not correct, start the SYFIT client
+        // If the icon chached locally is not correct, request it
         if (!m_info->m_icon.set() || m_info->m_icon.hash() != hash) {
-            startSyfitProtocolClient(hash);
+            requestIcon(hash);
         }
     }
 
     // Datagram advertising icon not set
     else {
-        // Stop the SYFIT client if running
-        stopSyfitProtocolClient();
+        // Cancel the request if pending
+        cancelIconRequest();
 
         // Delete the cached icon if set
         if (m_info->m_icon.set()) {
@@ -892,55 +958,39 @@ void PeerUser::updatePeerIcon(bool iconSet, const QByteArray &hash)
 }
 
 ///
-/// The method is in charge to create a new instance of the SyfitProtocolClient
-/// to request the user icon (if not already available) and to update the icon
-/// data used by the client for the request.
+/// The request is recorded and notified through the iconRequested() signal,
+/// which is connected to the SyfitScheduler by the PeersList: the scheduler
+/// takes care of updating the request in case it is already pending.
 ///
-void PeerUser::startSyfitProtocolClient(const QByteArray &hash)
+void PeerUser::requestIcon(const QByteArray &hash)
 {
-    // If the client is not already running
-    if (m_syfitClient.isNull()) {
-
-        // Create a new instance of the client
-        m_syfitClient = new SyfitProtocolClient(m_confPath, m_info->m_uuid);
-        // Move it to the SYFD thread
-        m_syfitClient->moveToThread(ThreadPool::syfdThread());
-
-        // Connect the signal to be executed when the SYFIT protocol client
-        // finishes
-        connect(m_syfitClient, &SyfitProtocolClient::finished, this,
-                [this](UserIcon icon) {
-
-                    // Set the new icon and stop the protocol
-                    m_info->m_icon = icon;
-                    stopSyfitProtocolClient();
+    m_iconRequest = hash;
+    emit iconRequested(m_info->m_uuid, m_info->m_ipv4Address,
+                       m_info->m_iconPort, hash);
+}
 
-                    // Emit the updated signal
-                    LOG_INFO() << "PeerUser:" << qUtf8Printable(m_info->m_uuid)
-                               << "updated (icon)";
-                    m_toBeSaved = true;
-                    emit updatedIcon();
-                });
+///
+/// The cancellation is notified through the iconRequestCancelled() signal.
+///
+void PeerUser::cancelIconRequest()
+{
+    if (!m_iconRequest.isEmpty()) {
+        m_iconRequest.clear();
+        emit iconRequestCancelled(m_info->m_uuid);
     }
-
-    // Update the fields stored by the client instance and start the protocol
-    // if not yet running. The invokeMethod function guarantees that the
-    // method is executed in a thread-safe manner (posted to the client's
-    // event loop)
-    bool result = QMetaObject::invokeMethod(
-        m_syfitClient.data(), "updateAndStart",
-        Q_ARG(quint32, m_info->m_ipv4Address),
-        Q_ARG(quint16, m_info->m_iconPort), Q_ARG(QByteArray, hash));
-    LOG_ASSERT_X(result, "PeerUser: failed invoking the updateAndStart method");
 }
 
 ///
-/// The client is stopped by deleting the instance of the SyfitProtocolClient.
+/// The time is updated (and the instance marked to be saved) only in case at
+/// least LAST_SEEN_RESOLUTION elapsed since the last update: this is enough to
+/// expire the peers not seen for long, without saving them at every datagram
+/// received.
 ///
-void PeerUser::stopSyfitProtocolClient()
+void PeerUser::touch()
 {
-    if (!m_syfitClient.isNull()) {
-        m_syfitClient->deleteLater();
-        m_syfitClient.clear();
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - m_lastSeen >= PeerUser::LAST_SEEN_RESOLUTION) {
+        m_lastSeen = now;
+        m_toBeSaved = true;
     }
 }
@@ -26,14 +26,13 @@
 #include <QObject>
 #include <QPointer>
 
-class QJsonObject;
-
+class ReceptionPolicy;
 class SyfdDatagram;
 class SyfftProtocolReceiver;
 class SyfftProtocolSender;
 class SyfftProtocolServer;
 class SyfitProtocolServer;
-class SyfitProtocolClient;
+struct UserRecord;
 
 ///
 /// \brief The User class represents an abstract user of Share Your Files.
@@ -104,10 +103,10 @@ public:
     bool localUser() const { return m_age == User::Age::AgeInfinity; }
 
     ///
-    /// \brief Saves the main information to the JSON object.
-    /// \param json the object where data is added.
+    /// \brief Saves the main information to the record.
+    /// \param record the record where data is added.
     ///
-    void save(QJsonObject &json) const;
+    virtual void save(UserRecord &record) const;
 
     ///
     /// \brief Sets the reception preferences for the current user.
@@ -133,14 +132,15 @@ protected:
     explicit User(const QString &confPath, QObject *parent = Q_NULLPTR);
 
     ///
-    /// \brief Common initialization to create a user instance from a JSON
-    /// object.
+    /// \brief Common initialization to create a user instance from a saved
+    /// record.
     /// \param confPath the base path where configuration files are stored.
-    /// \param json the JSON object containing information about the user.
+    /// \param record the record containing information about the user.
+    /// \param local specifies whether the record represents the local user.
     /// \param parent the parent of the current object.
     ///
-    explicit User(const QString &confPath, const QJsonObject &json,
-                  QObject *parent = Q_NULLPTR);
+    explicit User(const QString &confPath, const UserRecord &record,
+                  bool local, QObject *parent = Q_NULLPTR);
 
 protected:
     ///
@@ -188,23 +188,23 @@ public:
     /// \brief A new instance representing the local user is created.
     /// \param confPath the base path where configuration files are stored.
     /// \param dataPath the default path where received files are stored.
-    /// \param ipv4Address the address chosen to be used.
+    /// \param ipv4Address the address chosen to be used (0 if not yet known).
     /// \param parent the parent of the current object.
     ///
     explicit LocalUser(const QString &confPath, const QString &dataPath,
                        quint32 ipv4Address, QObject *parent = Q_NULLPTR);
 
     ///
-    /// \brief A new instance representing a local user is created from a JSON
-    /// object.
+    /// \brief A new instance representing a local user is created from a saved
+    /// record.
     /// \param confPath the base path where configuration files are stored.
     /// \param dataPath the default path where received files are stored.
-    /// \param json the JSON object containing information about the user.
-    /// \param ipv4Address the address chosen to be used.
+    /// \param record the record containing information about the user.
+    /// \param ipv4Address the address chosen to be used (0 if not yet known).
     /// \param parent the parent of the current object.
     ///
     explicit LocalUser(const QString &confPath, const QString &dataPath,
-                       const QJsonObject &json, quint32 ipv4Address,
+                       const UserRecord &record, quint32 ipv4Address,
                        QObject *parent = Q_NULLPTR);
 
     ///
@@ -212,6 +212,12 @@ public:
     ///
     ~LocalUser();
 
+    ///
+    /// \brief Saves the main information to the record.
+    /// \param record the record where data is added.
+    ///
+    void save(UserRecord &record) const override;
+
     ///
     /// \brief Generates a new UUID.
     /// \param usedUuids the list of UUIDs used by the peers.
@@ -257,6 +263,26 @@ public:
     ///
     void updateLocalAddress(quint32 ipv4Address);
 
+    ///
+    /// \brief Sets whether the local host can act as discovery aggregator.
+    /// \param aggregator the value to be set.
+    ///
+    void setAggregator(bool aggregator);
+
+    ///
+    /// \brief Returns whether the local host can act as discovery aggregator.
+    ///
+    bool aggregator() const { return m_aggregator; }
+
+    ///
+    /// \brief Returns the snapshot of the reception preferences, shared with
+    /// the instances receiving the files.
+    ///
+    QSharedPointer<ReceptionPolicy> receptionPolicy() const
+    {
+        return m_receptionPolicy;
+    }
+
 signals:
     ///
     /// \brief Signal emitted when the names of the user changes.
@@ -269,6 +295,12 @@ signals:
     ///
     void modeChanged(Enums::OperationalMode mode);
 
+    ///
+    /// \brief Signal emitted when the aggregator capability changes.
+    /// \param aggregator the new value.
+    ///
+    void aggregatorChanged(bool aggregator);
+
     ///
     /// \brief Signal emitted when a new connection is attempted by a peer.
     /// \param receiver the receiver instance associated with the connection.
@@ -305,6 +337,12 @@ private:
 
     QString m_dataPath;            ///< \brief The default data path.
     Enums::OperationalMode m_mode; ///< \brief The current operation mode.
+
+    /// \brief Specifies whether the local host can act as aggregator.
+    bool m_aggregator;
+
+    /// \brief The snapshot of the reception preferences.
+    QSharedPointer<ReceptionPolicy> m_receptionPolicy;
 };
 
 
@@ -334,13 +372,14 @@ public:
                       const QString &localUuid, QObject *parent = Q_NULLPTR);
 
     ///
-    /// \brief A new instance representing a peer is created from a JSON object.
+    /// \brief A new instance representing a peer is created from a saved
+    /// record.
     /// \param confPath the base path where configuration files are stored.
-    /// \param json the JSON object containing information about the user.
+    /// \param record the record containing information about the user.
     /// \param localUuid the identifier of the local user.
     /// \param parent the parent of the current object.
     ///
-    explicit PeerUser(const QString &confPath, const QJsonObject &json,
+    explicit PeerUser(const QString &confPath, const UserRecord &record,
                       const QString &localUuid, QObject *parent = Q_NULLPTR);
 
     ///
@@ -348,6 +387,12 @@ public:
     ///
     ~PeerUser();
 
+    ///
+    /// \brief Saves the main information to the record.
+    /// \param record the record where data is added.
+    ///
+    void save(UserRecord &record) const override;
+
     ///
     /// \brief Increments the age of the current instance.
     /// \return true in case of expiration and false otherwise.
@@ -367,6 +412,34 @@ public:
     ///
     bool update(const SyfdDatagram &datagram);
 
+    ///
+    /// \brief Confirms the presence of the user given a heartbeat.
+    /// \param sequence the profile sequence number advertised by the
+    /// heartbeat.
+    /// \return true in case the cached profile is up to date (and the age is
+    /// reset) and false if the full profile has to be requested.
+    ///
+    bool refresh(quint32 sequence);
+
+    ///
+    /// \brief Completes the verification of an icon loaded in background.
+    /// \param hash the SHA-1 hash of the icon loaded.
+    /// \param success specifies whether the icon has been read correctly.
+    ///
+    void iconLoaded(const QByteArray &hash, bool success);
+
+    ///
+    /// \brief Sets the icon retrieved through the SYFIT protocol.
+    /// \param icon the instance representing the transferred icon.
+    ///
+    void iconFetched(const UserIcon &icon);
+
+    ///
+    /// \brief Returns the SHA-1 hash of the icon currently being requested
+    /// (empty if no request is pending).
+    ///
+    const QByteArray &iconRequest() const { return m_iconRequest; }
+
     ///
     /// \brief Returns whether the instance is related to an expired user or
     /// not.
@@ -393,6 +466,24 @@ public:
     ///
     QSharedPointer<SyfftProtocolSender> newSyfftInstance(bool anonymous) const;
 
+signals:
+    ///
+    /// \brief Signal emitted when the icon of the user needs to be requested
+    /// (see SyfitScheduler::request()).
+    /// \param uuid the UUID identifying the user.
+    /// \param serverAddress the IPv4 address of the SyfitProtocolServer.
+    /// \param serverPort the TCP port of the SyfitProtocolServer.
+    /// \param iconHash the expected SHA-1 hash of the icon.
+    ///
+    void iconRequested(QString uuid, quint32 serverAddress, quint16 serverPort,
+                       QByteArray iconHash);
+
+    ///
+    /// \brief Signal emitted when the icon of the user is no longer needed.
+    /// \param uuid the UUID identifying the user.
+    ///
+    void iconRequestCancelled(QString uuid);
+
 private:
     ///
     /// \brief Manages the update of icon information.
@@ -403,21 +494,37 @@ private:
     void updatePeerIcon(bool iconSet, const QByteArray &hash);
 
     ///
-    /// \brief Starts or updates the client in charge of requesting an icon.
+    /// \brief Starts or updates the request of an icon.
     /// \param hash the SHA-1 hash representing the icon.
     ///
-    void startSyfitProtocolClient(const QByteArray &hash);
+    void requestIcon(const QByteArray &hash);
 
     ///
-    /// \brief Stops the client in charge of requesting an icon.
+    /// \brief Cancels the request of an icon (if any).
     ///
-    void stopSyfitProtocolClient();
+    void cancelIconRequest();
 
-    /// \brief The server used for icon requests.
-    QPointer<SyfitProtocolClient> m_syfitClient;
+    ///
+    /// \brief Records that the user has just been seen (marking the instance
+    /// to be saved only once every LAST_SEEN_RESOLUTION).
+    ///
+    void touch();
+
+    /// \brief The SHA-1 hash of the icon being requested (if any).
+    QByteArray m_iconRequest;
 
     /// \brief The identifier of the local user.
     QString m_localUuid;
+
+    /// \brief The sequence number of the last profile received.
+    quint32 m_sequence;
+
+    /// \brief The last time the user has been seen (milliseconds since epoch).
+    qint64 m_lastSeen;
+
+    /// \brief The resolution of the last time the user has been seen, as saved
+    /// (in milliseconds).
+    static const qint64 LAST_SEEN_RESOLUTION = 60 * 60 * 1000;
 };
 
 #endif // USER_HPP
@@ -17,25 +17,19 @@
  */
 
 #include "usericon.hpp"
-
-#include <Logger.h>
+#include "Common/logging.hpp"
+#include "usericoncache.hpp"
+#include "usericonpack.hpp"
 
 #include <QBuffer>
 #include <QCryptographicHash>
-#include <QDir>
-#include <QFile>
-#include <QFileInfo>
 #include <QImage>
-#include <QLockFile>
-#include <QSaveFile>
 
 // Static variables definition
 const QSize UserIcon::ICON_SIZE_PX(128, 128);
 const quint32 UserIcon::ICON_MAX_SIZE_BYTES = 16 * 1024; // 16 KB
 
 const char *UserIcon::ICON_FORMAT = "JPG";
-const QString UserIcon::ICON_PATH("/icons/");
-const QString UserIcon::ICON_EXTENSION(".jpg");
 
 ///
 /// This method attempts to read an icon from an array of bytes: initially
@@ -73,135 +67,19 @@ QImage UserIcon::readIcon(const QString &identifier, const QByteArray &data,
     return icon;
 }
 
-///
-/// The method attempts to read an icon from file: initially the file is
-/// opened (after having obtained a lock to guarantee atomicity) and the
-/// bytes are read in a buffer, which is then used to try to build the image.
-/// In case of success, the image is returned and the buffer is copied into
-/// the associated parameter (if not NULL) while, if an error occurs at any
-/// step, a null image is returned.
-///
-/// \see UserIcon::readIcon(const QString&, const QByteArray&, const
-/// QByteArray&)
-///
-QImage UserIcon::readIcon(const QString &filePath, const QByteArray &hash,
-                          QByteArray *buffer)
-{
-    // Check if icon path exists and create it otherwise
-    QDir directory = QFileInfo(filePath).absoluteDir();
-    if (!directory.mkpath(".")) {
-        LOG_ERROR() << "UserIcon: impossible to create directory"
-                    << directory.absolutePath();
-        return QImage();
-    }
-
-    // Get the lock to guarantee atomic read
-    QLockFile lock(filePath + ".lock");
-    if (!lock.lock()) {
-        LOG_WARNING() << "UserIcon: impossible to read the requested icon -"
-                      << filePath << "- failed to acquire the lock";
-        return QImage();
-    }
-
-    // Attempt to read the data representing the image from file.
-    QFile file(filePath);
-    if (!file.open(QFile::ReadOnly)) {
-        LOG_WARNING() << "UserIcon: impossible to read the requested icon -"
-                      << filePath << "-" << file.errorString();
-        return QImage();
-    }
-
-    // Check the file size
-    if (file.size() > UserIcon::ICON_MAX_SIZE_BYTES) {
-        LOG_WARNING() << "UserIcon: impossible to read the requested icon -"
-                      << filePath << "- file too big";
-        return QImage();
-    }
-
-    // Read data from file
-    QByteArray data = file.readAll();
-    file.close();
-    lock.unlock();
-
-    // Try building the image
-    QImage icon = UserIcon::readIcon(filePath, data, hash);
-
-    // If buffer set and no error, copy the data in it
-    if (!icon.isNull() && buffer) {
-        *buffer = data;
-    }
-
-    // Return the read icon
-    return icon;
-}
-
-///
-/// The method attempts to write the array of bytes representing an icon
-/// to file: the file is opened (after having obtained a lock to guarantee
-/// atomicity) and the bytes are written to it. A boolean value is returned
-/// to signal if the operation succeeded of failed.
-///
-bool UserIcon::saveIcon(const QString &filePath, const QByteArray &icon)
-{
-    LOG_INFO() << "UserIcon: saving to" << filePath;
-
-    // Check if icon path exists and create it otherwise
-    QDir directory = QFileInfo(filePath).absoluteDir();
-    if (!directory.mkpath(".")) {
-        LOG_ERROR() << "UserIcon: impossible to create directory"
-                    << directory.absolutePath();
-        return false;
-    }
-
-    // Get the lock to guarantee atomic write
-    QLockFile lock(filePath + ".lock");
-    if (!lock.lock()) {
-        LOG_WARNING() << "UserIcon: impossible to write the requested icon -"
-                      << filePath << "- failed to acquire the lock";
-        return false;
-    }
-
-    // Attempt to write the data representing the image to file.
-    QSaveFile file(filePath);
-    if (!file.open(QSaveFile::WriteOnly)) {
-        LOG_WARNING() << "UserIcon: impossible to write the requested icon -"
-                      << filePath << "-" << file.errorString();
-        return false;
-    }
-
-    // Write data to file
-    if (file.write(icon) != icon.length()) {
-        LOG_WARNING() << "UserIcon: impossible to write the requested icon -"
-                      << filePath << "-" << file.errorString();
-        return false;
-    }
-
-    // Commit the data
-    if (!file.commit()) {
-        LOG_WARNING() << "UserIcon: impossible to write the requested icon -"
-                      << filePath << "-" << file.errorString();
-        return false;
-    }
-
-    return true;
-}
-
 ///
 /// The constructor tries to build a new UserIcon instance from an image;
 /// in particular the image is converted to the expected format (scaled and
-/// cropped if necessary), and then it is saved to file for later retrieval.
-/// In case of success, the icon fields are initialized (the SHA-1 hash is
-/// computed from the image), while in case of error an instance with the
-/// icon not set is built.
-///
-/// \see saveIcon(const QString&, const QByteArray&)
+/// cropped if necessary), and then it is saved to the pack for later
+/// retrieval. In case of success, the icon fields are initialized (the SHA-1
+/// hash is computed from the image), while in case of error an instance with
+/// the icon not set is built.
 ///
 UserIcon::UserIcon(const QString &confPath, const QString &uuid,
                    const QImage &icon)
         : m_set(false),
-          m_path(QFileInfo(confPath + UserIcon::ICON_PATH + uuid +
-                           UserIcon::ICON_EXTENSION)
-                     .absoluteFilePath())
+          m_verified(true),
+          m_pack(UserIconPack::instance(confPath))
 {
     LOG_ASSERT_X(!icon.isNull(),
                  "UserIcon: trying to create an instance from a NULL image");
@@ -238,31 +116,33 @@ UserIcon::UserIcon(const QString &confPath, const QString &uuid,
     }
     buffer.close();
 
-    // Save the image to file
-    if (!UserIcon::saveIcon(m_path, data)) {
+    // Compute the hash and save the image to the pack
+    QByteArray hash =
+        QCryptographicHash::hash(data, QCryptographicHash::Algorithm::Sha1);
+    if (!m_pack->insert(hash, data)) {
+        LOG_WARNING() << "UserIcon: failed saving the icon of"
+                      << qUtf8Printable(uuid);
         return;
     }
 
     m_set = true;
-    // Compute the hash
-    m_hash =
-        QCryptographicHash::hash(data, QCryptographicHash::Algorithm::Sha1);
+    m_hash = hash;
 }
 
 ///
 /// The constructor tries to build a new UserIcon instance from an array of
 /// bytes (e.g. the one received from the SYFIT protocol); in particular it
 /// verifies if the buffer contains valid data to build an image: in this case
-/// it is saved to file for later retrieval.
+/// it is saved to the pack for later retrieval (unless already present, e.g.
+/// because another user has the same icon).
 /// In case of success, the icon fields are initialized, while in case of error
 /// an instance with the icon not set is built.
 ///
 UserIcon::UserIcon(const QString &confPath, const QString &uuid,
                    const QByteArray &data, const QByteArray &hash)
         : m_set(false),
-          m_path(QFileInfo(confPath + UserIcon::ICON_PATH + uuid +
-                           UserIcon::ICON_EXTENSION)
-                     .absoluteFilePath())
+          m_verified(true),
+          m_pack(UserIconPack::instance(confPath))
 {
     // Try reading the icon from the buffer
     QImage icon = UserIcon::readIcon(uuid, data, hash);
@@ -271,42 +151,63 @@ UserIcon::UserIcon(const QString &confPath, const QString &uuid,
         return;
     }
 
-    // Save the image to file
-    if (!UserIcon::saveIcon(m_path, data)) {
+    // Save the image to the pack
+    if (!m_pack->insert(hash, data)) {
+        LOG_WARNING() << "UserIcon: failed saving the icon of"
+                      << qUtf8Printable(uuid);
         return;
     }
 
     m_set = true;
     m_hash = hash;
+
+    // The image has already been decoded: make it available to the views
+    UserIconCache::insert(hash, icon);
 }
 
 ///
 /// The constructor tries to build a new UserIcon instance from a previously
-/// stored image; in particular it tries to read the icon through the
-/// readIcon() method: in case of success, the icon fields are initialized,
-/// while in case of error an instance with the icon not set is built.
+/// stored image; in particular it tries to read the icon from the pack and
+/// to verify it through the readIcon() method: in case of success, the icon
+/// fields are initialized, while in case of error an instance with the icon
+/// not set is built.
 ///
 UserIcon::UserIcon(const QString &confPath, const QString &uuid,
                    const QByteArray &hash)
         : m_set(false),
-          m_path(QFileInfo(confPath + UserIcon::ICON_PATH + uuid +
-                           UserIcon::ICON_EXTENSION)
-                     .absoluteFilePath())
+          m_verified(true),
+          m_pack(UserIconPack::instance(confPath))
 {
     // Try reading the icon
-    QImage icon = UserIcon::readIcon(m_path, hash);
+    QImage icon = UserIcon::readIcon(uuid, m_pack->read(hash), hash);
 
     // If success, set the other fields of the structure
     if (!icon.isNull()) {
         m_set = true;
         m_hash = hash;
+        UserIconCache::insert(hash, icon);
     }
 }
 
 ///
-/// The method attempts to read the image from file and returns it.
+/// The instance is built without reading the icon, which is verified only
+/// when it is first read (e.g. by the UserIconLoader): this allows to avoid
+/// reading and decoding the icons of all the known peers at startup.
 ///
-/// \see readIcon(const QString&, const QByteArray& hash, QByteArray* buffer)
+UserIcon UserIcon::unverified(const QString &confPath, const QByteArray &hash)
+{
+    UserIcon icon;
+    icon.m_set = true;
+    icon.m_verified = false;
+    icon.m_hash = hash;
+    icon.m_pack = UserIconPack::instance(confPath);
+    return icon;
+}
+
+///
+/// The method attempts to read the image from the pack and returns it.
+///
+/// \see readIcon()
 ///
 QImage UserIcon::read() const
 {
@@ -316,19 +217,21 @@ QImage UserIcon::read() const
     }
 
     // Otherwise read the image and return it
-    return readIcon(m_path, m_hash);
+    return readIcon(QString::fromLatin1(m_hash.toHex()), m_pack->read(m_hash),
+                    m_hash);
 }
 
 ///
-/// The method attempts to read the image from file and returns it in the form
-/// of an array of bytes (ready to be shared through the SYFIT protocol).
+/// The method attempts to read the image from the pack and returns it in the
+/// form of an array of bytes (ready to be shared through the SYFIT protocol),
+/// after having verified that it represents a valid icon.
 ///
-/// \see readIcon(const QString&, const QByteArray& hash, QByteArray* buffer)
+/// \see readIcon()
 ///
 QByteArray UserIcon::readData() const
 {
     LOG_ASSERT_X(m_set, "UserIcon: trying to read an unset icon");
-    QByteArray data;
-    readIcon(m_path, m_hash, &data);
-    return data;
+    QByteArray data = m_pack->read(m_hash);
+    QImage icon = readIcon(QString::fromLatin1(m_hash.toHex()), data, m_hash);
+    return (icon.isNull()) ? QByteArray() : data;
 }
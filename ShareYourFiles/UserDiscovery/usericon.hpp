@@ -19,11 +19,12 @@
 #ifndef USERICON_HPP
 #define USERICON_HPP
 
+#include <QByteArray>
 #include <QSize>
 #include <QString>
 
-class QByteArray;
 class QImage;
+class UserIconPack;
 
 ///
 /// \brief The UserIcon class represents an icon chosen by a user.
@@ -33,13 +34,16 @@ class QImage;
 /// class is used to store information about those icons, and to provide the
 /// main operations that can be executed on them (mainly reading and writing).
 ///
+/// The icons are stored in the UserIconPack associated to the configuration
+/// path, where they are identified by their SHA-1 hash.
+///
 class UserIcon
 {
 public:
     ///
     /// \brief Builds a new instance with no icon associated.
     ///
-    explicit UserIcon() : m_set(false) {}
+    explicit UserIcon() : m_set(false), m_verified(true), m_pack(Q_NULLPTR) {}
 
     ///
     /// \brief Builds a new instance with the specified icon associated.
@@ -61,7 +65,7 @@ public:
                       const QByteArray &data, const QByteArray &hash);
 
     ///
-    /// \brief Builds a new instance reading the icon from file.
+    /// \brief Builds a new instance reading the icon from the pack.
     /// \param confPath the base path where configuration files are stored.
     /// \param uuid the identifier of the user.
     /// \param hash the SHA-1 hash of the icon.
@@ -69,6 +73,16 @@ public:
     explicit UserIcon(const QString &confPath, const QString &uuid,
                       const QByteArray &hash);
 
+    ///
+    /// \brief Builds a new instance referring to a stored icon, without
+    /// reading it.
+    /// \param confPath the base path where configuration files are stored.
+    /// \param hash the SHA-1 hash of the icon.
+    /// \return the instance built, which is set but not yet verified.
+    ///
+    static UserIcon unverified(const QString &confPath,
+                               const QByteArray &hash);
+
     ///
     /// \brief Generates an instance which is an exact copy of the parameter.
     /// \param other the instance to be copied.
@@ -92,15 +106,23 @@ public:
     bool set() const { return m_set; }
 
     ///
-    /// \brief Returns the SHA-1 hash of the icon (only if set is true).
+    /// \brief Returns whether the stored icon has been verified to match the
+    /// hash (meaningful only if set is true).
     ///
-    const QByteArray &hash() const { return m_hash; }
+    /// Icons built through unverified() are not checked until the first time
+    /// they are needed: in the meanwhile, they should not be displayed.
+    ///
+    bool verified() const { return m_verified; }
+
+    ///
+    /// \brief Marks the icon as verified (i.e. read() succeeded).
+    ///
+    void setVerified() { m_verified = true; }
 
     ///
-    /// \brief Returns the path indicating where the icon is stored (or a null
-    /// string if the icon is not set).
+    /// \brief Returns the SHA-1 hash of the icon (only if set is true).
     ///
-    QString path() const { return (m_set) ? m_path : QString(); }
+    const QByteArray &hash() const { return m_hash; }
 
     ///
     /// \brief Reads the icon associated to this instance.
@@ -133,39 +155,18 @@ private:
     static QImage readIcon(const QString &identifier, const QByteArray &data,
                            const QByteArray &hash);
 
-    ///
-    /// \brief Reads an icon from file.
-    /// \param filePath the path where the image is stored.
-    /// \param hash the expected SHA-1 hash of the image.
-    /// \param buffer the optional buffer where the image (as raw bytes) is
-    /// written.
-    /// \return the image read, or a NULL one in case of error.
-    ///
-    static QImage readIcon(const QString &filePath, const QByteArray &hash,
-                           QByteArray *buffer = Q_NULLPTR);
-
-    ///
-    /// \brief Writes an icon to file.
-    /// \param filePath the path where the image is to be stored.
-    /// \param icon the array of bytes forming the image.
-    /// \return true in case of success and false of error.
-    ///
-    static bool saveIcon(const QString &filePath, const QByteArray &icon);
-
 private:
     bool m_set; ///< \brief Specifies whether the icon is set or not.
+    /// \brief Specifies whether the stored icon has been verified or not.
+    bool m_verified;
 
-    QString m_path; ///< \brief Specifies the path where the icon is stored.
     /// \brief Specifies the SHA-1 hash associated with the icon.
     QByteArray m_hash;
+    /// \brief The pack where the icon is stored.
+    UserIconPack *m_pack;
 
     /// \brief The image format chosen to save the icons.
     static const char *ICON_FORMAT;
-    /// \brief The relative path (with respect to confPath), where icons are
-    /// located.
-    static const QString ICON_PATH;
-    /// \brief The image extension.
-    static const QString ICON_EXTENSION;
 };
 
 #endif // USERICON_HPP
@@ -0,0 +1,96 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "usericoncache.hpp"
+#include "usericon.hpp"
+
+#include <QMutexLocker>
+
+// Static variables definition
+const QString UserIconCache::PROVIDER_NAME("syficons");
+const int UserIconCache::MAX_COST_KB = 16 * 1024; // 16 MB
+
+QMutex UserIconCache::m_mutex;
+QCache<QByteArray, QImage> UserIconCache::m_cache(UserIconCache::MAX_COST_KB);
+
+///
+/// In case the image is not cached, it is read (and verified) without holding
+/// the lock, so that concurrent requests for different icons are not
+/// serialized; the image is then inserted in the cache in case of success.
+///
+QImage UserIconCache::image(const UserIcon &icon)
+{
+    if (!icon.set()) {
+        return QImage();
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        QImage *cached = m_cache.object(icon.hash());
+        if (cached) {
+            return *cached;
+        }
+    }
+
+    QImage image = icon.read();
+    UserIconCache::insert(icon.hash(), image);
+    return image;
+}
+
+///
+/// The cost of the entry is given by the memory occupied by the image, hence
+/// the number of icons cached depends on their actual size.
+///
+void UserIconCache::insert(const QByteArray &hash, const QImage &image)
+{
+    if (image.isNull()) {
+        return;
+    }
+
+    int cost = qMax(1, image.bytesPerLine() * image.height() / 1024);
+    QMutexLocker locker(&m_mutex);
+    m_cache.insert(hash, new QImage(image), cost);
+}
+
+void UserIconCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+}
+
+///
+/// The URL has the form image://syficons/<hash>, where the hash is encoded in
+/// hexadecimal. Since the hash is part of the URL, the views reload the image
+/// automatically when the icon of a user changes.
+///
+QString UserIconCache::url(const UserIcon &icon)
+{
+    if (!icon.set()) {
+        return QString();
+    }
+
+    return QString("image://%1/%2")
+        .arg(UserIconCache::PROVIDER_NAME,
+             QString::fromLatin1(icon.hash().toHex()));
+}
+
+QByteArray UserIconCache::parseId(const QString &id)
+{
+    return QByteArray::fromHex(id.toLatin1());
+}
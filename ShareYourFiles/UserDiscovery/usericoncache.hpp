@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USERICONCACHE_HPP
+#define USERICONCACHE_HPP
+
+#include <QByteArray>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+class UserIcon;
+
+///
+/// \brief The UserIconCache class provides a process-wide cache of the decoded
+/// icons of the users.
+///
+/// Decoding an icon requires to read the file, to verify its SHA-1 hash and to
+/// decompress the image: doing it for each view displaying the icon (and each
+/// time the view is recreated) is wasteful. This class, instead, keeps the
+/// images already decoded in a least recently used cache, whose entries are
+/// identified by the hash of the icon (as in the UserIconPack): users with
+/// the same icon share the same entry, while a new icon of a user corresponds
+/// to a different one, and the old one is simply evicted when no longer used.
+///
+/// The class cannot be instantiated, and all the methods are thread-safe, since
+/// the images are requested both by the GUI (through UserIconProvider) and by
+/// the workers of UserIconLoader.
+///
+class UserIconCache
+{
+public:
+    ///
+    /// \brief The constructor is disabled (it is not possible to create
+    /// instances).
+    ///
+    explicit UserIconCache() = delete;
+
+    ///
+    /// \brief Returns the decoded image of an icon, reading it only in case it
+    /// is not already cached.
+    /// \param icon the icon to be returned.
+    /// \return the requested image, or a NULL one if not set or in case of
+    /// error.
+    ///
+    static QImage image(const UserIcon &icon);
+
+    ///
+    /// \brief Inserts an already decoded image in the cache.
+    /// \param hash the SHA-1 hash of the icon.
+    /// \param image the decoded image (NULL images are ignored).
+    ///
+    static void insert(const QByteArray &hash, const QImage &image);
+
+    ///
+    /// \brief Removes all the images from the cache.
+    ///
+    static void clear();
+
+    ///
+    /// \brief Returns the URL identifying an icon in the QML image provider.
+    /// \param icon the icon to be identified.
+    /// \return the URL, or an empty string if the icon is not set.
+    ///
+    static QString url(const UserIcon &icon);
+
+    ///
+    /// \brief Parses the identifier built by url() (without the scheme and the
+    /// provider name).
+    /// \param id the identifier to be parsed.
+    /// \return the SHA-1 hash of the icon, or an empty array if not valid.
+    ///
+    static QByteArray parseId(const QString &id);
+
+    /// \brief The name of the QML image provider serving the icons.
+    static const QString PROVIDER_NAME;
+
+private:
+    /// \brief The mutex protecting the cache.
+    static QMutex m_mutex;
+    /// \brief The images already decoded (the cost is expressed in KB).
+    static QCache<QByteArray, QImage> m_cache;
+
+    /// \brief The maximum memory occupied by the cached images (in KB).
+    static const int MAX_COST_KB;
+};
+
+#endif // USERICONCACHE_HPP
@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "usericonloader.hpp"
+#include "Common/logging.hpp"
+#include "usericoncache.hpp"
+
+#include <QRunnable>
+#include <QThread>
+
+///
+/// \brief The UserIconLoaderTask class represents the loading of a single
+/// icon, executed by the pool of threads of a UserIconLoader.
+///
+class UserIconLoaderTask : public QRunnable
+{
+public:
+    ///
+    /// \brief Builds a new instance of this class.
+    /// \param loader the instance to be notified at the end.
+    /// \param uuid the identifier of the user owning the icon.
+    /// \param icon the icon to be loaded.
+    ///
+    explicit UserIconLoaderTask(UserIconLoader *loader, const QString &uuid,
+                                const UserIcon &icon)
+            : m_loader(loader), m_uuid(uuid), m_icon(icon)
+    {
+    }
+
+    ///
+    /// \brief Reads the icon (through the cache) and posts the result to the
+    /// loader.
+    ///
+    void run() override
+    {
+        QImage image = UserIconCache::image(m_icon);
+        QMetaObject::invokeMethod(m_loader, "finishLoading",
+                                  Qt::QueuedConnection, Q_ARG(QString, m_uuid),
+                                  Q_ARG(QByteArray, m_icon.hash()),
+                                  Q_ARG(QImage, image));
+    }
+
+private:
+    UserIconLoader *m_loader; ///< \brief The instance to be notified.
+    QString m_uuid;           ///< \brief The identifier of the user.
+    UserIcon m_icon;          ///< \brief The icon to be loaded.
+};
+
+
+///
+/// The pool is limited to the number of cores available, since the operations
+/// are mainly CPU bound (hashing and decoding).
+///
+UserIconLoader::UserIconLoader(QObject *parent) : QObject(parent)
+{
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+}
+
+///
+/// The operations not yet started are discarded, while the running ones are
+/// awaited, so that no worker refers to the instance after its destruction.
+///
+UserIconLoader::~UserIconLoader()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+///
+/// A new task is submitted to the pool, unless the icon of the same user is
+/// already being loaded.
+///
+void UserIconLoader::load(const QString &uuid, const UserIcon &icon)
+{
+    if (!icon.set() || m_pending.contains(uuid)) {
+        return;
+    }
+
+    m_pending.insert(uuid);
+    m_pool.start(new UserIconLoaderTask(this, uuid, icon));
+}
+
+///
+/// The user is removed from the pending ones and the loaded() signal emitted.
+///
+void UserIconLoader::finishLoading(const QString &uuid, const QByteArray &hash,
+                                   const QImage &image)
+{
+    m_pending.remove(uuid);
+
+    if (image.isNull()) {
+        LOG_WARNING() << "UserIconLoader: failed loading the icon of"
+                      << qUtf8Printable(uuid);
+    }
+
+    emit loaded(uuid, hash, image);
+}
@@ -0,0 +1,93 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USERICONLOADER_HPP
+#define USERICONLOADER_HPP
+
+#include "usericon.hpp"
+
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+
+///
+/// \brief The UserIconLoader class reads and verifies the icons in background.
+///
+/// Reading an icon requires to acquire the lock on the file, to read it, to
+/// compute its SHA-1 hash and to decode the image, which is too expensive to
+/// be done on the GUI thread for all the known peers at startup. Hence, the
+/// icons of the peers loaded from the configuration are not verified when
+/// created (see UserIcon::unverified()), and they are loaded through this
+/// class only when they are first displayed.
+///
+/// The operations are executed by a dedicated pool of worker threads, while
+/// the results are notified through the loaded() signal, emitted in the thread
+/// of the instance. Multiple requests for the same user are served only once.
+///
+class UserIconLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///
+    /// \brief Builds a new instance of this class.
+    /// \param parent the parent of the current object.
+    ///
+    explicit UserIconLoader(QObject *parent = Q_NULLPTR);
+
+    ///
+    /// \brief Waits for the pending operations and destroys the instance.
+    ///
+    ~UserIconLoader();
+
+    ///
+    /// \brief Schedules the loading of an icon.
+    /// \param uuid the identifier of the user owning the icon.
+    /// \param icon the icon to be loaded.
+    ///
+    void load(const QString &uuid, const UserIcon &icon);
+
+signals:
+    ///
+    /// \brief Signal emitted when an icon has been loaded.
+    /// \param uuid the identifier of the user owning the icon.
+    /// \param hash the SHA-1 hash of the icon.
+    /// \param image the decoded image (NULL in case of error).
+    ///
+    void loaded(QString uuid, QByteArray hash, QImage image);
+
+private slots:
+    ///
+    /// \brief Completes the loading of an icon (executed by the workers).
+    /// \param uuid the identifier of the user owning the icon.
+    /// \param hash the SHA-1 hash of the icon.
+    /// \param image the decoded image (NULL in case of error).
+    ///
+    void finishLoading(const QString &uuid, const QByteArray &hash,
+                       const QImage &image);
+
+private:
+    /// \brief The pool of threads loading the icons.
+    QThreadPool m_pool;
+    /// \brief The users whose icons are currently being loaded.
+    QSet<QString> m_pending;
+};
+
+#endif // USERICONLOADER_HPP
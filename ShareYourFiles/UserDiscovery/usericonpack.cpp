@@ -0,0 +1,504 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "usericonpack.hpp"
+#include "Common/logging.hpp"
+#include "usericon.hpp"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QThread>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+// Static variables definition
+const QString UserIconPack::PACK_PATH("/icons.pack");
+const QString UserIconPack::LEGACY_PATH("/icons/");
+const char UserIconPack::MAGIC[] = "SYFI";
+
+
+///
+/// \brief Returns the header of a pack.
+/// \param magic the magic string.
+/// \param version the version of the format.
+/// \return the header (magic string, version and reserved bytes).
+///
+static QByteArray packHeader(const char *magic, quint8 version)
+{
+    QByteArray header(magic, 4);
+    header.append(static_cast<char>(version));
+    header.append(3, '\0');
+    return header;
+}
+
+///
+/// The instances are never destroyed until the termination of the application,
+/// so that the returned pointer can be safely stored (e.g. by UserIcon).
+///
+UserIconPack *UserIconPack::instance(const QString &confPath)
+{
+    static QMutex mutex;
+    static QHash<QString, QSharedPointer<UserIconPack>> packs;
+
+    QMutexLocker locker(&mutex);
+    QSharedPointer<UserIconPack> &pack = packs[confPath];
+    if (pack.isNull()) {
+        pack.reset(new UserIconPack(confPath));
+    }
+    return pack.data();
+}
+
+///
+/// The pack is validated and indexed, the icons stored in the legacy format
+/// are moved to it and the resulting index is published. In case of error,
+/// an empty pack is published (and the icons will be requested again).
+///
+UserIconPack::UserIconPack(const QString &confPath)
+        : m_filePath(QFileInfo(confPath + UserIconPack::PACK_PATH)
+                         .absoluteFilePath()),
+          m_size(0),
+          m_snapshot(std::make_shared<Snapshot>())
+{
+    LOG_INFO() << "UserIconPack: opening" << m_filePath;
+
+    QHash<QByteArray, Entry> index;
+    if (load(index)) {
+        migrate(confPath + UserIconPack::LEGACY_PATH, index);
+        publish(index);
+    }
+}
+
+///
+/// The padding at the end of the pack is removed, after having released the
+/// mappings (a mapped file cannot be truncated on every platform).
+///
+UserIconPack::~UserIconPack()
+{
+    std::atomic_store(&m_snapshot,
+                      std::shared_ptr<const Snapshot>(new Snapshot()));
+    m_mapping.reset();
+
+    if (m_writer.isOpen() && m_size >= UserIconPack::HEADER_LEN &&
+        m_writer.size() > m_size) {
+        m_writer.resize(m_size);
+    }
+    m_writer.close();
+}
+
+bool UserIconPack::contains(const QByteArray &hash) const
+{
+    return snapshot()->index.contains(hash);
+}
+
+///
+/// The data is copied from the mapped pack of the current snapshot, which is
+/// kept alive (and mapped) until the copy completes, even in case a writer
+/// publishes a new one in the meanwhile.
+///
+QByteArray UserIconPack::read(const QByteArray &hash) const
+{
+    std::shared_ptr<const Snapshot> current = snapshot();
+
+    auto it = current->index.constFind(hash);
+    if (it == current->index.constEnd() ||
+        it.value().offset + it.value().length > current->size) {
+        return QByteArray();
+    }
+
+    return QByteArray(
+        reinterpret_cast<const char *>(current->data + it.value().offset),
+        static_cast<int>(it.value().length));
+}
+
+///
+/// The icon is appended only in case it is not already present (e.g. received
+/// from another user), and a new snapshot including it is then published.
+///
+bool UserIconPack::insert(const QByteArray &hash, const QByteArray &data)
+{
+    if (contains(hash)) {
+        return true;
+    }
+
+    QMutexLocker locker(&m_writeMutex);
+    QHash<QByteArray, Entry> index = snapshot()->index;
+    if (index.contains(hash)) {
+        return true;
+    }
+
+    return append(hash, data, index) && publish(index);
+}
+
+///
+/// The pack is rewritten only in case the space occupied by the records no
+/// longer referenced is at least COMPACT_MIN_WASTE and exceeds the one of the
+/// live records. The new pack is written to a temporary file that atomically
+/// replaces the current one. Since a file that is open or mapped cannot be
+/// replaced on every platform, the new content is meanwhile published from
+/// memory and the previous mappings are released (the readers refer to them
+/// only while copying an icon) before replacing the pack and mapping it again.
+///
+bool UserIconPack::compact(const QSet<QByteArray> &live)
+{
+    QMutexLocker locker(&m_writeMutex);
+    std::shared_ptr<const Snapshot> current = snapshot();
+
+    // Compute the space wasted
+    qint64 liveBytes = 0;
+    for (auto it = current->index.constBegin(); it != current->index.constEnd();
+         ++it) {
+        if (live.contains(it.key())) {
+            liveBytes += UserIconPack::RECORD_HEADER_LEN + it.value().length;
+        }
+    }
+
+    qint64 wasted = current->size - UserIconPack::HEADER_LEN - liveBytes;
+    if (wasted < UserIconPack::COMPACT_MIN_WASTE || wasted < liveBytes) {
+        return true;
+    }
+
+    LOG_INFO() << "UserIconPack: compacting (" << wasted << "bytes wasted )";
+
+    // Build the content of the new pack
+    QByteArray content = packHeader(UserIconPack::MAGIC, UserIconPack::VERSION);
+    content.reserve(static_cast<int>(content.size() + liveBytes));
+
+    QHash<QByteArray, Entry> index;
+    for (auto it = current->index.constBegin(); it != current->index.constEnd();
+         ++it) {
+        if (!live.contains(it.key())) {
+            continue;
+        }
+
+        qint64 length = UserIconPack::RECORD_HEADER_LEN + it.value().length;
+        const uchar *record = current->data + it.value().offset -
+                              UserIconPack::RECORD_HEADER_LEN;
+
+        index.insert(it.key(),
+                     Entry{content.size() + UserIconPack::RECORD_HEADER_LEN,
+                           it.value().length});
+        content.append(reinterpret_cast<const char *>(record),
+                       static_cast<int>(length));
+    }
+
+    // Write the new pack
+    QSaveFile file(m_filePath);
+    if (!file.open(QSaveFile::WriteOnly) ||
+        file.write(content) != content.size()) {
+        LOG_WARNING() << "UserIconPack: impossible to compact -"
+                      << file.errorString();
+        return false;
+    }
+
+    // Publish the new content from memory
+    QHash<QByteArray, Entry> previousIndex = current->index;
+    qint64 previousSize = m_size;
+
+    std::shared_ptr<Mapping> memory = std::make_shared<Mapping>();
+    memory->buffer = content;
+    memory->data = reinterpret_cast<const uchar *>(memory->buffer.constData());
+    memory->capacity = memory->buffer.size();
+
+    m_mapping = memory;
+    m_size = content.size();
+    publish(index);
+    current.reset();
+
+    // Wait for the readers still referring to the previous mappings
+    for (const std::weak_ptr<const Mapping> &previous : m_mappings) {
+        while (!previous.expired()) {
+            QThread::yieldCurrentThread();
+        }
+    }
+    m_mappings.clear();
+
+    // Replace the pack and reopen it
+    m_writer.close();
+    bool success = file.commit();
+    if (!m_writer.open(QFile::ReadWrite)) {
+        LOG_ERROR() << "UserIconPack: impossible to reopen the pack -"
+                    << m_writer.errorString();
+        return false;
+    }
+
+    // Map the pack again (the previous one in case of error)
+    m_mapping.reset();
+    if (!success) {
+        LOG_WARNING() << "UserIconPack: impossible to compact -"
+                      << file.errorString();
+        m_size = previousSize;
+        publish(previousIndex);
+        return false;
+    }
+
+    return publish(index);
+}
+
+///
+/// The header is checked and the records are scanned up to the first one that
+/// is invalid or truncated, where the pack is cut. In case the header is not
+/// valid, the pack is reinitialized.
+///
+bool UserIconPack::load(QHash<QByteArray, Entry> &index)
+{
+    // Check if the path exists and create it otherwise
+    QDir directory = QFileInfo(m_filePath).absoluteDir();
+    if (!directory.mkpath(".")) {
+        LOG_ERROR() << "UserIconPack: impossible to create directory"
+                    << directory.absolutePath();
+        return false;
+    }
+
+    m_writer.setFileName(m_filePath);
+    if (!m_writer.open(QFile::ReadWrite)) {
+        LOG_ERROR() << "UserIconPack: impossible to open the pack -"
+                    << m_writer.errorString();
+        return false;
+    }
+
+    qint64 size = m_writer.size();
+    qint64 end = UserIconPack::HEADER_LEN;
+    bool valid = (size >= UserIconPack::HEADER_LEN);
+    bool padding = true;
+
+    if (valid) {
+        uchar *data = m_writer.map(0, size);
+        if (!data) {
+            LOG_ERROR() << "UserIconPack: impossible to map the pack -"
+                        << m_writer.errorString();
+            return false;
+        }
+
+        // Header
+        valid = std::memcmp(data, UserIconPack::MAGIC, 4) == 0 &&
+                data[4] == UserIconPack::VERSION;
+
+        // Records
+        while (valid && size - end >= UserIconPack::RECORD_HEADER_LEN) {
+            quint32 length = qFromLittleEndian<quint32>(data + end);
+            if (length == 0 || length > UserIcon::ICON_MAX_SIZE_BYTES ||
+                size - end - UserIconPack::RECORD_HEADER_LEN < length) {
+                break;
+            }
+
+            QByteArray hash(
+                reinterpret_cast<const char *>(data + end + sizeof(quint32)),
+                UserIconPack::HASH_LEN);
+            index.insert(hash,
+                         Entry{end + UserIconPack::RECORD_HEADER_LEN, length});
+            end += UserIconPack::RECORD_HEADER_LEN + length;
+        }
+
+        // Check whether the remaining bytes are only padding
+        for (qint64 i = end; valid && padding && i < size; i++) {
+            padding = (data[i] == 0);
+        }
+
+        m_writer.unmap(data);
+    }
+
+    if (!valid) {
+        end = UserIconPack::HEADER_LEN;
+
+        // Reinitialize the pack
+        if (size > 0) {
+            LOG_WARNING() << "UserIconPack: invalid pack detected, discarded";
+        }
+
+        index.clear();
+        QByteArray header =
+            packHeader(UserIconPack::MAGIC, UserIconPack::VERSION);
+        if (!m_writer.resize(0) || m_writer.write(header) != header.size() ||
+            !m_writer.flush()) {
+            LOG_ERROR() << "UserIconPack: impossible to initialize the pack -"
+                        << m_writer.errorString();
+            return false;
+        }
+    } else if (end < size) {
+        // Discard the truncated record and the padding
+        if (!padding) {
+            LOG_WARNING() << "UserIconPack: discarding" << size - end
+                          << "bytes at the end of the pack";
+        }
+        if (!m_writer.resize(end)) {
+            LOG_ERROR() << "UserIconPack: impossible to truncate the pack -"
+                        << m_writer.errorString();
+            return false;
+        }
+    }
+
+    m_size = end;
+    LOG_INFO() << "UserIconPack:" << index.size() << "icons found";
+    return true;
+}
+
+///
+/// Each file is read and appended to the pack (identified by its hash, since
+/// the icons are content addressed), and then removed together with its lock
+/// file. Files that cannot be appended are left in place, to be retried at
+/// the next start.
+///
+void UserIconPack::migrate(const QString &legacyPath,
+                           QHash<QByteArray, Entry> &index)
+{
+    QDir directory(legacyPath);
+    if (!directory.exists()) {
+        return;
+    }
+
+    LOG_INFO() << "UserIconPack: migrating the icons from" << legacyPath;
+
+    QFileInfoList files = directory.entryInfoList(
+        QStringList() << "*.jpg", QDir::Files | QDir::NoDotAndDotDot);
+    foreach (const QFileInfo &info, files) {
+        QFile file(info.absoluteFilePath());
+        if (info.size() <= UserIcon::ICON_MAX_SIZE_BYTES &&
+            file.open(QFile::ReadOnly)) {
+
+            QByteArray data = file.readAll();
+            file.close();
+
+            QByteArray hash = QCryptographicHash::hash(
+                data, QCryptographicHash::Algorithm::Sha1);
+            if (!data.isEmpty() && !index.contains(hash) &&
+                !append(hash, data, index)) {
+                continue;
+            }
+        }
+
+        QFile::remove(info.absoluteFilePath());
+        QFile::remove(info.absoluteFilePath() + ".lock");
+    }
+
+    // Remove the directory if empty
+    directory.rmdir(directory.absolutePath());
+}
+
+///
+/// The record is written and flushed after the valid content of the pack,
+/// which is previously extended (by at least half of its size, to limit the
+/// number of mappings) if the record does not fit. In case of error, the
+/// length of the record is cleared, so that it is discarded when the pack is
+/// loaded (the file is not truncated, since it may be mapped).
+///
+bool UserIconPack::append(const QByteArray &hash, const QByteArray &data,
+                          QHash<QByteArray, Entry> &index)
+{
+    LOG_ASSERT_X(hash.size() == UserIconPack::HASH_LEN,
+                 "UserIconPack: invalid hash");
+
+    if (!m_writer.isOpen()) {
+        return false;
+    }
+
+    quint32 length =
+        qToLittleEndian<quint32>(static_cast<quint32>(data.size()));
+    QByteArray record;
+    record.reserve(UserIconPack::RECORD_HEADER_LEN + data.size());
+    record.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    record.append(hash);
+    record.append(data);
+
+    qint64 offset = m_size;
+    qint64 end = offset + record.size();
+    if (end > m_writer.size()) {
+        qint64 capacity = qMax(end, m_writer.size() + m_writer.size() / 2);
+        capacity = (capacity + UserIconPack::GROWTH_STEP - 1) /
+                   UserIconPack::GROWTH_STEP * UserIconPack::GROWTH_STEP;
+        if (!m_writer.resize(capacity)) {
+            LOG_WARNING() << "UserIconPack: impossible to extend the pack -"
+                          << m_writer.errorString();
+            return false;
+        }
+    }
+
+    if (!m_writer.seek(offset) || m_writer.write(record) != record.size() ||
+        !m_writer.flush()) {
+        LOG_WARNING() << "UserIconPack: impossible to append the icon -"
+                      << m_writer.errorString();
+        if (m_writer.seek(offset)) {
+            m_writer.write(QByteArray(sizeof(quint32), '\0'));
+            m_writer.flush();
+        }
+        return false;
+    }
+
+    m_size = end;
+    index.insert(hash, Entry{offset + UserIconPack::RECORD_HEADER_LEN,
+                             static_cast<quint32>(data.size())});
+    return true;
+}
+
+///
+/// The current mapping is reused as long as it covers the valid content of the
+/// pack. Otherwise, a new mapping of the whole file (including the padding) is
+/// created, since the previous one may still be in use by the readers: it is
+/// released when the last snapshot referring to it is destroyed.
+///
+bool UserIconPack::publish(const QHash<QByteArray, Entry> &index)
+{
+    std::shared_ptr<const Mapping> mapping = m_mapping;
+    if (!mapping || mapping->capacity < m_size) {
+        std::shared_ptr<Mapping> next = std::make_shared<Mapping>();
+        next->file.reset(new QFile(m_filePath));
+        if (!next->file->open(QFile::ReadOnly)) {
+            LOG_ERROR() << "UserIconPack: impossible to open the pack -"
+                        << next->file->errorString();
+            return false;
+        }
+
+        next->capacity = next->file->size();
+        next->data = next->file->map(0, next->capacity);
+        if (!next->data) {
+            LOG_ERROR() << "UserIconPack: impossible to map the pack -"
+                        << next->file->errorString();
+            return false;
+        }
+
+        mapping = m_mapping = next;
+
+        // Keep track of the mappings still in use
+        m_mappings.erase(
+            std::remove_if(m_mappings.begin(), m_mappings.end(),
+                           [](const std::weak_ptr<const Mapping> &item) {
+                               return item.expired();
+                           }),
+            m_mappings.end());
+        m_mappings.push_back(mapping);
+    }
+
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>();
+    next->mapping = mapping;
+    next->data = mapping->data;
+    next->size = m_size;
+    next->index = index;
+    std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>(next));
+    return true;
+}
+
+std::shared_ptr<const UserIconPack::Snapshot> UserIconPack::snapshot() const
+{
+    return std::atomic_load(&m_snapshot);
+}
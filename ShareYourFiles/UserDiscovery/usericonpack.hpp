@@ -0,0 +1,226 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USERICONPACK_HPP
+#define USERICONPACK_HPP
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+///
+/// \brief The UserIconPack class stores all the icons in a single append-only
+/// file, indexed by their SHA-1 hash.
+///
+/// Storing each icon in a separate file (protected by a lock file) requires
+/// thousands of small files and the creation of a lock file for each access.
+/// The icons are instead appended to a single pack, whose format is:
+/// - header: the magic string "SYFI", the version and three reserved bytes;
+/// - records: the length of the icon (4 bytes, little endian), its SHA-1 hash
+///   and the actual data.
+///
+/// Since the records are identified by the hash, identical icons (e.g. of the
+/// same user on different hosts) are stored only once. The pack is memory
+/// mapped and the index is published as an immutable snapshot, which is
+/// replaced atomically by the writers: hence, reads do not require any lock
+/// and never wait for the writers. The file is extended in steps (padded with
+/// zeros), so that it is mapped again only when a record does not fit the
+/// current mapping. The records no longer referenced are removed by compact(),
+/// which rewrites the pack when the wasted space becomes significant. A
+/// truncated record at the end of the pack (e.g. due to a crash) and the
+/// padding are discarded when the pack is opened, while the icons are verified
+/// against their hash when read.
+///
+/// A single instance is associated to each configuration path, and is
+/// obtained through instance(): all the methods are thread-safe.
+///
+class UserIconPack
+{
+public:
+    ///
+    /// \brief Returns the pack associated to a configuration path, opening it
+    /// if necessary.
+    /// \param confPath the base path where configuration files are stored.
+    /// \return the requested instance (never NULL).
+    ///
+    static UserIconPack *instance(const QString &confPath);
+
+    ///
+    /// \brief Returns whether an icon is stored in the pack or not.
+    /// \param hash the SHA-1 hash of the icon.
+    ///
+    bool contains(const QByteArray &hash) const;
+
+    ///
+    /// \brief Reads an icon from the pack.
+    /// \param hash the SHA-1 hash of the icon.
+    /// \return the data of the icon (not verified), or an empty array if not
+    /// present.
+    ///
+    QByteArray read(const QByteArray &hash) const;
+
+    ///
+    /// \brief Appends an icon to the pack (unless already present).
+    /// \param hash the SHA-1 hash of the icon.
+    /// \param data the data of the icon.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool insert(const QByteArray &hash, const QByteArray &data);
+
+    ///
+    /// \brief Removes the icons no longer referenced, in case the wasted
+    /// space is significant.
+    /// \param live the hashes of the icons still referenced.
+    /// \return true in case of success (or if the pack is not rewritten) and
+    /// false otherwise.
+    ///
+    bool compact(const QSet<QByteArray> &live);
+
+    ///
+    /// \brief Closes the pack.
+    ///
+    ~UserIconPack();
+
+private:
+    ///
+    /// \brief The Entry struct represents the position of an icon.
+    ///
+    struct Entry {
+        qint64 offset;  ///< \brief The offset of the data in the pack.
+        quint32 length; ///< \brief The length of the data.
+    };
+
+    ///
+    /// \brief The Mapping struct represents the content of the pack mapped in
+    /// memory, shared by the snapshots referring to it.
+    ///
+    struct Mapping {
+        /// \brief Builds an empty mapping.
+        Mapping() : data(Q_NULLPTR), capacity(0) {}
+
+        /// \brief The file mapped (unmapped when the mapping is released).
+        std::unique_ptr<QFile> file;
+        /// \brief The content kept in memory while the pack is replaced.
+        QByteArray buffer;
+        const uchar *data; ///< \brief The mapped content of the pack.
+        qint64 capacity;   ///< \brief The size of the mapped content.
+    };
+
+    ///
+    /// \brief The Snapshot struct represents an immutable view of the pack.
+    ///
+    struct Snapshot {
+        /// \brief Builds an empty snapshot.
+        Snapshot() : data(Q_NULLPTR), size(0) {}
+
+        /// \brief The mapping the data belongs to.
+        std::shared_ptr<const Mapping> mapping;
+        const uchar *data; ///< \brief The content of the pack.
+        qint64 size;       ///< \brief The size of the valid content.
+        /// \brief The position of the icons in the pack.
+        QHash<QByteArray, Entry> index;
+    };
+
+    ///
+    /// \brief Opens (or creates) the pack.
+    /// \param confPath the base path where configuration files are stored.
+    ///
+    explicit UserIconPack(const QString &confPath);
+
+    ///
+    /// \brief Validates the pack and builds the index of the records.
+    /// \param index the index to be filled.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool load(QHash<QByteArray, Entry> &index);
+
+    ///
+    /// \brief Moves the icons stored in the legacy format (one file per user)
+    /// to the pack.
+    /// \param legacyPath the directory containing the legacy files.
+    /// \param index the index to be updated.
+    ///
+    void migrate(const QString &legacyPath, QHash<QByteArray, Entry> &index);
+
+    ///
+    /// \brief Appends a record to the pack (without publishing it).
+    /// \param hash the SHA-1 hash of the icon.
+    /// \param data the data of the icon.
+    /// \param index the index to be updated.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool append(const QByteArray &hash, const QByteArray &data,
+                QHash<QByteArray, Entry> &index);
+
+    ///
+    /// \brief Maps the pack (unless the current mapping is large enough) and
+    /// publishes the index.
+    /// \param index the index to be published.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool publish(const QHash<QByteArray, Entry> &index);
+
+    /// \brief Returns the snapshot currently published.
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+private:
+    QString m_filePath; ///< \brief The path of the pack.
+    /// \brief The file used to append the records (accessed by writers only).
+    QFile m_writer;
+    /// \brief The mutex serializing the writers.
+    QMutex m_writeMutex;
+    /// \brief The size of the valid content (accessed by writers only).
+    qint64 m_size;
+    /// \brief The most recent mapping (accessed by writers only).
+    std::shared_ptr<const Mapping> m_mapping;
+    /// \brief The mappings of the file possibly in use (accessed by writers
+    /// only).
+    std::vector<std::weak_ptr<const Mapping>> m_mappings;
+    /// \brief The snapshot currently published.
+    std::shared_ptr<const Snapshot> m_snapshot;
+
+    /// \brief The relative path (with respect to confPath) of the pack.
+    static const QString PACK_PATH;
+    /// \brief The relative path (with respect to confPath) of the legacy
+    /// icons.
+    static const QString LEGACY_PATH;
+
+    /// \brief The magic string identifying the pack.
+    static const char MAGIC[];
+    /// \brief The version of the pack format.
+    static const quint8 VERSION = 1;
+    /// \brief The length of the header of the pack.
+    static const int HEADER_LEN = 8;
+    /// \brief The length of the SHA-1 hash of the icons.
+    static const int HASH_LEN = 20;
+    /// \brief The length of the header of a record.
+    static const int RECORD_HEADER_LEN = sizeof(quint32) + HASH_LEN;
+    /// \brief The minimum wasted space triggering the compaction (in bytes).
+    static const qint64 COMPACT_MIN_WASTE = 256 * 1024;
+    /// \brief The granularity the pack is extended with (in bytes).
+    static const qint64 GROWTH_STEP = 64 * 1024;
+};
+
+#endif // USERICONPACK_HPP
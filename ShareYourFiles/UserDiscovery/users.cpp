@@ -17,191 +17,61 @@
  */
 
 #include "users.hpp"
+#include "Common/coalescedtimer.hpp"
+#include "Common/logging.hpp"
+#include "Common/threadpool.hpp"
+#include "receptionpolicy.hpp"
 #include "syfddatagram.hpp"
+#include "syfddatagramview.hpp"
+#include "syfitscheduler.hpp"
 #include "user.hpp"
+#include "usericonloader.hpp"
+#include "usericonpack.hpp"
+#include "userstore.hpp"
 
-#include <Logger.h>
-
-#include <QDir>
-#include <QFile>
-#include <QFileInfo>
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QSaveFile>
+#include <QSet>
+#include <QStringList>
 #include <QTimer>
 
 // Static variables definition
-const QString LocalInstance::JSON_PATH = "/me.json";
-const QString PeersList::JSON_PATH = "/peers.json";
-
-
-///
-/// \brief Reads a JSON document from a file.
-/// \param filePath the path of the file to be read.
-/// \param error the description of the occurred error (if any).
-/// \return the JSON document read or a null one in case of error.
-///
-static QJsonDocument readFromFile(const QString &filePath, QString &error)
-{
-    // Check if path exists and create it otherwise
-    QDir directory = QFileInfo(filePath).absoluteDir();
-    if (!directory.mkpath(".")) {
-        LOG_ERROR() << "Users: impossible to create directory"
-                    << directory.absolutePath();
-        return QJsonDocument();
-    }
-
-    // Open the file
-    QFile file(filePath);
-    if (!file.open(QFile::ReadOnly)) {
-        error = file.errorString();
-        return QJsonDocument();
-    }
-
-    // Read data from file
-    QByteArray data = file.readAll();
-    file.close();
-
-    // Convert data to JSON document
-    return QJsonDocument::fromJson(data);
-}
-
-///
-/// \brief Saves a JSON document to a file.
-/// \param filePath the path of the file to be written.
-/// \param json the JSON document to be saved.
-/// \param error the description of the occurred error (if any).
-/// \return true in case of success and false in case of failure.
-///
-static bool saveToFile(const QString &filePath, const QJsonDocument &json,
-                       QString &error)
-{
-    // Check if path exists and create it otherwise
-    QDir directory = QFileInfo(filePath).absoluteDir();
-    if (!directory.mkpath(".")) {
-        LOG_ERROR() << "Users: impossible to create directory"
-                    << directory.absolutePath();
-        return false;
-    }
-
-    // Open the file
-    QSaveFile file(filePath);
-    if (!file.open(QSaveFile::WriteOnly)) {
-        error = file.errorString();
-        return false;
-    }
-
-    // Write data to the file
-    QByteArray data = json.toJson();
-    if (file.write(data) != data.length()) {
-        error = file.errorString();
-        return false;
-    }
-
-    // Commit the data
-    if (!file.commit()) {
-        error = file.errorString();
-        return false;
-    }
-
-    return true;
-}
-
-///
-/// \brief Saves a User instance to file.
-/// \param filePath the path of the file to be written.
-/// \param instance the User instance to be saved.
-///
-/// The instance is saved only if it is marked to be needed (through the
-/// to be saved flag).
-///
-static void saveToFile(const QString &filePath, const LocalUser &instance)
-{
-    // Check if data has to be saved
-    if (!instance.toBeSaved()) {
-        return;
-    }
-
-    // Fill the JSON object
-    QJsonObject jsonObj;
-    instance.save(jsonObj);
-
-    // Save it to file
-    QString error;
-    if (!saveToFile(filePath, QJsonDocument(jsonObj), error)) {
-        LOG_ERROR() << "LocalUser: failed saving information to file"
-                    << filePath << "-" << error;
-    } else {
-        LOG_INFO() << "LocalUser: information correctly saved to file"
-                   << filePath;
-    }
-}
-
-///
-/// \brief Saves a list of User instances to file.
-/// \param filePath the path of the file to be written.
-/// \param instances the instances to be saved.
-///
-static void saveToFile(QString filePath,
-                       const QList<QSharedPointer<PeerUser>> &instances)
-{
-    // Build an array given the current peers
-    QJsonArray jsonArray;
-    foreach (QSharedPointer<PeerUser> peer, instances) {
-        // Save the user as JSON
-        QJsonObject jsonObj;
-        peer->save(jsonObj);
-
-        // Add to the array
-        jsonArray.append(jsonObj);
-    }
-
-    // Save it to file
-    QString error;
-    if (!saveToFile(filePath, QJsonDocument(jsonArray), error)) {
-        LOG_ERROR() << "PeersList: failed saving information to file"
-                    << filePath << "-" << error;
-    } else {
-        LOG_INFO() << "PeersList: information correctly saved to file"
-                   << filePath;
-    }
-}
-
-
-/******************************************************************************/
+const QString LocalInstance::STORE_PATH = "/me.db";
+const QString LocalInstance::LEGACY_PATH = "/me.json";
+const QString PeersList::STORE_PATH = "/peers.db";
+const QString PeersList::LEGACY_PATH = "/peers.json";
 
 
 ///
 /// The LocalUser instance is created by initially trying to read if
 /// some configuration was saved by previous executions. In this case
-/// the file is read, converted to a JSON document and then the User
-/// instance is constructed from that data. On the other hand, if no
-/// configuration is found, or if it is corrupted, a brand new instance
-/// is generated.
+/// the record is read from the store and then the User instance is
+/// constructed from that data. On the other hand, if no configuration
+/// is found, or if it is corrupted, a brand new instance is generated.
 ///
 LocalInstance::LocalInstance(const QString &confPath, const QString &dataPath,
                              quint32 ipv4Address)
-        : m_confPath(confPath)
+        : m_confPath(confPath),
+          m_store(new UserStore(confPath + LocalInstance::STORE_PATH,
+                                confPath + LocalInstance::LEGACY_PATH)),
+          m_timerSave(new QTimer(this))
 {
-    QString path(m_confPath + LocalInstance::JSON_PATH), error;
+    QString path(m_confPath + LocalInstance::STORE_PATH);
     LOG_INFO() << "LocalInstance: initialization"
-               << qUtf8Printable("(json file: \"" + path + "\")...");
+               << qUtf8Printable("(store file: \"" + path + "\")...");
 
     // Try to read the saved instance
-    QJsonDocument json = readFromFile(path, error);
-    if (!json.isNull()) {
-        // Construct the instance from JSON data
-        m_instance.reset(
-            new LocalUser(confPath, dataPath, json.object(), ipv4Address));
+    QList<UserRecord> records = m_store->load();
+    if (!records.isEmpty()) {
+        // Construct the instance from the saved record
+        m_savedUuid = records.last().uuid;
+        m_instance.reset(new LocalUser(confPath, dataPath, records.last(),
+                                       ipv4Address));
     } else {
         LOG_WARNING()
-            << "LocalInstance: impossible to read information from file:"
-            << error;
+            << "LocalInstance: no information found in the store file";
     }
 
     // If failed to create a new instance
-    if (!m_instance || !m_instance->valid() || !m_instance->localUser()) {
+    if (!m_instance || !m_instance->valid()) {
         LOG_INFO()
             << "LocalInstance: creating a new instance from default parameters";
         m_instance.reset(new LocalUser(confPath, dataPath, ipv4Address));
@@ -216,23 +86,52 @@ LocalInstance::LocalInstance(const QString &confPath, const QString &dataPath,
     LOG_INFO() << "LocalInstance - last name:" << m_instance->info().lastName();
 
     // Save the new instance if necessary
-    saveToFile(path, *m_instance);
+    save();
 
     // Function executed when some information of the local user is changed
-    // to save the changes to file
+    // to save the changes (once the delay elapses without further changes)
+    m_timerSave->setSingleShot(true);
+    m_timerSave->setInterval(LocalInstance::SAVE_DELAY);
+    connect(m_timerSave, &QTimer::timeout, this, [this]() { save(); });
     connect(m_instance.data(), &LocalUser::updated, this,
-            [this, path]() { saveToFile(path, *m_instance); });
+            [this]() { m_timerSave->start(); });
 
     LOG_INFO() << "LocalInstance: initialization completed";
 }
 
 ///
-/// The method saves the changes to file (if necessary) and then destroys
-/// the instance (done automatically by the destructor of the shared pointer)
+/// The method saves the changes (if necessary) and then destroys the instance
+/// (done automatically by the destructor of the shared pointer), waiting for
+/// the pending writes to complete.
 ///
 LocalInstance::~LocalInstance()
 {
-    saveToFile(m_confPath + LocalInstance::JSON_PATH, *m_instance);
+    m_timerSave->stop();
+    save();
+}
+
+///
+/// The record is saved only if the instance is marked to be needed (through
+/// the to be saved flag); in case the UUID changed, the previous record is
+/// removed.
+///
+void LocalInstance::save()
+{
+    // Check if data has to be saved
+    if (!m_instance->toBeSaved()) {
+        return;
+    }
+
+    UserRecord record;
+    m_instance->save(record);
+
+    if (!m_savedUuid.isEmpty() && m_savedUuid != record.uuid) {
+        m_store->remove(QStringList(m_savedUuid));
+    }
+    m_store->put(QList<UserRecord>() << record);
+    m_savedUuid = record.uuid;
+
+    LOG_INFO() << "LocalUser: information saved";
 }
 
 
@@ -242,57 +141,144 @@ LocalInstance::~LocalInstance()
 ///
 /// The PeersList instance is created by initially trying to read if
 /// some configuration was saved from previous executions. In this case
-/// the file is read, converted to a JSON document and then the detected
-/// users are added to the list (marked as unconfirmed since no datagram
-/// as been received yet). In case no configuration is found, an empty list
-/// is created.
+/// the records are read from the store (the ones of the peers not seen for
+/// longer than PEER_MAX_AGE are discarded) and the detected users are added
+/// to the list (marked as unconfirmed since no datagram as been received yet).
+/// In case no configuration is found, an empty list is created.
 ///
 PeersList::PeersList(const QString &confPath, LocalUser *localUser)
         : m_confPath(confPath),
           m_localUser(localUser),
-          m_timerAge(new QTimer(this))
+          m_store(new UserStore(confPath + PeersList::STORE_PATH,
+                                confPath + PeersList::LEGACY_PATH)),
+          m_timerAge(new CoalescedTimer(this)),
+          m_timerSave(new QTimer(this)),
+          m_iconLoader(new UserIconLoader(this)),
+          m_iconScheduler(new SyfitScheduler(confPath)),
+          m_receptionPolicy(localUser->receptionPolicy())
 {
-    QString path(m_confPath + PeersList::JSON_PATH), error;
+    // Move the icon scheduler to the SYFD thread
+    m_iconScheduler->moveToThread(ThreadPool::syfdThread());
+
+    QString path(m_confPath + PeersList::STORE_PATH);
     LOG_INFO() << "PeersList: initialization"
-               << qUtf8Printable("(json file: \"" + path + "\")...");
+               << qUtf8Printable("(store file: \"" + path + "\")...");
 
     // Get the information related to the local user
     UserInfo me = m_localUser->info();
 
     // Try to read the saved instances
-    QJsonDocument json = readFromFile(path, error);
-    if (!json.isNull() && json.isArray()) {
-        QJsonArray peers = json.array();
+    QList<UserRecord> records = m_store->load(PeersList::PEER_MAX_AGE);
+    QStringList invalid;
 
-        // Insert each instance into the data structure if valid
-        foreach (QJsonValue obj, peers) {
-            QSharedPointer<PeerUser> peer(
-                new PeerUser(confPath, obj.toObject(), me.uuid()));
+    // Insert each instance into the data structure if valid
+    foreach (const UserRecord &record, records) {
+        QSharedPointer<PeerUser> peer(
+            new PeerUser(confPath, record, me.uuid()));
 
-            if (peer->valid() && peer->info().uuid() != me.uuid()) {
-                QString uuid = peer->info().uuid();
+        if (peer->valid() && peer->info().uuid() != me.uuid()) {
+            QString uuid = peer->info().uuid();
 
-                addPeerToList(peer);
-                LOG_INFO() << "Peerslist:" << qUtf8Printable(uuid) << "added";
-            } else {
-                LOG_WARNING() << "Peerslist: invalid record found";
-            }
+            addPeerToList(peer);
+            LOG_INFO() << "Peerslist:" << qUtf8Printable(uuid) << "added";
+        } else {
+            LOG_WARNING() << "Peerslist: invalid record found";
+            invalid.append(record.uuid);
         }
-    } else {
-        LOG_WARNING() << "Peerslist: impossible to read information from file:"
-                      << error;
     }
+    m_store->remove(invalid);
+
+    // Remove from the icon pack the icons no longer referenced by any user
+    QSet<QByteArray> live;
+    if (me.icon().set()) {
+        live.insert(me.icon().hash());
+    }
+    foreach (const QSharedPointer<PeerUser> &peer, m_instances) {
+        if (peer->info().icon().set()) {
+            live.insert(peer->info().icon().hash());
+        }
+    }
+    UserIconPack::instance(m_confPath)->compact(live);
+
+    // Complete the verification of the icons loaded in background
+    connect(m_iconLoader, &UserIconLoader::loaded, this,
+            [this](const QString &uuid, const QByteArray &hash,
+                   const QImage &image) {
+                auto it = m_instances.find(uuid);
+                if (it != m_instances.end()) {
+                    it.value()->iconLoaded(hash, !image.isNull());
+                }
+            });
+
+    // Set the icons retrieved from the peers
+    connect(m_iconScheduler, &SyfitScheduler::fetched, this,
+            [this](const QString &uuid, const UserIcon &icon) {
+                auto it = m_instances.find(uuid);
+                if (it != m_instances.end()) {
+                    it.value()->iconFetched(icon);
+                }
+            });
+
+    // Keep the snapshot of the reception preferences of the active peers
+    // updated (the anonymous user is always active)
+    connect(this, &PeersList::peerAdded, this,
+            [this](const QString &uuid) { updateReceptionPolicy(uuid); });
+    connect(this, &PeersList::peerUpdated, this,
+            [this](const QString &uuid) { updateReceptionPolicy(uuid); });
+    connect(this, &PeersList::peerExpired, this,
+            [this](const QString &uuid) { updateReceptionPolicy(uuid); });
+    updateReceptionPolicy(User::ANONYMOUS_UUID);
 
     // Initialize the timer used to increase the age of the peers
-    connect(m_timerAge, &QTimer::timeout, this, [this]() { incrementAge(); });
+    connect(m_timerAge, &CoalescedTimer::timeout, this,
+            [this]() { incrementAge(); });
     m_timerAge->start(AGING_INTERVAL);
 
+    // Initialize the timer used to save the changes
+    m_timerSave->setSingleShot(true);
+    m_timerSave->setInterval(PeersList::SAVE_DELAY);
+    connect(m_timerSave, &QTimer::timeout, this, [this]() { save(); });
+    scheduleSave();
+
     LOG_INFO() << "PeersList: initialization completed";
 }
 
 ///
 /// The function, to be executed every time a new datagram is received from
-/// the network, is in charge of keeping the peers list updated.
+/// the network, is in charge of keeping the peers list updated, by dispatching
+/// it to the handler corresponding to its type.
+///
+/// \see updateProfile()
+/// \see updateHeartbeat()
+///
+void PeersList::update(const SyfdDatagram &datagram)
+{
+    LOG_ASSERT_X(datagram.valid(),
+                 "PeersList: trying to update with an invalid datagram");
+
+    switch (datagram.type()) {
+    case SyfdDatagram::Type::Profile:
+        updateProfile(datagram);
+        break;
+    case SyfdDatagram::Type::Heartbeat:
+        updateHeartbeat(SyfdDatagramView::prefixKey(
+                            reinterpret_cast<const uchar *>(
+                                datagram.uuidPrefix().constData())),
+                        datagram.sequence(), datagram.flagQuit());
+        break;
+    case SyfdDatagram::Type::Digest:
+        updateDigest(datagram);
+        break;
+    case SyfdDatagram::Type::ProfileRequest:
+    case SyfdDatagram::Type::Solicit:
+        // Requests are directly managed by the SyfdProtocol
+        break;
+    }
+}
+
+///
+/// The function, executed every time a profile is received from the network,
+/// updates the information about the corresponding peer.
 ///
 /// The datagram is initially checked to verify if the quit flag is set:
 /// in this case the quitting user is marked as expired and the peerExpired()
@@ -311,11 +297,8 @@ PeersList::PeersList(const QString &confPath, LocalUser *localUser)
 /// much harder) and in that case the duplicatedNamesDetected() signal is
 /// emitted.
 ///
-void PeersList::update(const SyfdDatagram &datagram)
+void PeersList::updateProfile(const SyfdDatagram &datagram)
 {
-    LOG_ASSERT_X(datagram.valid(),
-                 "PeersList: trying to update with an invalid datagram");
-
     QString uuid = datagram.uuid();
 
     // Check if user is quitting
@@ -397,6 +380,75 @@ void PeersList::update(const SyfdDatagram &datagram)
     return;
 }
 
+///
+/// The function, executed every time a heartbeat is received from the network,
+/// checks whether the quit flag is set: in this case the peer is marked as
+/// expired and the peerExpired() signal is emitted. Otherwise, the peer is
+/// refreshed through refreshPeer(). The fields are received separately, so
+/// that the SyfdProtocol dispatches the heartbeats without building a
+/// SyfdDatagram.
+///
+void PeersList::updateHeartbeat(quint64 prefixKey, quint32 sequence,
+                                bool quit)
+{
+    // Check if user is quitting
+    if (quit) {
+        QString uuid = m_prefixes.value(prefixKey);
+        QSharedPointer<PeerUser> peer = m_instances.value(uuid);
+        if (peer && peer->setUnconfirmed()) {
+            LOG_INFO() << "PeersList:" << qUtf8Printable(uuid) << "quitted";
+            emit peerExpired(uuid);
+        }
+        return;
+    }
+
+    refreshPeer(prefixKey, sequence);
+}
+
+///
+/// The function, executed every time a digest is received from the network,
+/// refreshes all the peers it summarizes (except the local user) through
+/// refreshPeer().
+///
+void PeersList::updateDigest(const SyfdDatagram &datagram)
+{
+    QByteArray localPrefix =
+        SyfdDatagram::prefixFromUuid(m_localUser->info().uuid());
+
+    foreach (const SyfdDatagram::DigestEntry &entry,
+             datagram.digestEntries()) {
+        if (entry.first != localPrefix) {
+            refreshPeer(SyfdDatagramView::prefixKey(
+                            reinterpret_cast<const uchar *>(
+                                entry.first.constData())),
+                        entry.second);
+        }
+    }
+}
+
+///
+/// The function looks for the peer identified by the UUID prefix: in case it
+/// is found and the profile sequence number matches the cached one, the peer
+/// is simply confirmed as active. In all the other cases (unknown or
+/// unconfirmed peer, outdated profile) the profileRequested() signal is emitted
+/// to ask the peer to send again its full profile.
+///
+void PeersList::refreshPeer(quint64 prefixKey, quint32 sequence)
+{
+    QSharedPointer<PeerUser> peer =
+        m_instances.value(m_prefixes.value(prefixKey));
+
+    // Check if the cached profile is up to date
+    if (peer && peer->refresh(sequence)) {
+        if (peer->toBeSaved()) {
+            scheduleSave();
+        }
+        return;
+    }
+
+    emit profileRequested(SyfdDatagramView::prefixFromKey(prefixKey));
+}
+
 ///
 /// The function searches the peers list for the user identified by the
 /// specified UUID. In case it is found, a copy of the UserInfo instance is
@@ -450,6 +502,29 @@ QHash<QString, UserInfo> PeersList::activePeers() const
     return peers;
 }
 
+///
+/// The icon is loaded through the UserIconLoader only in case it is set but
+/// not yet verified (i.e. read from the configuration and never displayed).
+/// If it is being requested to the peer, instead, the request is prioritized
+/// by the SyfitScheduler, since the icon is currently displayed.
+///
+void PeersList::loadIcon(const QString &uuid)
+{
+    auto it = m_instances.constFind(uuid);
+    if (it == m_instances.constEnd()) {
+        return;
+    }
+
+    const UserIcon &icon = it.value()->info().icon();
+    if (icon.set() && !icon.verified()) {
+        m_iconLoader->load(uuid, icon);
+    } else if (!it.value()->iconRequest().isEmpty()) {
+        bool result = QMetaObject::invokeMethod(m_iconScheduler, "prioritize",
+                                                Q_ARG(QString, uuid));
+        LOG_ASSERT_X(result, "PeersList: failed invoking prioritize()");
+    }
+}
+
 ///
 /// The function proceeds by setting preferences for the specified user. In
 /// case the given UUID does not exist, nothing is performed.
@@ -538,25 +613,110 @@ void PeersList::checkDuplicatedNames(const QString &firstName,
 ///
 /// The function inserts a new user to list, after having connected the
 /// signal in charge of retriggering the signal emitted in case of icon
-/// updated.
+/// updated and the ones forwarding the icon requests to the SyfitScheduler.
+/// The UUID prefix is also recorded to allow heartbeats lookups.
 ///
 void PeersList::addPeerToList(const QSharedPointer<PeerUser> &instance)
 {
-    QString uuid = instance->info().uuid();
+    UserInfo info = instance->info();
+    QString uuid = info.uuid();
 
     // Connect the signal in case of icon updated
     connect(instance.data(), &User::updatedIcon, this,
             [this, uuid]() { emit peerUpdated(uuid); });
 
+    // Connect the signals to save the changes
+    connect(instance.data(), &User::updated, this,
+            [this]() { scheduleSave(); });
+
+    // Connect the signal to update the snapshot of the reception preferences
+    connect(instance.data(), &User::updated, this,
+            [this, uuid]() { updateReceptionPolicy(uuid); });
+    connect(instance.data(), &User::updatedIcon, this,
+            [this]() { scheduleSave(); });
+
+    // Connect the signals to request the icon to the peer
+    connect(instance.data(), &PeerUser::iconRequested, m_iconScheduler,
+            &SyfitScheduler::request);
+    connect(instance.data(), &PeerUser::iconRequestCancelled, m_iconScheduler,
+            &SyfitScheduler::cancel);
+
+    // Forward the request issued during the creation of the instance (if any)
+    if (!instance->iconRequest().isEmpty()) {
+        bool result = QMetaObject::invokeMethod(
+            m_iconScheduler, "request", Q_ARG(QString, uuid),
+            Q_ARG(quint32, info.ipv4Address()), Q_ARG(quint16, info.iconPort()),
+            Q_ARG(QByteArray, instance->iconRequest()));
+        LOG_ASSERT_X(result, "PeersList: failed invoking request()");
+    }
+
     // Add the new user to the list
     m_instances.insert(uuid, instance);
+    QByteArray prefix = SyfdDatagram::prefixFromUuid(uuid);
+    if (prefix.length() == SyfdDatagram::PREFIX_LEN) {
+        const uchar *data = reinterpret_cast<const uchar *>(prefix.constData());
+        m_prefixes.insert(SyfdDatagramView::prefixKey(data), uuid);
+    }
 }
 
 ///
-/// The method saves the changes the peer list to file and then destroys
-/// the instances (done automatically by the destructor of the shared pointers)
+/// The reception preferences of the peer are copied to the snapshot shared
+/// with the receivers in case it is active, while they are removed otherwise
+/// (so that the requests are handled by the main thread as before).
+///
+void PeersList::updateReceptionPolicy(const QString &uuid)
+{
+    UserInfo info = activePeer(uuid);
+    if (info.valid()) {
+        m_receptionPolicy->setPeer(uuid, info.names(), info.preferences());
+    } else {
+        m_receptionPolicy->removePeer(uuid);
+    }
+}
+
+///
+/// The timer is started only if not already active, so that the changes are
+/// coalesced while still being saved at most SAVE_DELAY after the first one
+/// (even if the peers keep changing).
+///
+void PeersList::scheduleSave()
+{
+    if (!m_timerSave->isActive()) {
+        m_timerSave->start();
+    }
+}
+
+///
+/// Only the instances marked to be saved (through the to be saved flag) are
+/// written to the store, which appends them asynchronously.
+///
+void PeersList::save()
+{
+    QList<UserRecord> records;
+    foreach (const QSharedPointer<PeerUser> &peer, m_instances) {
+        if (peer->toBeSaved()) {
+            UserRecord record;
+            peer->save(record);
+            records.append(record);
+        }
+    }
+
+    if (!records.isEmpty()) {
+        m_store->put(records);
+        LOG_INFO() << "PeersList:" << records.size() << "peers saved";
+    }
+}
+
+///
+/// The method saves the changes the peer list and then destroys the instances
+/// (done automatically by the destructor of the shared pointers), waiting for
+/// the pending writes to complete.
 ///
 PeersList::~PeersList()
 {
-    saveToFile(m_confPath + PeersList::JSON_PATH, m_instances.values());
+    m_timerSave->stop();
+    save();
+
+    // The scheduler is destroyed in its thread
+    m_iconScheduler->deleteLater();
 }
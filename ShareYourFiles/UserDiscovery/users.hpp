@@ -27,16 +27,24 @@
 
 class QTimer;
 
+class CoalescedTimer;
 class LocalUser;
 class PeerUser;
+class ReceptionPolicy;
 class SyfdDatagram;
 class SyfftProtocolSender;
+class SyfitScheduler;
+class UserIconLoader;
+class UserStore;
 
 ///
 /// \brief The LocalInstance class provides a simple wrapper to the LocalUser
 /// instance, managing reading and writing operations from and to the
 /// configuration file.
 ///
+/// The changes are saved asynchronously through a UserStore, shortly after
+/// the updated() signal is emitted (multiple changes are coalesced).
+///
 class LocalInstance : public QObject
 {
     Q_OBJECT
@@ -46,7 +54,8 @@ public:
     /// \brief Builds a new instance of this class.
     /// \param confPath the base path where configuration files are stored.
     /// \param dataPath the default path where received files are stored.
-    /// \param ipv4Address the address chosen to be used as source address.
+    /// \param ipv4Address the address chosen to be used as source address (0
+    /// if not yet known, to be set through LocalUser::updateLocalAddress()).
     ///
     explicit LocalInstance(const QString &confPath, const QString &dataPath,
                            quint32 ipv4Address);
@@ -63,14 +72,32 @@ public:
     ~LocalInstance();
 
 private:
+    ///
+    /// \brief Saves the changes of the local user (if any).
+    ///
+    void save();
+
     QString m_confPath; ///< \brief The base path.
 
+    /// \brief The store where the information is saved.
+    QScopedPointer<UserStore> m_store;
     /// \brief The actual LocalUser instance.
     QScopedPointer<LocalUser> m_instance;
+    /// \brief The UUID of the record currently saved.
+    QString m_savedUuid;
+
+    /// \brief The timer used to delay the saving of the changes.
+    QPointer<QTimer> m_timerSave;
 
     /// \brief The relative path (with respect to confPath), where the
     /// configuration file is located.
-    static const QString JSON_PATH;
+    static const QString STORE_PATH;
+    /// \brief The relative path (with respect to confPath), where the
+    /// configuration file used by the previous versions is located.
+    static const QString LEGACY_PATH;
+
+    /// \brief The delay between a change and its saving (in milliseconds).
+    static const int SAVE_DELAY = 1000;
 };
 
 
@@ -81,6 +108,10 @@ private:
 /// In particular, the class actually stores a hash map in order to provide fast
 /// lookups of instances given their identifier (the UUID).
 ///
+/// The peers are saved through a UserStore: the instances modified are written
+/// periodically (at most SAVE_DELAY after the first change), while the peers
+/// not seen for longer than PEER_MAX_AGE are removed when the list is loaded.
+///
 class PeersList : public QObject
 {
     Q_OBJECT
@@ -106,6 +137,14 @@ public:
     ///
     void update(const SyfdDatagram &datagram);
 
+    ///
+    /// \brief Updates the peers list given the fields of a heartbeat.
+    /// \param prefixKey the UUID prefix of the peer (converted to a number).
+    /// \param sequence the profile sequence number advertised.
+    /// \param quit whether the quit flag is set.
+    ///
+    void updateHeartbeat(quint64 prefixKey, quint32 sequence, bool quit);
+
     ///
     /// \brief Returns the information relative to the specified user.
     /// \param uuid the identifier of the requested user.
@@ -129,6 +168,21 @@ public:
     ///
     QHash<QString, UserInfo> activePeers() const;
 
+    ///
+    /// \brief Loads in background the icon of the specified user, in case it
+    /// has not been verified yet, or gives priority to its request in case it
+    /// is being retrieved from the peer (otherwise nothing is done).
+    /// \param uuid the identifier of the requested user.
+    ///
+    /// The peerUpdated() signal is emitted once the icon is available.
+    ///
+    void loadIcon(const QString &uuid);
+
+    ///
+    /// \brief Returns the base path where configuration files are stored.
+    ///
+    const QString &confPath() const { return m_confPath; }
+
     ///
     /// \brief Sets the reception preferences for the given user.
     /// \param uuid the identifier of the requested user.
@@ -178,35 +232,96 @@ signals:
     /// \param uuid the identifier of the responsible user.
     void duplicatedNameDetected(QString uuid);
 
+    /// \brief Signal emitted when the full profile of a peer is needed.
+    /// \param uuidPrefix the prefix of the UUID identifying the peer.
+    void profileRequested(QByteArray uuidPrefix);
+
 private:
+    ///
+    /// \brief Updates the peers list given a SyfdDatagram of type profile.
+    /// \param datagram the datagram received from the network.
+    ///
+    void updateProfile(const SyfdDatagram &datagram);
+
+    ///
+    /// \brief Updates the peers list given a SyfdDatagram of type digest.
+    /// \param datagram the datagram received from the network.
+    ///
+    void updateDigest(const SyfdDatagram &datagram);
+
+    ///
+    /// \brief Confirms the presence of a peer or requests its profile.
+    /// \param prefixKey the UUID prefix identifying the peer (converted to a
+    /// number).
+    /// \param sequence the profile sequence number advertised.
+    ///
+    void refreshPeer(quint64 prefixKey, quint32 sequence);
+
     ///
     /// \brief Adds a new user to the list of peers.
     /// \param instance the instance to be added.
     ///
     void addPeerToList(const QSharedPointer<PeerUser> &instance);
 
+    ///
+    /// \brief Updates the snapshot of the reception preferences of a peer.
+    /// \param uuid the identifier of the peer.
+    ///
+    void updateReceptionPolicy(const QString &uuid);
+
     ///
     /// \brief Increments the age of all the instances saved in the list.
     ///
     void incrementAge();
 
+    ///
+    /// \brief Schedules the saving of the modified instances.
+    ///
+    void scheduleSave();
+
+    ///
+    /// \brief Saves the modified instances.
+    ///
+    void save();
+
 private:
     QString m_confPath; ///< \brief The base path.
     /// \brief The hash table containing the instances.
     QHash<QString, QSharedPointer<PeerUser>> m_instances;
+    /// \brief The hash table associating the UUID prefixes (converted to
+    /// numbers) to the UUIDs.
+    QHash<quint64, QString> m_prefixes;
 
     /// \brief The pointer to the instance representing the local user.s
     QPointer<LocalUser> m_localUser;
 
+    /// \brief The store where the instances are saved.
+    QScopedPointer<UserStore> m_store;
+
     /// \brief The timer used to increment the age of the instances.
-    QPointer<QTimer> m_timerAge;
+    QPointer<CoalescedTimer> m_timerAge;
+    /// \brief The timer used to delay the saving of the changes.
+    QPointer<QTimer> m_timerSave;
+    /// \brief The instance loading the icons in background.
+    QPointer<UserIconLoader> m_iconLoader;
+    /// \brief The instance requesting the icons to the peers (SYFD thread).
+    QPointer<SyfitScheduler> m_iconScheduler;
+    /// \brief The snapshot of the reception preferences (shared).
+    QSharedPointer<ReceptionPolicy> m_receptionPolicy;
 
     /// \brief The relative path (with respect to confPath), where the
     /// configuration file is located.
-    static const QString JSON_PATH;
+    static const QString STORE_PATH;
+    /// \brief The relative path (with respect to confPath), where the
+    /// configuration file used by the previous versions is located.
+    static const QString LEGACY_PATH;
 
     /// \brief Interval between executions of incrementAge().
     static const int AGING_INTERVAL = 5000;
+    /// \brief The maximum delay between a change and its saving (in ms).
+    static const int SAVE_DELAY = 2000;
+    /// \brief The age after which the peers not seen are forgotten (in ms).
+    static const qint64 PEER_MAX_AGE = Q_INT64_C(90) * 24 * 60 * 60 * 1000;
 };
 
 #endif // USERS_HPP
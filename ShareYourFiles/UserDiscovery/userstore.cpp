@@ -0,0 +1,564 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "userstore.hpp"
+#include "Common/common.hpp"
+#include "Common/logging.hpp"
+#include "syfddatagram.hpp"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QUuid>
+#include <QVariant>
+#include <QVector>
+#include <QtEndian>
+
+#include <cstring>
+
+// Static variables definition
+const char UserStore::MAGIC[] = "SYFU";
+
+
+///
+/// \brief The UserStoreTask class represents a write to the file of a
+/// UserStore, executed by its worker thread.
+///
+class UserStoreTask : public QRunnable
+{
+public:
+    ///
+    /// \brief Builds a new instance of this class.
+    /// \param store the instance the data is written for.
+    /// \param data the entries to be written.
+    /// \param rewrite specifies whether the file is to be rewritten.
+    ///
+    explicit UserStoreTask(UserStore *store, const QByteArray &data,
+                           bool rewrite)
+            : m_store(store), m_data(data), m_rewrite(rewrite)
+    {
+    }
+
+    ///
+    /// \brief Writes the data to the file.
+    ///
+    void run() override { m_store->write(m_data, m_rewrite); }
+
+private:
+    UserStore *m_store; ///< \brief The instance the data is written for.
+    QByteArray m_data;  ///< \brief The entries to be written.
+    bool m_rewrite;     ///< \brief Whether the file is to be rewritten.
+};
+
+
+///
+/// \brief Returns the header of the file.
+/// \param magic the magic string.
+/// \param version the version of the format.
+/// \return the header (magic string, version and reserved bytes).
+///
+static QByteArray storeHeader(const char *magic, quint8 version)
+{
+    QByteArray header(magic, 4);
+    header.append(static_cast<char>(version));
+    header.append(3, '\0');
+    return header;
+}
+
+///
+/// \brief Serializes a record.
+/// \param record the record to be serialized.
+/// \return the array of bytes representing the record.
+///
+static QByteArray serialize(const UserRecord &record)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << record;
+    return payload;
+}
+
+
+/******************************************************************************/
+
+
+///
+/// The record is built from the fields used by the previous versions of the
+/// application; since the time the user was last seen is unknown, the current
+/// one is used. In case the icon hash is not valid, the icon is not set.
+///
+UserRecord UserRecord::fromJson(const QJsonObject &json)
+{
+    UserRecord record;
+
+    // Check if the object contains the mandatory fields
+    if (!json.contains("UUID") || !json.contains("First") ||
+        !json.contains("Last")) {
+        return record;
+    }
+
+    record.uuid = json["UUID"].toString();
+    record.firstName = json["First"].toString();
+    record.lastName = json["Last"].toString();
+
+    // Icon hash
+    if (json["Icon"].toBool(false)) {
+        QString strHash = json["IconHash"].toString("");
+        QRegularExpression hexMatcher(
+            "^[0-9A-F]*$", QRegularExpression::CaseInsensitiveOption);
+
+        if (strHash.length() == SyfdDatagram::HASH_LEN * 2 &&
+            hexMatcher.match(strHash).hasMatch()) {
+            record.iconHash = QByteArray::fromHex(strHash.toLatin1());
+        }
+    }
+
+    // Reception preferences
+    bool useDefaults = json["RP_UseDefaults"].toBool(true) ||
+                       !json.contains("RP_Action") || !json.contains("RP_Path");
+    if (!useDefaults) {
+        ReceptionPreferences::Action action = ReceptionPreferences::Action::Ask;
+        QVariant vaction = json["RP_Action"].toVariant();
+        if (vaction.canConvert<ReceptionPreferences::Action>()) {
+            action = vaction.value<ReceptionPreferences::Action>();
+        }
+
+        record.preferences = ReceptionPreferences(
+            action, json["RP_Path"].toString(),
+            json["RP_FolderUser"].toBool(false),
+            json["RP_FolderDate"].toBool(false));
+    }
+
+    record.aggregator = json["Aggregator"].toBool(false);
+    record.lastSeen = QDateTime::currentMSecsSinceEpoch();
+    return record;
+}
+
+///
+/// The UserRecord instance is written to the stream according to the following
+/// format: the UUID, the first and the last names, the icon hash (empty if not
+/// set), the reception preferences (a flag indicating if the default ones are
+/// used, followed by the action, the path and the folder flags otherwise), the
+/// aggregator flag and the last time the user was seen.
+///
+/// \see operator>>()
+///
+QDataStream &operator<<(QDataStream &out, const UserRecord &record)
+{
+    out << QUuid(record.uuid);
+    out << record.firstName << record.lastName;
+    out << record.iconHash;
+
+    const ReceptionPreferences &preferences = record.preferences;
+    out << preferences.useDefaults();
+    if (!preferences.useDefaults()) {
+        out << static_cast<quint8>(preferences.action());
+        out << preferences.path();
+        out << preferences.folderUser() << preferences.folderDate();
+    }
+
+    out << record.aggregator << record.lastSeen;
+    return out;
+}
+
+///
+/// The UserRecord instance is read from the stream according to the format
+/// described by operator<<(). In case of invalid data, the status of the stream
+/// is different from Ok and the record is left unchanged.
+///
+/// \see operator<<()
+///
+QDataStream &operator>>(QDataStream &in, UserRecord &record)
+{
+    QUuid uuid;
+    QString firstName, lastName;
+    QByteArray iconHash;
+    bool useDefaults = true;
+    in >> uuid >> firstName >> lastName >> iconHash >> useDefaults;
+
+    ReceptionPreferences preferences;
+    if (!useDefaults) {
+        quint8 action = 0;
+        QString path;
+        bool folderUser = false, folderDate = false;
+        in >> action >> path >> folderUser >> folderDate;
+
+        const quint8 last =
+            static_cast<quint8>(ReceptionPreferences::Action::Reject);
+        if (action > last) {
+            in.setStatus(QDataStream::Status::ReadCorruptData);
+        }
+        preferences = ReceptionPreferences(
+            static_cast<ReceptionPreferences::Action>(action), path,
+            folderUser, folderDate);
+    }
+
+    bool aggregator = false;
+    qint64 lastSeen = 0;
+    in >> aggregator >> lastSeen;
+
+    // If the stream status is not ok, something went wrong
+    if (in.status() != QDataStream::Status::Ok || uuid.isNull()) {
+        in.setStatus(QDataStream::Status::ReadCorruptData);
+        return in;
+    }
+
+    record.uuid = uuid.toString();
+    record.firstName = firstName;
+    record.lastName = lastName;
+    record.iconHash = iconHash;
+    record.preferences = preferences;
+    record.aggregator = aggregator;
+    record.lastSeen = lastSeen;
+    return in;
+}
+
+
+/******************************************************************************/
+
+
+///
+/// A single worker thread is used, so that the writes are executed in the same
+/// order they are submitted.
+///
+UserStore::UserStore(const QString &filePath, const QString &legacyPath)
+        : m_filePath(filePath), m_legacyPath(legacyPath)
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+///
+/// The pending writes are completed before destroying the instance, so that
+/// no change is lost at exit.
+///
+UserStore::~UserStore()
+{
+    m_pool.waitForDone();
+    m_file.close();
+}
+
+///
+/// The file is mapped in memory and the entries are scanned to find the last
+/// one associated to each user, without decoding the records: only the ones
+/// surviving (neither replaced, nor removed) are then decoded. The scan stops
+/// at the first entry which is truncated or whose checksum does not match.
+///
+/// The file is rewritten in background (containing only the records returned)
+/// in case some record expired, some data at the end has been discarded or
+/// the space occupied by the superseded entries is both larger than
+/// COMPACT_MIN_WASTE and than the one of the live records. In case the file
+/// does not exist, the legacy configuration is imported (if present).
+///
+QList<UserRecord> UserStore::load(qint64 maxAge)
+{
+    QList<UserRecord> records;
+
+    // Check if the path exists and create it otherwise
+    QDir directory = QFileInfo(m_filePath).absoluteDir();
+    if (!directory.mkpath(".")) {
+        LOG_ERROR() << "UserStore: impossible to create directory"
+                    << directory.absolutePath();
+        return records;
+    }
+
+    // Import the legacy configuration if necessary
+    if (!QFile::exists(m_filePath)) {
+        records = migrate();
+
+        QByteArray data;
+        foreach (const UserRecord &record, records) {
+            data.append(entry(Operation::Put, record.uuid, serialize(record)));
+        }
+        if (write(data, true) && !records.isEmpty()) {
+            QFile::remove(m_legacyPath);
+        }
+        return records;
+    }
+
+    // Open and map the file
+    QFile file(m_filePath);
+    if (!file.open(QFile::ReadOnly)) {
+        LOG_ERROR() << "UserStore: impossible to open" << m_filePath << "-"
+                    << file.errorString();
+        return records;
+    }
+
+    qint64 size = file.size();
+    uchar *data = Q_NULLPTR;
+    if (size >= UserStore::HEADER_LEN) {
+        data = file.map(0, size);
+        if (!data) {
+            LOG_ERROR() << "UserStore: impossible to map" << m_filePath << "-"
+                        << file.errorString();
+            return records;
+        }
+    }
+
+    // Check the header
+    if (!data || std::memcmp(data, UserStore::MAGIC, 4) != 0 ||
+        data[4] != UserStore::VERSION) {
+        LOG_WARNING() << "UserStore: invalid file detected, discarded -"
+                      << m_filePath;
+        submit(QByteArray(), true);
+        return records;
+    }
+
+    // Find the last entry associated to each user
+    struct Entry {
+        qint64 offset;  // The offset of the entry
+        quint32 length; // The length of the body
+    };
+    QHash<QByteArray, Entry> latest;
+
+    qint64 end = UserStore::HEADER_LEN;
+    while (size - end >= UserStore::ENTRY_HEADER_LEN) {
+        quint32 length = qFromLittleEndian<quint32>(data + end);
+        quint16 checksum = qFromLittleEndian<quint16>(data + end + 4);
+        const uchar *body = data + end + UserStore::ENTRY_HEADER_LEN;
+
+        if (length < 1 + Constants::UUID_LEN ||
+            length > UserStore::MAX_ENTRY_LEN ||
+            size - end - UserStore::ENTRY_HEADER_LEN < length ||
+            qChecksum(reinterpret_cast<const char *>(body), length) !=
+                checksum) {
+            break;
+        }
+
+        QByteArray uuid(reinterpret_cast<const char *>(body + 1),
+                        Constants::UUID_LEN);
+        if (body[0] == Operation::Put) {
+            latest.insert(uuid, Entry{end, length});
+        } else if (body[0] == Operation::Remove) {
+            latest.remove(uuid);
+        } else {
+            break;
+        }
+
+        end += UserStore::ENTRY_HEADER_LEN + length;
+    }
+
+    // Decode the surviving records
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 liveBytes = 0;
+    bool expired = false;
+    QVector<Entry> live;
+    live.reserve(latest.size());
+
+    for (auto it = latest.constBegin(); it != latest.constEnd(); ++it) {
+        const int skip = UserStore::ENTRY_HEADER_LEN + 1 + Constants::UUID_LEN;
+        QByteArray payload = QByteArray::fromRawData(
+            reinterpret_cast<const char *>(data + it.value().offset + skip),
+            static_cast<int>(it.value().length) - 1 - Constants::UUID_LEN);
+
+        QDataStream stream(payload);
+        stream.setVersion(QDataStream::Qt_5_6);
+        UserRecord record;
+        stream >> record;
+
+        if (stream.status() != QDataStream::Status::Ok) {
+            LOG_WARNING() << "UserStore: invalid record found, discarded";
+            expired = true;
+            continue;
+        }
+
+        if (maxAge > 0 && now - record.lastSeen > maxAge) {
+            LOG_INFO() << "UserStore:" << qUtf8Printable(record.uuid)
+                       << "not seen for too long, removed";
+            expired = true;
+            continue;
+        }
+
+        records.append(record);
+        live.append(it.value());
+        liveBytes += UserStore::ENTRY_HEADER_LEN + it.value().length;
+    }
+
+    // Rewrite the file if necessary
+    qint64 wasted = size - UserStore::HEADER_LEN - liveBytes;
+    if (expired || end < size ||
+        (wasted >= UserStore::COMPACT_MIN_WASTE && wasted > liveBytes)) {
+        LOG_INFO() << "UserStore: compacting" << m_filePath << "("
+                   << wasted << "bytes wasted )";
+
+        QByteArray compacted;
+        compacted.reserve(static_cast<int>(liveBytes));
+        foreach (const Entry &kept, live) {
+            compacted.append(reinterpret_cast<const char *>(data + kept.offset),
+                             UserStore::ENTRY_HEADER_LEN + kept.length);
+        }
+        submit(compacted, true);
+    }
+
+    file.unmap(data);
+    LOG_INFO() << "UserStore:" << records.size() << "records read from"
+               << m_filePath;
+    return records;
+}
+
+void UserStore::put(const QList<UserRecord> &records)
+{
+    QByteArray data;
+    foreach (const UserRecord &record, records) {
+        data.append(entry(Operation::Put, record.uuid, serialize(record)));
+    }
+
+    if (!data.isEmpty()) {
+        submit(data, false);
+    }
+}
+
+void UserStore::remove(const QStringList &uuids)
+{
+    QByteArray data;
+    foreach (const QString &uuid, uuids) {
+        data.append(entry(Operation::Remove, uuid));
+    }
+
+    if (!data.isEmpty()) {
+        submit(data, false);
+    }
+}
+
+///
+/// The body of the entry is composed by the operation, the UUID (in binary
+/// format) and the payload, and it is preceded by its length and checksum
+/// (both in little endian).
+///
+QByteArray UserStore::entry(Operation operation, const QString &uuid,
+                            const QByteArray &payload)
+{
+    QByteArray body;
+    body.reserve(1 + Constants::UUID_LEN + payload.size());
+    body.append(static_cast<char>(operation));
+    body.append(QUuid(uuid).toRfc4122());
+    body.append(payload);
+
+    QByteArray entry(UserStore::ENTRY_HEADER_LEN, Qt::Uninitialized);
+    uchar *header = reinterpret_cast<uchar *>(entry.data());
+    qToLittleEndian<quint32>(static_cast<quint32>(body.size()), header);
+    qToLittleEndian<quint16>(qChecksum(body.constData(), body.size()),
+                             header + sizeof(quint32));
+    return entry + body;
+}
+
+///
+/// The legacy file contains either a single object (local user) or an array of
+/// objects (peers) in JSON format.
+///
+QList<UserRecord> UserStore::migrate()
+{
+    QList<UserRecord> records;
+
+    QFile file(m_legacyPath);
+    if (m_legacyPath.isEmpty() || !file.exists() ||
+        !file.open(QFile::ReadOnly)) {
+        return records;
+    }
+
+    LOG_INFO() << "UserStore: importing the configuration from"
+               << m_legacyPath;
+
+    QJsonDocument json = QJsonDocument::fromJson(file.readAll());
+    file.close();
+
+    QJsonArray array;
+    if (json.isArray()) {
+        array = json.array();
+    } else if (json.isObject()) {
+        array.append(json.object());
+    }
+
+    foreach (const QJsonValue &value, array) {
+        UserRecord record = UserRecord::fromJson(value.toObject());
+        if (!record.uuid.isEmpty()) {
+            records.append(record);
+        } else {
+            LOG_WARNING() << "UserStore: invalid legacy record found";
+        }
+    }
+
+    return records;
+}
+
+void UserStore::submit(const QByteArray &data, bool rewrite)
+{
+    m_pool.start(new UserStoreTask(this, data, rewrite));
+}
+
+///
+/// In case of rewrite, the new content is written to a temporary file which
+/// then atomically replaces the current one; otherwise, the data is appended
+/// and flushed (in case of error, the file is truncated to the previous size).
+///
+bool UserStore::write(const QByteArray &data, bool rewrite)
+{
+    QByteArray header = storeHeader(UserStore::MAGIC, UserStore::VERSION);
+
+    if (rewrite) {
+        m_file.close();
+
+        QSaveFile file(m_filePath);
+        if (!file.open(QSaveFile::WriteOnly) ||
+            file.write(header) != header.size() ||
+            file.write(data) != data.size() || !file.commit()) {
+            LOG_ERROR() << "UserStore: failed writing" << m_filePath << "-"
+                        << file.errorString();
+            return false;
+        }
+        return true;
+    }
+
+    // Open the file if necessary
+    if (!m_file.isOpen()) {
+        m_file.setFileName(m_filePath);
+        if (!m_file.open(QFile::ReadWrite)) {
+            LOG_ERROR() << "UserStore: failed opening" << m_filePath << "-"
+                        << m_file.errorString();
+            return false;
+        }
+
+        if (m_file.size() < UserStore::HEADER_LEN &&
+            (!m_file.resize(0) || m_file.write(header) != header.size())) {
+            LOG_ERROR() << "UserStore: failed writing" << m_filePath << "-"
+                        << m_file.errorString();
+            m_file.close();
+            return false;
+        }
+    }
+
+    // Append the data
+    qint64 offset = m_file.size();
+    if (!m_file.seek(offset) || m_file.write(data) != data.size() ||
+        !m_file.flush()) {
+        LOG_ERROR() << "UserStore: failed writing" << m_filePath << "-"
+                    << m_file.errorString();
+        m_file.resize(offset);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,207 @@
+/*
+ *  Copyright (c) 2017 Marco Iorio (giorio94 at gmail dot com)
+ *  This file is part of Share Your Files (SYF).
+ *
+ *  SYF is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  SYF is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef USERSTORE_HPP
+#define USERSTORE_HPP
+
+#include "receptionpreferences.hpp"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+class QJsonObject;
+
+///
+/// \brief The UserRecord class contains the persistent information about a
+/// user, as stored by the UserStore.
+///
+struct UserRecord {
+    ///
+    /// \brief Builds an empty record (not valid since the UUID is missing).
+    ///
+    explicit UserRecord() : aggregator(false), lastSeen(0) {}
+
+    ///
+    /// \brief Builds a record from a JSON object in the legacy format.
+    /// \param json the JSON object containing information about the user.
+    /// \return the record built (with an empty UUID in case of error).
+    ///
+    static UserRecord fromJson(const QJsonObject &json);
+
+    QString uuid;      ///< \brief The identifier of the user.
+    QString firstName; ///< \brief The first name of the user.
+    QString lastName;  ///< \brief The last name of the user.
+    /// \brief The SHA-1 hash of the icon (empty if not set).
+    QByteArray iconHash;
+    /// \brief The reception preferences associated to the user.
+    ReceptionPreferences preferences;
+    /// \brief Whether the user can act as discovery aggregator (local only).
+    bool aggregator;
+    /// \brief The last time the user has been seen (milliseconds since epoch).
+    qint64 lastSeen;
+};
+
+///
+/// \brief Writes a UserRecord to a QDataStream.
+/// \param out the stream the data is written to.
+/// \param record the record to be written.
+/// \return the stream itself.
+///
+QDataStream &operator<<(QDataStream &out, const UserRecord &record);
+
+///
+/// \brief Reads a UserRecord from a QDataStream.
+/// \param in the stream the data is read from.
+/// \param record the record where the data is stored.
+/// \return the stream itself.
+///
+QDataStream &operator>>(QDataStream &in, UserRecord &record);
+
+
+///
+/// \brief The UserStore class persists a set of UserRecord instances to a
+/// compact binary file.
+///
+/// The file is an append-only change log: it starts with a header (magic string
+/// and version) and contains a sequence of entries, each one either replacing
+/// the record of a user or removing it. Every entry is composed by the length
+/// and the CRC-16 checksum of its body, the operation, the UUID of the user and
+/// the serialized record (only for replacements). Hence, the changes are saved
+/// by appending only the records actually modified, instead of rewriting the
+/// whole set every time.
+///
+/// At startup, the file is mapped in memory and scanned to find the last entry
+/// of each user, and only the surviving records are then decoded; entries that
+/// are truncated or corrupted (e.g. due to a crash) are discarded together with
+/// the following ones. The records not seen for longer than a given age are
+/// expired, and the file is rewritten in background when the space occupied by
+/// the superseded entries becomes significant. The configuration saved in the
+/// legacy JSON format (if any) is imported the first time.
+///
+/// The writes are executed asynchronously and in order by a dedicated worker
+/// thread, which is awaited when the instance is destroyed.
+///
+class UserStore
+{
+public:
+    ///
+    /// \brief Builds a new instance of this class.
+    /// \param filePath the path of the file where the records are stored.
+    /// \param legacyPath the path of the file storing the records in the
+    /// legacy JSON format.
+    ///
+    explicit UserStore(const QString &filePath, const QString &legacyPath);
+
+    ///
+    /// \brief Waits for the pending writes and destroys the instance.
+    ///
+    ~UserStore();
+
+    ///
+    /// \brief Reads the records stored in the file (to be called once, before
+    /// any write).
+    /// \param maxAge the age (in milliseconds) after which the records are
+    /// expired and removed (zero means never).
+    /// \return the records read.
+    ///
+    QList<UserRecord> load(qint64 maxAge = 0);
+
+    ///
+    /// \brief Saves the records given as parameter (asynchronously).
+    /// \param records the records to be added or replaced.
+    ///
+    void put(const QList<UserRecord> &records);
+
+    ///
+    /// \brief Removes the records of the given users (asynchronously).
+    /// \param uuids the identifiers of the users to be removed.
+    ///
+    void remove(const QStringList &uuids);
+
+private:
+    friend class UserStoreTask;
+
+    ///
+    /// \brief The Operation enum specifies the type of an entry.
+    ///
+    enum Operation : quint8 {
+        Put = 1,   ///< \brief Addition or replacement of a record.
+        Remove = 2 ///< \brief Removal of a record.
+    };
+
+    ///
+    /// \brief Builds an entry of the change log.
+    /// \param operation the type of the entry.
+    /// \param uuid the identifier of the user.
+    /// \param payload the serialized record (for replacements).
+    /// \return the entry built.
+    ///
+    static QByteArray entry(Operation operation, const QString &uuid,
+                            const QByteArray &payload = QByteArray());
+
+    ///
+    /// \brief Converts the records stored in the legacy file (if present).
+    /// \return the records read.
+    ///
+    QList<UserRecord> migrate();
+
+    ///
+    /// \brief Submits a write to the worker thread.
+    /// \param data the entries to be written.
+    /// \param rewrite specifies whether the file is to be rewritten.
+    ///
+    void submit(const QByteArray &data, bool rewrite);
+
+    ///
+    /// \brief Writes data to the file (executed by the worker thread).
+    /// \param data the entries to be written.
+    /// \param rewrite specifies whether the entries replace the whole content
+    /// of the file or they are appended.
+    /// \return true in case of success and false otherwise.
+    ///
+    bool write(const QByteArray &data, bool rewrite);
+
+    QString m_filePath;   ///< \brief The path of the file.
+    QString m_legacyPath; ///< \brief The path of the legacy JSON file.
+
+    /// \brief The file entries are appended to (used by the worker only).
+    QFile m_file;
+    /// \brief The pool executing the writes (a single thread).
+    QThreadPool m_pool;
+
+    /// \brief The magic string identifying the file.
+    static const char MAGIC[];
+    /// \brief The version of the format.
+    static const quint8 VERSION = 1;
+    /// \brief The length of the header of the file.
+    static const int HEADER_LEN = 8;
+    /// \brief The length of the header of an entry (length and checksum).
+    static const int ENTRY_HEADER_LEN = sizeof(quint32) + sizeof(quint16);
+    /// \brief The maximum length of an entry body.
+    static const quint32 MAX_ENTRY_LEN = 64 * 1024;
+    /// \brief The minimum wasted space triggering the rewrite (in bytes).
+    static const qint64 COMPACT_MIN_WASTE = 64 * 1024;
+};
+
+#endif // USERSTORE_HPP
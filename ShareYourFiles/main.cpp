@@ -16,25 +16,31 @@
  *  along with SYF.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "Common/asynclogappender.hpp"
 #include "Common/common.hpp"
+#include "Common/logging.hpp"
 #include "Common/networkentrieslist.hpp"
+#include "Control/controlserver.hpp"
 #include "FileTransfer/syfftprotocolreceiver.hpp"
 #include "FileTransfer/syfftprotocolsender.hpp"
 #include "FileTransfer/syfpprotocol.hpp"
 #include "FileTransfer/transferlist.hpp"
 #include "UserDiscovery/user.hpp"
+#include "UserDiscovery/usericoncache.hpp"
 #include "UserDiscovery/users.hpp"
 #include "shareyourfiles.hpp"
 
+#include "Gui/Wrappers/lazywindow.hpp"
 #include "Gui/Wrappers/peersselectormodel.hpp"
 #include "Gui/Wrappers/settingsmodel.hpp"
 #include "Gui/Wrappers/transfersmodel.hpp"
+#include "Gui/Wrappers/usericonprovider.hpp"
 
 #include <ConsoleAppender.h>
-#include <Logger.h>
 #include <RollingFileAppender.h>
 
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QFontDatabase>
 #include <QPointer>
 #include <QStandardPaths>
@@ -50,8 +56,12 @@
 #include <QQuickStyle>
 
 // Function declarations
+static int runService(int argc, char *argv[]);
+static void initPaths(QString &confPath, QString &dataPath);
 static void initLogger(const QString &logPath);
+static void initUserInterface(const QString &confPath);
 static void initSystemTrayIcon();
+static void completeSystemTrayIcon();
 static void initializeModeAction(QMenu *systemTrayMenu);
 static void initializeInterfaceSubmenu(QMenu *systemTrayMenu);
 static QActionGroup *initializeInterfaceActionGroup(QMenu *subMenu);
@@ -61,7 +71,7 @@ static void initializeQuitAction(QMenu *systemTrayMenu);
 static void initializeAboutActions(QMenu *systemTrayMenu);
 static void initializeSystemTrayMessages();
 
-static void peersSelector(const QStringList &paths);
+static void peersSelector(const TransferList &transferList);
 static void startTransfer(const QString &uuid, const TransferList &transferList,
                           const QString &message);
 static void setConnectionMessages(SyfftProtocolCommon *instance, bool sender);
@@ -70,12 +80,13 @@ static void setConnectionMessages(SyfftProtocolCommon *instance, bool sender);
 /// \brief The name of the application
 static const QString APP_NAME = QObject::tr("Share Your Files");
 
-/// \brief The index of the settings window inside the mainEngine object.
-static const int IDX_SETTINGS = 0;
-/// \brief The index of the transfers window inside the mainEngine object.
-static const int IDX_TRANSFERS = 1;
-/// \brief The index of the about window inside the mainEngine object.
-static const int IDX_ABOUT = 2;
+/// \brief The path (relative to the configuration one) of the transfers
+/// history.
+static const QString HISTORY_PATH = "/transfers.db";
+/// \brief The number of daily log files preserved.
+static const int LOG_FILES_LIMIT = 7;
+/// \brief The command line option starting the application in service mode.
+static const char *SERVICE_OPTION = "--daemon";
 
 
 /// \brief The object representing the system tray icon.
@@ -85,10 +96,21 @@ static QPointer<QMenu> systemTrayMenu;
 /// \brief The object including all the network entries actions.
 static QPointer<QActionGroup> entriesActionGroup;
 
-/// \brief The QML engine used for the settings and transfers windows.
+/// \brief The QML engine used for all the windows.
 static QPointer<QQmlApplicationEngine> mainEngine;
+/// \brief The component describing the peers selector window (compiled once).
+static QPointer<QQmlComponent> peersSelectorComponent;
 /// \brief The model containing all the active transfers.
 static QPointer<TransfersModel> transfersModel;
+/// \brief The server allowing other processes to control the application.
+static QPointer<ControlServer> controlServer;
+
+/// \brief The settings window (created when first shown).
+static QPointer<LazyWindow> settingsWindow;
+/// \brief The transfers window (created when first shown).
+static QPointer<LazyWindow> transfersWindow;
+/// \brief The about window (created when first shown).
+static QPointer<LazyWindow> aboutWindow;
 
 /// \brief Associates the operational mode to the corresponding string.
 static QMap<Enums::OperationalMode, QString> modeStringMap;
@@ -100,26 +122,35 @@ static QIcon errorIcon;
 ///
 /// \brief The entry point of Share Your Files.
 ///
+/// In case the SERVICE_OPTION is specified, the application is started in
+/// service mode (see runService()), otherwise the user interface is shown.
+///
 int main(int argc, char *argv[])
 {
+    for (int i = 1; i < argc; i++) {
+        if (qstrcmp(argv[i], SERVICE_OPTION) == 0) {
+            return runService(argc, argv);
+        }
+    }
+
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
 
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     QApplication app(argc, argv);
     app.setQuitOnLastWindowClosed(false);
     app.setWindowIcon(QIcon(":/Resources/IconGreen.svg"));
 
     // Build the base configuration and data paths
-    QString confPath =
-        QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
-    QString dataPath =
-        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
-        "/ShareYourFiles";
+    QString confPath, dataPath;
+    initPaths(confPath, dataPath);
 
     // Initialize the logger
     initLogger(dataPath);
 
-    // Create the ShareYourFiles instance
+    // Create the ShareYourFiles instance (the lock and the threads only)
     if (!ShareYourFiles::createInstance(confPath, dataPath)) {
         LOG_ERROR() << "Share Your Files: initialization failed";
         QString message(QObject::tr("Impossible to start the application.\n") +
@@ -132,7 +163,14 @@ int main(int argc, char *argv[])
     // Connect the slot to destroy the data structures before the termination
     QObject::connect(&app, &QCoreApplication::aboutToQuit, []() {
 
+        delete controlServer.data();
         qApp->closeAllWindows();
+
+        // Destroy the windows (if created) before the engine they belong to
+        delete settingsWindow.data();
+        delete transfersWindow.data();
+        delete aboutWindow.data();
+
         if (systemTrayMenu) {
             systemTrayMenu->deleteLater();
         }
@@ -143,36 +181,178 @@ int main(int argc, char *argv[])
         ShareYourFiles::destroyInstance();
     });
 
+    // Show the system tray icon immediately, while the remaining data
+    // structures are initialized in background
+    initSystemTrayIcon();
+    LOG_INFO() << "Share Your Files: system tray icon shown after"
+               << startupTimer.elapsed() << "ms";
+
+    // Complete the user interface once the initialization terminates
+    QObject::connect(
+        ShareYourFiles::instance(), &ShareYourFiles::initialized, &app,
+        [confPath, startupTimer](bool success) {
+            if (!success) {
+                LOG_ERROR() << "Share Your Files: initialization failed";
+                QString message(
+                    QObject::tr("Impossible to start the application.\n") +
+                    ShareYourFiles::instance()->errorMessage());
+                QMessageBox::critical(Q_NULLPTR, APP_NAME, message);
+                QCoreApplication::exit(-1);
+                return;
+            }
+
+            initUserInterface(confPath);
+            LOG_INFO() << "Share Your Files: startup completed after"
+                       << startupTimer.elapsed() << "ms";
+        });
+    ShareYourFiles::instance()->start();
+
+    // Enter the event loop
+    return app.exec();
+}
+
+///
+/// \brief Runs Share Your Files in service mode.
+/// \param argc the number of command line arguments.
+/// \param argv the command line arguments.
+/// \return the exit code of the application.
+///
+/// In service mode, neither the system tray icon nor the windows are created:
+/// the protocols are started as usual, and the application is controlled by
+/// other processes (e.g. the command line client) through the ControlServer,
+/// which also handles the incoming transfers.
+///
+static int runService(int argc, char *argv[])
+{
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
+    QCoreApplication app(argc, argv);
+
+    // Build the base configuration and data paths
+    QString confPath, dataPath;
+    initPaths(confPath, dataPath);
+
+    // Initialize the logger
+    initLogger(dataPath);
+
+    // Create the ShareYourFiles instance (the lock and the threads only)
+    if (!ShareYourFiles::createInstance(confPath, dataPath)) {
+        LOG_ERROR() << "Share Your Files: initialization failed -"
+                    << ShareYourFiles::instance()->errorMessage();
+        ShareYourFiles::destroyInstance();
+        return -1;
+    }
+
+    // Connect the slot to destroy the data structures before the termination
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, []() {
+        delete controlServer.data();
+        ShareYourFiles::destroyInstance();
+    });
+
+    // Start the control server once the initialization terminates
+    QObject::connect(
+        ShareYourFiles::instance(), &ShareYourFiles::initialized, &app,
+        [startupTimer](bool success) {
+            if (!success) {
+                LOG_ERROR() << "Share Your Files: initialization failed -"
+                            << ShareYourFiles::instance()->errorMessage();
+                QCoreApplication::exit(-1);
+                return;
+            }
+
+            controlServer = new ControlServer(true);
+            if (!controlServer->start()) {
+                QCoreApplication::exit(-1);
+                return;
+            }
+
+            LOG_INFO() << "Share Your Files: service started after"
+                       << startupTimer.elapsed() << "ms";
+        });
+    ShareYourFiles::instance()->start();
+
+    // Enter the event loop
+    return app.exec();
+}
+
+///
+/// \brief Builds the base configuration and data paths.
+/// \param confPath the variable set to the configuration path.
+/// \param dataPath the variable set to the data path.
+///
+static void initPaths(QString &confPath, QString &dataPath)
+{
+    confPath =
+        QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
+    dataPath =
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
+        "/ShareYourFiles";
+}
+
+///
+/// \brief Initializes the QML engine, the models and the windows, and completes
+/// the system tray icon (executed once ShareYourFiles is initialized).
+/// \param confPath the base path where the configuration files are stored.
+///
+static void initUserInterface(const QString &confPath)
+{
+    QElapsedTimer timer;
+    timer.start();
+
     // Initialize the QML main engine
     QQuickStyle::setStyle("Material");
     mainEngine = new QQmlApplicationEngine(ShareYourFiles::instance());
+    mainEngine->addImageProvider(UserIconCache::PROVIDER_NAME,
+                                 new UserIconProvider(confPath));
 
-    // Create the settings window
+    // Prepare the settings window (the windows are created only when first
+    // shown, and destroyed after having been hidden for a while)
     SettingsModel *model =
         new SettingsModel(ShareYourFiles::instance()->localUser(),
                           ShareYourFiles::instance()->peersList(), mainEngine);
     mainEngine->rootContext()->setContextProperty("settings", model);
-    mainEngine->load(QUrl(QStringLiteral("qrc:/Qml/Settings.qml")));
-
-    // Create the transfers window
-    transfersModel =
-        new TransfersModel(ShareYourFiles::instance()->localUser(),
-                           ShareYourFiles::instance()->peersList(), mainEngine);
+    settingsWindow = new LazyWindow(
+        mainEngine, QUrl(QStringLiteral("qrc:/Qml/Settings.qml")),
+        LazyWindow::RELEASE_DELAY, mainEngine);
+
+    // Prepare the transfers window (the dialogs related to the transfers are
+    // managed by an object always instantiated)
+    transfersModel = new TransfersModel(
+        ShareYourFiles::instance()->localUser(),
+        ShareYourFiles::instance()->peersList(), confPath + HISTORY_PATH,
+        mainEngine);
     mainEngine->rootContext()->setContextProperty("transfers", transfersModel);
-    mainEngine->load(QUrl(QStringLiteral("qrc:/Qml/Transfers.qml")));
+    mainEngine->load(QUrl(QStringLiteral("qrc:/Qml/TransferDialogs.qml")));
+    transfersWindow = new LazyWindow(
+        mainEngine, QUrl(QStringLiteral("qrc:/Qml/Transfers.qml")),
+        LazyWindow::RELEASE_DELAY, mainEngine);
 
-    // Create the about window
+    // Prepare the about window
     mainEngine->rootContext()->setContextProperty("version", QString(VERSION));
-    mainEngine->load(QUrl(QStringLiteral("qrc:/Qml/About.qml")));
+    aboutWindow = new LazyWindow(
+        mainEngine, QUrl(QStringLiteral("qrc:/Qml/About.qml")),
+        LazyWindow::RELEASE_DELAY, mainEngine);
 
+    // Compile the peers selector in background, so that it is ready to be
+    // instantiated as soon as a transfer is requested
+    peersSelectorComponent = new QQmlComponent(
+        mainEngine, QUrl(QStringLiteral("qrc:/Qml/PeersSelector.qml")),
+        QQmlComponent::Asynchronous, mainEngine);
 
-    // Initialize the System Tray Icon
-    initSystemTrayIcon();
+
+    // Complete the System Tray Icon
+    completeSystemTrayIcon();
 
     // Connect the signal to start a new transfer when requested
-    QObject::connect(ShareYourFiles::instance()->syfpProtocolInstance(),
-                     &SyfpProtocolServer::pathsReceived, mainEngine,
-                     peersSelector);
+    // (the requests received during the startup are delivered afterwards)
+    SyfpProtocolServer *syfp =
+        ShareYourFiles::instance()->syfpProtocolInstance();
+    QObject::connect(syfp, &SyfpProtocolServer::transferListReceived,
+                     mainEngine, peersSelector);
+    bool result =
+        QMetaObject::invokeMethod(syfp, "attach", Qt::QueuedConnection);
+    LOG_ASSERT_X(result, "Share Your Files: failed invoking attach()");
 
 
     // Connect the signal to start a new reception when requested
@@ -184,39 +364,72 @@ int main(int argc, char *argv[])
                          setConnectionMessages(receiver.data(), false);
 
                          // Show the transfers window
-                         mainEngine->rootObjects()
-                             .at(IDX_TRANSFERS)
-                             ->setProperty("visible", true);
+                         transfersWindow->show();
                      });
 
-    // Enter the event loop
-    return app.exec();
+    // Allow other processes to control the application (the incoming
+    // transfers are still handled by the user interface, while the outgoing
+    // ones are displayed as the others)
+    controlServer = new ControlServer(false);
+    QObject::connect(controlServer, &ControlServer::transferStarted, mainEngine,
+                     [](QSharedPointer<SyfftProtocolSender> sender) {
+                         transfersModel->addSyfftInstance(sender);
+                         setConnectionMessages(sender.data(), true);
+                     });
+    controlServer->start();
+
+    LOG_INFO() << "Share Your Files: user interface initialized after"
+               << timer.elapsed() << "ms";
 }
 
 ///
 /// \brief Shows the QML window to choose the recipients of the transfer.
-/// \param paths the base paths used to build a TransferList instance.
+/// \param transferList the files requested to be shared.
 ///
-static void peersSelector(const QStringList &paths)
+static void peersSelector(const TransferList &transferList)
 {
-    // Build a new transfer list from the list of paths
-    TransferList transferList(paths);
+    // If the component is still being compiled, retry once ready
+    if (peersSelectorComponent->isLoading()) {
+        QSharedPointer<QMetaObject::Connection> connection(
+            new QMetaObject::Connection());
+        *connection = QObject::connect(
+            peersSelectorComponent, &QQmlComponent::statusChanged,
+            [transferList, connection]() {
+                QObject::disconnect(*connection);
+                peersSelector(transferList);
+            });
+        return;
+    }
+
+    if (!peersSelectorComponent->isReady()) {
+        LOG_ERROR() << "Share Your Files: failed loading the peers selector -"
+                    << peersSelectorComponent->errorString();
+        return;
+    }
+
+    // Nothing to be shared
     if (transferList.totalFiles() == 0) {
         return;
     }
 
-    // Open the selector window
-    QQmlApplicationEngine *engine = new QQmlApplicationEngine(mainEngine);
+    // Open the selector window, in a dedicated context of the main engine
     PeersSelectorModel *model = new PeersSelectorModel(
         transferList.totalFiles(), sizeToHRFormat(transferList.totalBytes()),
-        ShareYourFiles::instance()->peersList(), engine);
-
-    engine->rootContext()->setContextProperty("peersSelector", model);
-    engine->load(QUrl(QStringLiteral("qrc:/Qml/PeersSelector.qml")));
+        ShareYourFiles::instance()->peersList(), mainEngine);
+
+    QQmlContext *context = new QQmlContext(mainEngine->rootContext(), model);
+    context->setContextProperty("peersSelector", model);
+    QObject *window = peersSelectorComponent->create(context);
+    if (!window) {
+        LOG_ERROR() << "Share Your Files: failed creating the peers selector -"
+                    << peersSelectorComponent->errorString();
+        model->deleteLater();
+        return;
+    }
 
     // Connect the signal executed when the decision is taken
-    QObject::connect(model, &PeersSelectorModel::selectionCompleted,
-                     [engine, model, transferList](bool confirmed) {
+    QObject::connect(model, &PeersSelectorModel::selectionCompleted, model,
+                     [model, window, transferList](bool confirmed) {
 
                          // If the transfer has been confirmed, open a
                          // connection for each
@@ -229,12 +442,12 @@ static void peersSelector(const QStringList &paths)
                              }
 
                              // Show the transfers window
-                             mainEngine->rootObjects()
-                                 .at(IDX_TRANSFERS)
-                                 ->setProperty("visible", true);
+                             transfersWindow->show();
                          }
 
-                         engine->deleteLater();
+                         // Destroy the window before its context
+                         window->deleteLater();
+                         model->deleteLater();
                      });
 }
 
@@ -279,17 +492,25 @@ static void initLogger(const QString &logPath)
         "[%{TypeOne}] %{time}{yyyy-MM-dd HH:mm:ss.zzz} - %{message}\n";
 #endif
 
-    ConsoleAppender *consoleAppender = new ConsoleAppender;
-    consoleAppender->setFormat(format);
-    cuteLogger->registerAppender(consoleAppender);
-
-    // Try to make the directory where the log files are stored
-    if (QDir(logPath).mkpath(".")) {
-        FileAppender *fileAppender =
-            new FileAppender(logPath + "/ShareYourFiles.log");
-        fileAppender->setFormat(format);
-        cuteLogger->registerAppender(fileAppender);
-    } else {
+    // The messages are formatted by the thread logging them, and then written
+    // to the console and to the log files by a background thread
+    AsyncLogAppender *asyncAppender = new AsyncLogAppender;
+    asyncAppender->setFormat(format);
+    asyncAppender->addSink(new ConsoleAppender);
+
+    // Try to make the directory where the log files are stored (a new file is
+    // started every day, and only the most recent ones are preserved)
+    bool logPathCreated = QDir(logPath).mkpath(".");
+    if (logPathCreated) {
+        RollingFileAppender *fileAppender =
+            new RollingFileAppender(logPath + "/ShareYourFiles.log");
+        fileAppender->setDatePattern(RollingFileAppender::DailyRollover);
+        fileAppender->setLogFilesLimit(LOG_FILES_LIMIT);
+        asyncAppender->addSink(fileAppender);
+    }
+
+    cuteLogger->registerAppender(asyncAppender);
+    if (!logPathCreated) {
         LOG_ERROR() << "ShareYourFiles: impossible to create the log path"
                     << logPath;
     }
@@ -298,7 +519,8 @@ static void initLogger(const QString &logPath)
 }
 
 ///
-/// \brief Initializes the system tray icon and the associated menu.
+/// \brief Initializes the system tray icon, shown while the application is
+/// still starting.
 ///
 static void initSystemTrayIcon()
 {
@@ -311,6 +533,18 @@ static void initSystemTrayIcon()
         QIcon(":/Resources/IconYellow.svg");
     errorIcon = QIcon(":/Resources/IconRed.svg");
 
+    // System tray icon (offline until the protocols are started)
+    systemTrayIcon = new QSystemTrayIcon();
+    systemTrayIcon->setIcon(modeIconMap.value(Enums::OperationalMode::Offline));
+    systemTrayIcon->setToolTip(APP_NAME + QObject::tr(" is starting..."));
+    systemTrayIcon->show();
+}
+
+///
+/// \brief Completes the system tray icon with the associated menu.
+///
+static void completeSystemTrayIcon()
+{
     // System tray menu
     systemTrayMenu = new QMenu();
 
@@ -328,11 +562,10 @@ static void initSystemTrayIcon()
     initializeQuitAction(systemTrayMenu);
 
     // System tray icon
-    systemTrayIcon = new QSystemTrayIcon();
     systemTrayIcon->setIcon(
         modeIconMap.value(ShareYourFiles::instance()->localUser()->mode()));
+    systemTrayIcon->setToolTip(APP_NAME);
     systemTrayIcon->setContextMenu(systemTrayMenu);
-    systemTrayIcon->show();
 
     // Show the welcome message
     systemTrayIcon->showMessage(
@@ -538,11 +771,8 @@ static void initializeSettingsAction(QMenu *systemTrayMenu)
 {
     QAction *settingsAction =
         new QAction(QObject::tr("&Settings"), systemTrayMenu);
-    QObject::connect(settingsAction, &QAction::triggered, mainEngine, []() {
-        mainEngine->rootObjects()
-            .at(IDX_SETTINGS)
-            ->setProperty("visible", true);
-    });
+    QObject::connect(settingsAction, &QAction::triggered, mainEngine,
+                     []() { settingsWindow->show(); });
     systemTrayMenu->addAction(settingsAction);
 }
 
@@ -554,11 +784,8 @@ static void initializeTransfersAction(QMenu *systemTrayMenu)
 {
     QAction *transfersAction =
         new QAction(QObject::tr("&Transfers"), systemTrayMenu);
-    QObject::connect(transfersAction, &QAction::triggered, mainEngine, []() {
-        mainEngine->rootObjects()
-            .at(IDX_TRANSFERS)
-            ->setProperty("visible", true);
-    });
+    QObject::connect(transfersAction, &QAction::triggered, mainEngine,
+                     []() { transfersWindow->show(); });
     systemTrayMenu->addAction(transfersAction);
 }
 
@@ -570,9 +797,8 @@ static void initializeAboutActions(QMenu *systemTrayMenu)
 {
     // About action
     QAction *aboutAction = new QAction(QObject::tr("&About"), systemTrayMenu);
-    QObject::connect(aboutAction, &QAction::triggered, mainEngine, []() {
-        mainEngine->rootObjects().at(IDX_ABOUT)->setProperty("visible", true);
-    });
+    QObject::connect(aboutAction, &QAction::triggered, mainEngine,
+                     []() { aboutWindow->show(); });
     systemTrayMenu->addAction(aboutAction);
 
     // AboutQt action
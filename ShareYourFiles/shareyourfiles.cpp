@@ -17,16 +17,17 @@
  */
 
 #include "shareyourfiles.hpp"
+#include "Common/logging.hpp"
+#include "Common/startupsequence.hpp"
 #include "Common/threadpool.hpp"
 #include "FileTransfer/syfpprotocol.hpp"
 #include "UserDiscovery/syfddatagram.hpp"
 #include "UserDiscovery/syfdprotocol.hpp"
 #include "UserDiscovery/user.hpp"
 
-#include <Logger.h>
-
 #include <QDir>
 #include <QLockFile>
+#include <QMutexLocker>
 
 // Static variables definition
 ShareYourFiles *ShareYourFiles::m_instance = Q_NULLPTR;
@@ -56,47 +57,86 @@ void ShareYourFiles::destroyInstance()
 }
 
 ///
-/// The main data structures and protocols necessary for the application
-/// operation are methodically created and initialized. In case some operation
-/// fails, the error flag is set to true.
+/// Only the phases the others depend on are executed synchronously (i.e. the
+/// acquisition of the global lock and the creation of the threads), while the
+/// main data structures and protocols are initialized by start(). In case some
+/// operation fails, the error flag is set to true.
 ///
 ShareYourFiles::ShareYourFiles(const QString &confPath, const QString &dataPath,
                                QObject *parent)
-        : QObject(parent), m_error(true)
+        : QObject(parent),
+          m_error(true),
+          m_confPath(confPath),
+          m_dataPath(dataPath),
+          m_startup(new StartupSequence(this))
 {
     LOG_INFO() << "ShareYourFiles: initialization...";
     LOG_INFO() << "ShareYourFiles: configuration path -" << confPath;
 
     // Try to acquire the global lock
-    if (!initLock(confPath)) {
+    if (!m_startup->run("global lock",
+                        [this]() { return initLock(m_confPath); })) {
         return;
     }
 
     // Create the thread pool
-    ThreadPool::createInstance();
+    m_startup->run("thread pool", []() {
+        ThreadPool::createInstance();
+        return true;
+    });
 
-    // Initialize the SYFP protocol
-    if (!initSYFPProtocol()) {
-        return;
-    }
+    m_error = false;
+}
 
-    // Initialize the network entries
-    if (!initNetworkEntries()) {
-        return;
-    }
+///
+/// The initialization is organized as a graph of tasks: the SYFP server is
+/// started in its thread, the network entries are enumerated in the SYFD
+/// thread and the user instances are loaded in the current one, all of them in
+/// parallel; the SYFD protocol is then started as soon as both the network
+/// entry and the local user are available. The initialized() signal is emitted
+/// when all the tasks are completed or after that one of them failed.
+///
+void ShareYourFiles::start()
+{
+    LOG_ASSERT_X(!m_error && m_startup,
+                 "ShareYourFiles: initialization already started or failed");
 
-    // Initialize the user instances
-    initUserInstances(confPath, dataPath);
+    m_startup->addTask("SYFP protocol", QStringList(),
+                       [this]() { return initSYFPProtocol(); },
+                       ThreadPool::syfpThread());
 
-    // Initialize the SYFD protocol
-    if (!initSYFDProtocol(Enums::OperationalMode::Online)) {
-        return;
-    }
+    m_startup->addTask("network entries", QStringList(),
+                       [this]() { return initNetworkEntries(); },
+                       ThreadPool::syfdThread());
 
-    m_error = false;
-    m_errorMessage = tr("Success.");
+    m_startup->addTask("user instances", QStringList(), [this]() {
+        initUserInstances();
+        return true;
+    });
+
+    m_startup->addTask(
+        "SYFD protocol", QStringList() << "network entries" << "user instances",
+        [this]() {
+            m_localInstance->data()->updateLocalAddress(
+                m_currentNetworkEntry.second);
+            return initSYFDProtocol(Enums::OperationalMode::Online);
+        });
+
+    // Function executed when the initialization terminates
+    connect(m_startup, &StartupSequence::finished, this, [this](bool success) {
+        m_error = !success;
+        if (success) {
+            m_errorMessage = tr("Success.");
+            LOG_INFO() << "ShareYourFiles: initialization completed";
+        } else {
+            LOG_ERROR() << "ShareYourFiles: initialization failed";
+        }
+
+        m_startup->deleteLater();
+        emit initialized(success);
+    });
 
-    LOG_INFO() << "ShareYourFiles: initialization completed";
+    m_startup->start();
 }
 
 ///
@@ -234,7 +274,8 @@ bool ShareYourFiles::initLock(const QString &confPath)
 /// The function attempts to initialize the SYFP protocol server, the one used
 /// to receive the list of files to be shared from the SYFPicker utility.
 /// In case an error occurs, false is returned and the error message is set to
-/// an appropriate value.
+/// an appropriate value. The function is executed in the SYFP thread, so that
+/// the server is directly created where it runs.
 ///
 bool ShareYourFiles::initSYFPProtocol()
 {
@@ -248,29 +289,30 @@ bool ShareYourFiles::initSYFPProtocol()
     // In case an error occurred, print it
     if (!result) {
         LOG_ERROR() << "ShareYourFiles: failed starting the SYFP protocol";
-        m_errorMessage = tr("Failed starting the SYFP protocol.");
+        setErrorMessage(tr("Failed starting the SYFP protocol."));
         return false;
     }
 
-    // Otherwise move the server to its thread
-    m_syfpInstance->moveToThread(ThreadPool::syfpThread());
     return true;
 }
 
 ///
 /// The function initializes the object representing the list of network entries
 /// (i.e. pairs network interface and IPv4 address) that are valid and can be
-/// used by the other network protocols.
+/// used by the other network protocols. The function is executed in the SYFD
+/// thread, since the enumeration of the interfaces may be slow, and the object
+/// is then moved to the thread of the current instance.
 ///
 bool ShareYourFiles::initNetworkEntries()
 {
     m_networkEntries = new NetworkEntriesList();
+    m_networkEntries->moveToThread(thread());
 
     // In case no valid entries found, print the error
     if (m_networkEntries->empty()) {
         m_currentNetworkEntry = NetworkEntriesList::InvalidEntry;
         LOG_ERROR() << "ShareYourFiles: no valid network entry found";
-        m_errorMessage = tr("No valid network interfaces detected.");
+        setErrorMessage(tr("No valid network interfaces detected."));
         return false;
     }
 
@@ -288,16 +330,15 @@ bool ShareYourFiles::initNetworkEntries()
 
 ///
 /// The function initializes the objects representing both the local user
-/// instance and the list of peers.
+/// instance and the list of peers. The local address is initially null, since
+/// the network entries are enumerated in parallel.
 ///
-void ShareYourFiles::initUserInstances(const QString &confPath,
-                                       const QString &dataPath)
+void ShareYourFiles::initUserInstances()
 {
     LOG_INFO() << "ShareYourFiles: user instances initialization...";
 
-    m_localInstance =
-        new LocalInstance(confPath, dataPath, m_currentNetworkEntry.second);
-    m_peersList = new PeersList(confPath, m_localInstance->data());
+    m_localInstance = new LocalInstance(m_confPath, m_dataPath, 0);
+    m_peersList = new PeersList(m_confPath, m_localInstance->data());
 
     // Function executed when the names of the local user are changed
     // to check if some peer advertises the same names
@@ -343,13 +384,18 @@ bool ShareYourFiles::initSYFDProtocol(Enums::OperationalMode mode)
     if (!m_syfdInstance->valid()) {
         m_syfdInstance->deleteLater();
         LOG_ERROR() << "ShareYourFiles: failed starting the SYFD protocol";
-        m_errorMessage = tr("Failed starting the SYFP protocol");
+        setErrorMessage(tr("Failed starting the SYFP protocol"));
         return false;
     }
 
     // Connect the slot to update the peer list when a datagram is received
     connect(m_syfdInstance, &SyfdProtocol::datagramReceived, m_peersList,
             &PeersList::update);
+    connect(m_syfdInstance, &SyfdProtocol::heartbeatReceived, m_peersList,
+            &PeersList::updateHeartbeat);
+    // Connect the slot to request the profiles missing from the peer list
+    connect(m_peersList, &PeersList::profileRequested, m_syfdInstance,
+            &SyfdProtocol::requestProfile);
 
     // Connect the slots to maintain the operational mode sync'ed
     connect(m_syfdInstance, &SyfdProtocol::modeChanged, m_localInstance->data(),
@@ -359,12 +405,17 @@ bool ShareYourFiles::initSYFDProtocol(Enums::OperationalMode mode)
                 m_syfdInstance->setMode(mode, false);
             });
 
+    // Connect the slot to maintain the aggregator capability sync'ed
+    connect(m_localInstance->data(), &LocalUser::aggregatorChanged,
+            m_syfdInstance, &SyfdProtocol::setAggregatorCapable);
+
     // Connect the slot to force the network entries list update when an
     // error occurs while sending datagrams
     QObject::connect(m_syfdInstance, &SyfdProtocol::error, m_networkEntries,
                      &NetworkEntriesList::updateEntries);
 
     // Start the SYFD protocol instance and move it to its thread
+    m_syfdInstance->setAggregatorCapable(m_localInstance->data()->aggregator());
     m_syfdInstance->start(mode, SyfdDatagram(m_localInstance->data()->info()));
     m_syfdInstance->moveToThread(ThreadPool::syfdThread());
     return true;
@@ -425,3 +476,15 @@ void ShareYourFiles::networkEntriesListUpdated()
 
     emit networkEntryChanged(m_currentNetworkEntry);
 }
+
+///
+/// The first message is preserved, since the other phases running in parallel
+/// may fail as a consequence of the same error.
+///
+void ShareYourFiles::setErrorMessage(const QString &message)
+{
+    QMutexLocker locker(&m_errorMutex);
+    if (m_errorMessage.isEmpty()) {
+        m_errorMessage = message;
+    }
+}
@@ -24,12 +24,14 @@
 #include "FileTransfer/syfpprotocol.hpp"
 #include "UserDiscovery/users.hpp"
 
+#include <QMutex>
 #include <QObject>
 #include <QPointer>
 
 class QLockFile;
 
 class LocalUser;
+class StartupSequence;
 class SyfdProtocol;
 class SyfpProtocolServer;
 
@@ -47,12 +49,18 @@ class SyfpProtocolServer;
 /// application. Through the provided functions, it is possible to access to the
 /// pointers to such instances.
 ///
+/// The creation of the instance only acquires the global lock and starts the
+/// worker threads, while the remaining data structures are initialized in
+/// background by start(): the accessors can be used only after that the
+/// initialized() signal has been emitted with a successful outcome.
+///
 class ShareYourFiles : public QObject
 {
     Q_OBJECT
 public:
     ///
-    /// \brief Creates the instance of ShareYourFiles.
+    /// \brief Creates the instance of ShareYourFiles (the initialization has
+    /// to be completed through start()).
     /// \param confPath the base path where the configuration files are stored.
     /// \param dataPath the base path where the data files are stored.
     /// \return a value indicating whether the operation succeeded or not.
@@ -74,6 +82,15 @@ public:
     /// \brief Destroys the main data structures used by Share Your Files.
     ~ShareYourFiles();
 
+    ///
+    /// \brief Starts the asynchronous initialization of the data structures
+    /// and of the protocols.
+    ///
+    /// The independent phases are executed in parallel, and the initialized()
+    /// signal is emitted once completed.
+    ///
+    void start();
+
     /// \brief Returns whether an error occurred during the initialization.
     bool error() const { return m_error; }
     /// \brief Returns a message describing the occurred error.
@@ -87,6 +104,12 @@ public:
     /// \brief Returns the pointer to the SyfpProtocolServer instance.
     SyfpProtocolServer *syfpProtocolInstance() { return m_syfpInstance; }
 
+    ///
+    /// \brief Returns the pointer to the SyfdProtocol instance (null in case
+    /// no network entry is available).
+    ///
+    SyfdProtocol *syfdProtocolInstance() { return m_syfdInstance; }
+
     /// \brief Returns the pointer to the NetworkEntriesList instance.
     NetworkEntriesList *networkEntriesList() { return m_networkEntries; }
 
@@ -101,6 +124,14 @@ public:
     bool changeNetworkEntry(const NetworkEntriesList::Entry &entry);
 
 signals:
+    ///
+    /// \brief Signal emitted when the initialization started by start()
+    /// terminates.
+    /// \param success whether the initialization succeeded or not (in the
+    /// latter case, errorMessage() describes the error).
+    ///
+    void initialized(bool success);
+
     ///
     /// \brief Signal emitted when the current network entry is changed.
     /// \param entry the instance representing the selected entry.
@@ -114,6 +145,9 @@ private:
     /// \param dataPath the base path where the data files are stored.
     /// \param parent the parent of the current object.
     ///
+    /// Only the global lock is acquired and the worker threads are started,
+    /// while the other data structures are initialized by start().
+    ///
     explicit ShareYourFiles(const QString &confPath, const QString &dataPath,
                             QObject *parent = Q_NULLPTR);
 
@@ -138,11 +172,9 @@ private:
 
     ///
     /// \brief Initializes the instances representing both the local user and
-    /// the peers.
-    /// \param confPath the base path where the configuration files are stored.
-    /// \param dataPath the base path where the data files are stored.
+    /// the peers (the local address is set once the network entry is known).
     ///
-    void initUserInstances(const QString &confPath, const QString &dataPath);
+    void initUserInstances();
 
     ///
     /// \brief Initializes the SYFD protocol instance.
@@ -156,6 +188,13 @@ private:
     ///
     void networkEntriesListUpdated();
 
+    ///
+    /// \brief Sets the message describing the occurred error, unless another
+    /// one has already been set (the function is thread-safe).
+    /// \param message the description of the error.
+    ///
+    void setErrorMessage(const QString &message);
+
 private:
     /// \brief A value indicating whether an error occurred during the
     /// initialization or not.
@@ -163,6 +202,17 @@ private:
 
     /// \brief A textual description of the occurred error (if any).
     QString m_errorMessage;
+    /// \brief The mutex protecting the error message, set by the phases of
+    /// the initialization executed in the worker threads.
+    QMutex m_errorMutex;
+
+    /// \brief The base path where the configuration files are stored.
+    QString m_confPath;
+    /// \brief The base path where the data files are stored.
+    QString m_dataPath;
+
+    /// \brief The graph of tasks carrying out the initialization.
+    QPointer<StartupSequence> m_startup;
 
     /// \brief The object representing the local user.
     QPointer<LocalInstance> m_localInstance;